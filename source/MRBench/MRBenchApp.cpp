@@ -0,0 +1,26 @@
+#include "MRBenchInputs.h"
+#include "MRMesh/MRSystem.h"
+#include "MRMesh/MRMeshTopology.h"
+
+#include <string>
+
+// Runs MeshLib benchmarks in Google Benchmark style, all standard options are supported, e.g.
+//   MRBench --benchmark_filter=Decimate --benchmark_out=result.json --benchmark_out_format=json
+// The largest problem size is controlled by MRBENCH_MAX_ELEMENTS environment variable (1M by default, up to 50M).
+int main( int argc, char** argv )
+{
+    MR::loadMeshDll();
+    MR::setupLoggerByDefault();
+
+    benchmark::AddCustomContext( "meshlib_version", MR::GetMRVersionString() );
+    benchmark::AddCustomContext( "cpu", MR::GetCpuId() );
+    benchmark::AddCustomContext( "os", MR::GetDetailedOSName() );
+    benchmark::AddCustomContext( "mrbench_max_elements", std::to_string( MR::Bench::maxElements() ) );
+
+    benchmark::Initialize( &argc, argv );
+    if ( benchmark::ReportUnrecognizedArguments( argc, argv ) )
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
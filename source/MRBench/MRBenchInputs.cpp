@@ -0,0 +1,198 @@
+#include "MRBenchInputs.h"
+#include "MRMesh/MRMesh.h"
+#include "MRMesh/MRMakeSphereMesh.h"
+#include "MRMesh/MRTorus.h"
+#include "MRMesh/MRRegularGridMesh.h"
+#include "MRMesh/MRPointCloud.h"
+#include "MRMesh/MRMeshSave.h"
+#include "MRMesh/MRParallelFor.h"
+#include "MRMesh/MRSystem.h"
+#include "MRMesh/MRBox.h"
+#include "MRMesh/MRStringConvert.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace MR::Bench
+{
+
+namespace
+{
+
+/// thread-safe cache of lazily created objects of type T keyed by (size, tag)
+template <typename T>
+class Cache
+{
+public:
+    template <typename F>
+    const T & get( size_t size, const std::string & tag, F && make )
+    {
+        std::unique_lock lock( mutex_ );
+        auto & ptr = map_[{ size, tag }];
+        if ( !ptr )
+            ptr = std::make_unique<T>( make() );
+        return *ptr;
+    }
+private:
+    std::mutex mutex_;
+    std::map<std::pair<size_t, std::string>, std::unique_ptr<T>> map_;
+};
+
+/// points are generated in independent blocks of this size each with own seed,
+/// so the result does not depend on the number of threads
+constexpr size_t cPointsBlockSize = 65536;
+
+} //anonymous namespace
+
+size_t maxElements()
+{
+    static const size_t res = []
+    {
+        if ( auto env = std::getenv( "MRBENCH_MAX_ELEMENTS" ) )
+            if ( auto v = std::strtoull( env, nullptr, 10 ); v > 0 )
+                return size_t( v );
+        return size_t( 1'000'000 );
+    }();
+    return res;
+}
+
+std::vector<int64_t> sizes()
+{
+    std::vector<int64_t> res;
+    for ( int64_t s : { 1'000'000, 10'000'000, 50'000'000 } )
+        if ( size_t( s ) <= maxElements() )
+            res.push_back( s );
+    if ( res.empty() )
+        res.push_back( int64_t( maxElements() ) );
+    return res;
+}
+
+std::vector<int64_t> threadCounts()
+{
+    const int64_t hw = std::max( 1u, std::thread::hardware_concurrency() );
+    std::vector<int64_t> res;
+    for ( int64_t t = 1; t < hw; t *= 2 )
+        res.push_back( t );
+    res.push_back( hw );
+    return res;
+}
+
+void sizesAndThreads( benchmark::internal::Benchmark* b )
+{
+    b->ArgNames( { "size", "threads" } );
+    b->ArgsProduct( { sizes(), threadCounts() } );
+}
+
+void sizesOnly( benchmark::internal::Benchmark* b )
+{
+    b->ArgNames( { "size" } );
+    for ( auto s : sizes() )
+        b->Arg( s );
+}
+
+ThreadLimit::ThreadLimit( int64_t numThreads )
+{
+    if ( numThreads > 0 )
+        control_.emplace( tbb::global_control::max_allowed_parallelism, size_t( numThreads ) );
+}
+
+const Mesh & torus( size_t numFaces )
+{
+    static Cache<Mesh> cache;
+    return cache.get( numFaces, {}, [numFaces]
+    {
+        // makeTorus creates 2 * primary * secondary triangles, take primary = 2 * secondary
+        const int secondary = std::max( 3, int( std::sqrt( numFaces / 4.0 ) ) );
+        return makeTorus( 1.0f, 0.3f, 2 * secondary, secondary );
+    } );
+}
+
+const Mesh & sphere( size_t numFaces )
+{
+    static Cache<Mesh> cache;
+    return cache.get( numFaces, {}, [numFaces]
+    {
+        // makeUVSphere creates about 2 * horizontal * vertical triangles, take horizontal = 2 * vertical
+        const int vertical = std::max( 3, int( std::sqrt( numFaces / 4.0 ) ) );
+        return makeUVSphere( 1.0f, 2 * vertical, vertical );
+    } );
+}
+
+const Mesh & grid( size_t numFaces )
+{
+    static Cache<Mesh> cache;
+    return cache.get( numFaces, {}, [numFaces]
+    {
+        // regular grid of side n has 2 * ( n - 1 )^2 triangles
+        const size_t side = std::max( size_t( 2 ), size_t( std::sqrt( numFaces / 2.0 ) ) + 1 );
+        const float step = 1.0f / float( side - 1 );
+        auto res = makeRegularGridMesh( side, side,
+            []( size_t, size_t ) { return true; },
+            [step]( size_t x, size_t y )
+            {
+                const float fx = x * step, fy = y * step;
+                return Vector3f( fx, fy, 0.05f * std::sin( 20 * fx ) * std::cos( 20 * fy ) );
+            } );
+        if ( !res )
+            throw std::runtime_error( res.error() );
+        return std::move( *res );
+    } );
+}
+
+std::vector<Vector3f> randomPointsInBox( size_t numPoints, const Box3f & box, uint32_t seed )
+{
+    std::vector<Vector3f> res( numPoints );
+    const auto size = box.size();
+    const size_t numBlocks = ( numPoints + cPointsBlockSize - 1 ) / cPointsBlockSize;
+    ParallelFor( size_t( 0 ), numBlocks, [&]( size_t block )
+    {
+        std::mt19937 gen( seed + uint32_t( block ) );
+        std::uniform_real_distribution<float> dist( 0.0f, 1.0f );
+        const auto end = std::min( numPoints, ( block + 1 ) * cPointsBlockSize );
+        for ( size_t i = block * cPointsBlockSize; i < end; ++i )
+        {
+            const float x = dist( gen ), y = dist( gen ), z = dist( gen );
+            res[i] = box.min + mult( size, Vector3f( x, y, z ) );
+        }
+    } );
+    return res;
+}
+
+const PointCloud & randomPoints( size_t numPoints )
+{
+    static Cache<PointCloud> cache;
+    return cache.get( numPoints, {}, [numPoints]
+    {
+        PointCloud res;
+        res.points.vec_ = randomPointsInBox( numPoints, Box3f( Vector3f(), Vector3f::diagonal( 1.0f ) ), 0 );
+        res.validPoints.resize( numPoints, true );
+        return res;
+    } );
+}
+
+const std::filesystem::path & torusFile( size_t numFaces, const char * extension )
+{
+    static Cache<std::filesystem::path> cache;
+    return cache.get( numFaces, extension, [numFaces, extension]
+    {
+        auto path = GetTempDirectory() / ( "MRBench_torus_" + std::to_string( numFaces ) + extension );
+        if ( auto saved = MeshSave::toAnySupportedFormat( torus( numFaces ), path ); !saved )
+            throw std::runtime_error( "Cannot save " + utf8string( path ) + ": " + saved.error() );
+        return path;
+    } );
+}
+
+void setCounters( benchmark::State & state, size_t itemsPerIteration, int64_t numThreads )
+{
+    state.SetItemsProcessed( int64_t( state.iterations() ) * int64_t( itemsPerIteration ) );
+    state.counters["threads"] = double( numThreads > 0 ? numThreads : int64_t( std::thread::hardware_concurrency() ) );
+}
+
+} //namespace MR::Bench
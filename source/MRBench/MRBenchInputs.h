@@ -0,0 +1,69 @@
+#pragma once
+
+#include "MRMesh/MRMeshFwd.h"
+#include "MRMesh/MRVector3.h"
+#include "MRPch/MRTBB.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+namespace MR::Bench
+{
+
+/// the largest number of elements (triangles, points or voxels) a benchmark is allowed to process;
+/// taken from MRBENCH_MAX_ELEMENTS environment variable, 1M by default
+[[nodiscard]] size_t maxElements();
+
+/// standard problem sizes: 1M, 10M and 50M elements, but not exceeding maxElements()
+[[nodiscard]] std::vector<int64_t> sizes();
+
+/// thread counts for sweeps: 1, 2, 4, ... up to the hardware concurrency (inclusive)
+[[nodiscard]] std::vector<int64_t> threadCounts();
+
+/// adds all (size, threads) combinations as benchmark arguments, to be used with ->Apply()
+void sizesAndThreads( benchmark::internal::Benchmark* b );
+
+/// adds only the sizes as benchmark arguments (all hardware threads are used), to be used with ->Apply()
+void sizesOnly( benchmark::internal::Benchmark* b );
+
+/// limits the number of threads in TBB pool while the object is alive;
+/// zero or negative numThreads means no limitation
+class ThreadLimit
+{
+public:
+    explicit ThreadLimit( int64_t numThreads );
+private:
+    std::optional<tbb::global_control> control_;
+};
+
+/// all inputs below are generated deterministically and cached by size,
+/// so that the benchmarks with different thread counts reuse the same data;
+/// the returned references stay valid till the program exit
+
+/// closed regular torus with approximately given number of triangles
+[[nodiscard]] const Mesh & torus( size_t numFaces );
+
+/// closed UV-sphere of unit radius with approximately given number of triangles
+[[nodiscard]] const Mesh & sphere( size_t numFaces );
+
+/// open regular grid mesh (wavy height field) with approximately given number of triangles
+[[nodiscard]] const Mesh & grid( size_t numFaces );
+
+/// point cloud with given number of points uniformly distributed in the unit cube
+[[nodiscard]] const PointCloud & randomPoints( size_t numPoints );
+
+/// given number of points uniformly distributed in the box, generated from given seed
+[[nodiscard]] std::vector<Vector3f> randomPointsInBox( size_t numPoints, const Box3f & box, uint32_t seed );
+
+/// file with the torus( numFaces ) saved in the format with given extension (e.g. ".stl", ".ply", ".obj")
+/// in the temporary directory; the file is created on first request
+[[nodiscard]] const std::filesystem::path & torusFile( size_t numFaces, const char * extension );
+
+/// reports processed items and thread count in benchmark counters
+void setCounters( benchmark::State & state, size_t itemsPerIteration, int64_t numThreads );
+
+} //namespace MR::Bench
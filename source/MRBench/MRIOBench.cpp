@@ -0,0 +1,73 @@
+#include "MRBenchInputs.h"
+#include "MRMesh/MRMesh.h"
+#include "MRMesh/MRMeshLoad.h"
+#include "MRMesh/MRMeshSave.h"
+#include "MRMesh/MRSystem.h"
+
+#include <string>
+
+namespace MR::Bench
+{
+
+namespace
+{
+
+void loadTorus( benchmark::State & state, const char * extension )
+{
+    const auto numFaces = size_t( state.range( 0 ) );
+    const auto & path = torusFile( numFaces, extension );
+    ThreadLimit limit( state.range( 1 ) );
+    for ( auto _ : state )
+    {
+        auto res = MeshLoad::fromAnySupportedFormat( path );
+        if ( !res )
+        {
+            state.SkipWithError( res.error().c_str() );
+            break;
+        }
+        benchmark::DoNotOptimize( res->topology.edgeSize() );
+    }
+    setCounters( state, numFaces, state.range( 1 ) );
+}
+
+void BM_LoadStl( benchmark::State & state ) { loadTorus( state, ".stl" ); }
+BENCHMARK( BM_LoadStl )->Apply( sizesAndThreads )->Unit( benchmark::kMillisecond )->UseRealTime();
+
+void BM_LoadPly( benchmark::State & state ) { loadTorus( state, ".ply" ); }
+BENCHMARK( BM_LoadPly )->Apply( sizesAndThreads )->Unit( benchmark::kMillisecond )->UseRealTime();
+
+void BM_LoadObj( benchmark::State & state ) { loadTorus( state, ".obj" ); }
+BENCHMARK( BM_LoadObj )->Apply( sizesAndThreads )->Unit( benchmark::kMillisecond )->UseRealTime();
+
+void saveTorus( benchmark::State & state, const char * extension )
+{
+    const auto numFaces = size_t( state.range( 0 ) );
+    const auto & mesh = torus( numFaces );
+    const auto path = GetTempDirectory() / ( std::string( "MRBench_saved_torus" ) + extension );
+    ThreadLimit limit( state.range( 1 ) );
+    for ( auto _ : state )
+    {
+        auto res = MeshSave::toAnySupportedFormat( mesh, path );
+        if ( !res )
+        {
+            state.SkipWithError( res.error().c_str() );
+            break;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::remove( path, ec );
+    setCounters( state, numFaces, state.range( 1 ) );
+}
+
+void BM_SaveStl( benchmark::State & state ) { saveTorus( state, ".stl" ); }
+BENCHMARK( BM_SaveStl )->Apply( sizesAndThreads )->Unit( benchmark::kMillisecond )->UseRealTime();
+
+void BM_SavePly( benchmark::State & state ) { saveTorus( state, ".ply" ); }
+BENCHMARK( BM_SavePly )->Apply( sizesAndThreads )->Unit( benchmark::kMillisecond )->UseRealTime();
+
+void BM_SaveObj( benchmark::State & state ) { saveTorus( state, ".obj" ); }
+BENCHMARK( BM_SaveObj )->Apply( sizesAndThreads )->Unit( benchmark::kMillisecond )->UseRealTime();
+
+} //anonymous namespace
+
+} //namespace MR::Bench
@@ -0,0 +1,253 @@
+#include "MRBenchInputs.h"
+#include "MRMesh/MRMesh.h"
+#include "MRMesh/MRMeshBuilder.h"
+#include "MRMesh/MRMeshDecimate.h"
+#include "MRMesh/MRMeshBoolean.h"
+#include "MRMesh/MRMeshProject.h"
+#include "MRMesh/MRMeshIntersect.h"
+#include "MRMesh/MRPointCloud.h"
+#include "MRMesh/MRPointsProject.h"
+#include "MRMesh/MRBuffer.h"
+#include "MRMesh/MRAABBTree.h"
+#include "MRMesh/MRAABBTreeWide.h"
+#include "MRMesh/MRAffineXf3.h"
+#include "MRMesh/MRMatrix3.h"
+#include "MRMesh/MRBitSet.h"
+#include "MRMesh/MRParallelFor.h"
+#include "MRMesh/MRLine3.h"
+#include "MRMesh/MRBox.h"
+#include "MRMesh/MRConstants.h"
+
+#include <atomic>
+#include <cmath>
+
+namespace MR::Bench
+{
+
+namespace
+{
+
+/// the number of projection and ray queries per iteration does not grow beyond this
+constexpr size_t cMaxQueries = 1'000'000;
+
+void BM_AABBTreeBuild( benchmark::State & state )
+{
+    const auto & mesh = torus( size_t( state.range( 0 ) ) );
+    ThreadLimit limit( state.range( 1 ) );
+    for ( auto _ : state )
+    {
+        AABBTree tree( mesh );
+        benchmark::DoNotOptimize( tree.nodes().data() );
+    }
+    setCounters( state, mesh.topology.numValidFaces(), state.range( 1 ) );
+}
+BENCHMARK( BM_AABBTreeBuild )->Apply( sizesAndThreads )->Unit( benchmark::kMillisecond )->UseRealTime();
+
+void BM_AABBTreeRefit( benchmark::State & state )
+{
+    // a small brush-like modification: 1000 consecutive vertices are moved
+    Mesh mesh = torus( size_t( state.range( 0 ) ) );
+    VertBitSet changed( mesh.topology.vertSize() );
+    for ( VertId v( 0 ); v < 1000 && v < mesh.topology.vertSize(); ++v )
+        changed.set( v );
+    mesh.getAABBTree();
+    mesh.updateCaches( changed ); // prepare the data for fast refit
+    ThreadLimit limit( state.range( 1 ) );
+    float shift = 0;
+    for ( auto _ : state )
+    {
+        shift = 0.001f - shift;
+        for ( auto v : changed )
+            mesh.points[v].z += shift;
+        mesh.updateCaches( changed, 2.0f );
+        benchmark::DoNotOptimize( mesh.getAABBTreeNotCreate() );
+    }
+    setCounters( state, changed.count(), state.range( 1 ) );
+}
+BENCHMARK( BM_AABBTreeRefit )->Apply( sizesAndThreads )->Unit( benchmark::kMicrosecond )->UseRealTime();
+
+void BM_FromTriangles( benchmark::State & state )
+{
+    const auto & mesh = torus( size_t( state.range( 0 ) ) );
+    const auto t = mesh.topology.getTriangulation();
+    ThreadLimit limit( state.range( 1 ) );
+    for ( auto _ : state )
+    {
+        auto topology = MeshBuilder::fromTriangles( t );
+        benchmark::DoNotOptimize( topology.edgeSize() );
+    }
+    setCounters( state, t.size(), state.range( 1 ) );
+}
+BENCHMARK( BM_FromTriangles )->Apply( sizesAndThreads )->Unit( benchmark::kMillisecond )->UseRealTime();
+
+void BM_MeshTopologyPack( benchmark::State & state )
+{
+    // every 10th face is deleted to make packing nontrivial
+    MeshTopology holed = torus( size_t( state.range( 0 ) ) ).topology;
+    FaceBitSet del( holed.faceSize() );
+    for ( FaceId f{ 0 }; f < holed.faceSize(); f += 10 )
+        del.set( f );
+    holed.deleteFaces( del );
+
+    ThreadLimit limit( state.range( 1 ) );
+    for ( auto _ : state )
+    {
+        state.PauseTiming();
+        auto topology = holed;
+        state.ResumeTiming();
+        topology.pack( nullptr, nullptr, nullptr, true );
+        benchmark::DoNotOptimize( topology.edgeSize() );
+    }
+    setCounters( state, holed.numValidFaces(), state.range( 1 ) );
+}
+BENCHMARK( BM_MeshTopologyPack )->Apply( sizesAndThreads )->Unit( benchmark::kMillisecond )->UseRealTime();
+
+void BM_DecimateMesh( benchmark::State & state )
+{
+    const auto & orig = torus( size_t( state.range( 0 ) ) );
+    const auto numFaces = orig.topology.numValidFaces();
+    ThreadLimit limit( state.range( 1 ) );
+    for ( auto _ : state )
+    {
+        state.PauseTiming();
+        auto mesh = orig;
+        state.ResumeTiming();
+        DecimateSettings settings
+        {
+            .maxError = FLT_MAX,
+            .maxDeletedFaces = numFaces * 9 / 10,
+            .packMesh = true,
+            .subdivideParts = 64
+        };
+        auto res = decimateMesh( mesh, settings );
+        benchmark::DoNotOptimize( res.facesDeleted );
+    }
+    setCounters( state, numFaces, state.range( 1 ) );
+}
+BENCHMARK( BM_DecimateMesh )->Apply( sizesAndThreads )->Unit( benchmark::kMillisecond )->UseRealTime();
+
+void BM_Boolean( benchmark::State & state )
+{
+    // each sphere gets half of the requested triangles
+    const auto & meshA = sphere( size_t( state.range( 0 ) ) / 2 );
+    const auto & meshB = meshA;
+    // shifted and slightly rotated to avoid coinciding vertices
+    const auto xf = AffineXf3f( Matrix3f::rotation( Vector3f( 1, 1, 1 ).normalized(), 0.1f ), Vector3f( 0.5f, 0.2f, 0.1f ) );
+    meshA.getAABBTree();
+    ThreadLimit limit( state.range( 1 ) );
+    for ( auto _ : state )
+    {
+        auto res = boolean( meshA, meshB, BooleanOperation::Union, &xf );
+        if ( !res )
+        {
+            state.SkipWithError( res.errorString.c_str() );
+            break;
+        }
+        benchmark::DoNotOptimize( res.mesh.topology.edgeSize() );
+    }
+    setCounters( state, 2 * meshA.topology.numValidFaces(), state.range( 1 ) );
+}
+BENCHMARK( BM_Boolean )->Apply( sizesAndThreads )->Unit( benchmark::kMillisecond )->UseRealTime();
+
+template <bool Wide>
+void BM_FindProjection( benchmark::State & state )
+{
+    const auto & mesh = torus( size_t( state.range( 0 ) ) );
+    const auto box = mesh.computeBoundingBox().expanded( Vector3f::diagonal( 0.1f ) );
+    const auto pts = randomPointsInBox( std::min( cMaxQueries, size_t( state.range( 0 ) ) ), box, 1 );
+    mesh.getAABBTree();
+    const auto * wide = Wide ? &mesh.getAABBTreeWide() : nullptr;
+    ThreadLimit limit( state.range( 1 ) );
+    for ( auto _ : state )
+    {
+        std::atomic<size_t> numValid{ 0 };
+        ParallelFor( pts, [&]( size_t i )
+        {
+            if ( Wide ? findProjectionWide( pts[i], mesh, *wide ) : findProjection( pts[i], mesh ) )
+                ++numValid;
+        } );
+        benchmark::DoNotOptimize( numValid.load() );
+    }
+    setCounters( state, pts.size(), state.range( 1 ) );
+}
+BENCHMARK( BM_FindProjection<false> )->Name( "BM_FindProjection" )->Apply( sizesAndThreads )->Unit( benchmark::kMillisecond )->UseRealTime();
+BENCHMARK( BM_FindProjection<true> )->Name( "BM_FindProjectionWide" )->Apply( sizesAndThreads )->Unit( benchmark::kMillisecond )->UseRealTime();
+
+template <bool Wide>
+void BM_RayMeshIntersect( benchmark::State & state )
+{
+    const auto & mesh = torus( size_t( state.range( 0 ) ) );
+    const auto box = mesh.computeBoundingBox();
+    const auto numRays = std::min( cMaxQueries, size_t( state.range( 0 ) ) );
+    // rays start from random points and go to other random points in the same box
+    const auto orgs = randomPointsInBox( numRays, box, 2 );
+    const auto dests = randomPointsInBox( numRays, box, 3 );
+    mesh.getAABBTree();
+    const auto * wide = Wide ? &mesh.getAABBTreeWide() : nullptr;
+    ThreadLimit limit( state.range( 1 ) );
+    for ( auto _ : state )
+    {
+        std::atomic<size_t> numHits{ 0 };
+        ParallelFor( orgs, [&]( size_t i )
+        {
+            const Line3f line( orgs[i], dests[i] - orgs[i] );
+            if ( Wide ? rayMeshIntersectWide( mesh, *wide, line ) : rayMeshIntersect( mesh, line ) )
+                ++numHits;
+        } );
+        benchmark::DoNotOptimize( numHits.load() );
+    }
+    setCounters( state, numRays, state.range( 1 ) );
+}
+BENCHMARK( BM_RayMeshIntersect<false> )->Name( "BM_RayMeshIntersect" )->Apply( sizesAndThreads )->Unit( benchmark::kMillisecond )->UseRealTime();
+BENCHMARK( BM_RayMeshIntersect<true> )->Name( "BM_RayMeshIntersectWide" )->Apply( sizesAndThreads )->Unit( benchmark::kMillisecond )->UseRealTime();
+
+void BM_FindNClosestPointsPerPoint( benchmark::State & state )
+{
+    const auto & mesh = torus( size_t( state.range( 0 ) ) );
+    PointCloud pc;
+    pc.points = mesh.points;
+    pc.validPoints = mesh.topology.getValidVerts();
+    pc.getAABBTree();
+    ThreadLimit limit( state.range( 1 ) );
+    for ( auto _ : state )
+    {
+        auto neis = findNClosestPointsPerPoint( pc, 8 );
+        benchmark::DoNotOptimize( neis.data() );
+    }
+    setCounters( state, pc.validPoints.count(), state.range( 1 ) );
+}
+BENCHMARK( BM_FindNClosestPointsPerPoint )->Apply( sizesAndThreads )->Unit( benchmark::kMillisecond )->UseRealTime();
+
+/// intersects the torus with coherent camera rays either one by one or by packets
+template <bool Packets>
+void BM_MultiRayMeshIntersect( benchmark::State & state )
+{
+    const auto & mesh = torus( size_t( state.range( 0 ) ) );
+    const auto box = mesh.computeBoundingBox();
+    const int side = int( std::sqrt( double( std::min( cMaxQueries, size_t( state.range( 0 ) ) ) ) ) );
+    // all rays start from one point above the torus and cover its bounding box
+    std::vector<Vector3f> origins( size_t( side ) * side, box.center() + Vector3f( 0, 0, 2 * box.size().z + box.size().x ) );
+    std::vector<Vector3f> dirs( origins.size() );
+    for ( int y = 0; y < side; ++y )
+        for ( int x = 0; x < side; ++x )
+            dirs[size_t( y ) * side + x] = Vector3f( box.min.x + box.size().x * x / side, box.min.y + box.size().y * y / side, box.center().z ) - origins[0];
+    mesh.getAABBTree();
+    ThreadLimit limit( state.range( 1 ) );
+    for ( auto _ : state )
+    {
+        std::vector<float> dists;
+        if ( Packets )
+            multiRayMeshIntersectPacket( mesh, origins, dirs, { .rayDistances = &dists } );
+        else
+            multiRayMeshIntersect( mesh, origins, dirs, { .rayDistances = &dists } );
+        benchmark::DoNotOptimize( dists.data() );
+    }
+    setCounters( state, origins.size(), state.range( 1 ) );
+}
+BENCHMARK( BM_MultiRayMeshIntersect<false> )->Name( "BM_MultiRayMeshIntersect" )->Apply( sizesAndThreads )->Unit( benchmark::kMillisecond )->UseRealTime();
+BENCHMARK( BM_MultiRayMeshIntersect<true> )->Name( "BM_MultiRayMeshIntersectPacket" )->Apply( sizesAndThreads )->Unit( benchmark::kMillisecond )->UseRealTime();
+
+
+} //anonymous namespace
+
+} //namespace MR::Bench
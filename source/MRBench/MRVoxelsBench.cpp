@@ -0,0 +1,95 @@
+#ifndef MESHLIB_NO_VOXELS
+#include "MRBenchInputs.h"
+#include "MRMesh/MRMesh.h"
+#include "MRVoxels/MROffset.h"
+#include "MRVoxels/MRMarchingCubes.h"
+#include "MRVoxels/MRVoxelsVolume.h"
+#include "MRMesh/MRParallelFor.h"
+
+#include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+namespace MR::Bench
+{
+
+namespace
+{
+
+/// signed distance to the sphere of radius 0.8 centered in the cubic volume of approximately given number of voxels
+const SimpleVolumeMinMax & sphereVolume( size_t numVoxels )
+{
+    static std::mutex mutex;
+    static std::map<size_t, std::unique_ptr<SimpleVolumeMinMax>> cache;
+    std::unique_lock lock( mutex );
+    auto & ptr = cache[numVoxels];
+    if ( ptr )
+        return *ptr;
+
+    const int side = std::max( 2, int( std::cbrt( double( numVoxels ) ) ) );
+    const float voxelSize = 2.0f / float( side );
+    ptr = std::make_unique<SimpleVolumeMinMax>();
+    auto & vol = *ptr;
+    vol.dims = Vector3i::diagonal( side );
+    vol.voxelSize = Vector3f::diagonal( voxelSize );
+    vol.data.resize( size_t( side ) * side * side );
+    ParallelFor( 0, side, [&]( int z )
+    {
+        size_t n = size_t( z ) * side * side;
+        for ( int y = 0; y < side; ++y )
+            for ( int x = 0; x < side; ++x, ++n )
+            {
+                const auto p = voxelSize * Vector3f( x + 0.5f, y + 0.5f, z + 0.5f ) - Vector3f::diagonal( 1.0f );
+                vol.data[VoxelId( n )] = p.length() - 0.8f;
+            }
+    } );
+    vol.min = -0.8f;
+    vol.max = std::sqrt( 3.0f ) - 0.8f;
+    return vol;
+}
+
+void BM_MarchingCubes( benchmark::State & state )
+{
+    const auto & vol = sphereVolume( size_t( state.range( 0 ) ) );
+    ThreadLimit limit( state.range( 1 ) );
+    for ( auto _ : state )
+    {
+        auto res = marchingCubes( vol );
+        if ( !res )
+        {
+            state.SkipWithError( res.error().c_str() );
+            break;
+        }
+        benchmark::DoNotOptimize( res->topology.edgeSize() );
+    }
+    setCounters( state, vol.data.size(), state.range( 1 ) );
+}
+BENCHMARK( BM_MarchingCubes )->Apply( sizesAndThreads )->Unit( benchmark::kMillisecond )->UseRealTime();
+
+void BM_OffsetMesh( benchmark::State & state )
+{
+    // the mesh is smaller than the voxel grid to keep the run time reasonable
+    const auto & mesh = torus( size_t( state.range( 0 ) ) / 10 );
+    OffsetParameters params;
+    params.voxelSize = suggestVoxelSize( mesh, float( state.range( 0 ) ) );
+    ThreadLimit limit( state.range( 1 ) );
+    for ( auto _ : state )
+    {
+        auto res = offsetMesh( mesh, 0.05f, params );
+        if ( !res )
+        {
+            state.SkipWithError( res.error().c_str() );
+            break;
+        }
+        benchmark::DoNotOptimize( res->topology.edgeSize() );
+    }
+    setCounters( state, size_t( state.range( 0 ) ), state.range( 1 ) );
+}
+BENCHMARK( BM_OffsetMesh )->Apply( sizesAndThreads )->Unit( benchmark::kMillisecond )->UseRealTime();
+
+} //anonymous namespace
+
+} //namespace MR::Bench
+#endif
@@ -78,6 +78,9 @@ namespace MR
             // TODO: partFaces
             /// minimum number of faces in one subdivision part for ( subdivideParts > 1 ) mode
             public int minFacesInPart = 0;
+            /// If true and subdivideParts > 1, then the mesh is subdivided on compact in space parts (subtrees of AABB tree),
+            /// so there is no need to call Mesh::PackOptimally before the decimation
+            public bool subdivideSpatially = false;
         };
 
         /// parameters for Remesh
@@ -170,6 +173,7 @@ namespace MR
             public int subdivideParts = 1;
             public byte decimateBetweenParts = 1;
             public int minFacesInPart = 0;
+            public byte subdivideSpatially = 0;
             public MRDecimateParameters() { }
         };
 
@@ -239,6 +243,7 @@ namespace MR
             mrParameters.decimateBetweenParts = settings.decimateBetweenParts ? (byte)1 : (byte)0;
             mrParameters.progressCallback = IntPtr.Zero;
             mrParameters.minFacesInPart = settings.minFacesInPart;
+            mrParameters.subdivideSpatially = settings.subdivideSpatially ? (byte)1 : (byte)0;
 
             return mrDecimateMesh(mesh.mesh_, ref mrParameters);
         }
@@ -4,12 +4,19 @@
 #include "MRMesh/MRBox.h"
 #include "MRMesh/MRColor.h"
 #include "MRMesh/MRIOFormatsRegistry.h"
+#include "MRMesh/MRMappedFile.h"
+#include "MRMesh/MRParallelFor.h"
 #include "MRMesh/MRPointCloud.h"
 #include "MRMesh/MRPointsLoadSettings.h"
 #include "MRMesh/MRProgressCallback.h"
 #include "MRMesh/MRStringConvert.h"
+#include "MRMesh/MRTimer.h"
 #include "MRPch/MRFmt.h"
 
+#include <atomic>
+#include <limits>
+#include <stdexcept>
+
 #if _MSC_VER >= 1937 // Visual Studio 2022 version 17.7
 #pragma warning( push )
 #pragma warning( disable: 5267 ) //definition of implicit copy constructor is deprecated because it has a user-provided destructor
@@ -263,10 +270,27 @@ Color getColor( uint8_t classification )
         return Color::black();
 }
 
-Expected<PointCloud> process( lazperf::reader::basic_file& reader, const PointsLoadSettings& settings )
+Box3d getBox( lazperf::reader::basic_file& reader )
 {
-    const auto pointCount = reader.pointCount();
+    const auto& header = reader.header();
+    return {
+        { header.minx, header.miny, header.minz },
+        { header.maxx, header.maxy, header.maxz },
+    };
+}
+
+/// the layout of points in LAS file and their transformation
+struct LasLayout
+{
+    int pointFormat = 0;
+    size_t recordLength = 0;
+    bool hasNormals = false;
+    Vector3d scale;
+    Vector3d offset;
+};
 
+Expected<LasLayout> prepare( lazperf::reader::basic_file& reader, const PointsLoadSettings& settings )
+{
     const auto& header = reader.header();
     const auto pointFormat = header.pointFormat();
     if ( pointFormat < 0 || pointFormat > 10 )
@@ -298,85 +322,266 @@ Expected<PointCloud> process( lazperf::reader::basic_file& reader, const PointsL
         return unexpected( fmt::format( "Too short LAS point+normal record length {} for point format {}, expected length {}",
             header.point_record_length, pointFormat, LasPointSize[pointFormat] + 3 * sizeof( double ) ) );
 
-    PointCloud result;
-    result.points.reserve( pointCount );
-    if ( settings.colors )
-        settings.colors->reserve( pointCount );
-    if ( hasNormals )
-        result.normals.reserve( pointCount );
-
-    Vector3d offset {
-        header.offset.x,
-        header.offset.y,
-        header.offset.z,
-    };
+    LasLayout res;
+    res.pointFormat = pointFormat;
+    res.recordLength = header.point_record_length;
+    res.hasNormals = hasNormals;
+    res.scale = { header.scale.x, header.scale.y, header.scale.z };
+    res.offset = { header.offset.x, header.offset.y, header.offset.z };
     if ( settings.outXf )
     {
-        const Box3d box {
-            { header.minx, header.miny, header.minz },
-            { header.maxx, header.maxy, header.maxz },
-        };
-        const auto center = box.center();
+        const auto center = getBox( reader ).center();
         *settings.outXf = AffineXf3f::translation( Vector3f( center ) );
-        offset -= center;
+        res.offset -= center;
     }
+    return res;
+}
 
-    auto colorsHave16Bits = false;
+/// decodes one point record and stores it in (result) at given index;
+/// if (colorsLo) is not null, then both variants of colors are stored in (colorsLo) and (colorsHi)
+void decodePoint( const char* rec, const LasLayout& layout, VertId v, PointCloud& result,
+    VertColors* colorsLo, VertColors* colorsHi, bool& colorsHave16Bits )
+{
+    const auto pointFormat = layout.pointFormat;
+    const auto point = getPoint( rec, pointFormat );
+    const Vector3d pos {
+        point.x * layout.scale.x + layout.offset.x,
+        point.y * layout.scale.y + layout.offset.y,
+        point.z * layout.scale.z + layout.offset.z,
+    };
+    result.points[v] = Vector3f( pos );
+
+    if ( colorsLo )
+    {
+        if ( hasColorChannels( pointFormat ) )
+        {
+            const auto colorChannels = *getColorChannels( rec, pointFormat );
+            // LAS stores color data in 16-bit per channel format, but most programs use 8-bit per channel.
+            // Some of them convert color values to the 16-bit format (by multiplying by 256), some save them as is.
+            // We have to support both approaches.
+            const Color colorLo {
+                colorChannels.red % 0x100,
+                colorChannels.green % 0x100,
+                colorChannels.blue % 0x100,
+            };
+            const Color colorHi {
+                colorChannels.red >> 8,
+                colorChannels.green >> 8,
+                colorChannels.blue >> 8,
+            };
+            colorsHave16Bits |= ( colorHi.r || colorHi.g || colorHi.b );
+            ( *colorsLo )[v] = colorLo;
+            ( *colorsHi )[v] = colorHi;
+        }
+        else
+        {
+            const auto color = getColor( getClassification( rec, pointFormat ) );
+            ( *colorsLo )[v] = color;
+            ( *colorsHi )[v] = color;
+        }
+
+        if ( layout.hasNormals )
+        {
+            Vector3d normal;
+            std::memcpy( &normal.x, rec + LasPointSize[pointFormat], 3 * sizeof( double ) );
+            result.normals[v] = Vector3f( normal );
+        }
+    }
+}
+
+/// resizes the arrays of the cloud and colors to store given number of points
+void resizePoints( size_t size, const LasLayout& layout, PointCloud& result, VertColors* colorsLo, VertColors* colorsHi )
+{
+    result.points.resizeNoInit( size );
+    if ( colorsLo )
+    {
+        colorsLo->resizeNoInit( size );
+        colorsHi->resizeNoInit( size );
+        if ( layout.hasNormals )
+            result.normals.resizeNoInit( size );
+    }
+}
+
+/// reads next (count) points from the reader and appends them to (result);
+/// if (colorsLo) is not null, then both variants of colors are appended to (colorsLo) and (colorsHi)
+void readPoints( lazperf::reader::basic_file& reader, const LasLayout& layout, size_t count, PointCloud& result,
+    VertColors* colorsLo, VertColors* colorsHi, bool& colorsHave16Bits, std::vector<char>& buf )
+{
+    buf.resize( layout.recordLength, '\0' );
+    const auto first = result.points.size();
+    resizePoints( first + count, layout, result, colorsLo, colorsHi );
+    for ( size_t i = 0; i < count; ++i )
+    {
+        reader.readPoint( buf.data() );
+        decodePoint( buf.data(), layout, VertId( first + i ), result, colorsLo, colorsHi, colorsHave16Bits );
+    }
+}
+
+/// the range of points in the file, which can be decoded independently of other points
+struct LasChunk
+{
+    size_t firstPoint = 0;
+    size_t numPoints = 0;
+    /// the position of chunk's data in the file
+    size_t offset = 0;
+};
+
+/// finds the chunks of points in the file mapped in memory, which can be decoded in parallel;
+/// returns empty vector if the points can be read only sequentially
+std::vector<LasChunk> findChunks( lazperf::reader::basic_file& reader, const LasLayout& layout, const char* data, size_t size, bool& compressed )
+{
+    std::vector<LasChunk> res;
+    const auto& header = reader.header();
+    const size_t pointCount = reader.pointCount();
+    const size_t pointOffset = header.point_offset;
+
+    const auto lazVlr = reader.vlrData( "laszip encoded", 22204 );
+    compressed = !lazVlr.empty();
+    if ( !compressed )
+    {
+        // the records of uncompressed points can be decoded from any position
+        if ( pointOffset + pointCount * layout.recordLength > size )
+            return res;
+        constexpr size_t cChunkSize = 65536;
+        for ( size_t first = 0; first < pointCount; first += cChunkSize )
+            res.push_back( { first, std::min( cChunkSize, pointCount - first ), pointOffset + first * layout.recordLength } );
+        return res;
+    }
+
+    // LAZ: the offset of the chunk table is written before the first chunk;
+    // the table contains the compressed sizes of chunks (and the numbers of points in them for variable chunks)
+    constexpr size_t cChunkSizeOffsetInVlr = 12;
+    if ( lazVlr.size() < cChunkSizeOffsetInVlr + sizeof( std::uint32_t ) || pointOffset + sizeof( std::int64_t ) > size )
+        return res;
+    std::uint32_t chunkSize = 0;
+    std::memcpy( &chunkSize, lazVlr.data() + cChunkSizeOffsetInVlr, sizeof( chunkSize ) );
+    const bool variable = chunkSize == std::numeric_limits<std::uint32_t>::max();
+
+    std::int64_t tableOffset = 0;
+    std::memcpy( &tableOffset, data + pointOffset, sizeof( tableOffset ) );
+    if ( tableOffset == -1 ) // the table offset was written in the end of file
+        std::memcpy( &tableOffset, data + size - sizeof( std::int64_t ), sizeof( tableOffset ) );
+    if ( tableOffset <= std::int64_t( pointOffset ) || size_t( tableOffset ) + 2 * sizeof( std::uint32_t ) > size )
+        return res;
+
+    std::uint32_t numChunks = 0;
+    std::memcpy( &numChunks, data + tableOffset + sizeof( std::uint32_t ), sizeof( numChunks ) );
+    size_t pos = size_t( tableOffset ) + 2 * sizeof( std::uint32_t );
+    const lazperf::InputCb readTable = [&] ( unsigned char* buf, size_t len )
+    {
+        if ( pos + len > size )
+            throw std::runtime_error( "Truncated LAZ chunk table" );
+        std::memcpy( buf, data + pos, len );
+        pos += len;
+    };
+    std::vector<lazperf::chunk> table;
+    try
+    {
+        table = lazperf::decompress_chunk_table( readTable, numChunks, variable );
+    }
+    catch ( const std::exception& )
+    {
+        return res; // a damaged table does not prevent sequential reading of the points
+    }
+
+    size_t firstPoint = 0;
+    size_t offset = pointOffset + sizeof( std::int64_t );
+    for ( const auto& c : table )
+    {
+        if ( firstPoint >= pointCount )
+            break;
+        const size_t numPoints = variable ? size_t( c.count ) : std::min( size_t( chunkSize ), pointCount - firstPoint );
+        res.push_back( { firstPoint, numPoints, offset } );
+        firstPoint += numPoints;
+        offset += size_t( c.offset ); // the size of compressed chunk
+    }
+    if ( firstPoint != pointCount || offset > size_t( tableOffset ) )
+        res.clear();
+    return res;
+}
+
+/// decodes the points of LAS/LAZ file mapped in memory in parallel;
+/// returns std::nullopt if the points of this file can be read only sequentially
+std::optional<Expected<PointCloud>> processInParallel( lazperf::reader::basic_file& reader, const char* data, size_t size, const PointsLoadSettings& settings )
+{
+    MR_TIMER;
+    const auto layout = prepare( reader, settings );
+    if ( !layout )
+        return unexpected( layout.error() );
+    bool compressed = false;
+    const auto chunks = findChunks( reader, *layout, data, size, compressed );
+    if ( chunks.empty() )
+        return std::nullopt;
+
+    PointCloud result;
     std::optional<VertColors> colorsHi;
     if ( settings.colors )
         colorsHi.emplace();
+    resizePoints( reader.pointCount(), *layout, result, settings.colors, colorsHi ? &*colorsHi : nullptr );
 
-    std::vector<char> buf( header.point_record_length, '\0' );
-    for ( auto i = 0; i < pointCount; ++i )
+    const int extraBytesCount = int( layout->recordLength - LasPointSize[layout->pointFormat] );
+    std::atomic<bool> colorsHave16Bits{ false };
+    const bool keepGoing = ParallelFor( chunks, [&] ( size_t i )
     {
-        if ( i % 4096 == 0 )
-            reportProgress( settings.callback, (float)i / (float)pointCount );
-
-        reader.readPoint( buf.data() );
-        const auto point = getPoint( buf.data(), pointFormat );
-        const Vector3d pos {
-            point.x * header.scale.x + offset.x,
-            point.y * header.scale.y + offset.y,
-            point.z * header.scale.z + offset.z,
-        };
-        result.points.emplace_back( pos );
-
-        if ( settings.colors )
+        const auto& chunk = chunks[i];
+        // each chunk of LAZ file is compressed independently, and its decompressor starts from the beginning of chunk
+        std::optional<lazperf::reader::chunk_decompressor> decompressor;
+        std::vector<char> buf;
+        if ( compressed )
         {
-            if ( hasColorChannels( pointFormat ) )
-            {
-                const auto colorChannels = *getColorChannels( buf.data(), pointFormat );
-                // LAS stores color data in 16-bit per channel format, but most programs use 8-bit per channel.
-                // Some of them convert color values to the 16-bit format (by multiplying by 256), some save them as is.
-                // We have to support both approaches.
-                const Color colorLo {
-                    colorChannels.red % 0x100,
-                    colorChannels.green % 0x100,
-                    colorChannels.blue % 0x100,
-                };
-                const Color colorHi {
-                    colorChannels.red >> 8,
-                    colorChannels.green >> 8,
-                    colorChannels.blue >> 8,
-                };
-                colorsHave16Bits |= ( colorHi.r || colorHi.g || colorHi.b );
-                settings.colors->emplace_back( colorLo );
-                colorsHi->emplace_back( colorHi );
-            }
-            else
-            {
-                const auto color = getColor( getClassification( buf.data(), pointFormat ) );
-                settings.colors->emplace_back( color );
-                colorsHi->emplace_back( color );
-            }
-
-            if ( hasNormals )
+            decompressor.emplace( layout->pointFormat, extraBytesCount, data + chunk.offset );
+            buf.resize( layout->recordLength, '\0' );
+        }
+        bool have16Bits = false;
+        for ( size_t j = 0; j < chunk.numPoints; ++j )
+        {
+            const char* rec = data + chunk.offset + j * layout->recordLength;
+            if ( decompressor )
             {
-                Vector3d normal;
-                std::memcpy( &normal.x, buf.data() + LasPointSize[pointFormat], 3 * sizeof( double ) );
-                result.normals.push_back( Vector3f( normal ) );
+                decompressor->decompress( buf.data() );
+                rec = buf.data();
             }
+            decodePoint( rec, *layout, VertId( chunk.firstPoint + j ), result, settings.colors, colorsHi ? &*colorsHi : nullptr, have16Bits );
         }
+        if ( have16Bits )
+            colorsHave16Bits = true;
+    }, settings.callback, 1 );
+    if ( !keepGoing )
+        return unexpectedOperationCanceled();
+
+    if ( settings.colors && colorsHave16Bits )
+        std::swap( *settings.colors, *colorsHi );
+
+    result.validPoints.resize( result.points.size(), true );
+    return result;
+}
+
+Expected<PointCloud> process( lazperf::reader::basic_file& reader, const PointsLoadSettings& settings )
+{
+    const size_t pointCount = reader.pointCount();
+    const auto layout = prepare( reader, settings );
+    if ( !layout )
+        return unexpected( layout.error() );
+
+    PointCloud result;
+    result.points.reserve( pointCount );
+    if ( settings.colors )
+        settings.colors->reserve( pointCount );
+    if ( settings.colors && layout->hasNormals )
+        result.normals.reserve( pointCount );
+
+    auto colorsHave16Bits = false;
+    std::optional<VertColors> colorsHi;
+    if ( settings.colors )
+        colorsHi.emplace();
+
+    std::vector<char> buf;
+    constexpr size_t cReportEvery = 4096;
+    for ( size_t i = 0; i < pointCount; i += cReportEvery )
+    {
+        reportProgress( settings.callback, (float)i / (float)pointCount );
+        readPoints( reader, *layout, std::min( cReportEvery, pointCount - i ), result,
+            settings.colors, colorsHi ? &*colorsHi : nullptr, colorsHave16Bits, buf );
     }
 
     if ( settings.colors && colorsHave16Bits )
@@ -390,6 +595,41 @@ Expected<PointCloud> process( lazperf::reader::basic_file& reader, const PointsL
     return result;
 }
 
+Expected<void> processByParts( lazperf::reader::basic_file& reader, const PointsLoad::LasPartCallback& onPart,
+    const PointsLoadSettings& settings, size_t partSize )
+{
+    const size_t pointCount = reader.pointCount();
+    const auto layout = prepare( reader, settings );
+    if ( !layout )
+        return unexpected( layout.error() );
+
+    partSize = std::max( partSize, size_t( 1 ) );
+    PointCloud part;
+    VertColors colorsLo, colorsHi;
+    const bool needColors = settings.colors != nullptr;
+    std::optional<bool> colorsHave16Bits;
+    std::vector<char> buf;
+    for ( size_t i = 0; i < pointCount; i += partSize )
+    {
+        if ( !reportProgress( settings.callback, (float)i / (float)pointCount ) )
+            return unexpectedOperationCanceled();
+        part.points.clear();
+        part.normals.clear();
+        colorsLo.clear();
+        colorsHi.clear();
+        bool have16Bits = false;
+        readPoints( reader, *layout, std::min( partSize, pointCount - i ), part,
+            needColors ? &colorsLo : nullptr, needColors ? &colorsHi : nullptr, have16Bits, buf );
+        // the depth of colors is detected on the first part to have the same conversion in all parts
+        if ( !colorsHave16Bits )
+            colorsHave16Bits = have16Bits;
+        part.validPoints.clear();
+        part.validPoints.resize( part.points.size(), true );
+        if ( auto res = onPart( part, needColors ? ( *colorsHave16Bits ? &colorsHi : &colorsLo ) : nullptr ); !res )
+            return res;
+    }
+    return {};
+}
 }
 
 namespace MR::PointsLoad
@@ -400,6 +640,13 @@ Expected<PointCloud> fromLas( const std::filesystem::path& file, const PointsLoa
     try
     {
         lazperf::reader::named_file reader( utf8string( file ) );
+        // the points are decoded in parallel directly from the file mapped in memory if possible
+        MappedFile mapped;
+        if ( mapped.open( file ) )
+        {
+            if ( auto res = processInParallel( reader, mapped.data(), mapped.size(), settings ) )
+                return std::move( *res );
+        }
         return process( reader, settings );
     }
     catch ( const std::exception& exc )
@@ -421,6 +668,51 @@ Expected<PointCloud> fromLas( std::istream& in, const PointsLoadSettings& settin
     }
 }
 
+Expected<void> fromLasByParts( const std::filesystem::path& file, const LasPartCallback& onPart, const PointsLoadSettings& settings, size_t partSize )
+{
+    try
+    {
+        lazperf::reader::named_file reader( utf8string( file ) );
+        return processByParts( reader, onPart, settings, partSize );
+    }
+    catch ( const std::exception& exc )
+    {
+        return unexpected( fmt::format( "Failed to read file: {}", exc.what() ) );
+    }
+}
+
+Expected<TiledPointCloud> lasToTiledPointCloud( const std::filesystem::path& file, const std::filesystem::path& folder,
+    const TiledPointCloudSettings& tiledSettings, const PointsLoadSettings& settings )
+{
+    MR_TIMER;
+    Box3f box;
+    try
+    {
+        lazperf::reader::named_file reader( utf8string( file ) );
+        const auto boxd = getBox( reader );
+        // the points are shifted by the center of the box if the transformation is requested
+        const auto shift = settings.outXf ? boxd.center() : Vector3d();
+        box = Box3f( Vector3f( boxd.min - shift ), Vector3f( boxd.max - shift ) );
+    }
+    catch ( const std::exception& exc )
+    {
+        return unexpected( fmt::format( "Failed to read file: {}", exc.what() ) );
+    }
+
+    TiledPointCloudBuilder builder( folder, box, tiledSettings );
+    VertColors colors;
+    auto partSettings = settings;
+    partSettings.colors = tiledSettings.colors ? &colors : nullptr;
+    partSettings.callback = subprogress( settings.callback, 0.0f, 0.8f );
+    auto added = fromLasByParts( file, [&]( const PointCloud& part, const VertColors* partColors )
+    {
+        return builder.addPoints( part.points, partColors );
+    }, partSettings );
+    if ( !added )
+        return unexpected( std::move( added.error() ) );
+    return builder.finish( subprogress( settings.callback, 0.8f, 1.0f ) );
+}
+
 MR_ADD_POINTS_LOADER( IOFilter( "LAS (.las)", "*.las" ), fromLas )
 MR_ADD_POINTS_LOADER( IOFilter( "LASzip (.laz)", "*.laz" ), fromLas )
 
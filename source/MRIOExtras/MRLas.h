@@ -6,8 +6,10 @@
 
 #include <MRMesh/MRExpected.h>
 #include <MRMesh/MRPointsLoadSettings.h>
+#include <MRMesh/MRTiledPointCloud.h>
 
 #include <filesystem>
+#include <functional>
 
 namespace MR
 {
@@ -19,6 +21,21 @@ namespace PointsLoad
 MRIOEXTRAS_API Expected<PointCloud> fromLas( const std::filesystem::path& file, const PointsLoadSettings& settings = {} );
 MRIOEXTRAS_API Expected<PointCloud> fromLas( std::istream& in, const PointsLoadSettings& settings = {} );
 
+/// receives next part of points read from a file, and their colors if they were requested
+using LasPartCallback = std::function<Expected<void>( const PointCloud& part, const VertColors* colors )>;
+
+/// reads .las file part by part without keeping all points in memory, and passes each part in given callback;
+/// if settings.colors is not null then the colors of each part are passed in the callback (and settings.colors itself is not filled);
+/// the bit depth of colors is detected on the first part
+MRIOEXTRAS_API Expected<void> fromLasByParts( const std::filesystem::path& file, const LasPartCallback& onPart,
+    const PointsLoadSettings& settings = {}, size_t partSize = size_t( 1 ) << 20 );
+
+/// builds out-of-core tiled point cloud in given folder from .las file reading it part by part;
+/// the root box of the tiled cloud is taken from the header of the file;
+/// settings.colors is ignored, the colors are stored if tiledSettings.colors is set
+MRIOEXTRAS_API Expected<TiledPointCloud> lasToTiledPointCloud( const std::filesystem::path& file, const std::filesystem::path& folder,
+    const TiledPointCloudSettings& tiledSettings = {}, const PointsLoadSettings& settings = {} );
+
 } // namespace PointsLoad
 
 } // namespace MR
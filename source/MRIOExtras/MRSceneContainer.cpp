@@ -0,0 +1,573 @@
+#include "MRSceneContainer.h"
+#ifndef MRIOEXTRAS_NO_ZLIB
+#include "MRMesh/MRBuffer.h"
+#include "MRMesh/MRDirectory.h"
+#include "MRMesh/MRIOFormatsRegistry.h"
+#include "MRMesh/MRObjectLoad.h"
+#include "MRMesh/MRObjectSave.h"
+#include "MRMesh/MRParallelFor.h"
+#include "MRMesh/MRphmap.h"
+#include "MRMesh/MRStringConvert.h"
+#include "MRMesh/MRTimer.h"
+#include "MRMesh/MRUniqueTemporaryFolder.h"
+#include "MRPch/MRTBB.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+
+namespace
+{
+
+using namespace MR;
+
+constexpr char cHeaderMagic[8] = { 'M', 'R', 'S', 'C', 'E', 'N', 'E', 0 };
+constexpr char cFooterMagic[8] = { 'M', 'R', 'S', 'C', 'T', 'O', 'C', 0 };
+constexpr std::uint32_t cVersion = 1;
+constexpr size_t cHeaderSize = sizeof( cHeaderMagic ) + 2 * sizeof( std::uint32_t );
+constexpr size_t cFooterSize = sizeof( std::uint64_t ) + sizeof( cFooterMagic );
+
+template <typename T>
+void writePod( std::ostream& out, const T& v )
+{
+    out.write( (const char*)&v, sizeof( T ) );
+}
+
+/// reads plain values from the table of contents in memory with bounds checking
+class TocReader
+{
+public:
+    TocReader( const char* data, size_t size ) : data_( data ), size_( size ) {}
+
+    template <typename T>
+    bool read( T& v )
+    {
+        if ( pos_ + sizeof( T ) > size_ )
+            return false;
+        std::memcpy( &v, data_ + pos_, sizeof( T ) );
+        pos_ += sizeof( T );
+        return true;
+    }
+
+    bool read( std::string& s, size_t len )
+    {
+        if ( pos_ + len > size_ )
+            return false;
+        s.assign( data_ + pos_, len );
+        pos_ += len;
+        return true;
+    }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    size_t pos_ = 0;
+};
+
+/// one block of a file, which is compressed or decompressed by a task
+struct BlockJob
+{
+    size_t entry = 0;
+    size_t block = 0;
+};
+
+/// collects the error of the first failed job from parallel threads
+class FirstError
+{
+public:
+    void set( size_t job, std::string error )
+    {
+        failed_ = true;
+        std::unique_lock lock( mutex_ );
+        if ( job < job_ )
+        {
+            job_ = job;
+            error_ = std::move( error );
+        }
+    }
+    bool failed() const { return failed_.load( std::memory_order_relaxed ); }
+    std::string take() { return std::move( error_ ); }
+
+private:
+    std::atomic<bool> failed_{ false };
+    std::mutex mutex_;
+    size_t job_ = SIZE_MAX;
+    std::string error_;
+};
+
+/// the number of blocks processed in parallel before writing them sequentially, limits the memory for block buffers
+size_t blocksInBatch()
+{
+    return 2 * size_t( std::max( 1, tbb::this_task_arena::max_concurrency() ) );
+}
+
+/// reads given block from the container and decompresses it in (out), which must have block.size bytes
+Expected<void> readBlock( const std::filesystem::path& file, const SceneContainerEntry::Block& block, char* out )
+{
+    std::ifstream in( file, std::ifstream::binary );
+    in.seekg( block.offset );
+    if ( block.compressedSize == block.size )
+    {
+        // stored without compression
+        if ( !in.read( out, block.size ) )
+            return unexpected( std::string( "Cannot read block from scene container" ) );
+        return {};
+    }
+
+    Buffer<char> compressed( block.compressedSize );
+    if ( !in.read( compressed.data(), compressed.size() ) )
+        return unexpected( std::string( "Cannot read block from scene container" ) );
+
+    uLongf destLen = uLongf( block.size );
+    const auto ret = uncompress( (Bytef*)out, &destLen, (const Bytef*)compressed.data(), uLong( compressed.size() ) );
+    if ( ret != Z_OK || destLen != block.size )
+        return unexpected( std::string( "Cannot decompress block from scene container" ) );
+    return {};
+}
+
+/// entry names must be relative paths with '/' separators not leaving the folder of extraction;
+/// backslashes are rejected since they are separators on Windows (as well as drive letters and UNC prefixes)
+bool isSafeEntryName( const std::string& name )
+{
+    if ( name.empty() || name.front() == '/' || name.find_first_of( ":\\" ) != std::string::npos )
+        return false;
+    size_t pos = 0;
+    while ( pos <= name.size() )
+    {
+        auto next = name.find( '/', pos );
+        if ( next == std::string::npos )
+            next = name.size();
+        if ( name.compare( pos, next - pos, ".." ) == 0 )
+            return false;
+        pos = next + 1;
+    }
+    return true;
+}
+
+/// the model files of a scene, which are extracted from the container in the temporary folder only when requested
+class SceneContainerModelFiles : public SceneModelFiles
+{
+public:
+    explicit SceneContainerModelFiles( SceneContainerReader reader ) : reader_( std::move( reader ) ) {}
+
+    [[nodiscard]] const SceneContainerReader& reader() const { return reader_; }
+    [[nodiscard]] const std::filesystem::path& folder() const { return folder_; }
+
+    Expected<void> fetch( const std::filesystem::path& modelPath ) const override
+    {
+        // the file of the model is named by its path with any extension
+        auto prefix = utf8string( modelPath.lexically_relative( folder_ ) );
+        std::replace( prefix.begin(), prefix.end(), '\\', '/' );
+        prefix += '.';
+
+        std::unique_lock lock( mutex_ );
+        std::vector<std::string> names;
+        auto res = reader_.extract( folder_, [&] ( const SceneContainerEntry& entry )
+        {
+            if ( !entry.name.starts_with( prefix ) || entry.name.find( '/', prefix.size() ) != std::string::npos
+                || extracted_.contains( entry.name ) )
+                return false;
+            names.push_back( entry.name );
+            return true;
+        } );
+        if ( !res )
+            return res;
+        for ( auto& name : names )
+            extracted_.insert( std::move( name ) );
+        return {};
+    }
+
+private:
+    SceneContainerReader reader_;
+    UniqueTemporaryFolder folder_{ {} };
+    mutable std::mutex mutex_;
+    mutable HashSet<std::string> extracted_;
+};
+
+} // anonymous namespace
+
+namespace MR
+{
+
+Expected<void> packFolderInSceneContainer( const std::filesystem::path& folder, const std::filesystem::path& file,
+    const SceneContainerSaveSettings& settings, ProgressCallback cb )
+{
+    MR_TIMER;
+    assert( settings.blockSize > 0 );
+
+    std::error_code ec;
+    if ( !std::filesystem::is_directory( folder, ec ) )
+        return unexpected( "Directory '" + utf8string( folder ) + "' does not exist" );
+
+    std::vector<std::filesystem::path> paths;
+    std::vector<SceneContainerEntry> entries;
+    for ( auto entry : DirectoryRecursive{ folder, ec } )
+    {
+        if ( !entry.is_regular_file( ec ) )
+            continue;
+        auto name = utf8string( std::filesystem::relative( entry.path(), folder, ec ) );
+        std::replace( name.begin(), name.end(), '\\', '/' );
+        paths.push_back( entry.path() );
+        entries.push_back( { .name = std::move( name ), .size = std::uint64_t( entry.file_size( ec ) ) } );
+    }
+
+    std::vector<BlockJob> jobs;
+    std::uint64_t totalSize = 0;
+    for ( size_t e = 0; e < entries.size(); ++e )
+    {
+        auto& entry = entries[e];
+        for ( std::uint64_t pos = 0; pos < entry.size; pos += settings.blockSize )
+        {
+            jobs.push_back( { .entry = e, .block = entry.blocks.size() } );
+            entry.blocks.push_back( { .size = std::min<std::uint64_t>( settings.blockSize, entry.size - pos ) } );
+        }
+        totalSize += entry.size;
+    }
+
+    std::ofstream out( file, std::ofstream::binary );
+    if ( !out )
+        return unexpected( "Cannot open file for writing " + utf8string( file ) );
+    out.write( cHeaderMagic, sizeof( cHeaderMagic ) );
+    writePod( out, cVersion );
+    writePod( out, std::uint32_t( 0 ) ); // reserved
+
+    const auto batchSize = blocksInBatch();
+    std::vector<Buffer<char>> compressed( std::min( batchSize, jobs.size() ) );
+    std::uint64_t offset = cHeaderSize;
+    std::uint64_t packedSize = 0;
+    for ( size_t first = 0; first < jobs.size(); first += batchSize )
+    {
+        const auto last = std::min( jobs.size(), first + batchSize );
+        FirstError error;
+        ParallelFor( first, last, [&] ( size_t j )
+        {
+            if ( error.failed() )
+                return;
+            const auto& job = jobs[j];
+            auto& block = entries[job.entry].blocks[job.block];
+            const auto& path = paths[job.entry];
+
+            Buffer<char> raw( block.size );
+            std::ifstream in( path, std::ifstream::binary );
+            in.seekg( job.block * settings.blockSize );
+            if ( !in.read( raw.data(), raw.size() ) )
+                return error.set( j, "Cannot read file " + utf8string( path ) );
+
+            auto& res = compressed[j - first];
+            uLongf destLen = compressBound( uLong( raw.size() ) );
+            res.resize( destLen );
+            const auto ret = compress2( (Bytef*)res.data(), &destLen, (const Bytef*)raw.data(), uLong( raw.size() ), settings.compressionLevel );
+            if ( ret != Z_OK )
+                return error.set( j, "Cannot compress file " + utf8string( path ) );
+            if ( destLen >= raw.size() )
+            {
+                // incompressible data are stored as is, which is indicated by equal sizes
+                res = std::move( raw );
+                block.compressedSize = block.size;
+            }
+            else
+                block.compressedSize = destLen;
+        } );
+        if ( error.failed() )
+            return unexpected( error.take() );
+
+        for ( size_t j = first; j < last; ++j )
+        {
+            const auto& job = jobs[j];
+            auto& block = entries[job.entry].blocks[job.block];
+            block.offset = offset;
+            out.write( compressed[j - first].data(), block.compressedSize );
+            offset += block.compressedSize;
+            packedSize += block.size;
+        }
+        if ( !out )
+            return unexpected( "Cannot write file " + utf8string( file ) );
+        if ( !reportProgress( cb, float( packedSize ) / float( totalSize ) ) )
+            return unexpectedOperationCanceled();
+    }
+
+    // table of contents
+    const auto tocOffset = offset;
+    writePod( out, std::uint64_t( entries.size() ) );
+    for ( const auto& entry : entries )
+    {
+        writePod( out, std::uint32_t( entry.name.size() ) );
+        out.write( entry.name.data(), entry.name.size() );
+        writePod( out, entry.size );
+        writePod( out, std::uint64_t( entry.blocks.size() ) );
+        for ( const auto& block : entry.blocks )
+        {
+            writePod( out, block.offset );
+            writePod( out, block.compressedSize );
+            writePod( out, block.size );
+        }
+    }
+    writePod( out, tocOffset );
+    out.write( cFooterMagic, sizeof( cFooterMagic ) );
+
+    if ( !out )
+        return unexpected( "Cannot write file " + utf8string( file ) );
+    if ( !reportProgress( cb, 1.0f ) )
+        return unexpectedOperationCanceled();
+    return {};
+}
+
+Expected<void> SceneContainerReader::open( const std::filesystem::path& file )
+{
+    MR_TIMER;
+    file_.clear();
+    entries_.clear();
+
+    std::ifstream in( file, std::ifstream::binary );
+    if ( !in )
+        return unexpected( "Cannot open file for reading " + utf8string( file ) );
+
+    std::error_code ec;
+    const auto fileSize = std::filesystem::file_size( file, ec );
+    if ( ec || fileSize < cHeaderSize + cFooterSize )
+        return unexpected( std::string( "Scene container is too short" ) );
+
+    char magic[8];
+    std::uint32_t version = 0;
+    in.read( magic, sizeof( magic ) );
+    in.read( (char*)&version, sizeof( version ) );
+    if ( !in || std::memcmp( magic, cHeaderMagic, sizeof( magic ) ) != 0 )
+        return unexpected( std::string( "File is not a scene container" ) );
+    if ( version > cVersion )
+        return unexpected( "Unsupported version of scene container: " + std::to_string( version ) );
+
+    std::uint64_t tocOffset = 0;
+    in.seekg( fileSize - cFooterSize );
+    in.read( (char*)&tocOffset, sizeof( tocOffset ) );
+    in.read( magic, sizeof( magic ) );
+    if ( !in || std::memcmp( magic, cFooterMagic, sizeof( magic ) ) != 0 )
+        return unexpected( std::string( "Scene container has no table of contents" ) );
+    if ( tocOffset < cHeaderSize || tocOffset > fileSize - cFooterSize )
+        return unexpected( std::string( "Scene container has invalid table of contents" ) );
+
+    Buffer<char> toc( fileSize - cFooterSize - tocOffset );
+    in.seekg( tocOffset );
+    if ( !in.read( toc.data(), toc.size() ) )
+        return unexpected( std::string( "Cannot read table of contents of scene container" ) );
+
+    TocReader reader( toc.data(), toc.size() );
+    const auto tocError = [] { return unexpected( std::string( "Scene container has invalid table of contents" ) ); };
+    std::uint64_t numEntries = 0;
+    if ( !reader.read( numEntries ) || numEntries > toc.size() )
+        return tocError();
+    std::vector<SceneContainerEntry> entries( numEntries );
+    for ( auto& entry : entries )
+    {
+        std::uint32_t nameLen = 0;
+        std::uint64_t numBlocks = 0;
+        if ( !reader.read( nameLen ) || !reader.read( entry.name, nameLen ) || !reader.read( entry.size ) || !reader.read( numBlocks ) )
+            return tocError();
+        if ( !isSafeEntryName( entry.name ) || numBlocks > toc.size() )
+            return tocError();
+        entry.blocks.resize( numBlocks );
+        std::uint64_t sumSize = 0;
+        for ( auto& block : entry.blocks )
+        {
+            if ( !reader.read( block.offset ) || !reader.read( block.compressedSize ) || !reader.read( block.size ) )
+                return tocError();
+            if ( block.offset < cHeaderSize || block.compressedSize > tocOffset || block.offset > tocOffset - block.compressedSize )
+                return tocError();
+            sumSize += block.size;
+        }
+        if ( sumSize != entry.size )
+            return tocError();
+    }
+
+    file_ = file;
+    entries_ = std::move( entries );
+    return {};
+}
+
+int SceneContainerReader::findEntry( const std::string& name ) const
+{
+    for ( int i = 0; i < (int)entries_.size(); ++i )
+        if ( entries_[i].name == name )
+            return i;
+    return -1;
+}
+
+Expected<std::string> SceneContainerReader::readEntry( size_t index, ProgressCallback cb ) const
+{
+    MR_TIMER;
+    if ( index >= entries_.size() )
+        return unexpected( std::string( "Invalid entry of scene container" ) );
+    const auto& entry = entries_[index];
+
+    std::vector<std::uint64_t> blockPos( entry.blocks.size(), 0 );
+    for ( size_t b = 1; b < entry.blocks.size(); ++b )
+        blockPos[b] = blockPos[b - 1] + entry.blocks[b - 1].size;
+
+    std::string res;
+    res.resize( entry.size );
+    FirstError error;
+    const auto keepGoing = ParallelFor( entry.blocks, [&] ( size_t b )
+    {
+        if ( error.failed() )
+            return;
+        if ( auto r = readBlock( file_, entry.blocks[b], res.data() + blockPos[b] ); !r )
+            error.set( b, std::move( r.error() ) );
+    }, cb, 1 );
+    if ( error.failed() )
+        return unexpected( error.take() );
+    if ( !keepGoing )
+        return unexpectedOperationCanceled();
+    return res;
+}
+
+Expected<void> SceneContainerReader::extract( const std::filesystem::path& folder,
+    const std::function<bool( const SceneContainerEntry& )>& filter, ProgressCallback cb ) const
+{
+    MR_TIMER;
+    std::error_code ec;
+    if ( !std::filesystem::is_directory( folder, ec ) )
+        return unexpected( "Directory does not exist " + utf8string( folder ) );
+
+    std::vector<BlockJob> jobs;
+    std::vector<size_t> selected;
+    std::uint64_t totalSize = 0;
+    for ( size_t e = 0; e < entries_.size(); ++e )
+    {
+        const auto& entry = entries_[e];
+        if ( filter && !filter( entry ) )
+            continue;
+        selected.push_back( e );
+        for ( size_t b = 0; b < entry.blocks.size(); ++b )
+            jobs.push_back( { .entry = e, .block = b } );
+        totalSize += entry.size;
+    }
+
+    // create all selected files, including empty ones
+    std::vector<std::filesystem::path> paths( entries_.size() );
+    for ( auto e : selected )
+    {
+        auto path = folder / pathFromUtf8( entries_[e].name );
+        path.make_preferred();
+        std::filesystem::create_directories( path.parent_path(), ec );
+        std::ofstream ofs( path, std::ofstream::binary );
+        if ( !ofs )
+            return unexpected( "Cannot create file " + utf8string( path ) );
+        paths[e] = std::move( path );
+    }
+
+    const auto batchSize = blocksInBatch();
+    std::vector<Buffer<char>> decompressed( std::min( batchSize, jobs.size() ) );
+    std::ofstream out;
+    size_t outEntry = SIZE_MAX;
+    std::uint64_t extractedSize = 0;
+    for ( size_t first = 0; first < jobs.size(); first += batchSize )
+    {
+        const auto last = std::min( jobs.size(), first + batchSize );
+        FirstError error;
+        ParallelFor( first, last, [&] ( size_t j )
+        {
+            if ( error.failed() )
+                return;
+            const auto& block = entries_[jobs[j].entry].blocks[jobs[j].block];
+            auto& buf = decompressed[j - first];
+            buf.resize( block.size );
+            if ( auto r = readBlock( file_, block, buf.data() ); !r )
+                error.set( j, std::move( r.error() ) );
+        } );
+        if ( error.failed() )
+            return unexpected( error.take() );
+
+        // the blocks of each file go one after another
+        for ( size_t j = first; j < last; ++j )
+        {
+            if ( jobs[j].entry != outEntry )
+            {
+                out.close();
+                outEntry = jobs[j].entry;
+                out.open( paths[outEntry], std::ofstream::binary );
+            }
+            const auto& buf = decompressed[j - first];
+            out.write( buf.data(), buf.size() );
+            if ( !out )
+                return unexpected( "Cannot write file " + utf8string( paths[outEntry] ) );
+            extractedSize += buf.size();
+        }
+        if ( !reportProgress( cb, float( extractedSize ) / float( totalSize ) ) )
+            return unexpectedOperationCanceled();
+    }
+    out.close();
+    if ( !reportProgress( cb, 1.0f ) )
+        return unexpectedOperationCanceled();
+    return {};
+}
+
+Expected<void> serializeObjectTreeToSceneContainer( const Object& object, const std::filesystem::path& file, ProgressCallback callback )
+{
+    MR_TIMER;
+    UniqueTemporaryFolder scenePath( {} );
+    if ( !scenePath )
+        return unexpected( "Cannot create temporary folder" );
+
+    if ( auto res = serializeObjectTreeToFolder( object, scenePath, subprogress( callback, 0.0f, 0.6f ) ); !res )
+        return res;
+
+    return packFolderInSceneContainer( scenePath, file, {}, subprogress( callback, 0.6f, 1.0f ) );
+}
+
+Expected<LoadedObject> deserializeObjectTreeFromSceneContainer( const std::filesystem::path& file, const ProgressCallback& callback )
+{
+    return deserializeObjectTreeFromSceneContainer( file, DeferModels::Never, callback );
+}
+
+Expected<LoadedObject> deserializeObjectTreeFromSceneContainer( const std::filesystem::path& file, DeferModels deferModels,
+    const ProgressCallback& callback )
+{
+    MR_TIMER;
+    SceneContainerReader reader;
+    if ( auto res = reader.open( file ); !res )
+        return unexpected( std::move( res.error() ) );
+
+    if ( deferModels == DeferModels::Never )
+    {
+        UniqueTemporaryFolder scenePath( {} );
+        if ( !scenePath )
+            return unexpected( "Cannot create temporary folder" );
+
+        if ( auto res = reader.extract( scenePath, {}, subprogress( callback, 0.0f, 0.4f ) ); !res )
+            return unexpected( std::move( res.error() ) );
+
+        return deserializeObjectTreeFromFolder( scenePath, subprogress( callback, 0.4f, 1.0f ) );
+    }
+
+    // only the descriptions of objects are extracted now, and the models are extracted when they are loaded;
+    // empty files are created in place of not extracted ones to let the objects find their models
+    auto modelFiles = std::make_shared<SceneContainerModelFiles>( std::move( reader ) );
+    const auto& scenePath = modelFiles->folder();
+    if ( scenePath.empty() )
+        return unexpected( "Cannot create temporary folder" );
+
+    const auto isDescription = [] ( const SceneContainerEntry& entry ) { return entry.name.ends_with( ".json" ); };
+    if ( auto res = modelFiles->reader().extract( scenePath, isDescription ); !res )
+        return unexpected( std::move( res.error() ) );
+    std::error_code ec;
+    for ( const auto& entry : modelFiles->reader().entries() )
+    {
+        if ( isDescription( entry ) )
+            continue;
+        auto path = scenePath / pathFromUtf8( entry.name );
+        path.make_preferred();
+        std::filesystem::create_directories( path.parent_path(), ec );
+        if ( !std::ofstream( path, std::ofstream::binary ) )
+            return unexpected( "Cannot create file " + utf8string( path ) );
+    }
+
+    return deserializeObjectTreeFromFolder( scenePath, callback, deferModels, std::move( modelFiles ) );
+}
+
+MR_ADD_SCENE_LOADER( IOFilter( "MeshLib binary scene (.mrscene)", "*.mrscene" ), deserializeObjectTreeFromSceneContainer )
+MR_ADD_SCENE_SAVER( IOFilter( "MeshLib binary scene (.mrscene)", "*.mrscene" ), serializeObjectTreeToSceneContainer )
+
+} // namespace MR
+#endif
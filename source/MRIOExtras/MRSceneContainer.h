@@ -0,0 +1,100 @@
+#pragma once
+
+#include "config.h"
+#ifndef MRIOEXTRAS_NO_ZLIB
+#include "exports.h"
+
+#include <MRMesh/MRExpected.h>
+#include <MRMesh/MRLoadedObjects.h>
+#include <MRMesh/MRObject.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace MR
+{
+
+/// parameters of packing files in binary scene container
+struct SceneContainerSaveSettings
+{
+    /// the compression level of zlib: 0 - no compression, 1 - the fastest, 9 - the strongest, -1 - default level
+    int compressionLevel = -1;
+
+    /// each file is split on the blocks of this size, which are compressed independently and in parallel,
+    /// so even a single large file is compressed by all threads
+    size_t blockSize = size_t( 4 ) << 20; // 4 MiB
+};
+
+/// one file stored in binary scene container
+struct SceneContainerEntry
+{
+    /// the path of the file relative to the packed folder in UTF-8 with '/' separators
+    std::string name;
+
+    /// the size of the file before compression
+    std::uint64_t size = 0;
+
+    struct Block
+    {
+        std::uint64_t offset = 0; ///< the position of compressed data in the container
+        std::uint64_t compressedSize = 0; ///< equal to size if the block is stored without compression
+        std::uint64_t size = 0; ///< the size of the block before compression
+    };
+    /// independently compressed consecutive parts of the file
+    std::vector<Block> blocks;
+};
+
+/**
+ * \brief packs all files of given folder in a single binary file
+ * \details the file starts from the header, then go compressed blocks of all files,
+ * and the table of contents with the names of files and the positions of their blocks is stored in the end;
+ * the blocks are compressed in parallel and written in the file sequentially
+ */
+MRIOEXTRAS_API Expected<void> packFolderInSceneContainer( const std::filesystem::path& folder, const std::filesystem::path& file,
+    const SceneContainerSaveSettings& settings = {}, ProgressCallback cb = {} );
+
+/// this class reads the table of contents of binary scene container,
+/// and then extracts only requested files from it decompressing their blocks in parallel
+class SceneContainerReader
+{
+public:
+    /// opens the container and reads its table of contents
+    MRIOEXTRAS_API Expected<void> open( const std::filesystem::path& file );
+
+    /// all files stored in the container
+    [[nodiscard]] const std::vector<SceneContainerEntry>& entries() const { return entries_; }
+
+    /// returns the index of the entry with given name, or -1 if it is not found
+    [[nodiscard]] MRIOEXTRAS_API int findEntry( const std::string& name ) const;
+
+    /// decompresses given file in memory
+    MRIOEXTRAS_API Expected<std::string> readEntry( size_t index, ProgressCallback cb = {} ) const;
+
+    /// decompresses the files accepted by the filter (or all files if no filter is given) in given existing folder
+    MRIOEXTRAS_API Expected<void> extract( const std::filesystem::path& folder,
+        const std::function<bool( const SceneContainerEntry& )>& filter = {}, ProgressCallback cb = {} ) const;
+
+private:
+    std::filesystem::path file_;
+    std::vector<SceneContainerEntry> entries_;
+};
+
+/// saves object subtree in binary scene container with the same files as in .mru scene
+MRIOEXTRAS_API Expected<void> serializeObjectTreeToSceneContainer( const Object& object, const std::filesystem::path& file,
+    ProgressCallback callback = {} );
+
+/// loads objects tree from binary scene container
+MRIOEXTRAS_API Expected<LoadedObject> deserializeObjectTreeFromSceneContainer( const std::filesystem::path& file,
+    const ProgressCallback& callback = {} );
+
+/// loads objects tree from binary scene container;
+/// if deferModels is set then only the descriptions of objects are extracted now, and the files of deferred models
+/// are extracted from the container when the models are loaded (see Object::loadDeferredModel)
+MRIOEXTRAS_API Expected<LoadedObject> deserializeObjectTreeFromSceneContainer( const std::filesystem::path& file,
+    DeferModels deferModels, const ProgressCallback& callback = {} );
+
+} // namespace MR
+#endif
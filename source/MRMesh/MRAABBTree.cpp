@@ -7,6 +7,7 @@
 #include "MRBuffer.h"
 #include "MRGTest.h"
 #include "MRRegionBoundary.h"
+#include "MRParallelFor.h"
 
 namespace MR
 {
@@ -64,38 +65,304 @@ AABBTree::AABBTree( const MeshPart & mp )
     nodes_ = makeAABBTreeNodeVec( std::move( boxedFaces ) );
 }
 
-void AABBTree::refit( const Mesh & mesh, const VertBitSet & changedVerts )
+/// the surface area of the box (divided by two)
+static float boxArea( const Box3f & box )
 {
+    const auto d = box.size();
+    return d.x * d.y + d.y * d.z + d.z * d.x;
+}
+
+void AABBTree::prepareRefit_()
+{
+    if ( !parents_.empty() || nodes_.empty() )
+        return;
     MR_TIMER;
 
-    const auto changedFaces = getIncidentFaces( mesh.topology, changedVerts );
+    FaceId maxFace;
+    for ( const auto & node : nodes_ )
+        if ( node.leaf() )
+            maxFace = std::max( maxFace, node.leafId() );
 
-    // update leaf nodes
-    NodeBitSet changedNodes( nodes_.size() );
-    BitSetParallelForAll( changedNodes, [&]( NodeId nid )
+    parents_.resize( nodes_.size() );
+    faceToLeaf_.resize( maxFace + 1 );
+    builtArea_.resize( nodes_.size() );
+    ParallelFor( nodes_, [&]( NodeId nid )
     {
-        auto & node = nodes_[nid];
-        if ( !node.leaf() )
-            return;
-        const auto f = node.leafId();
-        if ( !changedFaces.test( f ) )
+        const auto & node = nodes_[nid];
+        builtArea_[nid] = boxArea( node.box );
+        if ( node.leaf() )
+        {
+            faceToLeaf_[node.leafId()] = nid;
             return;
-        changedNodes.set( nid );
-        node.box = computeFaceBox( mesh, f );
+        }
+        parents_[node.l] = nid;
+        parents_[node.r] = nid;
     } );
+}
+
+void AABBTree::rebuildSubtree_( NodeId root )
+{
+    std::vector<NodeId> leaves;
+    std::vector<NodeId> stack{ root };
+    while ( !stack.empty() )
+    {
+        const auto nid = stack.back();
+        stack.pop_back();
+        const auto & node = nodes_[nid];
+        if ( node.leaf() )
+        {
+            leaves.push_back( nid );
+            continue;
+        }
+        stack.push_back( node.r );
+        stack.push_back( node.l );
+    }
 
-    //update not-leaf nodes
-    for ( auto nid = nodes_.backId(); nid; --nid )
+    // the boxes of leaves are already updated
+    Buffer<BoxedFace> boxedFaces( leaves.size() );
+    for ( size_t i = 0; i < leaves.size(); ++i )
     {
-        auto & node = nodes_[nid];
+        boxedFaces[i].leafId = nodes_[leaves[i]].leafId();
+        boxedFaces[i].box = nodes_[leaves[i]].box;
+    }
+    const auto subtree = makeAABBTreeNodeVec( std::move( boxedFaces ) );
+
+    // the subtree occupies the same continuous range of nodes in depth-first order
+    assert( subtree.size() == getNumNodes( int( leaves.size() ) ) );
+    for ( auto sid = subtree.beginId(); sid < subtree.endId(); ++sid )
+    {
+        const auto nid = root + int( sid );
+        auto node = subtree[sid];
+        builtArea_[nid] = boxArea( node.box );
         if ( node.leaf() )
+            faceToLeaf_[node.leafId()] = nid;
+        else
+        {
+            node.l = root + int( node.l );
+            node.r = root + int( node.r );
+            parents_[node.l] = nid;
+            parents_[node.r] = nid;
+        }
+        nodes_[nid] = node;
+    }
+}
+
+void AABBTree::refit( const Mesh & mesh, const VertBitSet & changedVerts, float rebuildAreaRatio )
+{
+    MR_TIMER;
+    if ( nodes_.empty() )
+        return;
+    prepareRefit_();
+
+    const auto changedFaces = getIncidentFaces( mesh.topology, changedVerts );
+    const auto numChangedFaces = changedFaces.count();
+    if ( numChangedFaces == 0 )
+        return;
+
+    NodeBitSet changedNodes( nodes_.size() );
+    if ( numChangedFaces * 16 > numLeaves() )
+    {
+        // update leaf nodes
+        BitSetParallelForAll( changedNodes, [&]( NodeId nid )
+        {
+            auto & node = nodes_[nid];
+            if ( !node.leaf() )
+                return;
+            const auto f = node.leafId();
+            if ( !changedFaces.test( f ) )
+                return;
+            changedNodes.set( nid );
+            node.box = computeFaceBox( mesh, f );
+        } );
+
+        //update not-leaf nodes
+        for ( auto nid = nodes_.backId(); nid; --nid )
+        {
+            auto & node = nodes_[nid];
+            if ( node.leaf() )
+                continue;
+            if ( !changedNodes.test( node.l ) && !changedNodes.test( node.r ) )
+                continue;
+            changedNodes.set( nid );
+            node.box = nodes_[node.l].box;
+            node.box.include( nodes_[node.r].box );
+        }
+    }
+    else
+    {
+        // update only the leaves of changed faces and their ancestors
+        std::vector<NodeId> changedInnerNodes;
+        for ( auto f : changedFaces )
+        {
+            if ( f >= faceToLeaf_.size() )
+                break;
+            const auto leaf = faceToLeaf_[f];
+            if ( !leaf )
+                continue; // the face is not in the tree
+            nodes_[leaf].box = computeFaceBox( mesh, f );
+            changedNodes.set( leaf );
+            for ( auto p = parents_[leaf]; p && !changedNodes.test_set( p ); p = parents_[p] )
+                changedInnerNodes.push_back( p );
+        }
+
+        // children always have larger ids than their parent
+        std::sort( changedInnerNodes.begin(), changedInnerNodes.end(), std::greater<NodeId>() );
+        for ( auto nid : changedInnerNodes )
+        {
+            auto & node = nodes_[nid];
+            node.box = nodes_[node.l].box;
+            node.box.include( nodes_[node.r].box );
+        }
+    }
+
+    if ( rebuildAreaRatio >= FLT_MAX )
+        return;
+    // rebuild topmost degraded subtrees, the ancestors are visited before their descendants
+    for ( auto nid = changedNodes.find_first(); nid; )
+    {
+        const auto & node = nodes_[nid];
+        if ( node.leaf() || !( boxArea( node.box ) > rebuildAreaRatio * builtArea_[nid] ) )
+        {
+            nid = changedNodes.find_next( nid );
+            continue;
+        }
+        // find the last node of the subtree
+        auto last = nid;
+        while ( !nodes_[last].leaf() )
+            last = nodes_[last].r;
+        rebuildSubtree_( nid );
+        nid = changedNodes.find_next( last );
+    }
+}
+
+void AABBTree::replaceFaces( const Mesh & mesh, const FaceBitSet & removedFaces, const FaceBitSet & addedFaces )
+{
+    MR_TIMER;
+    if ( nodes_.empty() || removedFaces.none() )
+    {
+        // there is no place for new faces in the tree
+        *this = AABBTree( mesh );
+        return;
+    }
+    prepareRefit_();
+
+    // the first and the last leaves of removed faces in depth-first order
+    NodeId firstLeaf, lastLeaf;
+    for ( auto f : removedFaces )
+    {
+        const auto leaf = f < faceToLeaf_.size() ? faceToLeaf_[f] : NodeId();
+        assert( leaf ); // the face must be in the tree before removal
+        if ( !leaf )
             continue;
-        if ( !changedNodes.test( node.l ) && !changedNodes.test( node.r ) )
+        if ( !firstLeaf || leaf < firstLeaf )
+            firstLeaf = leaf;
+        if ( !lastLeaf || leaf > lastLeaf )
+            lastLeaf = leaf;
+    }
+
+    // the subtree of a node occupies continuous range of nodes in depth-first order
+    auto subtreeEnd = [&]( NodeId nid )
+    {
+        while ( !nodes_[nid].leaf() )
+            nid = nodes_[nid].r;
+        return nid + 1;
+    };
+    // the smallest subtree containing all removed faces
+    auto root = firstLeaf ? firstLeaf : rootNodeId();
+    while ( lastLeaf && subtreeEnd( root ) <= lastLeaf )
+        root = parents_[root];
+    const auto rootEnd = subtreeEnd( root );
+
+    size_t numSubtreeLeaves = addedFaces.count();
+    for ( auto nid = root; nid < rootEnd; ++nid )
+        if ( nodes_[nid].leaf() && !removedFaces.test( nodes_[nid].leafId() ) )
+            ++numSubtreeLeaves;
+    if ( numSubtreeLeaves == 0 )
+    {
+        // the subtree disappears completely
+        *this = AABBTree( mesh );
+        return;
+    }
+
+    // the boxes of remaining faces are taken from the leaves
+    Buffer<BoxedFace> boxedFaces( numSubtreeLeaves );
+    size_t n = 0;
+    for ( auto nid = root; nid < rootEnd; ++nid )
+    {
+        const auto & node = nodes_[nid];
+        if ( !node.leaf() || removedFaces.test( node.leafId() ) )
             continue;
-        changedNodes.set( nid );
-        node.box = nodes_[node.l].box;
-        node.box.include( nodes_[node.r].box );
+        boxedFaces[n].leafId = node.leafId();
+        boxedFaces[n].box = node.box;
+        ++n;
+    }
+    for ( auto f : addedFaces )
+    {
+        boxedFaces[n].leafId = f;
+        boxedFaces[n].box = computeFaceBox( mesh, f );
+        ++n;
     }
+    assert( n == numSubtreeLeaves );
+    const auto subtree = makeAABBTreeNodeVec( std::move( boxedFaces ) );
+
+    // the nodes after the subtree are shifted by the change of its size
+    const int delta = int( subtree.size() ) - ( int( rootEnd ) - int( root ) );
+    NodeVec newNodes;
+    newNodes.resize( nodes_.size() + delta );
+    ParallelFor( newNodes, [&]( NodeId nid )
+    {
+        if ( nid >= root && nid < root + int( subtree.size() ) )
+        {
+            auto node = subtree[nid - int( root )];
+            if ( !node.leaf() )
+            {
+                node.l = node.l + int( root );
+                node.r = node.r + int( root );
+            }
+            newNodes[nid] = node;
+            return;
+        }
+        auto node = nid < root ? nodes_[nid] : nodes_[nid - delta];
+        if ( !node.leaf() )
+        {
+            if ( node.l >= rootEnd )
+                node.l = node.l + delta;
+            if ( node.r >= rootEnd )
+                node.r = node.r + delta;
+        }
+        newNodes[nid] = node;
+    } );
+
+    // the ancestors of the subtree keep their positions, but their boxes can change
+    for ( auto p = parents_[root]; p; p = parents_[p] )
+    {
+        auto & node = newNodes[p];
+        node.box = newNodes[node.l].box;
+        node.box.include( newNodes[node.r].box );
+    }
+
+    nodes_ = std::move( newNodes );
+    // node ids have changed
+    parents_ = {};
+    faceToLeaf_ = {};
+    builtArea_ = {};
+}
+
+void AABBTree::getLeafOrderAndReset( LeafBMap & leafMap )
+{
+    AABBTreeBase::getLeafOrderAndReset( leafMap );
+    // leaf ids have changed
+    parents_ = {};
+    faceToLeaf_ = {};
+    builtArea_ = {};
+}
+
+size_t AABBTree::heapBytes() const
+{
+    return AABBTreeBase::heapBytes()
+        + parents_.heapBytes()
+        + faceToLeaf_.heapBytes()
+        + builtArea_.heapBytes();
 }
 
 template auto AABBTreeBase<FaceTreeTraits3>::getSubtrees( int minNum ) const -> std::vector<NodeId>;
@@ -123,6 +390,53 @@ TEST(MRMesh, AABBTree)
     EXPECT_EQ( smallerTree.nodes().size(), 1 );
 }
 
+TEST(MRMesh, AABBTreeRefit)
+{
+    Mesh sphere = makeUVSphere( 1, 32, 32 );
+    AABBTree tree( sphere );
+
+    auto checkTree = [&]()
+    {
+        for ( const auto & node : tree.nodes() )
+        {
+            if ( node.leaf() )
+            {
+                Vector3f a, b, c;
+                sphere.getTriPoints( node.leafId(), a, b, c );
+                EXPECT_TRUE( node.box.contains( a ) && node.box.contains( b ) && node.box.contains( c ) );
+            }
+            else
+            {
+                EXPECT_TRUE( node.box.contains( tree[node.l].box ) );
+                EXPECT_TRUE( node.box.contains( tree[node.r].box ) );
+            }
+        }
+        EXPECT_EQ( tree.getSubtreeLeaves( tree.rootNodeId() ), sphere.topology.getValidFaces() );
+    };
+
+    // few vertices are moved: fast refit path
+    VertBitSet changed( sphere.topology.vertSize() );
+    for ( VertId v( 0 ); v < 5; ++v )
+    {
+        sphere.points[v] *= 1.5f;
+        changed.set( v );
+    }
+    tree.refit( sphere, changed );
+    checkTree();
+
+    // significant movement with rebuild of degraded subtrees
+    for ( VertId v( 0 ); v < 5; ++v )
+        sphere.points[v] = -3.0f * sphere.points[v];
+    tree.refit( sphere, changed, 2.0f );
+    checkTree();
+
+    // many vertices are moved: full refit path
+    for ( auto & p : sphere.points )
+        p.z *= 2.0f;
+    tree.refit( sphere, sphere.topology.getValidVerts(), 2.0f );
+    checkTree();
+}
+
 TEST(MRMesh, ProjectionToEmptyMesh)
 {
     Vector3f p( 1.f, 2.f, 3.f );
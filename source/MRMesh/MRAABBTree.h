@@ -1,6 +1,7 @@
 #pragma once
 
 #include "MRAABBTreeBase.h"
+#include <cfloat>
 
 namespace MR
 {
@@ -23,12 +24,40 @@ public:
     AABBTree & operator =( AABBTree && ) noexcept = default;
 
     /// updates bounding boxes of the nodes containing changed vertices;
-    /// this is a faster alternative to full tree rebuild (but the tree after refit might be less efficient)
+    /// this is a faster alternative to full tree rebuild (but the tree after refit might be less efficient);
+    /// the first call prepares the parent of each node, and next calls with few changed vertices take the time
+    /// proportional to the number of changed faces times tree depth
     /// \param mesh same mesh for which this tree was constructed but with updated coordinates;
     /// \param changedVerts vertex ids with modified coordinates (since tree construction or last refit)
-    MRMESH_API void refit( const Mesh & mesh, const VertBitSet & changedVerts );
+    /// \param rebuildAreaRatio if the surface area of an updated node's box exceeds its area after construction by more than this factor,
+    ///                         then the subtree of that node is rebuilt to restore the efficiency of the tree
+    MRMESH_API void refit( const Mesh & mesh, const VertBitSet & changedVerts, float rebuildAreaRatio = FLT_MAX );
+
+    /// updates the tree after some faces of the mesh were deleted and new faces were added in their place (e.g. by local boolean),
+    /// while all other faces remained unchanged; only the smallest subtree containing all removed faces is rebuilt
+    /// from its remaining faces and the added faces, and other nodes are just copied (or the whole tree is rebuilt if nothing was removed)
+    /// \param mesh the mesh after the change
+    MRMESH_API void replaceFaces( const Mesh & mesh, const FaceBitSet & removedFaces, const FaceBitSet & addedFaces );
+
+    /// fills map: LeafId -> leaf#, then resets leaf order to 0,1,2,...;
+    /// buffer in leafMap must be resized before the call, and caller is responsible for filling missing leaf elements
+    MRMESH_API void getLeafOrderAndReset( LeafBMap & leafMap );
+
+    /// returns the amount of memory this object occupies on heap
+    [[nodiscard]] MRMESH_API size_t heapBytes() const;
 
 private:
+    /// prepares parents_, faceToLeaf_ and builtArea_ if they are not ready
+    void prepareRefit_();
+
+    /// rebuilds the subtree with given root from the leaves of the subtree
+    void rebuildSubtree_( NodeId root );
+
+    /// the data for fast refit, which is prepared on first refit() call:
+    Vector<NodeId, NodeId> parents_; ///< the parent of each node, invalid for the root
+    Vector<NodeId, FaceId> faceToLeaf_; ///< the leaf node of each face from the tree
+    Vector<float, NodeId> builtArea_; ///< the surface area of each node's box after its construction
+
     AABBTree( const AABBTree & ) = default;
     AABBTree & operator =( const AABBTree & ) = default;
     friend class UniqueThreadSafeOwner<AABBTree>;
@@ -5,6 +5,7 @@
 #include "MRMesh.h"
 #include "MRMeshToPointCloud.h"
 #include "MRBitSetParallelFor.h"
+#include "MRParallelFor.h"
 #include "MRHeapBytes.h"
 #include "MRBuffer.h"
 #include "MRGTest.h"
@@ -177,6 +178,7 @@ AABBTreePoints::AABBTreePoints( const PointCloud& pointCloud )
     auto [nodes, orderedPoints] = AABBTreePointsMaker().construct( pointCloud.points, &pointCloud.validPoints );
     nodes_ = std::move( nodes );
     orderedPoints_ = std::move( orderedPoints );
+    updateOrderedCoords_();
 }
 
 AABBTreePoints::AABBTreePoints( const Mesh& mesh )
@@ -184,6 +186,7 @@ AABBTreePoints::AABBTreePoints( const Mesh& mesh )
     auto [nodes, orderedPoints] = AABBTreePointsMaker().construct( mesh.points, &mesh.topology.getValidVerts() );
     nodes_ = std::move( nodes );
     orderedPoints_ = std::move( orderedPoints );
+    updateOrderedCoords_();
 }
 
 AABBTreePoints::AABBTreePoints( const VertCoords & points, const VertBitSet * validPoints )
@@ -191,6 +194,22 @@ AABBTreePoints::AABBTreePoints( const VertCoords & points, const VertBitSet * va
     auto [nodes, orderedPoints] = AABBTreePointsMaker().construct( points, validPoints );
     nodes_ = std::move( nodes );
     orderedPoints_ = std::move( orderedPoints );
+    updateOrderedCoords_();
+}
+
+void AABBTreePoints::updateOrderedCoords_()
+{
+    MR_TIMER;
+    orderedCoords_.x.resize( orderedPoints_.size() );
+    orderedCoords_.y.resize( orderedPoints_.size() );
+    orderedCoords_.z.resize( orderedPoints_.size() );
+    ParallelFor( orderedPoints_, [&]( size_t i )
+    {
+        const auto & p = orderedPoints_[i].coord;
+        orderedCoords_.x[i] = p.x;
+        orderedCoords_.y[i] = p.y;
+        orderedCoords_.z[i] = p.z;
+    } );
 }
 
 void AABBTreePoints::getLeafOrder( VertBMap & vertMap ) const
@@ -234,7 +253,10 @@ size_t AABBTreePoints::heapBytes() const
 {
     return
         nodes_.heapBytes() +
-        MR::heapBytes( orderedPoints_ );
+        MR::heapBytes( orderedPoints_ ) +
+        MR::heapBytes( orderedCoords_.x ) +
+        MR::heapBytes( orderedCoords_.y ) +
+        MR::heapBytes( orderedCoords_.z );
 }
 
 void AABBTreePoints::refit( const VertCoords & newCoords, const VertBitSet & changedVerts )
@@ -250,6 +272,9 @@ void AABBTreePoints::refit( const VertCoords & newCoords, const VertBitSet & cha
         {
             changedPoints.set( i );
             p.coord = newCoords[p.id];
+            orderedCoords_.x[i] = p.coord.x;
+            orderedCoords_.y[i] = p.coord.y;
+            orderedCoords_.z[i] = p.coord.z;
         }
         else
             assert( p.coord == newCoords[p.id] );
@@ -308,6 +333,11 @@ TEST( MRMesh, AABBTreePoints )
     EXPECT_TRUE( tree[AABBTreePoints::rootNodeId()].l.valid() );
     EXPECT_TRUE( tree[AABBTreePoints::rootNodeId()].r.valid() );
 
+    const auto & coords = tree.orderedCoords();
+    ASSERT_EQ( coords.x.size(), tree.orderedPoints().size() );
+    for ( size_t i = 0; i < coords.x.size(); ++i )
+        EXPECT_EQ( Vector3f( coords.x[i], coords.y[i], coords.z[i] ), tree.orderedPoints()[i].coord );
+
     assert( !tree.nodes().empty() );
     auto m = std::move( tree );
     assert( tree.nodes().empty() );
@@ -4,6 +4,8 @@
 #include "MRId.h"
 #include "MRVector.h"
 #include "MRVector3.h"
+#include <cassert>
+#include <vector>
 
 namespace MR
 {
@@ -42,6 +44,31 @@ public:
     };
     [[nodiscard]] const std::vector<Point>& orderedPoints() const { return orderedPoints_; }
 
+    /// coordinates of ordered points in structure-of-arrays layout: x[i], y[i], z[i] are the coordinates of orderedPoints()[i]
+    struct OrderedCoords
+    {
+        std::vector<float> x, y, z;
+    };
+    [[nodiscard]] const OrderedCoords& orderedCoords() const { return orderedCoords_; }
+
+    /// computes squared distances from given point to the ordered points with indices [first, last) (at most MaxNumPointsInLeaf of them);
+    /// the loop over structure-of-arrays coordinates is vectorized by the compiler
+    void getDistancesSq( const Vector3f & pt, int first, int last, float * distSq ) const
+    {
+        assert( first <= last && last - first <= MaxNumPointsInLeaf );
+        const float * x = orderedCoords_.x.data() + first;
+        const float * y = orderedCoords_.y.data() + first;
+        const float * z = orderedCoords_.z.data() + first;
+        const int n = last - first;
+        for ( int i = 0; i < n; ++i )
+        {
+            const float dx = x[i] - pt.x;
+            const float dy = y[i] - pt.y;
+            const float dz = z[i] - pt.z;
+            distSq[i] = dx * dx + dy * dy + dz * dz;
+        }
+    }
+
     /// creates tree for given point cloud
     MRMESH_API AABBTreePoints( const PointCloud& pointCloud );
     /// creates tree for vertices of given mesh
@@ -75,7 +102,11 @@ public:
     MRMESH_API void refit( const VertCoords & newCoords, const VertBitSet & changedVerts );
 
 private:
+    /// fills orderedCoords_ from orderedPoints_
+    void updateOrderedCoords_();
+
     std::vector<Point> orderedPoints_;
+    OrderedCoords orderedCoords_;
     NodeVec nodes_;
 
     AABBTreePoints( const AABBTreePoints & ) = default;
@@ -0,0 +1,208 @@
+#include "MRAABBTreeWide.h"
+#include "MRAABBTree.h"
+#include "MRMesh.h"
+#include "MRMeshProject.h"
+#include "MRMeshIntersect.h"
+#include "MRTorus.h"
+#include "MRLine3.h"
+#include "MRBall.h"
+#include "MRTimer.h"
+#include "MRGTest.h"
+#include <cmath>
+#include <random>
+
+namespace MR
+{
+
+namespace
+{
+
+class AABBTreeWideMaker
+{
+public:
+    AABBTreeWideMaker( const AABBTree & tree, Vector<AABBTreeWideNode, NodeId> & nodes ) : tree_( tree ), nodes_( nodes ) {}
+
+    /// creates wide node for the subtree of binary tree with given root, and returns its id
+    NodeId make( NodeId n );
+
+private:
+    /// selects up to Width binary nodes from the subtree of n, which together contain all subtree leaves
+    int collapse_( NodeId n, NodeId (&res)[AABBTreeWideNode::Width] ) const;
+
+    const AABBTree & tree_;
+    Vector<AABBTreeWideNode, NodeId> & nodes_;
+};
+
+int AABBTreeWideMaker::collapse_( NodeId n, NodeId (&res)[AABBTreeWideNode::Width] ) const
+{
+    const auto & node = tree_[n];
+    if ( node.leaf() )
+    {
+        res[0] = n;
+        return 1;
+    }
+    res[0] = node.l;
+    res[1] = node.r;
+    int num = 2;
+    while ( num < AABBTreeWideNode::Width )
+    {
+        // open the inner node with the largest surface area to minimize the expected number of box tests
+        int best = -1;
+        float bestArea = -1;
+        for ( int i = 0; i < num; ++i )
+        {
+            const auto & c = tree_[res[i]];
+            if ( c.leaf() )
+                continue;
+            const auto sz = c.box.size();
+            const float area = sz.x * sz.y + sz.y * sz.z + sz.z * sz.x;
+            if ( area > bestArea )
+            {
+                best = i;
+                bestArea = area;
+            }
+        }
+        if ( best < 0 )
+            break;
+        const auto & c = tree_[res[best]];
+        res[best] = c.l;
+        res[num++] = c.r;
+    }
+    return num;
+}
+
+NodeId AABBTreeWideMaker::make( NodeId n )
+{
+    const auto res = nodes_.endId();
+    nodes_.emplace_back();
+
+    NodeId children[AABBTreeWideNode::Width];
+    const int num = collapse_( n, children );
+
+    const auto & box = tree_[n].box;
+    AABBTreeWideNode w;
+    w.origin = box.min;
+    for ( int a = 0; a < 3; ++a )
+    {
+        // the smallest step such that the maximal quantized value covers the box
+        float s = ( box.max[a] - box.min[a] ) / 255;
+        while ( w.origin[a] + float( 255 ) * s < box.max[a] )
+            s = std::nextafter( s, FLT_MAX );
+        w.scale[a] = s;
+    }
+
+    for ( int i = 0; i < AABBTreeWideNode::Width; ++i )
+    {
+        if ( i >= num )
+        {
+            w.child[i] = -1;
+            for ( int a = 0; a < 3; ++a )
+            {
+                w.lo[a][i] = 255;
+                w.hi[a][i] = 0;
+            }
+            continue;
+        }
+        const auto & cbox = tree_[children[i]].box;
+        for ( int a = 0; a < 3; ++a )
+        {
+            const float s = w.scale[a];
+            auto dequantize = [&]( int q ) { return w.origin[a] + float( q ) * s; };
+            int qlo = 0, qhi = 0;
+            if ( s > 0 )
+            {
+                qlo = std::clamp( int( std::floor( ( cbox.min[a] - w.origin[a] ) / s ) ), 0, 255 );
+                qhi = std::clamp( int( std::ceil( ( cbox.max[a] - w.origin[a] ) / s ) ), 0, 255 );
+            }
+            // make the quantized box conservative despite rounding errors
+            while ( qlo > 0 && dequantize( qlo ) > cbox.min[a] )
+                --qlo;
+            while ( qhi < 255 && dequantize( qhi ) < cbox.max[a] )
+                ++qhi;
+            w.lo[a][i] = uint8_t( qlo );
+            w.hi[a][i] = uint8_t( qhi );
+        }
+        assert( w.childBox( i ).contains( cbox ) );
+    }
+
+    // inner children are created after filling this node, since nodes_ can be reallocated
+    for ( int i = 0; i < num; ++i )
+    {
+        const auto & c = tree_[children[i]];
+        w.child[i] = c.leaf() ? -2 - int( c.leafId() ) : int( make( children[i] ) );
+    }
+    nodes_[res] = w;
+    return res;
+}
+
+} //anonymous namespace
+
+AABBTreeWide::AABBTreeWide( const AABBTree & tree )
+{
+    MR_TIMER;
+    if ( tree.nodes().empty() )
+        return;
+
+    box_ = tree.getBoundingBox();
+    numLeaves_ = tree.numLeaves();
+    // each full wide node replaces three inner binary nodes
+    nodes_.reserve( numLeaves_ / 3 + 1 );
+    AABBTreeWideMaker( tree, nodes_ ).make( tree.rootNodeId() );
+}
+
+TEST( MRMesh, AABBTreeWide )
+{
+    const auto mesh = makeTorus( 1.0f, 0.3f, 64, 32 );
+    const auto & tree = mesh.getAABBTree();
+    const auto & wide = mesh.getAABBTreeWide();
+    EXPECT_EQ( wide.numLeaves(), tree.numLeaves() );
+    EXPECT_LT( wide.heapBytes(), tree.heapBytes() * 3 / 4 );
+
+    // all faces are referenced exactly once, and children boxes contain the faces
+    FaceBitSet found( mesh.topology.faceSize() );
+    for ( const auto & node : wide.nodes() )
+    {
+        for ( int i = 0; i < AABBTreeWideNode::Width; ++i )
+        {
+            if ( !node.leafChild( i ) )
+                continue;
+            const auto f = node.childFace( i );
+            EXPECT_FALSE( found.test( f ) );
+            found.set( f );
+            Vector3f a, b, c;
+            mesh.getTriPoints( f, a, b, c );
+            const auto box = node.childBox( i );
+            EXPECT_TRUE( box.contains( a ) && box.contains( b ) && box.contains( c ) );
+        }
+    }
+    EXPECT_EQ( found, mesh.topology.getValidFaces() );
+
+    // the queries return the same results with both trees
+    std::mt19937 gen( 0 );
+    std::uniform_real_distribution<float> dist( -1.5f, 1.5f );
+    for ( int i = 0; i < 200; ++i )
+    {
+        const Vector3f p( dist( gen ), dist( gen ), dist( gen ) );
+        const Vector3f d( dist( gen ), dist( gen ), dist( gen ) );
+
+        const auto proj = findProjection( p, mesh );
+        const auto isect = rayMeshIntersect( mesh, Line3f( p, d ) );
+        int numInBall = 0;
+        findTrisInBall( mesh, Ball3f{ p, 0.01f }, [&]( const MeshProjectionResult &, Ball3f & ) { ++numInBall; return Processing::Continue; } );
+
+        const auto projW = findProjectionWide( p, mesh, wide );
+        const auto isectW = rayMeshIntersectWide( mesh, wide, Line3f( p, d ) );
+        int numInBallW = 0;
+        findTrisInBallWide( mesh, wide, Ball3f{ p, 0.01f }, [&]( const MeshProjectionResult &, Ball3f & ) { ++numInBallW; return Processing::Continue; } );
+
+        EXPECT_EQ( proj.distSq, projW.distSq );
+        EXPECT_EQ( bool( isect ), bool( isectW ) );
+        if ( isect && isectW )
+        {
+            EXPECT_EQ( isect.distanceAlongLine, isectW.distanceAlongLine );
+        }
+        EXPECT_EQ( numInBall, numInBallW );
+    }
+}
+
+} //namespace MR
@@ -0,0 +1,203 @@
+#pragma once
+
+#include "MRBox.h"
+#include "MRId.h"
+#include "MRVector.h"
+#include "MRPch/MRBindingMacros.h"
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <emmintrin.h> //SSE2 instructions
+#endif
+
+namespace MR
+{
+
+/// \addtogroup AABBTreeGroup
+/// \{
+
+/// node of wide bounding volume hierarchy with up to four children;
+/// the boxes of children are quantized to 8 bits per coordinate relative to the box of this node,
+/// so whole node occupies exactly one cache line and all its children are tested together using SIMD instructions
+struct AABBTreeWideNode
+{
+    static constexpr int Width = 4;
+
+    /// the minimal corner of this node's box
+    Vector3f origin;
+
+    /// the size of one quantization step along each axis
+    Vector3f scale;
+
+    /// quantized minimal and maximal corners of children boxes: [axis][child]
+    uint8_t lo[3][Width];
+    uint8_t hi[3][Width];
+
+    /// child[i] >= 0 - id of inner child node, child[i] <= -2 - encoded leaf face, -1 - empty slot
+    int child[Width];
+
+    /// returns true if i-th child slot is not empty
+    [[nodiscard]] bool hasChild( int i ) const { return child[i] != -1; }
+
+    /// returns true if i-th child is a leaf with a face
+    [[nodiscard]] bool leafChild( int i ) const { return child[i] <= -2; }
+
+    /// returns inner child node (valid only if !leafChild(i))
+    [[nodiscard]] NodeId childNode( int i ) const { assert( child[i] >= 0 ); return NodeId( child[i] ); }
+
+    /// returns the face of leaf child (valid only if leafChild(i))
+    [[nodiscard]] FaceId childFace( int i ) const { assert( leafChild( i ) ); return FaceId( -2 - child[i] ); }
+
+    /// returns dequantized (slightly enlarged) box of i-th child
+    [[nodiscard]] Box3f childBox( int i ) const
+    {
+        Box3f res;
+        for ( int a = 0; a < 3; ++a )
+        {
+            res.min[a] = origin[a] + float( lo[a][i] ) * scale[a];
+            res.max[a] = origin[a] + float( hi[a][i] ) * scale[a];
+        }
+        return res;
+    }
+};
+static_assert( sizeof( AABBTreeWideNode ) == 64 );
+
+/// bounding volume hierarchy for mesh faces with 4-wide nodes and compressed children boxes;
+/// it is built from binary AABBTree by collapsing its levels, and occupies about three times less memory;
+/// it is traversed by rayMeshIntersectWide, findProjectionWide, findBoxedTrisInBallWide and findTrisInBallWide
+class AABBTreeWide
+{
+public:
+    AABBTreeWide() = default;
+
+    /// creates wide tree from given binary tree
+    [[nodiscard]] MRMESH_API explicit AABBTreeWide( const AABBTree & tree );
+
+    /// const-access to all nodes
+    [[nodiscard]] const Vector<AABBTreeWideNode, NodeId> & nodes() const { return nodes_; }
+
+    /// const-access to any node
+    [[nodiscard]] const AABBTreeWideNode & operator[]( NodeId nid ) const { return nodes_[nid]; }
+
+    /// returns root node id
+    [[nodiscard]] static NodeId rootNodeId() { return NodeId{ 0 }; }
+
+    /// returns the bounding box of whole tree
+    [[nodiscard]] const Box3f & getBoundingBox() const { return box_; }
+
+    /// returns the number of leaves in whole tree
+    [[nodiscard]] size_t numLeaves() const { return numLeaves_; }
+
+    /// returns the amount of memory this object occupies on heap
+    [[nodiscard]] size_t heapBytes() const { return nodes_.heapBytes(); }
+
+private:
+    Vector<AABBTreeWideNode, NodeId> nodes_;
+    Box3f box_;
+    size_t numLeaves_ = 0;
+};
+
+/// computes squared distances from given point to all children boxes of the node (the result for empty slots is undefined)
+MR_BIND_IGNORE inline void childBoxesDistanceSq( const AABBTreeWideNode & node, const Vector3f & pt, float (&distSq)[AABBTreeWideNode::Width] );
+
+/// finds the intersections of the ray with all children boxes of the node within ray's interval [t0, t1],
+/// \param invDir reciprocal of ray's direction (with infinities replaced by FLT_MAX)
+/// \param tEnter receives the ray parameter of each box entrance
+/// \return the bit mask of children (including empty slots) with intersected boxes
+MR_BIND_IGNORE inline int rayChildBoxesIntersect( const AABBTreeWideNode & node, const Vector3f & rayOrigin, const Vector3f & invDir,
+    float t0, float t1, float (&tEnter)[AABBTreeWideNode::Width] );
+
+/* CPU(X86_64) - AMD64 / Intel64 / x86_64 64-bit */
+#if defined(__x86_64__) || defined(_M_X64)
+
+/// dequantizes the coordinates of four children along one axis
+MR_BIND_IGNORE inline __m128 dequantizeChildren( const uint8_t (&q)[AABBTreeWideNode::Width], float origin, float scale )
+{
+    static_assert( AABBTreeWideNode::Width == 4 );
+    int packed;
+    std::memcpy( &packed, q, sizeof( packed ) );
+    const __m128i zero = _mm_setzero_si128();
+    __m128i v = _mm_cvtsi32_si128( packed );
+    v = _mm_unpacklo_epi8( v, zero );
+    v = _mm_unpacklo_epi16( v, zero );
+    return _mm_add_ps( _mm_set1_ps( origin ), _mm_mul_ps( _mm_cvtepi32_ps( v ), _mm_set1_ps( scale ) ) );
+}
+
+MR_BIND_IGNORE inline void childBoxesDistanceSq( const AABBTreeWideNode & node, const Vector3f & pt, float (&distSq)[AABBTreeWideNode::Width] )
+{
+    const __m128 zero = _mm_setzero_ps();
+    __m128 sum = zero;
+    for ( int a = 0; a < 3; ++a )
+    {
+        const __m128 p = _mm_set1_ps( pt[a] );
+        const __m128 lo = dequantizeChildren( node.lo[a], node.origin[a], node.scale[a] );
+        const __m128 hi = dequantizeChildren( node.hi[a], node.origin[a], node.scale[a] );
+        const __m128 d = _mm_max_ps( _mm_max_ps( _mm_sub_ps( lo, p ), _mm_sub_ps( p, hi ) ), zero );
+        sum = _mm_add_ps( sum, _mm_mul_ps( d, d ) );
+    }
+    _mm_storeu_ps( distSq, sum );
+}
+
+MR_BIND_IGNORE inline int rayChildBoxesIntersect( const AABBTreeWideNode & node, const Vector3f & rayOrigin, const Vector3f & invDir,
+    float t0, float t1, float (&tEnter)[AABBTreeWideNode::Width] )
+{
+    __m128 tMin = _mm_set1_ps( t0 );
+    __m128 tMax = _mm_set1_ps( t1 );
+    for ( int a = 0; a < 3; ++a )
+    {
+        const __m128 o = _mm_set1_ps( rayOrigin[a] );
+        const __m128 inv = _mm_set1_ps( invDir[a] );
+        const __m128 tLo = _mm_mul_ps( _mm_sub_ps( dequantizeChildren( node.lo[a], node.origin[a], node.scale[a] ), o ), inv );
+        const __m128 tHi = _mm_mul_ps( _mm_sub_ps( dequantizeChildren( node.hi[a], node.origin[a], node.scale[a] ), o ), inv );
+        if ( invDir[a] >= 0 )
+        {
+            tMin = _mm_max_ps( tMin, tLo );
+            tMax = _mm_min_ps( tMax, tHi );
+        }
+        else
+        {
+            tMin = _mm_max_ps( tMin, tHi );
+            tMax = _mm_min_ps( tMax, tLo );
+        }
+    }
+    _mm_storeu_ps( tEnter, tMin );
+    return _mm_movemask_ps( _mm_cmple_ps( tMin, tMax ) );
+}
+
+#else
+    #pragma message("AABBTreeWide: no hardware optimized instructions")
+
+MR_BIND_IGNORE inline void childBoxesDistanceSq( const AABBTreeWideNode & node, const Vector3f & pt, float (&distSq)[AABBTreeWideNode::Width] )
+{
+    for ( int i = 0; i < AABBTreeWideNode::Width; ++i )
+        distSq[i] = node.childBox( i ).getDistanceSq( pt );
+}
+
+MR_BIND_IGNORE inline int rayChildBoxesIntersect( const AABBTreeWideNode & node, const Vector3f & rayOrigin, const Vector3f & invDir,
+    float t0, float t1, float (&tEnter)[AABBTreeWideNode::Width] )
+{
+    int res = 0;
+    for ( int i = 0; i < AABBTreeWideNode::Width; ++i )
+    {
+        const auto box = node.childBox( i );
+        float tMin = t0, tMax = t1;
+        for ( int a = 0; a < 3; ++a )
+        {
+            const float tLo = ( box.min[a] - rayOrigin[a] ) * invDir[a];
+            const float tHi = ( box.max[a] - rayOrigin[a] ) * invDir[a];
+            tMin = std::max( tMin, invDir[a] >= 0 ? tLo : tHi );
+            tMax = std::min( tMax, invDir[a] >= 0 ? tHi : tLo );
+        }
+        tEnter[i] = tMin;
+        if ( tMin <= tMax )
+            res |= 1 << i;
+    }
+    return res;
+}
+
+#endif
+
+/// \}
+
+} // namespace MR
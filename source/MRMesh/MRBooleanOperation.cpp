@@ -80,7 +80,7 @@ std::optional<FaceBitSet> findMeshPart( const Mesh& origin,
         else
         {
             // a connected component without any cut
-            const Mesh* otherPtr = originIsA ? intParams.originalMeshB : intParams.originalMeshA;
+            const Mesh* otherPtr = originIsA ? intParams.originalMeshB : ( intParams.wholeMeshA ? intParams.wholeMeshA : intParams.originalMeshA );
             if ( mergeAllNonIntersectingComponents ||
                 isNonIntersectingInside( origin, f, otherPtr ? *otherPtr : otherMesh, originIsA ? rigidB2A : &a2b ) == needInsideComps )
             {
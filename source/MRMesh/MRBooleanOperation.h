@@ -91,6 +91,8 @@ struct BooleanResultMapper
     [[nodiscard]] const Maps& getMaps( MapObject index ) const { return maps[ int( index ) ]; }
 };
 
+struct CoordinateConverters;
+
 /// Parameters will be useful if specified
 struct BooleanInternalParameters
 {
@@ -100,6 +102,11 @@ struct BooleanInternalParameters
     const Mesh* originalMeshB{ nullptr };
     /// Optional output cut edges of booleaned meshes
     std::vector<EdgeLoop>* optionalOutCut{ nullptr };
+    /// Optional whole mesh if mesh A is only its part near mesh B,
+    /// it is used to find whether the components of mesh B without intersections are inside A
+    const Mesh* wholeMeshA{ nullptr };
+    /// Optional precomputed float-int converters for given meshes and their relative transformation
+    const CoordinateConverters* converters{ nullptr };
 };
 
 /// Perform boolean operation on cut meshes
@@ -2,7 +2,9 @@
 #include "MRHistoryAction.h"
 #include "MRObjectMesh.h"
 #include "MRMesh.h"
+#include "MRMeshDiff.h"
 #include "MRHeapBytes.h"
+#include <cassert>
 #include <memory>
 
 namespace MR
@@ -11,7 +13,9 @@ namespace MR
 /// \defgroup HistoryGroup History group
 /// \{
 
-/// Undo action for ObjectMesh mesh change
+/// Undo action for ObjectMesh mesh change;
+/// the action keeps full copy of the other mesh only until the changes are finished (see changesFinished()),
+/// and then replaces it with the difference from the current mesh if it is smaller
 class ChangeMeshAction : public HistoryAction
 {
 public:
@@ -48,7 +52,39 @@ public:
         if ( !objMesh_ )
             return;
 
-        cloneMesh_ = objMesh_->updateMesh( cloneMesh_ );
+        // the object is in the state after the change or after previous undo/redo here,
+        // so the changes are surely finished even if history store has not notified about it
+        makeDiff_();
+        if ( !useDiff_ )
+        {
+            cloneMesh_ = objMesh_->updateMesh( cloneMesh_ );
+            return;
+        }
+
+        const auto & m = objMesh_->varMesh();
+        assert( m );
+        if ( !m )
+            return;
+
+        if ( m.use_count() == 1 )
+        {
+            // nobody else sees the mesh, so it can be modified in place
+            meshDiff_.applyAndSwap( *m );
+            objMesh_->setDirtyFlags( DIRTY_ALL );
+            return;
+        }
+
+        // the current mesh is shared with other holders, so it is not modified in place
+        auto newMesh = std::make_shared<Mesh>( *m );
+        meshDiff_.applyAndSwap( *newMesh );
+        objMesh_->updateMesh( std::move( newMesh ) );
+    }
+
+    /// replaces full copy of the mesh before the changes with the difference from current object's mesh
+    virtual void changesFinished() override
+    {
+        if ( objMesh_ )
+            makeDiff_();
     }
 
     static void setObjectDirty( const std::shared_ptr<ObjectMesh>& obj )
@@ -59,12 +95,40 @@ public:
 
     [[nodiscard]] virtual size_t heapBytes() const override
     {
-        return name_.capacity() + MR::heapBytes( cloneMesh_ );
+        return name_.capacity() + MR::heapBytes( cloneMesh_ ) + meshDiff_.heapBytes();
     }
 
 private:
+    /// replaces full copy of the other mesh with its difference from current object's mesh, if the difference is smaller
+    void makeDiff_()
+    {
+        if ( useDiff_ || diffRejected_ || !cloneMesh_ )
+            return;
+        const auto & m = objMesh_->mesh();
+        if ( !m || m == cloneMesh_ )
+            return;
+
+        MeshDiff diff( *m, *cloneMesh_ );
+        if ( !diff.any() )
+            return; // the mesh is not changed yet, so keep the copy till the next attempt
+        if ( diff.heapBytes() >= cloneMesh_->heapBytes() )
+        {
+            diffRejected_ = true; // the meshes are too distinct, and they will not become closer
+            return;
+        }
+        meshDiff_ = std::move( diff );
+        cloneMesh_.reset();
+        useDiff_ = true;
+    }
+
     std::shared_ptr<ObjectMesh> objMesh_;
+    /// the other mesh in full, if !useDiff_
     std::shared_ptr<Mesh> cloneMesh_;
+    /// the difference from current object's mesh to the other mesh, if useDiff_
+    MeshDiff meshDiff_;
+    bool useDiff_ = false;
+    /// the difference was found larger than the full copy, so the full copy is kept forever
+    bool diffRejected_ = false;
 
     std::string name_;
 };
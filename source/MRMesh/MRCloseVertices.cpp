@@ -6,11 +6,183 @@
 #include "MRParallelFor.h"
 #include "MRphmap.h"
 #include "MRRingIterator.h"
+#include "MRBox.h"
+#include "MRMakeSphereMesh.h"
 #include "MRTimer.h"
+#include "MRGTest.h"
+#include "MRPch/MRTBB.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 
 namespace MR
 {
 
+namespace
+{
+
+/// after parallel pass, some close vertices can be mapped further;
+/// this maps them in the smallest close vertex not mapped further, where close vertices of v are enumerated by forEachCloseVert( v, callback )
+template<class F>
+void remapToSmallest( VertMap & res, const VertCoords & points, const VertBitSet * valid, F && forEachCloseVert )
+{
+    for ( auto v = 0_v; v < points.size(); ++v )
+    {
+        if ( valid && !valid->test( v ) )
+            continue;
+        VertId smallestCloseVert = res[v];
+        if ( smallestCloseVert == v )
+            continue; // v is the smallest closest by itself
+        if ( res[smallestCloseVert] == smallestCloseVert )
+            continue; // smallestCloseVert is not mapped further
+
+        // find another closest
+        smallestCloseVert = v;
+        forEachCloseVert( v, [&]( VertId cv )
+        {
+            if ( cv == v )
+                return;
+            if ( res[cv] != cv )
+                return; // cv vertex is removed by itself
+            smallestCloseVert = std::min( smallestCloseVert, cv );
+        } );
+        res[v] = smallestCloseVert;
+    }
+}
+
+/// valid points sorted by the cells of regular grid
+class CloseVertsGrid
+{
+public:
+    CloseVertsGrid( const VertCoords & points, float cellSize, const VertBitSet * valid );
+
+    /// the key of the cell containing given point
+    [[nodiscard]] std::uint64_t key( const Vector3f & p, int dx = 0, int dy = 0, int dz = 0 ) const
+    {
+        // each coordinate of the cell including neighbours fits in cMaxCells, so all keys are distinct
+        auto c = [&]( int i, int d ) { return std::uint64_t( std::int64_t( std::floor( ( p[i] - origin_[i] ) / cellSize_ ) ) + 1 + d ); };
+        return c( 0, dx ) | ( c( 1, dy ) << 21 ) | ( c( 2, dz ) << 42 );
+    }
+
+    /// the points sorted by the keys of their cells
+    [[nodiscard]] const std::vector<std::pair<std::uint64_t, VertId>> & sorted() const { return sorted_; }
+
+    /// calls given function for each range [first, last) in sorted() with the points from 27 cells around the cell of given point
+    template<class F>
+    void forEachNeighbourCell( const Vector3f & p, F && f ) const
+    {
+        for ( int dz = -1; dz <= 1; ++dz )
+            for ( int dy = -1; dy <= 1; ++dy )
+                for ( int dx = -1; dx <= 1; ++dx )
+                {
+                    const auto k = key( p, dx, dy, dz );
+                    const auto first = std::lower_bound( sorted_.begin(), sorted_.end(), k, []( const auto & a, std::uint64_t b ) { return a.first < b; } );
+                    auto last = first;
+                    while ( last != sorted_.end() && last->first == k )
+                        ++last;
+                    if ( first != last )
+                        f( size_t( first - sorted_.begin() ), size_t( last - sorted_.begin() ) );
+                }
+    }
+
+    /// the maximal number of cells along each axis, leaving place for neighbours of border cells in 21 bits
+    static constexpr int cMaxCells = ( 1 << 21 ) - 3;
+
+private:
+    Vector3f origin_;
+    float cellSize_ = 1;
+    std::vector<std::pair<std::uint64_t, VertId>> sorted_;
+};
+
+CloseVertsGrid::CloseVertsGrid( const VertCoords & points, float cellSize, const VertBitSet * valid )
+{
+    MR_TIMER;
+    Box3f box;
+    for ( auto v = 0_v; v < points.size(); ++v )
+        if ( !valid || valid->test( v ) )
+            box.include( points[v] );
+    if ( !box.valid() )
+        return;
+    origin_ = box.min;
+    // larger cells are also suitable for the search, but they contain more points
+    const auto size = box.size();
+    cellSize_ = std::max( cellSize, std::max( { size.x, size.y, size.z } ) / cMaxCells );
+    if ( !( cellSize_ > 0 ) )
+        cellSize_ = 1; // all points coincide
+
+    sorted_.reserve( valid ? valid->count() : points.size() );
+    for ( auto v = 0_v; v < points.size(); ++v )
+        if ( !valid || valid->test( v ) )
+            sorted_.push_back( { 0, v } );
+    ParallelFor( sorted_, [&]( size_t i )
+    {
+        sorted_[i].first = key( points[sorted_[i].second] );
+    } );
+    tbb::parallel_sort( sorted_.begin(), sorted_.end() );
+}
+
+} //anonymous namespace
+
+std::optional<VertMap> findSmallestCloseVerticesUsingGrid( const VertCoords & points, float closeDist, const VertBitSet * valid, const ProgressCallback & cb )
+{
+    MR_TIMER;
+
+    VertMap res;
+    res.resizeNoInit( points.size() );
+    ParallelFor( points, [&]( VertId v ) { res[v] = v; } );
+
+    const CloseVertsGrid grid( points, closeDist, valid );
+    const auto & sorted = grid.sorted();
+    if ( !reportProgress( cb, 0.2f ) )
+        return {};
+
+    // the positions in sorted array where new cells start
+    std::vector<size_t> cellStarts;
+    for ( size_t i = 0; i < sorted.size(); ++i )
+        if ( i == 0 || sorted[i].first != sorted[i - 1].first )
+            cellStarts.push_back( i );
+    cellStarts.push_back( sorted.size() );
+
+    // each cell is processed by one thread, which writes only the map of the points in the cell
+    const auto closeDistSq = sqr( closeDist );
+    if ( !ParallelFor( size_t( 0 ), cellStarts.size() - 1, [&]( size_t c )
+    {
+        const auto cellFirst = cellStarts[c];
+        const auto cellLast = cellStarts[c + 1];
+        grid.forEachNeighbourCell( points[sorted[cellFirst].second], [&]( size_t first, size_t last )
+        {
+            for ( auto i = cellFirst; i < cellLast; ++i )
+            {
+                const auto v = sorted[i].second;
+                const auto & p = points[v];
+                auto & smallestCloseVert = res[v];
+                for ( auto j = first; j < last; ++j )
+                {
+                    const auto u = sorted[j].second;
+                    if ( u < smallestCloseVert && ( points[u] - p ).lengthSq() <= closeDistSq )
+                        smallestCloseVert = u;
+                }
+            }
+        } );
+    }, subprogress( cb, 0.2f, 0.9f ) ) )
+        return {};
+
+    remapToSmallest( res, points, valid, [&]( VertId v, auto && callback )
+    {
+        const auto & p = points[v];
+        grid.forEachNeighbourCell( p, [&]( size_t first, size_t last )
+        {
+            for ( auto j = first; j < last; ++j )
+                if ( ( points[sorted[j].second] - p ).lengthSq() <= closeDistSq )
+                    callback( sorted[j].second );
+        } );
+    } );
+
+    if ( !reportProgress( cb, 1.0f ) )
+        return {};
+    return res;
+}
+
 std::optional<VertMap> findSmallestCloseVerticesUsingTree( const VertCoords & points, float closeDist, const AABBTreePoints & tree, const VertBitSet * valid, const ProgressCallback & cb )
 {
     MR_TIMER;
@@ -34,32 +206,14 @@ std::optional<VertMap> findSmallestCloseVerticesUsingTree( const VertCoords & po
     }, subprogress( cb, 0.0f, 0.8f ) ) )
         return {};
 
-    // after parallel pass, some close vertices can be mapped further
-
-    for ( auto v = 0_v; v < points.size(); ++v )
+    remapToSmallest( res, points, valid, [&]( VertId v, auto && callback )
     {
-        if ( valid && !valid->test( v ) )
-            continue;
-        VertId smallestCloseVert = res[v];
-        if ( smallestCloseVert == v )
-            continue; // v is the smallest closest by itself
-        if ( res[smallestCloseVert] == smallestCloseVert )
-            continue; // smallestCloseVert is not mapped further
-
-        // find another closest
-        smallestCloseVert = v;
         findPointsInBall( tree, { points[v], closeDistSq }, [&]( const PointsProjectionResult & found, const Vector3f &, Ball3f & )
         {
-            const auto cv = found.vId;
-            if ( cv == v )
-                return Processing::Continue;
-            if ( res[cv] != cv )
-                return Processing::Continue; // cv vertex is removed by itself
-            smallestCloseVert = std::min( smallestCloseVert, cv );
+            callback( found.vId );
             return Processing::Continue;
         } );
-        res[v] = smallestCloseVert;
-    }
+    } );
 
     if ( !reportProgress( cb, 1.0f ) )
         return {};
@@ -73,6 +227,35 @@ std::optional<VertMap> findSmallestCloseVertices( const VertCoords & points, flo
     return findSmallestCloseVerticesUsingTree( points, closeDist, tree, valid, cb );
 }
 
+TEST( MRMesh, FindSmallestCloseVerticesUsingGrid )
+{
+    // triangle soup of a sphere, where each vertex is repeated in all its triangles, with small noise
+    const auto sphere = makeUVSphere( 1.0f, 16, 16 );
+    VertCoords points;
+    for ( auto f : sphere.topology.getValidFaces() )
+    {
+        const auto tri = sphere.topology.getTriVerts( f );
+        for ( int i = 0; i < 3; ++i )
+            points.push_back( sphere.points[tri[i]] + Vector3f::diagonal( 1e-5f * float( i ) ) );
+    }
+    VertBitSet valid( points.size(), true );
+    valid.reset( 1_v );
+
+    const float closeDist = 1e-3f;
+    const auto byTree = findSmallestCloseVertices( points, closeDist, &valid );
+    const auto byGrid = findSmallestCloseVerticesUsingGrid( points, closeDist, &valid );
+    ASSERT_TRUE( byTree.has_value() );
+    ASSERT_TRUE( byGrid.has_value() );
+    EXPECT_EQ( byTree->vec_, byGrid->vec_ );
+    EXPECT_EQ( ( *byGrid )[1_v], 1_v );
+
+    // exactly coinciding points only
+    const auto exact = findSmallestCloseVerticesUsingGrid( points, 0.0f, nullptr );
+    ASSERT_TRUE( exact.has_value() );
+    EXPECT_EQ( ( *exact )[0_v], 0_v );
+    EXPECT_EQ( ( *exact )[1_v], 1_v );
+}
+
 std::optional<VertMap> findSmallestCloseVertices( const Mesh & mesh, float closeDist, const ProgressCallback & cb )
 {
     return findSmallestCloseVerticesUsingTree( mesh.points, closeDist, mesh.getAABBTreePoints(), &mesh.topology.getValidVerts(), cb );
@@ -23,6 +23,11 @@ namespace MR
 /// each vertex not from valid set is mapped to itself; given tree is used as is
 [[nodiscard]] MRMESH_API std::optional<VertMap> findSmallestCloseVerticesUsingTree( const VertCoords & points, float closeDist, const AABBTreePoints & tree, const VertBitSet * valid, const ProgressCallback & cb = {} );
 
+/// returns a map where each valid vertex is mapped to the smallest valid vertex Id located within given distance (including itself), and this smallest vertex is mapped to itself,
+/// each vertex not from valid set is mapped to itself; the vertices are sorted by the cells of regular grid with the size closeDist,
+/// and only 27 neighbour cells are probed for each cell; it is faster than the search in a tree if there are many coinciding vertices (e.g. in triangle soups)
+[[nodiscard]] MRMESH_API std::optional<VertMap> findSmallestCloseVerticesUsingGrid( const VertCoords & points, float closeDist, const VertBitSet * valid, const ProgressCallback & cb = {} );
+
 /// finds all close vertices, where for each vertex there is another one located within given distance
 [[nodiscard]] MRMESH_API std::optional<VertBitSet> findCloseVertices( const Mesh & mesh, float closeDist, const ProgressCallback & cb = {} );
 
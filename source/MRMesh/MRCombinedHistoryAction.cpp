@@ -28,6 +28,13 @@ void CombinedHistoryAction::action( HistoryAction::Type type )
     }
 }
 
+void CombinedHistoryAction::changesFinished()
+{
+    for ( auto& histAct : actions_ )
+        if ( histAct )
+            histAct->changesFinished();
+}
+
 bool CombinedHistoryAction::filter( HistoryStackFilter filteringCondition )
 {
     return filterHistoryActionsVector( actions_, filteringCondition ).first;
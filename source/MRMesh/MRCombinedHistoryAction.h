@@ -21,6 +21,9 @@ public:
 
     MRMESH_API virtual void action( HistoryAction::Type type ) override;
 
+    /// calls changesFinished() for each action
+    MRMESH_API virtual void changesFinished() override;
+
           HistoryActionsVector& getStack()       { return actions_; }
     const HistoryActionsVector& getStack() const { return actions_; }
 
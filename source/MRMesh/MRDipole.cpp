@@ -5,6 +5,7 @@
 #include "MRParallelFor.h"
 #include "MRTimer.h"
 #include "MRGTest.h"
+#include "MRTorus.h"
 
 namespace MR
 {
@@ -92,6 +93,37 @@ static float triangleSolidAngle( const Vector3f & p, const Triangle3f & tri )
     return 2 * std::atan2( m.det(), den );
 }
 
+/// returns the sum of solid angles (not divided on 4 pi) of the subtree starting from given node at point \param q
+static float calcSubtreeSolidAngle( const Dipoles& dipoles, const AABBTree& tree, const Mesh& mesh,
+    const Vector3f & q, float betaSq, FaceId skipFace, NodeId start )
+{
+    InplaceStack<NoInitNodeId, 32> subtasks;
+    subtasks.push( start );
+
+    float res = 0;
+    while ( !subtasks.empty() )
+    {
+        NodeId i = subtasks.top();
+        subtasks.pop();
+        const auto & node = tree[i];
+        const auto & d = dipoles[i];
+        if ( d.addIfGoodApprox( q, betaSq, res ) )
+            continue;
+        if ( !node.leaf() )
+        {
+            // recurse deeper
+            subtasks.push( node.r ); // to look later
+            subtasks.push( node.l ); // to look first
+            continue;
+        }
+        if ( node.leafId() != skipFace )
+            res += triangleSolidAngle( q, mesh.getTriPoints( node.leafId() ) );
+    }
+    return res;
+}
+
+constexpr float INV_4PI = 1.0f / ( 4 * PI_F );
+
 float calcFastWindingNumber( const Dipoles& dipoles, const AABBTree& tree, const Mesh& mesh,
     const Vector3f & q, float beta, FaceId skipFace )
 {
@@ -100,32 +132,124 @@ float calcFastWindingNumber( const Dipoles& dipoles, const AABBTree& tree, const
         assert( false );
         return 0;
     }
+    return INV_4PI * calcSubtreeSolidAngle( dipoles, tree, mesh, q, sqr( beta ), skipFace, AABBTree::rootNodeId() );
+}
+
+namespace
+{
+
+/// the points of one group evaluated together in structure-of-arrays layout;
+/// the loops common for all points always run over the whole group with constant trip count and without branches,
+/// so the compiler vectorizes them (MRDipole.cpp is compiled with -fno-math-errno for std::sqrt not to prevent that)
+constexpr int cGroupSize = 64;
+
+struct PointGroup
+{
+    int size = 0; ///< the number of actual points, the remaining slots are filled with the copies of the last point
+    alignas( 64 ) float x[cGroupSize];
+    alignas( 64 ) float y[cGroupSize];
+    alignas( 64 ) float z[cGroupSize];
+    alignas( 64 ) float sum[cGroupSize];
+    alignas( 64 ) float distSq[cGroupSize];
+};
+
+void calcGroupSolidAngles( const Dipoles& dipoles, const AABBTree& tree, const Mesh& mesh, PointGroup& g, float betaSq )
+{
+    const int n = g.size;
+    for ( int k = 0; k < cGroupSize; ++k )
+        g.sum[k] = 0;
 
-    const float betaSq = sqr( beta );
     InplaceStack<NoInitNodeId, 32> subtasks;
     subtasks.push( AABBTree::rootNodeId() );
-
-    float res = 0;
     while ( !subtasks.empty() )
     {
         NodeId i = subtasks.top();
         subtasks.pop();
         const auto & node = tree[i];
         const auto & d = dipoles[i];
-        if ( d.addIfGoodApprox( q, betaSq, res ) )
+
+        // integer count of far points instead of floating-point min/max reduction, which is not vectorized without -ffast-math
+        const auto approxDistSq = betaSq * d.rr;
+        int numFar = 0;
+        for ( int k = 0; k < cGroupSize; ++k )
+        {
+            const auto dd = sqr( d.pos.x - g.x[k] ) + sqr( d.pos.y - g.y[k] ) + sqr( d.pos.z - g.z[k] );
+            g.distSq[k] = dd;
+            numFar += dd > approxDistSq;
+        }
+
+        if ( numFar == cGroupSize )
+        {
+            // the dipole is good approximation for all points of the group, and all distances are positive
+            for ( int k = 0; k < cGroupSize; ++k )
+            {
+                const auto dd = g.distSq[k];
+                const auto dotDir = ( d.pos.x - g.x[k] ) * d.dirArea.x + ( d.pos.y - g.y[k] ) * d.dirArea.y + ( d.pos.z - g.z[k] ) * d.dirArea.z;
+                g.sum[k] += dotDir / ( std::sqrt( dd ) * dd );
+            }
+            continue;
+        }
+
+        if ( numFar > 0 )
+        {
+            // the dipole is good approximation only for some points: the others descend in the subtree one by one
+            for ( int k = 0; k < n; ++k )
+            {
+                const Vector3f q( g.x[k], g.y[k], g.z[k] );
+                if ( !d.addIfGoodApprox( q, betaSq, g.sum[k] ) )
+                    g.sum[k] += calcSubtreeSolidAngle( dipoles, tree, mesh, q, betaSq, {}, i );
+            }
             continue;
+        }
+
         if ( !node.leaf() )
         {
-            // recurse deeper
+            // recurse deeper with the whole group
             subtasks.push( node.r ); // to look later
             subtasks.push( node.l ); // to look first
             continue;
         }
-        if ( node.leafId() != skipFace )
-            res += triangleSolidAngle( q, mesh.getTriPoints( node.leafId() ) );
+        const auto tri = mesh.getTriPoints( node.leafId() );
+        for ( int k = 0; k < n; ++k )
+            g.sum[k] += triangleSolidAngle( Vector3f( g.x[k], g.y[k], g.z[k] ), tri );
+    }
+}
+
+} // anonymous namespace
+
+void calcFastWindingNumbers( const Dipoles& dipoles, const AABBTree& tree, const Mesh& mesh,
+    std::span<const Vector3f> qs, std::span<float> res, float beta )
+{
+    assert( qs.size() == res.size() );
+    if ( dipoles.empty() )
+    {
+        assert( false );
+        std::fill( res.begin(), res.end(), 0.f );
+        return;
+    }
+
+    const float betaSq = sqr( beta );
+    PointGroup g;
+    for ( size_t first = 0; first < qs.size(); first += cGroupSize )
+    {
+        g.size = int( std::min( qs.size() - first, size_t( cGroupSize ) ) );
+        for ( int k = 0; k < g.size; ++k )
+        {
+            const auto & q = qs[first + k];
+            g.x[k] = q.x;
+            g.y[k] = q.y;
+            g.z[k] = q.z;
+        }
+        for ( int k = g.size; k < cGroupSize; ++k )
+        {
+            g.x[k] = g.x[g.size - 1];
+            g.y[k] = g.y[g.size - 1];
+            g.z[k] = g.z[g.size - 1];
+        }
+        calcGroupSolidAngles( dipoles, tree, mesh, g, betaSq );
+        for ( int k = 0; k < g.size; ++k )
+            res[first + k] = INV_4PI * g.sum[k];
     }
-    constexpr float INV_4PI = 1.0f / ( 4 * PI_F );
-    return INV_4PI * res;
 }
 
 TEST(MRMesh, TriangleSolidAngle)
@@ -156,4 +280,23 @@ TEST(MRMesh, TriangleSolidAngle)
     EXPECT_EQ( triangleSolidAngle( -tri[2], tri ), 0 );
 }
 
+TEST(MRMesh, FastWindingNumbersInGroup)
+{
+    Mesh mesh = makeTorus( 1.f, 0.3f, 32, 16 );
+    const auto& tree = mesh.getAABBTree();
+    const auto& dipoles = mesh.getDipoles();
+
+    // a brick of points crossing the surface of the torus
+    std::vector<Vector3f> qs;
+    for ( int z = 0; z < 4; ++z )
+        for ( int y = 0; y < 4; ++y )
+            for ( int x = 0; x < 8; ++x )
+                qs.emplace_back( 0.5f + 0.12f * x, 0.05f * y, -0.2f + 0.1f * z );
+
+    std::vector<float> res( qs.size() );
+    calcFastWindingNumbers( dipoles, tree, mesh, qs, res, 2 );
+    for ( size_t i = 0; i < qs.size(); ++i )
+        EXPECT_NEAR( res[i], calcFastWindingNumber( dipoles, tree, mesh, qs[i], 2, {} ), 1e-5f );
+}
+
 } //namespace MR
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "MRVector3.h"
+#include <span>
 
 namespace MR
 {
@@ -40,4 +41,12 @@ MRMESH_API void calcDipoles( Dipoles& dipoles, const AABBTree& tree, const Mesh&
 [[nodiscard]] MRMESH_API float calcFastWindingNumber( const Dipoles& dipoles, const AABBTree& tree, const Mesh& mesh,
     const Vector3f & q, float beta, FaceId skipFace );
 
+/// compute approximate winding numbers at all points \param qs and put them in \param res (of the same size);
+/// the points are expected to be close to one another (e.g. the centers of a small brick of voxels):
+/// the tree is traversed once for a group of points, and the contribution of a dipole is accumulated in all points of the group
+/// by a single vectorizable loop if the dipole is good approximation for each of them;
+/// the results are the same as from calcFastWindingNumber called for each point separately (up to the order of summation)
+MRMESH_API void calcFastWindingNumbers( const Dipoles& dipoles, const AABBTree& tree, const Mesh& mesh,
+    std::span<const Vector3f> qs, std::span<float> res, float beta );
+
 } //namespace MR
@@ -9,6 +9,9 @@
 #include "MRDipole.h"
 #include "MRIsNaN.h"
 #include "MRDistanceToMeshOptions.h"
+#include "MRGTest.h"
+#include "MRTorus.h"
+#include <array>
 
 namespace MR
 {
@@ -51,6 +54,44 @@ Expected<void> FastWindingNumber::calcSelfIntersections( FaceBitSet& res, float
     return {};
 }
 
+namespace
+{
+
+/// the grid is processed by bricks of voxels, each brick's winding numbers are computed with single traversal of the tree
+constexpr int cBrickSide = 4;
+
+/// calls given function for each brick of the grid in parallel with the voxels of the brick and the points in their centers
+template<typename F>
+bool forEachBrick( const VolumeIndexer& indexer, const AffineXf3f& gridToMeshXf, F && f, const ProgressCallback& cb )
+{
+    const auto& dims = indexer.dims();
+    const Vector3i numBricks( ( dims.x + cBrickSide - 1 ) / cBrickSide, ( dims.y + cBrickSide - 1 ) / cBrickSide, ( dims.z + cBrickSide - 1 ) / cBrickSide );
+    const VolumeIndexer brickIndexer( numBricks );
+    return ParallelFor( size_t( 0 ), brickIndexer.size(), [&]( size_t b )
+    {
+        const auto brickPos = cBrickSide * brickIndexer.toPos( VoxelId( b ) );
+        const Vector3i brickEnd(
+            std::min( brickPos.x + cBrickSide, dims.x ),
+            std::min( brickPos.y + cBrickSide, dims.y ),
+            std::min( brickPos.z + cBrickSide, dims.z ) );
+        std::array<VoxelId, cBrickSide * cBrickSide * cBrickSide> voxels;
+        std::array<Vector3f, cBrickSide * cBrickSide * cBrickSide> points;
+        int n = 0;
+        for ( int z = brickPos.z; z < brickEnd.z; ++z )
+            for ( int y = brickPos.y; y < brickEnd.y; ++y )
+                for ( int x = brickPos.x; x < brickEnd.x; ++x )
+                {
+                    const Vector3i pos( x, y, z );
+                    voxels[n] = indexer.toVoxelId( pos );
+                    points[n] = gridToMeshXf( Vector3f( pos ) );
+                    ++n;
+                }
+        f( std::span<const VoxelId>( voxels.data(), n ), std::span<const Vector3f>( points.data(), n ) );
+    }, cb, 1 );
+}
+
+} // anonymous namespace
+
 Expected<void> FastWindingNumber::calcFromGrid( std::vector<float>& res, const Vector3i& dims, const AffineXf3f& gridToMeshXf, float beta, const ProgressCallback& cb )
 {
     MR_TIMER;
@@ -58,9 +99,13 @@ Expected<void> FastWindingNumber::calcFromGrid( std::vector<float>& res, const V
     VolumeIndexer indexer( dims );
     res.resize( indexer.size() );
 
-    if ( !ParallelFor( 0_vox, indexer.endId(), [&]( VoxelId i )
+    if ( !forEachBrick( indexer, gridToMeshXf, [&]( std::span<const VoxelId> voxels, std::span<const Vector3f> points )
     {
-        res[i] = calc_( gridToMeshXf( Vector3f( indexer.toPos( i ) ) ), beta );
+        std::array<float, cBrickSide * cBrickSide * cBrickSide> wns;
+        const std::span<float> brickWns( wns.data(), points.size() );
+        calcFastWindingNumbers( dipoles_, tree_, mesh_, points, brickWns, beta );
+        for ( size_t k = 0; k < voxels.size(); ++k )
+            res[voxels[k]] = brickWns[k];
     }, cb ) )
         return unexpectedOperationCanceled();
     return {};
@@ -82,15 +127,66 @@ Expected<void> FastWindingNumber::calcFromGridWithDistances( std::vector<float>&
     VolumeIndexer indexer( dims );
     res.resize( indexer.size() );
 
-    MeshPart mp( mesh_ );
-
-    if ( !ParallelFor( 0_vox, indexer.endId(), [&]( VoxelId i )
+    if ( !forEachBrick( indexer, gridToMeshXf, [&]( std::span<const VoxelId> voxels, std::span<const Vector3f> points )
+    {
+        // first find distances in all voxels of the brick, and then the signs only in the voxels where they are necessary
+        constexpr int cBrickSize = cBrickSide * cBrickSide * cBrickSide;
+        std::array<int, cBrickSize> signedIds;
+        std::array<Vector3f, cBrickSize> signedPoints;
+        int numSigned = 0;
+        for ( size_t k = 0; k < voxels.size(); ++k )
         {
-            const auto transformedPoint = gridToMeshXf( Vector3f( indexer.toPos( i ) ) );
-            res[i] = calcWithDistances( transformedPoint, options );
-        }, cb ) )
+            const auto distSq = findProjection( points[k], mesh_, options.maxDistSq, nullptr, options.minDistSq ).distSq;
+            if ( options.nullOutsideMinMax && ( distSq < options.minDistSq || distSq >= options.maxDistSq ) ) // note that distSq == minDistSq (e.g. == 0) is a valid situation
+            {
+                res[voxels[k]] = cQuietNan;
+                continue;
+            }
+            res[voxels[k]] = std::sqrt( distSq );
+            signedIds[numSigned] = int( k );
+            signedPoints[numSigned] = points[k];
+            ++numSigned;
+        }
+
+        std::array<float, cBrickSize> wns;
+        calcFastWindingNumbers( dipoles_, tree_, mesh_, std::span<const Vector3f>( signedPoints.data(), numSigned ),
+            std::span<float>( wns.data(), numSigned ), options.windingNumberBeta );
+        for ( int j = 0; j < numSigned; ++j )
+            if ( wns[j] > options.windingNumberThreshold )
+                res[voxels[signedIds[j]]] = -res[voxels[signedIds[j]]];
+    }, cb ) )
         return unexpectedOperationCanceled();
     return {};
 }
 
+TEST( MRMesh, FastWindingNumberGrid )
+{
+    Mesh mesh = makeTorus( 1.f, 0.3f, 32, 16 );
+    FastWindingNumber fwn( mesh );
+
+    const Vector3i dims( 13, 11, 6 ); // not divisible by brick size
+    const AffineXf3f gridToMeshXf( Matrix3f::scale( 0.2f ), Vector3f( -1.3f, -1.1f, -0.5f ) );
+    const VolumeIndexer indexer( dims );
+
+    std::vector<float> wns;
+    EXPECT_TRUE( fwn.calcFromGrid( wns, dims, gridToMeshXf, 2, {} ).has_value() );
+    ASSERT_EQ( wns.size(), indexer.size() );
+
+    const DistanceToMeshOptions options{ .maxDistSq = 0.09f, .nullOutsideMinMax = true };
+    std::vector<float> dists;
+    EXPECT_TRUE( fwn.calcFromGridWithDistances( dists, dims, gridToMeshXf, options, {} ).has_value() );
+    ASSERT_EQ( dists.size(), indexer.size() );
+
+    for ( auto i = 0_vox; i < indexer.endId(); ++i )
+    {
+        const auto p = gridToMeshXf( Vector3f( indexer.toPos( i ) ) );
+        EXPECT_NEAR( wns[i], calcFastWindingNumber( mesh.getDipoles(), mesh.getAABBTree(), mesh, p, 2, {} ), 1e-5f );
+        const auto dist = fwn.calcWithDistances( p, options );
+        if ( isNanFast( dist ) )
+            EXPECT_TRUE( isNanFast( dists[i] ) );
+        else
+            EXPECT_NEAR( dists[i], dist, 1e-6f );
+    }
+}
+
 } // namespace MR
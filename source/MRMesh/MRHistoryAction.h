@@ -23,6 +23,10 @@ public:
     /// This function is called on history action (undo, redo, etc.)
     virtual void action( Type actionType ) = 0;
 
+    /// This function is called by history store when the changes recorded by this action are finished
+    /// (next action is appended after this one); here the action can replace a full copy of the other state with a compact difference
+    virtual void changesFinished() {}
+
     /// returns the amount of memory this object occupies on heap
     [[nodiscard]] virtual size_t heapBytes() const = 0;
 };
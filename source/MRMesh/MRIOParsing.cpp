@@ -2,6 +2,7 @@
 #include "MRVector3.h"
 #include "MRColor.h"
 #include "MRString.h"
+#include "MRParallelFor.h"
 #include "MRTimer.h"
 #include "MRPch/MRTBB.h"
 
@@ -97,6 +98,41 @@ std::vector<size_t> splitByLines( const char* data, size_t size )
     return newlines;
 }
 
+Expected<void> parseLinesByChunks( size_t numLines,
+    const std::function<Expected<void>( size_t chunk, size_t firstLine, size_t lastLine )>& parseChunk, const ProgressCallback& cb )
+{
+    MR_TIMER;
+    const auto numChunks = numParseChunks( numLines );
+
+    std::mutex errorMutex;
+    size_t errorChunk = numChunks;
+    std::string error;
+    std::atomic<bool> failed{ false };
+    const auto keepGoing = ParallelFor( size_t( 0 ), numChunks, [&] ( size_t chunk )
+    {
+        if ( failed.load( std::memory_order_relaxed ) )
+            return;
+        const auto firstLine = chunk * cLinesInParseChunk;
+        const auto lastLine = std::min( numLines, firstLine + cLinesInParseChunk );
+        auto res = parseChunk( chunk, firstLine, lastLine );
+        if ( res )
+            return;
+        failed = true;
+        std::unique_lock lock( errorMutex );
+        if ( chunk < errorChunk )
+        {
+            errorChunk = chunk;
+            error = std::move( res.error() );
+        }
+    }, cb, 1 );
+
+    if ( failed )
+        return unexpected( std::move( error ) );
+    if ( !keepGoing )
+        return unexpectedOperationCanceled();
+    return {};
+}
+
 std::streamoff getStreamSize( std::istream& in )
 {
     const auto posStart = in.tellg();
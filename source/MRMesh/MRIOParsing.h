@@ -3,7 +3,9 @@
 #include "MRExpected.h"
 #include "MRBuffer.h"
 #include "MRPch/MRBindingMacros.h"
+#include <functional>
 #include <istream>
+#include <string_view>
 
 namespace MR
 {
@@ -11,6 +13,24 @@ namespace MR
 // returns offsets for each new line in monolith char block
 MRMESH_API std::vector<size_t> splitByLines( const char* data, size_t size );
 
+// the number of consecutive lines parsed by one task in parseLinesByChunks;
+// it is a multiple of 64 so that the bits of a bit-set associated with different chunks never share a block
+constexpr size_t cLinesInParseChunk = 4096;
+
+// returns the number of chunks the lines are split in by parseLinesByChunks
+inline size_t numParseChunks( size_t numLines ) { return ( numLines + cLinesInParseChunk - 1 ) / cLinesInParseChunk; }
+
+// returns the line with given index from the text split by splitByLines (including line ending characters)
+inline std::string_view getLine( const char* data, const std::vector<size_t>& newlines, size_t line )
+    { return { data + newlines[line], newlines[line + 1] - newlines[line] }; }
+
+// calls parseChunk( chunk, firstLine, lastLine ) in parallel for consecutive chunks of cLinesInParseChunk lines in [0, numLines),
+// the chunk is the index of the chunk, and the lines [firstLine, lastLine) are to be parsed in it;
+// the parsing stops after the first chunk returning an error, and the error of the chunk with the smallest index among failed ones is returned;
+// returns unexpectedOperationCanceled() if the progress callback returned false
+MR_BIND_IGNORE MRMESH_API Expected<void> parseLinesByChunks( size_t numLines,
+    const std::function<Expected<void>( size_t chunk, size_t firstLine, size_t lastLine )>& parseChunk, const ProgressCallback& cb = {} );
+
 // get the size of the remaining data in the input stream
 MRMESH_API std::streamoff getStreamSize( std::istream& in );
 
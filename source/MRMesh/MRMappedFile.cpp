@@ -0,0 +1,135 @@
+#include "MRMappedFile.h"
+#include "MRStringConvert.h"
+#include "MRGTest.h"
+#include "MRUniqueTemporaryFolder.h"
+#include <fstream>
+#include <utility>
+
+#ifdef _WIN32
+#include "MRPch/MRWinapi.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace MR
+{
+
+Expected<void> MappedFile::open( const std::filesystem::path & filename, [[maybe_unused]] bool sequential )
+{
+    close();
+#ifdef _WIN32
+    HANDLE file = CreateFileW( filename.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_ATTRIBUTE_NORMAL, nullptr );
+    if ( file == INVALID_HANDLE_VALUE )
+        return unexpected( "Cannot open file for reading " + utf8string( filename ) );
+
+    LARGE_INTEGER fileSize;
+    if ( !GetFileSizeEx( file, &fileSize ) )
+    {
+        CloseHandle( file );
+        return unexpected( "Cannot get the size of file " + utf8string( filename ) );
+    }
+    if ( fileSize.QuadPart > 0 )
+    {
+        // the mapping keeps the file open, so its handle can be closed right after
+        HANDLE mapping = CreateFileMappingW( file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+        CloseHandle( file );
+        if ( !mapping )
+            return unexpected( "Cannot map file " + utf8string( filename ) );
+        auto view = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+        if ( !view )
+        {
+            CloseHandle( mapping );
+            return unexpected( "Cannot map file " + utf8string( filename ) );
+        }
+        mapping_ = mapping;
+        data_ = (const char*)view;
+        size_ = size_t( fileSize.QuadPart );
+    }
+    else
+        CloseHandle( file );
+#else
+    const int fd = ::open( utf8string( filename ).c_str(), O_RDONLY );
+    if ( fd < 0 )
+        return unexpected( "Cannot open file for reading " + utf8string( filename ) );
+
+    struct stat st;
+    if ( fstat( fd, &st ) != 0 || !S_ISREG( st.st_mode ) )
+    {
+        ::close( fd );
+        return unexpected( "Cannot map file " + utf8string( filename ) );
+    }
+    if ( st.st_size > 0 )
+    {
+        // the mapping keeps the file open, so its descriptor can be closed right after
+        void * view = mmap( nullptr, size_t( st.st_size ), PROT_READ, MAP_PRIVATE, fd, 0 );
+        ::close( fd );
+        if ( view == MAP_FAILED )
+            return unexpected( "Cannot map file " + utf8string( filename ) );
+        if ( sequential )
+            madvise( view, size_t( st.st_size ), MADV_SEQUENTIAL );
+        data_ = (const char*)view;
+        size_ = size_t( st.st_size );
+    }
+    else
+        ::close( fd );
+#endif
+    opened_ = true;
+    return {};
+}
+
+void MappedFile::close()
+{
+    if ( data_ )
+    {
+#ifdef _WIN32
+        UnmapViewOfFile( data_ );
+        CloseHandle( mapping_ );
+        mapping_ = nullptr;
+#else
+        munmap( const_cast<char*>( data_ ), size_ );
+#endif
+    }
+    data_ = nullptr;
+    size_ = 0;
+    opened_ = false;
+}
+
+void MappedFile::swap( MappedFile & r ) noexcept
+{
+    std::swap( data_, r.data_ );
+    std::swap( size_, r.size_ );
+    std::swap( opened_, r.opened_ );
+#ifdef _WIN32
+    std::swap( mapping_, r.mapping_ );
+#endif
+}
+
+TEST( MRMesh, MappedFile )
+{
+    UniqueTemporaryFolder folder( {} );
+    const auto path = folder / "mapped.bin";
+    {
+        std::ofstream out( path, std::ofstream::binary );
+        out << "MeshLib";
+    }
+
+    MappedFile f;
+    EXPECT_TRUE( f.open( path ).has_value() );
+    EXPECT_TRUE( f.isOpen() );
+    ASSERT_EQ( f.size(), 7 );
+    EXPECT_EQ( std::string( f.data(), f.size() ), "MeshLib" );
+
+    MappedFile g( std::move( f ) );
+    EXPECT_FALSE( f.isOpen() );
+    EXPECT_EQ( g.size(), 7 );
+    g.close();
+    EXPECT_EQ( g.data(), nullptr );
+
+    EXPECT_FALSE( f.open( folder / "missing.bin" ).has_value() );
+}
+
+} //namespace MR
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "MRMeshFwd.h"
+#include "MRExpected.h"
+#include "MRPch/MRBindingMacros.h"
+#include <filesystem>
+
+namespace MR
+{
+
+/// the class to map whole file in memory for reading and automatically unmap it in the destructor;
+/// the pages of the file are loaded by the operating system on first access, so the data can be parsed directly without intermediate buffers
+class MR_BIND_IGNORE MappedFile
+{
+public:
+    MappedFile() = default;
+    MappedFile( const MappedFile & ) = delete;
+    MappedFile( MappedFile && r ) noexcept { swap( r ); }
+    ~MappedFile() { close(); }
+
+    MappedFile& operator =( const MappedFile & ) = delete;
+    MappedFile& operator =( MappedFile && r ) noexcept { close(); swap( r ); return * this; }
+
+    /// maps given file in memory in read-only mode, closing previously mapped file;
+    /// \param sequential hints the operating system that the data will be read from the beginning to the end
+    MRMESH_API Expected<void> open( const std::filesystem::path & filename, bool sequential = true );
+
+    /// unmaps the file
+    MRMESH_API void close();
+
+    /// returns true if a file is mapped (possibly empty one)
+    [[nodiscard]] bool isOpen() const { return opened_; }
+
+    /// the beginning of mapped data (nullptr for empty files)
+    [[nodiscard]] const char * data() const { return data_; }
+
+    /// the size of mapped data in bytes
+    [[nodiscard]] size_t size() const { return size_; }
+
+    MRMESH_API void swap( MappedFile & r ) noexcept;
+
+private:
+    const char * data_ = nullptr;
+    size_t size_ = 0;
+    bool opened_ = false;
+#ifdef _WIN32
+    void * mapping_ = nullptr;
+#endif
+};
+
+} // namespace MR
@@ -1,5 +1,6 @@
 #include "MRMesh.h"
 #include "MRAABBTree.h"
+#include "MRAABBTreeWide.h"
 #include "MRAABBTreePoints.h"
 #include "MRAffineXf3.h"
 #include "MRBitSet.h"
@@ -459,6 +460,7 @@ Expected<PackMapping> Mesh::packOptimally( bool preserveAABBTree, ProgressCallba
 
     PackMapping map;
     AABBTreePointsOwner_.reset(); // points-tree will be invalidated anyway
+    AABBTreeWideOwner_.reset(); // wide tree refers to old face ids
     if ( preserveAABBTree )
     {
         getAABBTree(); // ensure that tree is constructed
@@ -534,6 +536,16 @@ const AABBTree & Mesh::getAABBTree() const
     return res;
 }
 
+const AABBTreeWide & Mesh::getAABBTreeWide() const
+{
+    if ( auto pRes = AABBTreeWideOwner_.get() )
+        return *pRes; // fast path without tree access
+    const auto & tree = getAABBTree(); // must be ready before lambda body for single-threaded Emscripten
+    const auto & res = AABBTreeWideOwner_.getOrCreate( [&tree]{ return AABBTreeWide( tree ); } );
+    assert( res.numLeaves() == tree.numLeaves() );
+    return res;
+}
+
 const AABBTreePoints & Mesh::getAABBTreePoints() const
 {
     const auto & res = AABBTreePointsOwner_.getOrCreate( [this]{ return AABBTreePoints( *this ); } );
@@ -557,23 +569,37 @@ const Dipoles & Mesh::getDipoles() const
 void Mesh::invalidateCaches( bool pointsChanged )
 {
     AABBTreeOwner_.reset();
+    AABBTreeWideOwner_.reset();
     if ( pointsChanged )
         AABBTreePointsOwner_.reset();
     dipolesOwner_.reset();
 }
 
-void Mesh::updateCaches( const VertBitSet & changedVerts )
+void Mesh::updateCaches( const VertBitSet & changedVerts, float treeRebuildAreaRatio )
 {
     AABBTreeOwner_.update( [&]( AABBTree & tree )
     {
         assert( tree.numLeaves() == topology.numValidFaces() );
-        tree.refit( *this, changedVerts );
+        tree.refit( *this, changedVerts, treeRebuildAreaRatio );
     } );
     AABBTreePointsOwner_.update( [&]( AABBTreePoints & tree )
     {
         assert( tree.orderedPoints().size() == topology.numValidVerts() );
         tree.refit( points, changedVerts );
     } );
+    AABBTreeWideOwner_.reset();
+    dipolesOwner_.reset();
+}
+
+void Mesh::updateCaches( const FaceBitSet & removedFaces, const FaceBitSet & addedFaces )
+{
+    AABBTreeOwner_.update( [&]( AABBTree & tree )
+    {
+        tree.replaceFaces( *this, removedFaces, addedFaces );
+        assert( tree.numLeaves() == topology.numValidFaces() );
+    } );
+    AABBTreeWideOwner_.reset();
+    AABBTreePointsOwner_.reset();
     dipolesOwner_.reset();
 }
 
@@ -582,6 +608,7 @@ size_t Mesh::heapBytes() const
     return topology.heapBytes()
         + points.heapBytes()
         + AABBTreeOwner_.heapBytes()
+        + AABBTreeWideOwner_.heapBytes()
         + AABBTreePointsOwner_.heapBytes()
         + dipolesOwner_.heapBytes();
 }
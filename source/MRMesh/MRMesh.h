@@ -454,6 +454,12 @@ struct [[nodiscard]] Mesh
     /// returns cached aabb-tree for this mesh, but does not create it if it did not exist
     [[nodiscard]] const AABBTree * getAABBTreeNotCreate() const { return AABBTreeOwner_.get(); }
 
+    /// returns cached wide aabb-tree for this mesh (built from getAABBTree()), creating it if it did not exist in a thread-safe manner
+    MRMESH_API const AABBTreeWide & getAABBTreeWide() const;
+
+    /// returns cached wide aabb-tree for this mesh, but does not create it if it did not exist
+    [[nodiscard]] const AABBTreeWide * getAABBTreeWideNotCreate() const { return AABBTreeWideOwner_.get(); }
+
     /// returns cached aabb-tree for points of this mesh, creating it if it did not exist in a thread-safe manner
     MRMESH_API const AABBTreePoints & getAABBTreePoints() const;
 
@@ -473,7 +479,13 @@ struct [[nodiscard]] Mesh
     /// updates existing caches in case of few vertices were changed insignificantly,
     /// and topology remained unchanged;
     /// it shall be considered as a faster alternative to invalidateCaches() and following rebuild of trees
-    MRMESH_API void updateCaches( const VertBitSet & changedVerts );
+    /// \param treeRebuildAreaRatio the subtrees of aabb-tree, which boxes became larger than this factor times their initial area, are rebuilt locally
+    MRMESH_API void updateCaches( const VertBitSet & changedVerts, float treeRebuildAreaRatio = FLT_MAX );
+
+    /// updates existing caches in case of some faces were deleted and new faces were added in their place,
+    /// while other faces and their vertices remained unchanged (see AABBTree::replaceFaces);
+    /// it shall be considered as a faster alternative to invalidateCaches() and following rebuild of trees
+    MRMESH_API void updateCaches( const FaceBitSet & removedFaces, const FaceBitSet & addedFaces );
 
     // returns the amount of memory this object occupies on heap
     [[nodiscard]] MRMESH_API size_t heapBytes() const;
@@ -486,6 +498,7 @@ struct [[nodiscard]] Mesh
 
 private:
     mutable SharedThreadSafeOwner<AABBTree> AABBTreeOwner_;
+    mutable SharedThreadSafeOwner<AABBTreeWide> AABBTreeWideOwner_;
     mutable SharedThreadSafeOwner<AABBTreePoints> AABBTreePointsOwner_;
     mutable SharedThreadSafeOwner<Dipoles> dipolesOwner_;
 };
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "MRVector3.h"
+#include "MRPch/MRBindingMacros.h"
+#include <cstdint>
+
+namespace MR
+{
+
+#pragma pack(push, 1)
+
+/// the record of one triangle in binary STL file
+struct MR_BIND_IGNORE StlTriangle
+{
+    Vector3f normal;
+    Vector3f vert[3];
+    std::uint16_t attr = 0;
+};
+
+/// the record of one triangle in binary PLY file with face element having single property "list uchar int vertex_indices"
+struct MR_BIND_IGNORE PlyTriangle
+{
+    char cnt = 3;
+    int v[3];
+};
+
+#pragma pack(pop)
+
+static_assert( sizeof( StlTriangle ) == 50, "check your padding" );
+static_assert( sizeof( PlyTriangle ) == 13, "check your padding" );
+
+} //namespace MR
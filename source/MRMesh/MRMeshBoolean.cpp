@@ -24,6 +24,10 @@
 #include "MREdgePaths.h"
 #include "MRRingIterator.h"
 #include "MRParallelFor.h"
+#include "MRAABBTree.h"
+#include "MRMapEdge.h"
+#include "MRPartMapping.h"
+#include "MRMakeSphereMesh.h"
 
 namespace
 {
@@ -78,6 +82,33 @@ void gatherEdgeInfo( const MeshTopology& topology, EdgeId e, FaceBitSet& faces,
     dests.set( topology.dest( e ) );
 }
 
+// finds all faces of the mesh with the boxes intersecting given box using mesh's AABB tree
+FaceBitSet findFacesIntersectingBox( const Mesh& mesh, const Box3f& box )
+{
+    MR_TIMER;
+    FaceBitSet res( mesh.topology.faceSize() );
+    const AABBTree& tree = mesh.getAABBTree();
+    if ( tree.nodes().empty() )
+        return res;
+
+    std::vector<NodeId> stack{ tree.rootNodeId() };
+    while ( !stack.empty() )
+    {
+        const auto& node = tree[stack.back()];
+        stack.pop_back();
+        if ( !node.box.intersects( box ) )
+            continue;
+        if ( node.leaf() )
+        {
+            res.set( node.leafId() );
+            continue;
+        }
+        stack.push_back( node.l );
+        stack.push_back( node.r );
+    }
+    return res;
+}
+
 }
 
 namespace MR
@@ -126,6 +157,111 @@ BooleanResult boolean( Mesh&& meshA, Mesh&& meshB, BooleanOperation operation, c
     return booleanImpl( std::move( meshA ), std::move( meshB ), operation, params, {} );
 }
 
+Expected<void> localBoolean( Mesh& meshA, const Mesh& meshB, BooleanOperation operation,
+    const BooleanParameters& params, FaceBitSet* outChangedFaces )
+{
+    MR_TIMER;
+    if ( operation != BooleanOperation::Union && operation != BooleanOperation::DifferenceAB && operation != BooleanOperation::OutsideB )
+        return unexpected( "Local boolean supports only the operations keeping the part of mesh A outside of mesh B" );
+    if ( params.mapper || params.outPreCutA || params.outPreCutB || params.outCutEdges )
+        return unexpected( "Local boolean does not support mapper, outPreCutA, outPreCutB and outCutEdges" );
+
+    if ( outChangedFaces )
+        outChangedFaces->clear();
+
+    // the faces of mesh A that can be touched by mesh B,
+    // the boundary of this region is outside of mesh B, so it is not modified by the operation
+    const auto region = findFacesIntersectingBox( meshA, transformed( meshB.getBoundingBox(), params.rigidB2A ) );
+    if ( region.none() )
+    {
+        // mesh B does not touch mesh A, so it is either added as a separate component or nothing is changed
+        if ( operation == BooleanOperation::OutsideB || meshB.topology.numValidFaces() == 0 )
+            return {};
+        const AffineXf3f a2b = params.rigidB2A ? params.rigidB2A->inverse() : AffineXf3f();
+        const bool bInsideA = isNonIntersectingInside( meshB, meshA, params.rigidB2A ? &a2b : nullptr );
+        if ( bInsideA == ( operation == BooleanOperation::Union ) )
+            return {};
+        Mesh b = meshB;
+        if ( params.rigidB2A )
+            b.transform( *params.rigidB2A );
+        FaceMap b2aFaces;
+        meshA.addMeshPart( b, operation == BooleanOperation::DifferenceAB, {}, {}, Src2TgtMaps( &b2aFaces, nullptr, nullptr ) );
+        if ( outChangedFaces )
+        {
+            outChangedFaces->resize( meshA.topology.faceSize() );
+            for ( auto f : b2aFaces )
+                if ( f )
+                    outChangedFaces->set( f );
+        }
+        return {};
+    }
+
+    // the boundary of the region, where the result will be stitched with the remaining part of mesh A
+    std::vector<EdgePath> stitchA;
+    for ( auto& loop : findLeftBoundary( meshA.topology, region ) )
+    {
+        auto stitched = [&] ( EdgeId e ) { return meshA.topology.right( e ).valid(); };
+        // start from an edge on the boundary of mesh A itself, if any, to get maximal open paths
+        std::rotate( loop.begin(), std::find_if_not( loop.begin(), loop.end(), stitched ), loop.end() );
+        EdgePath path;
+        for ( auto e : loop )
+        {
+            if ( stitched( e ) )
+                path.push_back( e );
+            else if ( !path.empty() )
+                stitchA.push_back( std::move( path ) );
+        }
+        if ( !path.empty() )
+            stitchA.push_back( std::move( path ) );
+    }
+
+    auto a2regionEdges = WholeEdgeMapOrHashMap::createHashMap();
+    Mesh regionMesh = meshA.cloneRegion( region, false, { .src2tgtEdges = &a2regionEdges } );
+
+    // build the tree for the copy of mesh B to reuse it
+    meshB.getAABBTree();
+    BooleanResultMapper mapper;
+    auto res = booleanImpl( std::move( regionMesh ), Mesh( meshB ), operation,
+        { .rigidB2A = params.rigidB2A, .mapper = &mapper, .mergeAllNonIntersectingComponents = params.mergeAllNonIntersectingComponents,
+          .forceCut = params.forceCut, .cb = params.cb },
+        { .originalMeshB = &meshB, .wholeMeshA = &meshA } );
+    if ( !res.valid() )
+        return unexpected( std::move( res.errorString ) );
+
+    std::vector<EdgePath> stitchRes( stitchA.size() );
+    const auto& old2newEdgesA = mapper.getMaps( BooleanResultMapper::MapObject::A ).old2newEdges;
+    for ( int i = 0; i < stitchA.size(); ++i )
+    {
+        for ( auto e : stitchA[i] )
+        {
+            const auto eRes = mapEdge( old2newEdgesA, mapEdge( a2regionEdges, e ) );
+            if ( !eRes || !res.mesh.topology.left( eRes ) || res.mesh.topology.right( eRes ) )
+                return unexpected( "The boundary of local region is modified by boolean" );
+            stitchRes[i].push_back( eRes );
+        }
+    }
+
+    // the topology and points of mesh A are modified directly (and not by Mesh::deleteFaces and Mesh::addMeshPart invalidating the caches)
+    // to update the AABB tree of mesh A only in the changed region
+    meshA.topology.deleteFaces( region );
+    FaceMap res2aFaces;
+    VertMap res2aVerts;
+    meshA.topology.addPartByMask( res.mesh.topology, nullptr, false, stitchA, stitchRes, Src2TgtMaps( &res2aFaces, &res2aVerts, nullptr ) );
+    meshA.points.resize( std::max( meshA.points.size(), size_t( meshA.topology.lastValidVert() + 1 ) ) );
+    for ( auto v : res.mesh.topology.getValidVerts() )
+        if ( auto va = res2aVerts[v] )
+            meshA.points[va] = res.mesh.points[v];
+
+    FaceBitSet changedFaces( meshA.topology.faceSize() );
+    for ( auto f : res2aFaces )
+        if ( f )
+            changedFaces.set( f );
+    meshA.updateCaches( region, changedFaces );
+    if ( outChangedFaces )
+        *outChangedFaces = std::move( changedFaces );
+    return {};
+}
+
 namespace detail
 {
 struct JoinedSelfLoops
@@ -384,6 +520,57 @@ Contours3f findIntersectionContours( const Mesh& meshA, const Mesh& meshB, const
     return extractIntersectionContours( meshA, meshB, contours, converters, rigidB2A );
 }
 
+BooleanContext::BooleanContext( const Mesh& meshA, const Mesh& meshB )
+    : meshA_( meshA )
+    , meshB_( meshB )
+{
+    MR_TIMER;
+    tbb::task_group taskGroup;
+    taskGroup.run( [&] ()
+    {
+        meshA_.getAABBTree();
+        boxA_ = Box3d( meshA_.computeBoundingBox() );
+    } );
+    meshB_.getAABBTree();
+    boxB_ = meshB_.computeBoundingBox();
+    taskGroup.wait();
+}
+
+CoordinateConverters BooleanContext::getConverters( const AffineXf3f* rigidB2A ) const
+{
+    // transformed box of B contains all transformed points of B, so the converters are valid though can be a bit less precise
+    // than the ones computed by getVectorConverters from the points
+    Box3d bb = boxA_;
+    bb.include( Box3d( transformed( boxB_, rigidB2A ) ) );
+    CoordinateConverters res;
+    res.toInt = getToIntConverter( bb );
+    res.toFloat = getToFloatConverter( bb );
+    return res;
+}
+
+BooleanResult BooleanContext::boolean( BooleanOperation operation, const BooleanParameters& params ) const
+{
+    MR_TIMER;
+    const auto converters = getConverters( params.rigidB2A );
+    return booleanImpl( Mesh( meshA_ ), Mesh( meshB_ ), operation, params,
+        { .originalMeshA = &meshA_, .originalMeshB = &meshB_, .converters = &converters } );
+}
+
+Contours3f BooleanContext::findIntersectionContours( const AffineXf3f* rigidB2A ) const
+{
+    MR_TIMER;
+    const auto converters = getConverters( rigidB2A );
+    auto intersections = findCollidingEdgeTrisPrecise( meshA_, meshB_, converters.toInt, rigidB2A );
+    auto contours = orderIntersectionContours( meshA_.topology, meshB_.topology, intersections );
+    return extractIntersectionContours( meshA_, meshB_, contours, converters, rigidB2A );
+}
+
+bool BooleanContext::hasIntersection( const AffineXf3f* rigidB2A ) const
+{
+    const auto converters = getConverters( rigidB2A );
+    return !findCollidingEdgeTrisPrecise( meshA_, meshB_, converters.toInt, rigidB2A, true ).empty();
+}
+
 BooleanResult booleanImpl( Mesh&& meshA, Mesh&& meshB, BooleanOperation operation, const BooleanParameters& params, BooleanInternalParameters intParams )
 {
     MR_TIMER;
@@ -395,7 +582,7 @@ BooleanResult booleanImpl( Mesh&& meshA, Mesh&& meshB, BooleanOperation operatio
     bool needCutMeshA = operation != BooleanOperation::InsideB && operation != BooleanOperation::OutsideB;
     bool needCutMeshB = operation != BooleanOperation::InsideA && operation != BooleanOperation::OutsideA;
 
-    converters = getVectorConverters( meshA, meshB, params.rigidB2A );
+    converters = intParams.converters ? *intParams.converters : getVectorConverters( meshA, meshB, params.rigidB2A );
 
     auto loneCb = subprogress( params.cb, 0.0f, 0.8f );
 
@@ -822,6 +1009,108 @@ TEST( MRMesh, MeshBoolean )
 }
 
 
+TEST( MRMesh, LocalBoolean )
+{
+    Mesh meshA = makeSphere( { .radius = 1.f, .numMeshVertices = 3000 } );
+    const auto numFacesA = meshA.topology.numValidFaces();
+    Mesh tool = makeSphere( { .radius = 0.2f, .numMeshVertices = 300 } );
+    const AffineXf3f xf = AffineXf3f::translation( Vector3f( 0.f, 0.f, 1.f ) );
+
+    auto expected = boolean( meshA, tool, BooleanOperation::DifferenceAB, { .rigidB2A = &xf } );
+    ASSERT_TRUE( expected.valid() );
+
+    FaceBitSet changed;
+    auto res = localBoolean( meshA, tool, BooleanOperation::DifferenceAB, { .rigidB2A = &xf }, &changed );
+    ASSERT_TRUE( res.has_value() );
+    EXPECT_TRUE( meshA.topology.isClosed() );
+    EXPECT_NEAR( meshA.volume(), expected->volume(), 1e-4 );
+    EXPECT_TRUE( changed.any() );
+    EXPECT_LT( changed.count(), numFacesA / 4 );
+
+    // the tool far from the mesh changes nothing
+    const AffineXf3f farXf = AffineXf3f::translation( Vector3f( 0.f, 0.f, 5.f ) );
+    const auto volume = meshA.volume();
+    res = localBoolean( meshA, tool, BooleanOperation::DifferenceAB, { .rigidB2A = &farXf }, &changed );
+    ASSERT_TRUE( res.has_value() );
+    EXPECT_TRUE( changed.none() );
+    EXPECT_EQ( meshA.volume(), volume );
+
+    // unsupported outputs are reported as an error
+    BooleanResultMapper mapper;
+    res = localBoolean( meshA, tool, BooleanOperation::DifferenceAB, { .rigidB2A = &xf, .mapper = &mapper } );
+    EXPECT_FALSE( res.has_value() );
+}
+
+TEST( MRMesh, LocalBooleanUnion )
+{
+    Mesh meshA = makeSphere( { .radius = 1.f, .numMeshVertices = 3000 } );
+    const Mesh tool = makeSphere( { .radius = 0.2f, .numMeshVertices = 300 } );
+
+    // several tools are applied one by one, and the tree of mesh A is updated locally after each of them
+    for ( const auto& shift : { Vector3f( 0.f, 0.f, 1.f ), Vector3f( 1.f, 0.f, 0.f ), Vector3f( 0.f, -1.f, 0.f ) } )
+    {
+        const AffineXf3f xf = AffineXf3f::translation( shift );
+        auto expected = boolean( meshA, tool, BooleanOperation::Union, { .rigidB2A = &xf } );
+        ASSERT_TRUE( expected.valid() );
+
+        auto res = localBoolean( meshA, tool, BooleanOperation::Union, { .rigidB2A = &xf } );
+        ASSERT_TRUE( res.has_value() );
+        EXPECT_TRUE( meshA.topology.isClosed() );
+        EXPECT_NEAR( meshA.volume(), expected->volume(), 1e-4 );
+
+        const auto tree = meshA.getAABBTreeNotCreate();
+        ASSERT_TRUE( tree );
+        EXPECT_EQ( tree->numLeaves(), meshA.topology.numValidFaces() );
+        EXPECT_EQ( tree->getBoundingBox(), AABBTree( meshA ).getBoundingBox() );
+    }
+}
+
+TEST( MRMesh, LocalBooleanInside )
+{
+    // the box of the tool overlaps the faces of mesh A, but the tool is inside mesh A without intersections,
+    // so the classification of the tool relative to whole mesh A is necessary
+    const Mesh tool = makeSphere( { .radius = 0.1f, .numMeshVertices = 300 } );
+    const AffineXf3f xf = AffineXf3f::translation( Vector3f::diagonal( 0.85f / std::sqrt( 3.f ) ) );
+
+    for ( auto operation : { BooleanOperation::Union, BooleanOperation::DifferenceAB } )
+    {
+        Mesh meshA = makeSphere( { .radius = 1.f, .numMeshVertices = 3000 } );
+        const auto expected = boolean( meshA, tool, operation, { .rigidB2A = &xf } );
+        ASSERT_TRUE( expected.valid() );
+        ASSERT_TRUE( findFacesIntersectingBox( meshA, transformed( tool.getBoundingBox(), &xf ) ).any() );
+
+        const auto volumeA = meshA.volume();
+        auto res = localBoolean( meshA, tool, operation, { .rigidB2A = &xf } );
+        ASSERT_TRUE( res.has_value() );
+        EXPECT_NEAR( meshA.volume(), expected->volume(), 1e-4 );
+        if ( operation == BooleanOperation::Union )
+            EXPECT_NEAR( meshA.volume(), volumeA, 1e-4 );
+        else
+            EXPECT_NEAR( meshA.volume(), volumeA - tool.volume(), 1e-4 );
+    }
+}
+
+TEST( MRMesh, BooleanContext )
+{
+    const Mesh meshA = makeSphere( { .radius = 1.f, .numMeshVertices = 500 } );
+    const Mesh meshB = makeSphere( { .radius = 0.5f, .numMeshVertices = 300 } );
+    BooleanContext context( meshA, meshB );
+
+    for ( float shift : { 0.8f, 1.2f, 2.f } )
+    {
+        const AffineXf3f xf = AffineXf3f::translation( Vector3f( shift, 0.f, 0.f ) );
+        const bool intersect = shift < 1.5f;
+        EXPECT_EQ( context.hasIntersection( &xf ), intersect );
+        EXPECT_EQ( context.findIntersectionContours( &xf ).empty(), !intersect );
+
+        auto res = context.boolean( BooleanOperation::Union, { .rigidB2A = &xf } );
+        ASSERT_TRUE( res.valid() );
+        auto ref = boolean( meshA, meshB, BooleanOperation::Union, { .rigidB2A = &xf } );
+        ASSERT_TRUE( ref.valid() );
+        EXPECT_NEAR( res->volume(), ref->volume(), 1e-4 );
+    }
+}
+
 TEST( MRMesh, BooleanMultipleEdgePropogationSort )
 {
     Mesh meshA;
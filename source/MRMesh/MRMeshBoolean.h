@@ -4,6 +4,7 @@
 #include "MRContoursCut.h"
 #include "MRMesh.h"
 #include "MRBitSet.h"
+#include "MRBox.h"
 #include "MRExpected.h"
 #include <string>
 
@@ -107,6 +108,23 @@ MRMESH_API BooleanResult boolean( const Mesh& meshA, const Mesh& meshB, BooleanO
 MRMESH_API BooleanResult boolean( Mesh&& meshA, Mesh&& meshB, BooleanOperation operation,
                                   const BooleanParameters& params = {} );
 
+/** \brief Performs CSG operation modifying mesh `A` in place only in the vicinity of mesh `B`
+  *
+  * \ingroup BooleanGroup
+  * Only the faces of mesh `A` with the boxes overlapping the box of mesh `B` are found (using cached AABB tree of mesh `A`),
+  * copied, cut and classified, and then replace original faces in mesh `A`,
+  * so the cutting and classification cost is proportional to the touched area of mesh `A` and not to its total size,
+  * which is useful for many small tools (drills, engravings) applied to a huge mesh.
+  * The AABB tree of mesh `A` is kept valid: only its smallest subtree containing the replaced faces is rebuilt (see AABBTree::replaceFaces),
+  * so a series of calls for many tools does not rebuild the whole tree each time
+  * (except for mesh `B` not touching mesh `A` and added to it as a separate component).
+  * \param operation only the operations keeping the part of mesh `A` outside of mesh `B` are supported: Union, DifferenceAB and OutsideB
+  * \param params mapper, outPreCutA, outPreCutB and outCutEdges are not supported here, an error is returned if any of them is set
+  * \param outChangedFaces optional output: the faces of mesh `A` created instead of removed ones
+  */
+MRMESH_API Expected<void> localBoolean( Mesh& meshA, const Mesh& meshB, BooleanOperation operation,
+                                        const BooleanParameters& params = {}, FaceBitSet* outChangedFaces = nullptr );
+
 /// performs boolean operation on mesh with itself, cutting simple intersections contours and flipping their connectivity
 /// this function is experimental and likely to change signature and/or behavior in future 
 MRMESH_API Expected<Mesh> selfBoolean( const Mesh& mesh );
@@ -114,6 +132,42 @@ MRMESH_API Expected<Mesh> selfBoolean( const Mesh& mesh );
 /// returns intersection contours of given meshes
 MRMESH_API Contours3f findIntersectionContours( const Mesh& meshA, const Mesh& meshB, const AffineXf3f* rigidB2A = nullptr );
 
+/** \brief The data prepared once for many boolean operations on the same pair of meshes with different relative transformations
+  *
+  * \ingroup BooleanGroup
+  * The context builds AABB trees of both meshes and computes their bounding boxes on construction,
+  * then each call only finds the collisions of the trees and cuts the copies of the meshes (which reuse the trees);
+  * the meshes must not be modified and must outlive the context;
+  * const methods can be called from several threads simultaneously
+  */
+class BooleanContext
+{
+public:
+    MRMESH_API BooleanContext( const Mesh& meshA, const Mesh& meshB );
+
+    [[nodiscard]] const Mesh& meshA() const { return meshA_; }
+    [[nodiscard]] const Mesh& meshB() const { return meshB_; }
+
+    /// returns float-int converters for the meshes with given transformation from mesh `B` space to mesh `A` space,
+    /// computed from the boxes of the meshes without iterating over their vertices
+    [[nodiscard]] MRMESH_API CoordinateConverters getConverters( const AffineXf3f* rigidB2A = nullptr ) const;
+
+    /// performs CSG operation on the meshes, same as MR::boolean( meshA, meshB, operation, params )
+    [[nodiscard]] MRMESH_API BooleanResult boolean( BooleanOperation operation, const BooleanParameters& params = {} ) const;
+
+    /// returns intersection contours of the meshes, same as MR::findIntersectionContours( meshA, meshB, rigidB2A )
+    [[nodiscard]] MRMESH_API Contours3f findIntersectionContours( const AffineXf3f* rigidB2A = nullptr ) const;
+
+    /// returns true if the surfaces of the meshes intersect, stopping the search on the first found intersection
+    [[nodiscard]] MRMESH_API bool hasIntersection( const AffineXf3f* rigidB2A = nullptr ) const;
+
+private:
+    const Mesh& meshA_;
+    const Mesh& meshB_;
+    Box3d boxA_;
+    Box3f boxB_;
+};
+
 /// vertices and points representing mesh intersection result
 struct BooleanResultPoints
 {
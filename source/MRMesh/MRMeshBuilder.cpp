@@ -864,7 +864,9 @@ int uniteCloseVertices( Mesh& mesh, const UniteCloseParams& params /*= {} */ )
             vertRegion = *params.region;
     }
 
-    VertMap vertOldToNew = useRegion ?
+    VertMap vertOldToNew = params.useGrid ?
+        *findSmallestCloseVerticesUsingGrid( mesh.points, params.closeDist, useRegion ? &vertRegion : &mesh.topology.getValidVerts() ) :
+        useRegion ?
         *findSmallestCloseVertices( mesh.points, params.closeDist, &vertRegion ) :
         *findSmallestCloseVertices( mesh, params.closeDist );
     int numChanged = 0;
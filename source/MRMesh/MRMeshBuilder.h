@@ -103,6 +103,10 @@ struct UniteCloseParams
     ///< if true - try to duplicates non-manifold vertices instead of removing faces
     bool duplicateNonManifold = false;
 
+    ///< if true then close vertices are found by sorting them in the cells of regular grid instead of the search in AABB tree,
+    ///< which is much faster for triangle soups (e.g. loaded from STL) where each vertex is repeated several times
+    bool useGrid = false;
+
     ///< is the mapping of vertices: before -> after
     VertMap* optionalVertOldToNew = nullptr;
 
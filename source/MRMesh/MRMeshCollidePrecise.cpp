@@ -11,6 +11,25 @@
 namespace MR
 {
 
+namespace
+{
+
+// returns true if all given points are certainly on one side of the plane of triangle (t) according to fast filtered predicate;
+// then no segment between them can intersect the triangle even with simulation-of-simplicity, and the exact test can be skipped
+template<int N>
+bool certainlyOnOneSide( const PreciseVertCoords* t, const PreciseVertCoords* ps )
+{
+    const int s = orient3dFiltered( t[0].pt, t[1].pt, t[2].pt, ps[0].pt );
+    if ( s == 0 )
+        return false;
+    for ( int i = 1; i < N; ++i )
+        if ( orient3dFiltered( t[0].pt, t[1].pt, t[2].pt, ps[i].pt ) != s )
+            return false;
+    return true;
+}
+
+} // anonymous namespace
+
 PreciseCollisionResult findCollidingEdgeTrisPrecise( const MeshPart & a, const MeshPart & b, 
     ConvertToIntVector conv, const AffineXf3f * rigidB2A, bool anyIntersection )
 {
@@ -107,6 +126,10 @@ PreciseCollisionResult findCollidingEdgeTrisPrecise( const MeshPart & a, const M
             bvc[j].id += aVertsSize;
         }
 
+        // if one triangle is certainly on one side of the plane of another triangle then they do not intersect
+        if ( certainlyOnOneSide<3>( bvc, avc ) || certainlyOnOneSide<3>( avc, bvc ) )
+            return;
+
         // check edges from A
         int numA = 0;
         EdgeId aEdge = a.mesh.topology.edgeWithLeft( aTri );
@@ -281,6 +304,8 @@ std::vector<EdgeTri> findCollidingEdgeTrisPrecise(
         {
             FaceId fB = facesB[j];
             const auto & bvc = faceBCoords[j];
+            if ( certainlyOnOneSide<2>( bvc.data(), avc.data() ) )
+                continue;
             auto isect = doTriangleSegmentIntersect( { bvc[0], bvc[1], bvc[2], avc[0], avc[1] } );
             if ( !isect )
                 continue;
@@ -336,6 +361,8 @@ std::vector<EdgeTri> findCollidingEdgeTrisPrecise(
         {
             EdgeId eB = edgesB[j];
             const auto & bvc = edgeBCoords[j];
+            if ( certainlyOnOneSide<2>( avc.data(), bvc.data() ) )
+                continue;
             auto isect = doTriangleSegmentIntersect( { avc[0], avc[1], avc[2], bvc[0], bvc[1] } );
             if ( !isect )
                 continue;
@@ -424,6 +451,10 @@ std::vector<EdgeTri> findSelfCollidingEdgeTrisPrecise( const MeshPart& mp, Conve
             rvc[j].id += aVertsSize;
         }
 
+        // triangles with a shared vertex are never separated by the filter, since the vertex is exactly on both planes
+        if ( certainlyOnOneSide<3>( rvc, lvc ) || certainlyOnOneSide<3>( lvc, rvc ) )
+            return;
+
         auto sharedVerts = sharedPreciseVertCoord( lvc, rvc );
 
         // check edges from A
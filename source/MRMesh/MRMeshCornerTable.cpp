@@ -0,0 +1,174 @@
+#include "MRMeshCornerTable.h"
+#include "MRMeshTopology.h"
+#include "MRMeshBuilder.h"
+#include "MRBitSetParallelFor.h"
+#include "MRRingIterator.h"
+#include "MRTorus.h"
+#include "MRMesh.h"
+#include "MRTimer.h"
+#include "MRGTest.h"
+
+namespace MR
+{
+
+MeshCornerTable::MeshCornerTable( const MeshTopology & topology )
+{
+    MR_TIMER;
+    validFaces_ = topology.getValidFaces();
+    validFaces_.resize( topology.faceSize() );
+    cornerVert_.resize( 3 * topology.faceSize() );
+    cornerTwin_.resize( 3 * topology.faceSize() );
+    vertCorner_.resize( topology.vertSize() );
+
+    // returns the corner corresponding to given half-edge having valid left face
+    auto cornerOf = [&]( EdgeId e )
+    {
+        const auto f = topology.left( e );
+        assert( f );
+        auto e0 = topology.edgeWithLeft( f );
+        if ( e0 == e )
+            return corner( f, 0 );
+        e0 = topology.prev( e0.sym() );
+        if ( e0 == e )
+            return corner( f, 1 );
+        assert( topology.prev( e0.sym() ) == e );
+        return corner( f, 2 );
+    };
+
+    BitSetParallelFor( validFaces_, [&]( FaceId f )
+    {
+        assert( topology.isLeftTri( topology.edgeWithLeft( f ) ) );
+        auto e = topology.edgeWithLeft( f );
+        for ( int i = 0; i < 3; ++i )
+        {
+            assert( topology.left( e ) == f );
+            const auto c = corner( f, i );
+            cornerVert_[c] = topology.org( e );
+            if ( topology.right( e ) )
+                cornerTwin_[c] = cornerOf( e.sym() );
+            else
+            {
+                // the first edge with a face on the left around the destination after the hole
+                auto n = e.sym();
+                do
+                {
+                    n = topology.next( n );
+                } while ( !topology.left( n ) );
+                cornerTwin_[c] = encodeJump_( cornerOf( n ) );
+            }
+            e = topology.prev( e.sym() );
+        }
+        assert( e == topology.edgeWithLeft( f ) );
+    } );
+
+    BitSetParallelFor( topology.getValidVerts(), [&]( VertId v )
+    {
+        for ( auto e : orgRing( topology, v ) )
+        {
+            if ( topology.left( e ) )
+            {
+                vertCorner_[v] = cornerOf( e );
+                break;
+            }
+        }
+    } );
+}
+
+MeshTopology MeshCornerTable::toTopology() const
+{
+    MR_TIMER;
+    auto region = validFaces_;
+    auto res = MeshBuilder::fromTriangles( getTriangulation(), { .region = &region } );
+    assert( region.none() );
+    res.faceResize( faceSize() );
+    res.vertResize( vertSize() );
+    return res;
+}
+
+bool MeshCornerTable::isBdVert( VertId v ) const
+{
+    const auto c0 = vertCorner( v );
+    if ( !c0 )
+        return false;
+    auto c = c0;
+    do
+    {
+        if ( isBdCorner( c ) )
+            return true;
+        c = nextAroundVert( c );
+    } while ( c != c0 );
+    return false;
+}
+
+int MeshCornerTable::getVertDegree( VertId v ) const
+{
+    int res = 0;
+    forEachVertCorner( v, [&res]( CornerId ) { ++res; } );
+    return res;
+}
+
+Triangulation MeshCornerTable::getTriangulation() const
+{
+    MR_TIMER;
+    Triangulation res;
+    res.resize( faceSize() );
+    BitSetParallelFor( validFaces_, [&]( FaceId f )
+    {
+        res[f] = getTriVerts( f );
+    } );
+    return res;
+}
+
+size_t MeshCornerTable::heapBytes() const
+{
+    return
+        cornerVert_.heapBytes() +
+        cornerTwin_.heapBytes() +
+        vertCorner_.heapBytes() +
+        validFaces_.heapBytes();
+}
+
+TEST( MRMesh, MeshCornerTable )
+{
+    auto mesh = makeTorus( 1.0f, 0.3f, 32, 16 );
+    // make two holes, one of them touches a vertex of the other
+    FaceBitSet del( mesh.topology.faceSize() );
+    del.set( 0_f );
+    del.set( 10_f );
+    del.set( 11_f );
+    mesh.topology.deleteFaces( del );
+
+    const MeshTopology & topology = mesh.topology;
+    const MeshCornerTable table( topology );
+    EXPECT_LT( table.heapBytes(), topology.heapBytes() * 6 / 10 );
+
+    for ( auto f : topology.getValidFaces() )
+        EXPECT_EQ( table.getTriVerts( f ), topology.getTriVerts( f ) );
+
+    for ( auto v : topology.getValidVerts() )
+    {
+        EXPECT_EQ( table.isBdVert( v ), topology.isBdVertex( v ) );
+        // the corners of a vertex go in the same order as the left faces of its edges
+        std::vector<FaceId> topologyFaces, tableFaces;
+        for ( auto e : orgRing( topology, v ) )
+            if ( auto l = topology.left( e ) )
+                topologyFaces.push_back( l );
+        table.forEachVertCorner( v, [&]( CornerId c )
+        {
+            EXPECT_EQ( table.vert( c ), v );
+            tableFaces.push_back( table.face( c ) );
+        } );
+        ASSERT_EQ( topologyFaces.size(), tableFaces.size() );
+        auto it = std::find( topologyFaces.begin(), topologyFaces.end(), tableFaces.front() );
+        ASSERT_NE( it, topologyFaces.end() );
+        std::rotate( topologyFaces.begin(), it, topologyFaces.end() );
+        EXPECT_EQ( topologyFaces, tableFaces );
+    }
+
+    const auto restored = table.toTopology();
+    EXPECT_EQ( restored.getValidFaces(), topology.getValidFaces() );
+    EXPECT_EQ( restored.getTriangulation(), topology.getTriangulation() );
+    EXPECT_EQ( restored.findNumHoles(), 2 );
+}
+
+} //namespace MR
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "MRId.h"
+#include "MRVector.h"
+#include "MRBitSet.h"
+#include <array>
+
+namespace MR
+{
+
+/// \brief compact read-only representation of triangular mesh topology in the form of a corner table;
+/// \details each valid face f has three corners 3*f, 3*f+1, 3*f+2 listed counter-clockwise,
+/// corner c is located in vertex vert(c) and corresponds to the half-edge from vert(c) to vert(next(c)) having face(c) on the left;
+/// half-edge pairs are implicit: twin(c) is the corner of the neighbor face with the same edge in opposite direction;
+/// it occupies about two times less memory than MeshTopology (24 bytes per face for vertices and twins of corners
+/// instead of 48 bytes for three half-edge records) and has better cache locality for ring traversal,
+/// but it cannot be modified, so it is intended for read-mostly algorithms (projection, distance, rendering, export)
+/// \ingroup MeshTopologyGroup
+class MeshCornerTable
+{
+public:
+    MeshCornerTable() = default;
+
+    /// builds corner table from given topology, all faces must be triangular
+    [[nodiscard]] MRMESH_API explicit MeshCornerTable( const MeshTopology & topology );
+
+    /// builds full editable topology from this corner table with the same face and vertex ids (but edge ids can be different)
+    [[nodiscard]] MRMESH_API MeshTopology toTopology() const;
+
+    /// returns the number of face records including invalid ones
+    [[nodiscard]] size_t faceSize() const { return validFaces_.size(); }
+
+    /// returns the number of vertex records including invalid ones
+    [[nodiscard]] size_t vertSize() const { return vertCorner_.size(); }
+
+    /// returns the number of corner records including the corners of invalid faces
+    [[nodiscard]] size_t cornerSize() const { return cornerVert_.size(); }
+
+    /// returns true if given face exists in the table
+    [[nodiscard]] bool hasFace( FaceId f ) const { return validFaces_.test( f ); }
+
+    /// returns true if given vertex has at least one incident face
+    [[nodiscard]] bool hasVert( VertId v ) const { return v < int( vertCorner_.size() ) && vertCorner_[v].valid(); }
+
+    /// returns all valid faces
+    [[nodiscard]] const FaceBitSet & getValidFaces() const { return validFaces_; }
+
+    /// returns the face containing given corner
+    [[nodiscard]] static FaceId face( CornerId c ) { assert( c.valid() ); return FaceId( int( c ) / 3 ); }
+
+    /// returns i-th corner of given face, 0 <= i < 3
+    [[nodiscard]] static CornerId corner( FaceId f, int i ) { assert( f.valid() && i >= 0 && i < 3 ); return CornerId( 3 * int( f ) + i ); }
+
+    /// returns next counter-clockwise corner in the same face
+    [[nodiscard]] static CornerId next( CornerId c ) { assert( c.valid() ); return int( c ) % 3 == 2 ? CornerId( int( c ) - 2 ) : CornerId( int( c ) + 1 ); }
+
+    /// returns previous counter-clockwise (next clockwise) corner in the same face
+    [[nodiscard]] static CornerId prev( CornerId c ) { assert( c.valid() ); return int( c ) % 3 == 0 ? CornerId( int( c ) + 2 ) : CornerId( int( c ) - 1 ); }
+
+    /// returns the vertex of given corner, which is also the origin of corner's half-edge
+    [[nodiscard]] VertId vert( CornerId c ) const { return cornerVert_[c]; }
+
+    /// returns the destination of corner's half-edge
+    [[nodiscard]] VertId dest( CornerId c ) const { return cornerVert_[next( c )]; }
+
+    /// returns the corner of the neighbor face sharing the edge of this corner's half-edge, or invalid corner if the edge is on boundary
+    [[nodiscard]] CornerId twin( CornerId c ) const { auto t = cornerTwin_[c]; return t.valid() ? t : CornerId{}; }
+
+    /// returns true if the half-edge of given corner has no neighbor face
+    [[nodiscard]] bool isBdCorner( CornerId c ) const { return !cornerTwin_[c].valid(); }
+
+    /// returns some corner in given vertex, or invalid corner if the vertex has no incident faces
+    [[nodiscard]] CornerId vertCorner( VertId v ) const { return v < int( vertCorner_.size() ) ? vertCorner_[v] : CornerId{}; }
+
+    /// returns next counter-clockwise corner in the same vertex;
+    /// all corners of a vertex form a cycle, which jumps over the holes for boundary vertices like the ring of edges in MeshTopology
+    [[nodiscard]] CornerId nextAroundVert( CornerId c ) const
+    {
+        const auto t = cornerTwin_[prev( c )];
+        return t.valid() ? t : decodeJump_( t );
+    }
+
+    /// returns true if given vertex is on the boundary
+    [[nodiscard]] MRMESH_API bool isBdVert( VertId v ) const;
+
+    /// returns the number of faces incident to given vertex
+    [[nodiscard]] MRMESH_API int getVertDegree( VertId v ) const;
+
+    /// invokes given callback for every corner of given vertex in counter-clockwise order
+    template <typename F>
+    void forEachVertCorner( VertId v, F && callback ) const;
+
+    /// returns three vertex ids of given face in counter-clockwise order
+    [[nodiscard]] ThreeVertIds getTriVerts( FaceId f ) const
+    {
+        const auto c = corner( f, 0 );
+        return { cornerVert_[c], cornerVert_[c + 1], cornerVert_[c + 2] };
+    }
+
+    /// returns three vertex ids for valid triangles, invalid triangles get invalid ids
+    [[nodiscard]] MRMESH_API Triangulation getTriangulation() const;
+
+    /// returns the amount of memory this object occupies on heap
+    [[nodiscard]] MRMESH_API size_t heapBytes() const;
+
+private:
+    /// for boundary half-edges, cornerTwin_ stores the next corner around the destination vertex after the hole encoded as negative value
+    [[nodiscard]] static CornerId encodeJump_( CornerId c ) { assert( c.valid() ); return CornerId( -2 - int( c ) ); }
+    [[nodiscard]] static CornerId decodeJump_( CornerId t ) { assert( int( t ) <= -2 ); return CornerId( -2 - int( t ) ); }
+
+    Vector<VertId, CornerId> cornerVert_;
+    Vector<CornerId, CornerId> cornerTwin_;
+    Vector<CornerId, VertId> vertCorner_;
+    FaceBitSet validFaces_;
+};
+
+template <typename F>
+void MeshCornerTable::forEachVertCorner( VertId v, F && callback ) const
+{
+    const auto c0 = vertCorner( v );
+    if ( !c0 )
+        return;
+    auto c = c0;
+    do
+    {
+        assert( vert( c ) == v );
+        callback( c );
+        c = nextAroundVert( c );
+    } while ( c != c0 );
+}
+
+} //namespace MR
@@ -18,6 +18,8 @@
 #include "MRBuffer.h"
 #include "MRTbbThreadMutex.h"
 #include "MRMeshFixer.h"
+#include "MRAABBTree.h"
+#include "MRExpandShrink.h"
 
 namespace MR
 {
@@ -967,13 +969,29 @@ FaceBitSet getSubdividePart( const FaceBitSet & valids, size_t subdivideParts, s
     return res;
 }
 
+std::vector<FaceBitSet> getSpatialSubdivideParts( const MeshPart & mp, int minParts )
+{
+    MR_TIMER;
+    const AABBTree tree( mp );
+    const auto subtrees = tree.getSubtrees( minParts );
+    std::vector<FaceBitSet> res( subtrees.size() );
+    ParallelFor( res, [&]( size_t i )
+    {
+        res[i] = tree.getSubtreeLeaves( subtrees[i] );
+    } );
+    return res;
+}
+
 static DecimateResult decimateMeshParallelInplace( MR::Mesh & mesh, const DecimateSettings & settings )
 {
     MR_TIMER;
     assert( settings.subdivideParts > 1 );
-    const auto sz = settings.subdivideParts;
+    assert( !settings.partFaces || settings.partFaces->size() == settings.subdivideParts );
     const auto numIniVerts = mesh.topology.numValidVerts();
-    assert( !settings.partFaces || settings.partFaces->size() == sz );
+
+    // spatial subdivision produces parts with interleaving edge ids, which cannot be safely updated in shared bit sets and maps from parallel threads
+    const bool spatialParts = settings.subdivideSpatially && !settings.partFaces
+        && !settings.notFlippable && !settings.edgesToCollapse && !settings.twinMap;
 
     DecimateResult res;
     if ( mesh.topology.getFaceIds( settings.region ).none() )
@@ -1000,16 +1018,28 @@ static DecimateResult decimateMeshParallelInplace( MR::Mesh & mesh, const Decima
 
         DecimateResult decimRes;
     };
-    std::vector<Parts> parts( sz );
+    std::vector<Parts> parts;
 
     // determine faces for each part
-    ParallelFor( parts, [&]( size_t i )
+    if ( spatialParts )
     {
-        if ( settings.partFaces )
-            parts[i].region = std::move( (*settings.partFaces)[i] );
-        else
-            parts[i].region = getSubdividePart( mesh.topology.getValidFaces(), settings.subdivideParts, i );
-    } );
+        auto spatial = getSpatialSubdivideParts( MeshPart{ mesh, settings.region }, settings.subdivideParts );
+        parts.resize( spatial.size() );
+        for ( size_t i = 0; i < parts.size(); ++i )
+            parts[i].region = std::move( spatial[i] );
+    }
+    else
+    {
+        parts.resize( settings.subdivideParts );
+        ParallelFor( parts, [&]( size_t i )
+        {
+            if ( settings.partFaces )
+                parts[i].region = std::move( (*settings.partFaces)[i] );
+            else
+                parts[i].region = getSubdividePart( mesh.topology.getValidFaces(), settings.subdivideParts, i );
+        } );
+    }
+    const auto sz = parts.size();
     if ( settings.progressCallback && !settings.progressCallback( 0.03f ) )
         return res;
 
@@ -1188,7 +1218,40 @@ static DecimateResult decimateMeshParallelInplace( MR::Mesh & mesh, const Decima
     }
     seqSettings.vertForms = &mVertForms;
     seqSettings.progressCallback = subprogress( settings.progressCallback, 0.9f, 1.0f );
-    if ( settings.decimateBetweenParts )
+    if ( settings.decimateBetweenParts && spatialParts && !limitedDeletion )
+    {
+        // all part interiors are already decimated up to maxError, so only the band near the seams is worth revisiting;
+        // the seam vertices were fixed during parallel decimation, so they are still valid
+        VertBitSet seamVerts;
+        for ( const auto & submesh : parts )
+            seamVerts |= submesh.bdVerts;
+        FaceBitSet seam = getIncidentFaces( mesh.topology, seamVerts );
+        expand( mesh.topology, seam, 2 );
+        if ( settings.region )
+            seam &= *settings.region;
+
+        // fix the border of the band the same way as the border of each part was fixed
+        VertBitSet seamBdVerts = settings.touchNearBdEdges ?
+            getRegionBoundaryVerts( mesh.topology, seam ) : getBoundaryVerts( mesh.topology, &seam );
+        if ( settings.bdVerts )
+            seamBdVerts |= *settings.bdVerts;
+        seqSettings.region = &seam;
+        seqSettings.bdVerts = &seamBdVerts;
+        seqSettings.touchNearBdEdges = false;
+        seqSettings.packMesh = false;
+        res = decimateMeshSerial( mesh, seqSettings );
+
+        // the faces deleted from the band must be excluded from the whole region
+        if ( settings.region )
+            *settings.region &= mesh.topology.getValidFaces();
+        if ( !res.cancelled && settings.packMesh )
+        {
+            seqSettings.region = settings.region;
+            seqSettings.bdVerts = settings.bdVerts;
+            packMesh( mesh, seqSettings );
+        }
+    }
+    else if ( settings.decimateBetweenParts )
     {
         res = decimateMeshSerial( mesh, seqSettings );
     }
@@ -1362,4 +1425,35 @@ TEST( MRMesh, MeshDecimateParallel )
     ASSERT_EQ( mesh.topology.numValidVerts(), 3 );
 }
 
+TEST( MRMesh, MeshDecimateParallelSpatial )
+{
+    // no packOptimally() here
+    auto mesh = makeSphere( { .numMeshVertices = 2000 } );
+    const auto numIniFaces = mesh.topology.numValidFaces();
+    auto region = mesh.topology.getValidFaces();
+    DecimateSettings settings
+    {
+        .maxError = 0.05f,
+        .region = &region,
+        .subdivideParts = 8,
+        .subdivideSpatially = true
+    };
+    auto res = decimateMesh( mesh, settings );
+    EXPECT_FALSE( res.cancelled );
+    EXPECT_GT( res.facesDeleted, numIniFaces / 2 );
+    EXPECT_EQ( res.facesDeleted, numIniFaces - mesh.topology.numValidFaces() );
+    EXPECT_EQ( region.count(), mesh.topology.numValidFaces() );
+    EXPECT_TRUE( mesh.topology.isClosed() );
+
+    auto parts = getSpatialSubdivideParts( mesh, 8 );
+    EXPECT_GE( parts.size(), 8 );
+    FaceBitSet all;
+    for ( const auto & p : parts )
+    {
+        EXPECT_FALSE( all.intersects( p ) );
+        all |= p;
+    }
+    EXPECT_EQ( all.count(), mesh.topology.numValidFaces() );
+}
+
 } //namespace MR
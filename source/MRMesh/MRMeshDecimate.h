@@ -157,6 +157,13 @@ struct DecimateSettings
 
     /// minimum number of faces in one subdivision part for ( subdivideParts > 1 ) mode
     int minFacesInPart = 0;
+
+    /// If true and subdivideParts > 1, then the mesh (or its region) is subdivided on compact in space parts
+    /// formed by the subtrees of internally built AABB tree (see \ref getSpatialSubdivideParts) instead of the ranges of face ids,
+    /// so there is no need to call mesh.packOptimally() before the decimation; the actual number of parts can be up to twice larger than subdivideParts;
+    /// if the number of deletions is not limited, then the final decimation between parts is restricted to the band of faces near the parts' seams;
+    /// this option is ignored if partFaces, notFlippable, edgesToCollapse or twinMap are given
+    bool subdivideSpatially = false;
 };
 
 /**
@@ -210,6 +217,14 @@ MRMESH_API DecimateResult decimateMesh( Mesh & mesh, const DecimateSettings & se
  */
 [[nodiscard]] MRMESH_API FaceBitSet getSubdividePart( const FaceBitSet & valids, size_t subdivideParts, size_t myPart );
 
+/**
+ * \brief returns at least given number of not-overlapping parts of mesh (region) faces, each part is compact in space
+ * being the leaves of one subtree of the AABB tree built for the mesh part;
+ * unlike \ref getSubdividePart, it does not require for the mesh to be packed optimally
+ * \ingroup DecimateGroup
+ */
+[[nodiscard]] MRMESH_API std::vector<FaceBitSet> getSpatialSubdivideParts( const MeshPart & mp, int minParts );
+
 struct ResolveMeshDegenSettings
 {
     [[deprecated]]
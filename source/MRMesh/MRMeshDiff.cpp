@@ -2,6 +2,8 @@
 #include "MRMesh.h"
 #include "MRTimer.h"
 #include "MRMeshBuilder.h"
+#include "MRChangeMeshAction.h"
+#include "MRTorus.h"
 #include "MRGTest.h"
 
 namespace MR
@@ -53,4 +55,58 @@ TEST(MRMesh, MeshDiff)
     EXPECT_EQ( MeshDiff( m, m ).any(), false );
 }
 
+TEST(MRMesh, ChangeMeshActionDiff)
+{
+    auto obj = std::make_shared<ObjectMesh>();
+    obj->setMesh( std::make_shared<Mesh>( makeTorus( 1.0f, 0.3f, 64, 32 ) ) );
+    const Mesh mesh0 = *obj->mesh();
+
+    ChangeMeshAction action( "move", obj );
+    // the mesh is not changed yet, so the full copy must be kept
+    action.changesFinished();
+    EXPECT_GT( action.heapBytes(), mesh0.heapBytes() / 2 );
+
+    obj->varMesh()->points[0_v] += Vector3f( 0.1f, 0.f, 0.f );
+    obj->varMesh()->topology.deleteFace( 0_f );
+    const Mesh mesh1 = *obj->mesh();
+
+    // the clone of whole mesh is replaced with small difference when the changes are finished
+    action.changesFinished();
+    EXPECT_LT( action.heapBytes(), mesh0.heapBytes() / 10 );
+
+    // the mesh before undo is kept by other holder and must remain unchanged
+    auto sharedMesh = obj->mesh();
+    action.action( HistoryAction::Type::Undo );
+    EXPECT_EQ( *obj->mesh(), mesh0 );
+    EXPECT_EQ( *sharedMesh, mesh1 );
+    sharedMesh.reset();
+
+    // the mesh owned only by the object is modified in place
+    const auto * meshPtr = obj->mesh().get();
+    action.action( HistoryAction::Type::Redo );
+    EXPECT_EQ( obj->mesh().get(), meshPtr );
+    EXPECT_EQ( *obj->mesh(), mesh1 );
+    action.action( HistoryAction::Type::Undo );
+    EXPECT_EQ( obj->mesh().get(), meshPtr );
+    EXPECT_EQ( *obj->mesh(), mesh0 );
+}
+
+TEST(MRMesh, ChangeMeshActionRejectedDiff)
+{
+    auto obj = std::make_shared<ObjectMesh>();
+    obj->setMesh( std::make_shared<Mesh>( makeTorus( 1.0f, 0.3f, 16, 8 ) ) );
+    const Mesh mesh0 = *obj->mesh();
+
+    // the mesh is replaced completely, so the difference is not smaller than the copy
+    ChangeMeshAction action( "replace", obj, std::make_shared<Mesh>( makeTorus( 1.0f, 0.2f, 32, 16 ) ) );
+    const Mesh mesh1 = *obj->mesh();
+    action.changesFinished();
+    EXPECT_GE( action.heapBytes(), mesh0.heapBytes() );
+
+    action.action( HistoryAction::Type::Undo );
+    EXPECT_EQ( *obj->mesh(), mesh0 );
+    action.action( HistoryAction::Type::Redo );
+    EXPECT_EQ( *obj->mesh(), mesh1 );
+}
+
 } // namespace MR
@@ -102,6 +102,7 @@ class MRMESH_CLASS ObjTag;
 class MRMESH_CLASS TextureTag;
 class MRMESH_CLASS GraphVertTag;
 class MRMESH_CLASS GraphEdgeTag;
+class MRMESH_CLASS CornerTag;
 
 MR_CANONICAL_TYPEDEFS( (template <typename T> class MRMESH_CLASS), Id,
     ( EdgeId,           Id<EdgeTag>           )
@@ -116,6 +117,7 @@ MR_CANONICAL_TYPEDEFS( (template <typename T> class MRMESH_CLASS), Id,
     ( TextureId,        Id<TextureTag>        )
     ( GraphVertId,      Id<GraphVertTag>      )
     ( GraphEdgeId,      Id<GraphEdgeTag>      )
+    ( CornerId,         Id<CornerTag>         )
 )
 
 MR_CANONICAL_TYPEDEFS( (template <typename T> class MRMESH_CLASS), NoInitId,
@@ -438,6 +440,8 @@ struct MeshTriPoint;
 struct MeshProjectionResult;
 struct MeshIntersectionResult;
 struct PointsProjectionResult;
+struct PointNeighborhoodSettings;
+struct PointNeighborhoodGraph;
 template <typename T> struct IntersectionPrecomputes;
 
 template <typename I> struct IteratorRange;
@@ -555,6 +559,7 @@ struct MRMESH_CLASS EdgeLengthMesh;
 class MRMESH_CLASS MeshOrPoints;
 struct MRMESH_CLASS PointCloud;
 class MRMESH_CLASS AABBTree;
+class MRMESH_CLASS AABBTreeWide;
 class MRMESH_CLASS AABBTreePoints;
 class MRMESH_CLASS AABBTreeObjects;
 struct MRMESH_CLASS CloudPartMapping;
@@ -563,6 +568,7 @@ struct MeshOrPointsXf;
 struct MeshTexture;
 struct GridSettings;
 struct TriMesh;
+class IMeshStreamWriter;
 
 MR_CANONICAL_TYPEDEFS( ( template <typename T> struct ), MRMESH_CLASS MeshRegion,
     ( MeshPart, MeshRegion<FaceTag> )
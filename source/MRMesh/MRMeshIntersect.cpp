@@ -1,5 +1,6 @@
 #include "MRMeshIntersect.h"
 #include "MRAABBTree.h"
+#include "MRAABBTreeWide.h"
 #include "MRMesh.h"
 #include "MRMeshPart.h"
 #include "MRRayBoxIntersection.h"
@@ -12,6 +13,8 @@
 #include "MRParallelFor.h"
 #include "MRBitSetParallelFor.h"
 #include "MRTimer.h"
+#include "MRTorus.h"
+#include "MRGTest.h"
 #include "MRPch/MRSpdlog.h"
 
 namespace MR
@@ -118,6 +121,95 @@ MeshIntersectionResult meshRayIntersect_( const MeshPart& meshPart, const Line3<
     return res;
 }
 
+/// the same as meshRayIntersect_ but with wide tree
+static MeshIntersectionResult meshRayIntersectWide_( const MeshPart& meshPart, const AABBTreeWide& tree, const Line3f& line,
+    float rayStart, float rayEnd, const IntersectionPrecomputes<float>& prec, bool closestIntersect, const FacePredicate & validFaces )
+{
+    const auto& m = meshPart.mesh;
+    MeshIntersectionResult res;
+    if( tree.nodes().empty() )
+        return res;
+
+    const Vector3f invDir(
+        ( line.d.x == 0 ) ? std::numeric_limits<float>::max() : 1 / line.d.x,
+        ( line.d.y == 0 ) ? std::numeric_limits<float>::max() : 1 / line.d.y,
+        ( line.d.z == 0 ) ? std::numeric_limits<float>::max() : 1 / line.d.z );
+
+    struct SubTask
+    {
+        NoInitNodeId n;
+        float tEnter;
+    };
+    // each level of the tree adds at most Width-1 tasks
+    constexpr int maxStackSize = 32 * ( AABBTreeWideNode::Width - 1 ) + 1;
+    SubTask subtasks[maxStackSize];
+    int numSubtasks = 0;
+    subtasks[numSubtasks++] = { tree.rootNodeId(), rayStart };
+
+    FaceId faceId;
+    TriPointf triP;
+    while( numSubtasks > 0 && ( closestIntersect || !faceId ) )
+    {
+        const auto s = subtasks[--numSubtasks];
+        if( !( s.tEnter < rayEnd ) )
+            continue;
+
+        const auto& node = tree[s.n];
+        float tEnter[AABBTreeWideNode::Width];
+        const int hits = rayChildBoxesIntersect( node, line.p, invDir, rayStart, rayEnd, tEnter );
+
+        SubTask inner[AABBTreeWideNode::Width];
+        int numInner = 0;
+        for( int i = 0; i < AABBTreeWideNode::Width; ++i )
+        {
+            if( !( hits & ( 1 << i ) ) || !node.hasChild( i ) )
+                continue;
+            if( !node.leafChild( i ) )
+            {
+                inner[numInner++] = { node.childNode( i ), tEnter[i] };
+                continue;
+            }
+            const auto face = node.childFace( i );
+            if( ( meshPart.region && !meshPart.region->test( face ) ) || ( validFaces && !validFaces( face ) ) )
+                continue;
+
+            VertId a, b, c;
+            m.topology.getTriVerts( face, a, b, c );
+            if ( auto triIsect = rayTriangleIntersect( m.points[a] - line.p, m.points[b] - line.p, m.points[c] - line.p, prec ) )
+            {
+                if ( triIsect->t < rayEnd && triIsect->t > rayStart )
+                {
+                    faceId = face;
+                    triP = triIsect->bary;
+                    rayEnd = triIsect->t;
+                    if ( !closestIntersect )
+                        break;
+                }
+            }
+        }
+        if( numSubtasks + numInner > maxStackSize ) // max depth exceeded
+        {
+            spdlog::critical( "Maximal AABBTreeWide depth reached!" );
+            assert( false );
+            break;
+        }
+
+        // push the nodes with farther entrance first to descend in the closest one
+        std::sort( inner, inner + numInner, []( const SubTask & a, const SubTask & b ) { return a.tEnter > b.tEnter; } );
+        for( int i = 0; i < numInner; ++i )
+            subtasks[numSubtasks++] = inner[i];
+    }
+
+    if( faceId.valid() )
+    {
+        res.proj.face = faceId;
+        res.proj.point = line.p + rayEnd * line.d;
+        res.mtp = MeshTriPoint( m.topology.edgeWithLeft( faceId ), triP );
+        res.distanceAlongLine = rayEnd;
+    }
+    return res;
+}
+
 MeshIntersectionResult rayMeshIntersect( const MeshPart& meshPart, const Line3f& line,
     float rayStart, float rayEnd, const IntersectionPrecomputes<float>* prec, bool closestIntersect, const FacePredicate & validFaces )
 {
@@ -132,6 +224,15 @@ MeshIntersectionResult rayMeshIntersect( const MeshPart& meshPart, const Line3f&
     }
 }
 
+MeshIntersectionResult rayMeshIntersectWide( const MeshPart& meshPart, const AABBTreeWide& tree, const Line3f& line,
+    float rayStart, float rayEnd, const IntersectionPrecomputes<float>* prec, bool closestIntersect, const FacePredicate & validFaces )
+{
+    if( prec )
+        return meshRayIntersectWide_( meshPart, tree, line, rayStart, rayEnd, *prec, closestIntersect, validFaces );
+    const IntersectionPrecomputes<float> precNew( line.d );
+    return meshRayIntersectWide_( meshPart, tree, line, rayStart, rayEnd, precNew, closestIntersect, validFaces );
+}
+
 MeshIntersectionResult rayMeshIntersect( const MeshPart& meshPart, const Line3d& line,
     double rayStart, double rayEnd, const IntersectionPrecomputes<double>* prec, bool closestIntersect, const FacePredicate & validFaces )
 {
@@ -146,20 +247,12 @@ MeshIntersectionResult rayMeshIntersect( const MeshPart& meshPart, const Line3d&
     }
 }
 
-void multiRayMeshIntersect(
-    const MeshPart& meshPart,
-    const std::vector<Vector3f>& origins,
-    const std::vector<Vector3f>& dirs,
-    const MultiRayMeshIntersectResult& result,
-    float rayStart, float rayEnd,
-    bool closestIntersect,
-    const FacePredicate & validFaces
-)
+namespace
 {
-    MR_TIMER;
 
-    const auto sz = origins.size();
-    assert( dirs.size() == sz );
+/// resizes all requested outputs for given number of rays and fills them with no-intersection values
+void initMultiRayResult( const MultiRayMeshIntersectResult& result, size_t sz )
+{
     if ( result.intersectingRays )
     {
         result.intersectingRays->clear();
@@ -186,24 +279,316 @@ void multiRayMeshIntersect(
         result.isectPts->clear();
         result.isectPts->resize( sz, Vector3f( cQuietNan, cQuietNan, cQuietNan ) );
     }
+}
+
+/// stores the intersection of i-th ray in all requested outputs
+void setMultiRayResult( const MultiRayMeshIntersectResult& result, size_t i, const MeshIntersectionResult & res )
+{
+    if ( result.intersectingRays )
+        result.intersectingRays->set( i );
+    if ( result.rayDistances )
+        ( *result.rayDistances )[i] = res.distanceAlongLine;
+    if ( result.isectFaces )
+        (*result.isectFaces)[i] = res.proj.face;
+    if ( result.isectBary )
+        (*result.isectBary)[i] = res.mtp.bary;
+    if ( result.isectPts )
+        (*result.isectPts)[i] = res.proj.point;
+}
+
+/// the number of rays traversing the tree together in multiRayMeshIntersectPacket
+constexpr int cPacketSize = 8;
+
+/// a group of rays traversing the tree together;
+/// all per-ray data is stored in structure-of-arrays form to let the compiler vectorize the loops over rays
+class RayPacket
+{
+public:
+    RayPacket( const Vector3f * origins, const Vector3f * dirs, int num, float rayStart, float rayEnd );
+
+    /// finds the intersection of every ray with the mesh
+    void intersect( const MeshPart& meshPart, bool closestIntersect, const FacePredicate & validFaces );
+
+    /// returns the intersection found for i-th ray
+    MeshIntersectionResult result( const Mesh & mesh, int i ) const;
+
+private:
+    /// returns false if the box is certainly not intersected by any ray of the packet;
+    /// the test is done once for the whole packet using interval arithmetic over the frustum of rays with same direction signs
+    bool frustumIntersectsBox_( const Box3f & box, int mask ) const;
+
+    /// returns the mask of rays from given mask intersecting the box
+    int intersectBox_( const Box3f & box, int mask ) const;
+
+    /// finds the intersections of the rays from given mask with the triangle and updates the closest intersections
+    void intersectTriangle_( const Mesh & mesh, FaceId f, int mask );
+
+    int num_ = 0;
+    float rayStart_ = 0;
+    float org_[3][cPacketSize] = {};
+    float dir_[3][cPacketSize] = {};
+    float invDir_[3][cPacketSize] = {};
+    float dirLen_[cPacketSize] = {};
+    float rayEnd_[cPacketSize] = {};
+    IntersectionPrecomputes<float> prec_[cPacketSize];
+
+    /// true if all rays have the same sign of direction along the axis
+    bool sameSign_[3] = {};
+    /// true if the rays go in negative direction along the axis
+    bool negative_[3] = {};
+    /// the bounds of origins and inverse directions of all rays
+    Vector3f orgMin_, orgMax_, invDirMin_, invDirMax_;
+    /// the sum of all directions to order children nodes from near to far
+    Vector3f sumDir_;
+
+    FaceId face_[cPacketSize];
+    TriPointf bary_[cPacketSize];
+};
+
+RayPacket::RayPacket( const Vector3f * origins, const Vector3f * dirs, int num, float rayStart, float rayEnd )
+    : num_( num ), rayStart_( rayStart )
+{
+    assert( num > 0 && num <= cPacketSize );
+    orgMin_ = invDirMin_ = Vector3f::diagonal( FLT_MAX );
+    orgMax_ = invDirMax_ = Vector3f::diagonal( -FLT_MAX );
+    for ( int a = 0; a < 3; ++a )
+    {
+        sameSign_[a] = true;
+        negative_[a] = dirs[0][a] < 0;
+    }
+    for ( int i = 0; i < cPacketSize; ++i )
+    {
+        // unused slots repeat the last ray, but they are never active
+        const auto & o = origins[std::min( i, num - 1 )];
+        const auto & d = dirs[std::min( i, num - 1 )];
+        for ( int a = 0; a < 3; ++a )
+        {
+            org_[a][i] = o[a];
+            dir_[a][i] = d[a];
+            invDir_[a][i] = ( d[a] == 0 ) ? std::numeric_limits<float>::max() : 1 / d[a];
+            if ( i < num )
+            {
+                orgMin_[a] = std::min( orgMin_[a], o[a] );
+                orgMax_[a] = std::max( orgMax_[a], o[a] );
+                invDirMin_[a] = std::min( invDirMin_[a], invDir_[a][i] );
+                invDirMax_[a] = std::max( invDirMax_[a], invDir_[a][i] );
+                if ( ( d[a] < 0 ) != negative_[a] || d[a] == 0 )
+                    sameSign_[a] = false;
+            }
+        }
+        dirLen_[i] = d.length();
+        rayEnd_[i] = rayEnd;
+        if ( i < num )
+        {
+            prec_[i] = IntersectionPrecomputes<float>( d );
+            sumDir_ += d;
+        }
+    }
+}
+
+bool RayPacket::frustumIntersectsBox_( const Box3f & box, int mask ) const
+{
+    float maxEnd = rayStart_;
+    for ( int i = 0; i < num_; ++i )
+        if ( mask & ( 1 << i ) )
+            maxEnd = std::max( maxEnd, rayEnd_[i] );
+
+    // the products of intervals [a0, a1] * [b0, b1]
+    auto lowerProduct = []( float a0, float a1, float b0, float b1 ) { return std::min( std::min( a0 * b0, a0 * b1 ), std::min( a1 * b0, a1 * b1 ) ); };
+    auto upperProduct = []( float a0, float a1, float b0, float b1 ) { return std::max( std::max( a0 * b0, a0 * b1 ), std::max( a1 * b0, a1 * b1 ) ); };
+
+    float enterLo = rayStart_, exitHi = maxEnd;
+    for ( int a = 0; a < 3; ++a )
+    {
+        if ( !sameSign_[a] )
+            continue;
+        // the rays enter the slab through one plane and exit through the other
+        const float enterPlane = negative_[a] ? box.max[a] : box.min[a];
+        const float exitPlane = negative_[a] ? box.min[a] : box.max[a];
+        enterLo = std::max( enterLo, lowerProduct( enterPlane - orgMax_[a], enterPlane - orgMin_[a], invDirMin_[a], invDirMax_[a] ) );
+        exitHi = std::min( exitHi, upperProduct( exitPlane - orgMax_[a], exitPlane - orgMin_[a], invDirMin_[a], invDirMax_[a] ) );
+    }
+    return enterLo <= exitHi;
+}
+
+int RayPacket::intersectBox_( const Box3f & box, int mask ) const
+{
+    float tMin[cPacketSize], tMax[cPacketSize];
+    for ( int i = 0; i < cPacketSize; ++i )
+    {
+        tMin[i] = rayStart_;
+        tMax[i] = rayEnd_[i];
+    }
+    for ( int a = 0; a < 3; ++a )
+    {
+        for ( int i = 0; i < cPacketSize; ++i )
+        {
+            const float t1 = ( box.min[a] - org_[a][i] ) * invDir_[a][i];
+            const float t2 = ( box.max[a] - org_[a][i] ) * invDir_[a][i];
+            tMin[i] = std::max( tMin[i], std::min( t1, t2 ) );
+            tMax[i] = std::min( tMax[i], std::max( t1, t2 ) );
+        }
+    }
+    int res = 0;
+    for ( int i = 0; i < cPacketSize; ++i )
+        if ( tMin[i] <= tMax[i] )
+            res |= 1 << i;
+    return res & mask;
+}
+
+void RayPacket::intersectTriangle_( const Mesh & mesh, FaceId f, int mask )
+{
+    Vector3f a, b, c;
+    mesh.getTriPoints( f, a, b, c );
+    const auto e1 = b - a;
+    const auto e2 = c - a;
+    const float normLen = cross( e1, e2 ).length();
+
+    // Moller-Trumbore test of all rays at once is used as a conservative filter with a tolerance in barycentric coordinates,
+    // and the rays passing it are checked by exact watertight test, so the results are the same as from rayMeshIntersect
+    constexpr float cBaryTolerance = 1e-3f;
+    constexpr float cDegenerateDet = 1e-5f;
+    int candidates = 0;
+    for ( int i = 0; i < cPacketSize; ++i )
+    {
+        const float px = dir_[1][i] * e2.z - dir_[2][i] * e2.y;
+        const float py = dir_[2][i] * e2.x - dir_[0][i] * e2.z;
+        const float pz = dir_[0][i] * e2.y - dir_[1][i] * e2.x;
+        const float det = e1.x * px + e1.y * py + e1.z * pz;
+        const float tx = org_[0][i] - a.x;
+        const float ty = org_[1][i] - a.y;
+        const float tz = org_[2][i] - a.z;
+        const float qx = ty * e1.z - tz * e1.y;
+        const float qy = tz * e1.x - tx * e1.z;
+        const float qz = tx * e1.y - ty * e1.x;
+        const float invDet = 1 / det;
+        const float u = ( tx * px + ty * py + tz * pz ) * invDet;
+        const float v = ( dir_[0][i] * qx + dir_[1][i] * qy + dir_[2][i] * qz ) * invDet;
+        const bool degenerate = !( std::abs( det ) > cDegenerateDet * normLen * dirLen_[i] );
+        const bool inside = u >= -cBaryTolerance && v >= -cBaryTolerance && u + v <= 1 + cBaryTolerance;
+        if ( degenerate || inside )
+            candidates |= 1 << i;
+    }
+    candidates &= mask;
+    if ( !candidates )
+        return;
+
+    for ( int i = 0; i < num_; ++i )
+    {
+        if ( !( candidates & ( 1 << i ) ) )
+            continue;
+        const Vector3f o( org_[0][i], org_[1][i], org_[2][i] );
+        if ( auto triIsect = rayTriangleIntersect( a - o, b - o, c - o, prec_[i] ) )
+        {
+            if ( triIsect->t < rayEnd_[i] && triIsect->t > rayStart_ )
+            {
+                face_[i] = f;
+                bary_[i] = triIsect->bary;
+                rayEnd_[i] = triIsect->t;
+            }
+        }
+    }
+}
+
+void RayPacket::intersect( const MeshPart& meshPart, bool closestIntersect, const FacePredicate & validFaces )
+{
+    const auto& m = meshPart.mesh;
+    const auto& tree = m.getAABBTree();
+    if( tree.nodes().empty() )
+        return;
+
+    constexpr int maxTreeDepth = 32;
+    NodeId nodesStack[maxTreeDepth];
+    int currentNode = 0;
+    nodesStack[0] = tree.rootNodeId();
+
+    int active = ( 1 << num_ ) - 1;
+    while( currentNode >= 0 && active )
+    {
+        if( currentNode >= maxTreeDepth ) // max depth exceeded
+        {
+            spdlog::critical( "Maximal AABBTree depth reached!" );
+            assert( false );
+            break;
+        }
+
+        const auto& node = tree[nodesStack[currentNode--]];
+        if( !frustumIntersectsBox_( node.box, active ) )
+            continue;
+        const int hits = intersectBox_( node.box, active );
+        if( !hits )
+            continue;
+
+        if( node.leaf() )
+        {
+            const auto face = node.leafId();
+            if( ( meshPart.region && !meshPart.region->test( face ) ) || ( validFaces && !validFaces( face ) ) )
+                continue;
+            intersectTriangle_( m, face, hits );
+            if ( !closestIntersect )
+            {
+                // the rays with any intersection are done
+                for ( int i = 0; i < num_; ++i )
+                    if ( face_[i] )
+                        active &= ~( 1 << i );
+            }
+            continue;
+        }
+
+        // push farther child first to descend in the closer one
+        if( dot( tree[node.l].box.center() - tree[node.r].box.center(), sumDir_ ) > 0 )
+        {
+            nodesStack[++currentNode] = node.l;
+            nodesStack[++currentNode] = node.r;
+        }
+        else
+        {
+            nodesStack[++currentNode] = node.r;
+            nodesStack[++currentNode] = node.l;
+        }
+    }
+}
+
+MeshIntersectionResult RayPacket::result( const Mesh & mesh, int i ) const
+{
+    assert( i >= 0 && i < num_ );
+    MeshIntersectionResult res;
+    if( face_[i] )
+    {
+        const Vector3f o( org_[0][i], org_[1][i], org_[2][i] );
+        const Vector3f d( dir_[0][i], dir_[1][i], dir_[2][i] );
+        res.proj.face = face_[i];
+        res.proj.point = o + rayEnd_[i] * d;
+        res.mtp = MeshTriPoint( mesh.topology.edgeWithLeft( face_[i] ), bary_[i] );
+        res.distanceAlongLine = rayEnd_[i];
+    }
+    return res;
+}
+
+} //anonymous namespace
+
+void multiRayMeshIntersect(
+    const MeshPart& meshPart,
+    const std::vector<Vector3f>& origins,
+    const std::vector<Vector3f>& dirs,
+    const MultiRayMeshIntersectResult& result,
+    float rayStart, float rayEnd,
+    bool closestIntersect,
+    const FacePredicate & validFaces
+)
+{
+    MR_TIMER;
+
+    const auto sz = origins.size();
+    assert( dirs.size() == sz );
+    initMultiRayResult( result, sz );
 
     meshPart.mesh.getAABBTree(); // prepare tree before parallel region
 
     auto processRay = [&]( size_t i )
     {
-        auto res = rayMeshIntersect( meshPart, Line3f( origins[i], dirs[i] ), rayStart, rayEnd, nullptr, closestIntersect, validFaces );
-        if ( !res )
-            return;
-        if ( result.intersectingRays )
-            result.intersectingRays->set( i );
-        if ( result.rayDistances )
-            ( *result.rayDistances )[i] = res.distanceAlongLine;
-        if ( result.isectFaces )
-            (*result.isectFaces)[i] = res.proj.face;
-        if ( result.isectBary )
-            (*result.isectBary)[i] = res.mtp.bary;
-        if ( result.isectPts )
-            (*result.isectPts)[i] = res.proj.point;
+        if ( auto res = rayMeshIntersect( meshPart, Line3f( origins[i], dirs[i] ), rayStart, rayEnd, nullptr, closestIntersect, validFaces ) )
+            setMultiRayResult( result, i, res );
     };
 
     if ( result.intersectingRays )
@@ -212,6 +597,42 @@ void multiRayMeshIntersect(
         ParallelFor( size_t( 0 ), sz, processRay );
 }
 
+void multiRayMeshIntersectPacket(
+    const MeshPart& meshPart,
+    const std::vector<Vector3f>& origins,
+    const std::vector<Vector3f>& dirs,
+    const MultiRayMeshIntersectResult& result,
+    float rayStart, float rayEnd,
+    bool closestIntersect,
+    const FacePredicate & validFaces
+)
+{
+    MR_TIMER;
+
+    const auto sz = origins.size();
+    assert( dirs.size() == sz );
+    initMultiRayResult( result, sz );
+
+    meshPart.mesh.getAABBTree(); // prepare tree before parallel region
+
+    // each thread processes whole blocks of intersectingRays to avoid simultaneous modification of one block
+    constexpr size_t cRaysInBlock = BitSet::bits_per_block;
+    static_assert( cRaysInBlock % cPacketSize == 0 );
+    ParallelFor( size_t( 0 ), ( sz + cRaysInBlock - 1 ) / cRaysInBlock, [&]( size_t block )
+    {
+        const auto blockEnd = std::min( sz, ( block + 1 ) * cRaysInBlock );
+        for ( size_t first = block * cRaysInBlock; first < blockEnd; first += cPacketSize )
+        {
+            const int num = int( std::min( size_t( cPacketSize ), blockEnd - first ) );
+            RayPacket packet( origins.data() + first, dirs.data() + first, num, rayStart, rayEnd );
+            packet.intersect( meshPart, closestIntersect, validFaces );
+            for ( int i = 0; i < num; ++i )
+                if ( auto res = packet.result( meshPart.mesh, i ) )
+                    setMultiRayResult( result, first + i, res );
+        }
+    } );
+}
+
 template<typename T>
 MultiMeshIntersectionResult rayMultiMeshAnyIntersect_( const std::vector<Line3Mesh<T>> & lineMeshes,
     T rayStart /*= 0.0f*/, T rayEnd /*= FLT_MAX */ )
@@ -538,4 +959,32 @@ void xyPlaneMeshIntersect( const MeshPart& meshPart, float zLevel,
     }
 }
 
+TEST( MRMesh, MultiRayMeshIntersectPacket )
+{
+    const auto mesh = makeTorus( 1.0f, 0.3f, 64, 32 );
+
+    // camera rays from one point
+    std::vector<Vector3f> origins, dirs;
+    const int res = 37;
+    for ( int y = 0; y < res; ++y )
+        for ( int x = 0; x < res; ++x )
+        {
+            origins.emplace_back( 0.1f, 0.2f, 3.0f );
+            dirs.emplace_back( 3.0f * x / res - 1.5f, 3.0f * y / res - 1.5f, -3.0f );
+        }
+
+    BitSet hits, hitsPacket;
+    std::vector<float> dists, distsPacket;
+    multiRayMeshIntersect( mesh, origins, dirs, { .intersectingRays = &hits, .rayDistances = &dists } );
+    multiRayMeshIntersectPacket( mesh, origins, dirs, { .intersectingRays = &hitsPacket, .rayDistances = &distsPacket } );
+    EXPECT_TRUE( hits.any() );
+    EXPECT_EQ( hits, hitsPacket );
+    for ( auto i : hits )
+        EXPECT_EQ( dists[i], distsPacket[i] );
+
+    // any intersection is found for the same rays
+    multiRayMeshIntersectPacket( mesh, origins, dirs, { .intersectingRays = &hitsPacket }, 0.0f, FLT_MAX, false );
+    EXPECT_EQ( hits, hitsPacket );
+}
+
 } //namespace MR
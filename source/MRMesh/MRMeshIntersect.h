@@ -37,6 +37,12 @@ struct MeshIntersectionResult
     float rayStart = 0.0f, float rayEnd = FLT_MAX, const IntersectionPrecomputes<float>* prec = nullptr, bool closestIntersect = true,
     const FacePredicate & validFaces = {} );
 
+/// Same as \ref rayMeshIntersect in float-precision, but traverses explicitly given wide tree (e.g. Mesh::getAABBTreeWide()),
+/// which is faster for large meshes; the result is the same up to the choice among equally distant intersections
+[[nodiscard]] MRMESH_API MeshIntersectionResult rayMeshIntersectWide( const MeshPart& meshPart, const AABBTreeWide& tree, const Line3f& line,
+    float rayStart = 0.0f, float rayEnd = FLT_MAX, const IntersectionPrecomputes<float>* prec = nullptr, bool closestIntersect = true,
+    const FacePredicate & validFaces = {} );
+
 /// Finds ray and mesh intersection in double-precision.
 /// \p rayStart and \p rayEnd define the interval on the ray to detect an intersection.
 /// \p prec can be specified to reuse some precomputations (e.g. for checking many parallel rays).
@@ -71,6 +77,21 @@ MRMESH_API void multiRayMeshIntersect(
     const FacePredicate & validFaces = {} ///< if given then all faces for which false is returned will be skipped
 );
 
+/// Same as multiRayMeshIntersect, but traverses the tree by packets of 8 consecutive rays together,
+/// which is faster for coherent rays (e.g. from close origins in close directions as camera rays);
+/// the results are the same as from multiRayMeshIntersect (up to the choice among equally distant intersections)
+MRMESH_API void multiRayMeshIntersectPacket(
+    // input:
+    const MeshPart& meshPart, ///< mesh (or its part) to find intersections with
+    const std::vector<Vector3f>& origins, ///< origin point of every ray
+    const std::vector<Vector3f>& dirs,    ///< direction of every ray
+    const MultiRayMeshIntersectResult& result, ///< output data for every ray
+    // advanced options:
+    float rayStart = 0.0f, float rayEnd = FLT_MAX,
+    bool closestIntersect = true, ///< finds the closest to ray origin intersection (or any intersection for better performance if \p !closestIntersect)
+    const FacePredicate & validFaces = {} ///< if given then all faces for which false is returned will be skipped
+);
+
 struct MultiMeshIntersectionResult : MeshIntersectionResult
 {
     /// the intersection found in this mesh
@@ -2,11 +2,13 @@
 #include "MRMeshBuilder.h"
 #include "MRIdentifyVertices.h"
 #include "MRMesh.h"
+#include "MRMeshBinaryFormats.h"
 #include "MRphmap.h"
 #include "MRTimer.h"
 #include "miniply.h"
 #include "MRIOFormatsRegistry.h"
 #include "MRStringConvert.h"
+#include "MRString.h"
 #include "MRMeshLoadObj.h"
 #include "MRObjectMesh.h"
 #include "MRObjectsAccess.h"
@@ -15,10 +17,17 @@
 #include "MRIOParsing.h"
 #include "MRMeshDelone.h"
 #include "MRParallelFor.h"
+#include "MRMappedFile.h"
+#include "MRMeshSave.h"
+#include "MRTorus.h"
+#include "MRUniqueTemporaryFolder.h"
+#include "MRGTest.h"
 #include "MRPch/MRFmt.h"
 #include "MRPch/MRTBB.h"
 
 #include <array>
+#include <cstddef>
+#include <cstring>
 #include <future>
 
 namespace MR
@@ -117,8 +126,103 @@ Expected<Mesh> loadMesh( std::istream& in, const std::string& extension, const M
 namespace MeshLoad
 {
 
+namespace
+{
+
+/// loads mesh in internal MeshLib format directly from memory (e.g. mapped file), avoiding any intermediate buffers
+Expected<Mesh> fromMrmesh( const char* data, size_t size, const MeshLoadSettings& settings )
+{
+    MR_TIMER;
+
+    Mesh mesh;
+    auto readRes = mesh.topology.read( data, size, subprogress( settings.callback, 0.f, 0.5f ) );
+    if ( !readRes.has_value() )
+    {
+        std::string error = readRes.error();
+        if ( error != stringOperationCanceled() )
+            error = "Error reading topology from mrmesh - file:\n" + error;
+        return unexpected( error );
+    }
+
+    // read points
+    size_t pos = *readRes;
+    std::uint32_t numPoints;
+    if ( pos + 4 > size )
+        return unexpected( std::string( "Error reading the number of points from mrmesh-file" ) );
+    std::memcpy( &numPoints, data + pos, 4 );
+    pos += 4;
+    const size_t pointsBytes = size_t( numPoints ) * sizeof( Vector3f );
+    if ( pos + pointsBytes > size )
+        return unexpected( std::string( "Error reading  points from mrmesh-file" ) );
+    mesh.points.resizeNoInit( numPoints );
+    if ( !copyByBlocks( data + pos, ( char* )mesh.points.data(), pointsBytes, subprogress( settings.callback, 0.5f, 1.f ) ) )
+        return unexpectedOperationCanceled();
+
+    return mesh;
+}
+
+/// makes mesh from the triangles with identified vertices, the last stage of STL loading
+Expected<Mesh> fromIdentifiedTriangles( MeshBuilder::VertexIdentifier & vi, const MeshLoadSettings& settings )
+{
+    auto t = vi.takeTriangulation();
+    std::vector<MeshBuilder::VertDuplication> dups;
+    std::vector<MeshBuilder::VertDuplication>* dupsPtr = nullptr;
+    if ( settings.duplicatedVertexCount )
+        dupsPtr = &dups;
+    const auto res = Mesh::fromTrianglesDuplicatingNonManifoldVertices( vi.takePoints(), t, dupsPtr, { .skippedFaceCount = settings.skippedFaceCount } );
+    if ( settings.duplicatedVertexCount )
+        *settings.duplicatedVertexCount = int( dups.size() );
+    if ( !reportProgress( settings.callback , 1.0f ) )
+        return unexpectedOperationCanceled();
+    return res;
+}
+
+/// loads mesh in binary .STL format directly from memory (e.g. mapped file):
+/// the triangles are decoded in parallel by large chunks, and no copy of whole file is made
+Expected<Mesh> fromBinaryStl( const char* data, size_t size, const MeshLoadSettings& settings )
+{
+    MR_TIMER;
+
+    constexpr size_t cHeaderSize = 80 + 4;
+    if ( size < cHeaderSize )
+        return unexpected( std::string( "Error reading the number of triangles from STL-file" ) );
+    std::uint32_t numTris;
+    std::memcpy( &numTris, data + 80, 4 );
+    if ( size - cHeaderSize < sizeof( StlTriangle ) * size_t( numTris ) )
+        return unexpected( std::string( "Binary STL-file is too short" ) );
+    const char* tris = data + cHeaderSize;
+
+    MeshBuilder::VertexIdentifier vi;
+    vi.reserve( numTris );
+
+    const size_t itemsInChunk = std::min( numTris, 1u << 20 );
+    std::vector<Triangle3f> chunk;
+    for ( size_t first = 0; first < numTris; first += itemsInChunk )
+    {
+        chunk.resize( std::min( itemsInChunk, numTris - first ) );
+        ParallelFor( chunk, [&] ( size_t i )
+        {
+            static_assert( sizeof( Triangle3f ) == sizeof( StlTriangle::vert ) );
+            std::memcpy( (void*)&chunk[i], tris + ( first + i ) * sizeof( StlTriangle ) + offsetof( StlTriangle, vert ), sizeof( Triangle3f ) );
+        } );
+        vi.addTriangles( chunk );
+        // 0.5 because fromTrianglesDuplicatingNonManifoldVertices takes at least half of time
+        if ( !reportProgress( settings.callback, 0.5f * float( first + chunk.size() ) / float( numTris ) ) )
+            return unexpectedOperationCanceled();
+    }
+
+    return fromIdentifiedTriangles( vi, settings );
+}
+
+} //anonymous namespace
+
 Expected<Mesh> fromMrmesh( const std::filesystem::path& file, const MeshLoadSettings& settings /*= {}*/ )
 {
+    MappedFile mapped;
+    if ( mapped.open( file ) )
+        return addFileNameInError( fromMrmesh( mapped.data(), mapped.size(), settings ), file );
+
+    // the file cannot be mapped (e.g. it is not a regular file), read it as a stream
     std::ifstream in( file, std::ifstream::binary );
     if ( !in )
         return unexpected( std::string( "Cannot open file for reading " ) + utf8string( file ) );
@@ -206,83 +310,66 @@ Expected<Mesh> fromOff( std::istream& in, const MeshLoadSettings& settings /*= {
         }
     }
 
-    std::vector<Vector3f> pointsBlocks( numPoints );
+    if ( splitLines.size() < numPoints + strHeader + strBorder + numPolygons + 1 )
+        return unexpected( std::string( "OFF-file is too short" ) );
 
-    std::atomic<bool> forseStop = false;
-    bool keepGoing = ParallelFor( pointsBlocks, [&] ( size_t numPoint )
+    std::vector<Vector3f> pointsBlocks( numPoints );
+    auto parseRes = parseLinesByChunks( pointsBlocks.size(), [&] ( size_t, size_t first, size_t last ) -> Expected<void>
     {
-        if ( forseStop )
-        {
-            return;
-        }
-        size_t numLine = strHeader + numPoint;
-
-        const std::string_view line( &buf[splitLines[numLine]], splitLines[numLine + 1] - splitLines[numLine] );
-        Vector3d temp;
-        auto result = parseTextCoordinate( line, temp );
-        pointsBlocks[numPoint] = Vector3f( temp );
-
-        if ( !result.has_value() )
+        for ( auto numPoint = first; numPoint < last; ++numPoint )
         {
-            forseStop = true;
+            Vector3d temp;
+            if ( !parseTextCoordinate( getLine( buf.data(), splitLines, strHeader + numPoint ), temp ) )
+                return unexpected( std::string( "Error when reading coordinates" ) );
+            pointsBlocks[numPoint] = Vector3f( temp );
         }
+        return {};
     }, subprogress( settings.callback, 0.0f, 0.3f ) );
-
-    if ( forseStop )
-    {
-        return unexpected( std::string( "Error when reading coordinates" ) );
-    }
-    if ( !keepGoing )
-    {
-        return unexpectedOperationCanceled();
-    }
+    if ( !parseRes )
+        return unexpected( std::move( parseRes.error() ) );
 
     size_t delta = numPoints + strHeader + strBorder;
 
+    // the numbers of vertices in polygons are read in parallel and then converted in the spans of polygons
     Vector<MeshBuilder::VertSpan, FaceId> faces( numPolygons );
-    int numPolygonPoint = 0;
-    int start = 0;
-    for ( size_t i = 0; i < numPolygons; i++ )
+    parseRes = parseLinesByChunks( faces.size(), [&] ( size_t, size_t first, size_t last ) -> Expected<void>
     {
-        size_t numLine = delta + i;
-
-        const std::string_view line( &buf[splitLines[numLine]], splitLines[numLine + 1] - splitLines[numLine] );
-        if ( auto e = parseFirstNum( line, numPolygonPoint ); !e )
-            return unexpected( std::move( e.error() ) );
+        for ( auto numPolygon = first; numPolygon < last; ++numPolygon )
+        {
+            int numPolygonPoint = 0;
+            if ( auto e = parseFirstNum( getLine( buf.data(), splitLines, delta + numPolygon ), numPolygonPoint ); !e )
+                return unexpected( std::move( e.error() ) );
+            faces.vec_[numPolygon].lastVertex = numPolygonPoint;
+        }
+        return {};
+    }, subprogress( settings.callback, 0.3f, 0.35f ) );
+    if ( !parseRes )
+        return unexpected( std::move( parseRes.error() ) );
 
-        faces.vec_[i] = MeshBuilder::VertSpan{ start, start + numPolygonPoint };
-        start += numPolygonPoint;
+    int start = 0;
+    for ( auto & span : faces )
+    {
+        span.firstVertex = start;
+        start += span.lastVertex;
+        span.lastVertex = start;
     }
     if ( !reportProgress( settings.callback, 0.4f ) )
         return unexpectedOperationCanceled();
 
     std::vector<VertId> flatPolygonIndices( faces.back().lastVertex );
 
-    keepGoing = ParallelFor( faces, [&] ( size_t numPolygon )
+    parseRes = parseLinesByChunks( faces.size(), [&] ( size_t, size_t first, size_t last ) -> Expected<void>
     {
-        if ( forseStop )
+        for ( auto numPolygon = first; numPolygon < last; ++numPolygon )
         {
-            return;
-        }
-        size_t numLine = delta + numPolygon;
-
-        const std::string_view line( &buf[splitLines[numLine]], splitLines[numLine + 1] - splitLines[numLine] );
-        auto result = parsePolygon( line, &flatPolygonIndices[faces.vec_[numPolygon].firstVertex], nullptr );
-
-        if ( !result.has_value() )
-        {
-            forseStop = true;
+            if ( !parsePolygon( getLine( buf.data(), splitLines, delta + numPolygon ),
+                &flatPolygonIndices[faces.vec_[numPolygon].firstVertex], nullptr ) )
+                return unexpected( std::string( "Error when reading polygon topology" ) );
         }
+        return {};
     }, subprogress( settings.callback, 0.4f, 0.7f ) );
-
-    if ( forseStop )
-    {
-        return unexpected( std::string( "Error when reading polygon topology" ) );
-    }
-    if ( !keepGoing )
-    {
-        return unexpectedOperationCanceled();
-    }
+    if ( !parseRes )
+        return unexpected( std::move( parseRes.error() ) );
 
     auto res = Mesh::fromFaceSoup( std::move( pointsBlocks ), flatPolygonIndices, faces,
         { .skippedFaceCount = settings.skippedFaceCount }, subprogress( settings.callback, 0.7f, 1.0f )  );
@@ -330,11 +417,29 @@ Expected<Mesh> fromObj( std::istream& in, const MeshLoadSettings& settings /*= {
 
 Expected<MR::Mesh> fromAnyStl( const std::filesystem::path& file, const MeshLoadSettings& settings /*= {}*/ )
 {
+    MappedFile mapped;
+    if ( !mapped.open( file ) )
+    {
+        std::ifstream in( file, std::ifstream::binary );
+        if ( !in )
+            return unexpected( std::string( "Cannot open file for reading " ) + utf8string( file ) );
+
+        return addFileNameInError( fromAnyStl( in, settings ), file );
+    }
+
+    auto resBin = fromBinaryStl( mapped.data(), mapped.size(), settings );
+    if ( resBin.has_value() || resBin.error() == stringOperationCanceled() )
+        return addFileNameInError( std::move( resBin ), file );
+    mapped.close();
+
+    // not a binary STL, read it as ASCII one
     std::ifstream in( file, std::ifstream::binary );
     if ( !in )
         return unexpected( std::string( "Cannot open file for reading " ) + utf8string( file ) );
-
-    return addFileNameInError( fromAnyStl( in, settings ), file );
+    auto resAsc = fromASCIIStl( in, settings );
+    if ( !resAsc.has_value() )
+        resAsc = unexpected( resBin.error() + '\n' + resAsc.error() );
+    return addFileNameInError( std::move( resAsc ), file );
 }
 
 Expected<MR::Mesh> fromAnyStl( std::istream& in, const MeshLoadSettings& settings /*= {}*/ )
@@ -353,6 +458,11 @@ Expected<MR::Mesh> fromAnyStl( std::istream& in, const MeshLoadSettings& setting
 
 Expected<Mesh> fromBinaryStl( const std::filesystem::path & file, const MeshLoadSettings& settings /*= {}*/ )
 {
+    MappedFile mapped;
+    if ( mapped.open( file ) )
+        return addFileNameInError( fromBinaryStl( mapped.data(), mapped.size(), settings ), file );
+
+    // the file cannot be mapped (e.g. it is not a regular file), read it as a stream
     std::ifstream in( file, std::ifstream::binary );
     if ( !in )
         return unexpected( std::string( "Cannot open file for reading " ) + utf8string( file ) );
@@ -379,16 +489,6 @@ Expected<Mesh> fromBinaryStl( std::istream& in, const MeshLoadSettings& settings
     MeshBuilder::VertexIdentifier vi;
     vi.reserve( numTris );
 
-    #pragma pack(push, 1)
-    struct StlTriangle
-    {
-        Vector3f normal;
-        Vector3f vert[3];
-        std::uint16_t attr;
-    };
-    #pragma pack(pop)
-    static_assert( sizeof( StlTriangle ) == 50, "check your padding" );
-
     const auto itemsInBuffer = std::min( numTris, 32768u );
     std::vector<StlTriangle> buffer( itemsInBuffer ), nextBuffer( itemsInBuffer );
     std::vector<Triangle3f> chunk( itemsInBuffer );
@@ -445,17 +545,7 @@ Expected<Mesh> fromBinaryStl( std::istream& in, const MeshLoadSettings& settings
 //         "load_factor = " << hmap.load_factor() << "\n"
 //         "max_load_factor = " << hmap.max_load_factor() << "\n";
 
-    auto t = vi.takeTriangulation();
-    std::vector<MeshBuilder::VertDuplication> dups;
-    std::vector<MeshBuilder::VertDuplication>* dupsPtr = nullptr;
-    if ( settings.duplicatedVertexCount )
-        dupsPtr = &dups;
-    const auto res = Mesh::fromTrianglesDuplicatingNonManifoldVertices( vi.takePoints(), t, dupsPtr, { .skippedFaceCount = settings.skippedFaceCount } );
-    if ( settings.duplicatedVertexCount )
-        *settings.duplicatedVertexCount = int( dups.size() );
-    if ( !reportProgress( settings.callback , 1.0f ) )
-        return unexpectedOperationCanceled();
-    return res;
+    return fromIdentifiedTriangles( vi, settings );
 }
 
 Expected<Mesh> fromASCIIStl( const std::filesystem::path& file, const MeshLoadSettings& settings /*= {}*/ )
@@ -471,81 +561,81 @@ Expected<Mesh> fromASCIIStl( std::istream& in, const MeshLoadSettings& settings
 {
     MR_TIMER;
 
-    using HMap = ParallelHashMap<Vector3f, VertId>;
-    HMap hmap;
-    VertCoords points;
-    Triangulation t;
-
-    std::string line;
-    std::string prefix;
-    Vector3f point;
-    ThreeVertIds currTri;
-    int triPos = 0;
-    bool solidFound = false;
+    auto buf = readCharBuffer( in );
+    if ( !buf )
+        return unexpected( std::move( buf.error() ) );
+    if ( !reportProgress( settings.callback, 0.1f ) )
+        return unexpectedOperationCanceled();
 
-    const auto posStart = in.tellg();
-    const auto streamSize = getStreamSize( in );
+    const auto newlines = splitByLines( buf->data(), buf->size() );
+    const auto numLines = newlines.size() - 1;
 
-    for ( int i = 0; std::getline( in, line ); ++i )
+    const auto trimLeft = [] ( std::string_view line )
     {
-        std::istringstream iss( line );
-        if ( !( iss >> prefix ) )
-            break;
-
-        if ( !solidFound )
-        {
-            if ( prefix == "solid" )
-                solidFound = true;
-            else
-                break;
-        }
+        const auto pos = line.find_first_not_of( " \t" );
+        return pos == std::string_view::npos ? std::string_view{} : line.substr( pos );
+    };
 
-        if ( prefix == "outer" )
-        {
-            triPos = 0;
+    bool solidFound = false;
+    for ( size_t i = 0; i < numLines; ++i )
+    {
+        const auto line = trimRight( trimLeft( getLine( buf->data(), newlines, i ) ) );
+        if ( line.empty() )
             continue;
-        }
-        if ( prefix == "vertex" )
-        {
-            double x, y, z; // double is used to correctly open coordinates like 1e-55 which are under of float-precision
-            if ( !( iss >> x >> y >> z ) )
-                break;
-            point = Vector3f{ Vector3d{ x, y, z } };
+        solidFound = line.starts_with( "solid" );
+        break;
+    }
+    if ( !solidFound )
+        return unexpected( std::string( "Failed to find 'solid' prefix in ascii STL" ) );
 
-            VertId& id = hmap[point];
-            if ( !id.valid() )
-            {
-                id = VertId( points.size() );
-                points.push_back( point );
-            }
-            currTri[triPos] = id;
-            ++triPos;
-            continue;
-        }
-        if ( prefix == "endloop" )
+    // the coordinates of vertices are parsed in parallel by chunks of lines, and each three consecutive vertices make a triangle
+    std::vector<std::vector<Vector3f>> chunkVerts( numParseChunks( numLines ) );
+    auto parseRes = parseLinesByChunks( numLines, [&] ( size_t chunk, size_t firstLine, size_t lastLine ) -> Expected<void>
+    {
+        auto & verts = chunkVerts[chunk];
+        for ( auto i = firstLine; i < lastLine; ++i )
         {
-            t.push_back( currTri );
-            continue;
+            const auto line = trimLeft( getLine( buf->data(), newlines, i ) );
+            if ( !line.starts_with( "vertex" ) )
+                continue;
+            Vector3d p; // double is used to correctly open coordinates like 1e-55 which are under of float-precision
+            if ( !parseTextCoordinate( line.substr( 6 ), p ) )
+                return unexpected( "Failed to parse vertex in ascii STL: " + std::string( trimRight( line ) ) );
+            verts.emplace_back( p );
         }
-        if ( settings.callback && !( i & 0x3FF ) )
+        return {};
+    }, subprogress( settings.callback, 0.1f, 0.4f ) );
+    if ( !parseRes )
+        return unexpected( std::move( parseRes.error() ) );
+
+    std::vector<size_t> chunkFirstVert( chunkVerts.size() + 1, 0 );
+    for ( size_t c = 0; c < chunkVerts.size(); ++c )
+        chunkFirstVert[c + 1] = chunkFirstVert[c] + chunkVerts[c].size();
+    const auto numVerts = chunkFirstVert.back();
+    if ( numVerts % 3 != 0 )
+        return unexpected( std::string( "The number of vertices in ascii STL is not a multiple of 3" ) );
+
+    std::vector<Triangle3f> tris( numVerts / 3 );
+    ParallelFor( size_t( 0 ), chunkVerts.size(), [&] ( size_t c )
+    {
+        auto v = chunkFirstVert[c];
+        for ( const auto & p : chunkVerts[c] )
         {
-            const float progress = float( in.tellg() - posStart ) / float( streamSize );
-            if ( !settings.callback( progress ) )
-                return unexpectedOperationCanceled();
+            tris[v / 3][v % 3] = p;
+            ++v;
         }
-    }
+        chunkVerts[c] = {};
+    } );
+    if ( !reportProgress( settings.callback, 0.45f ) )
+        return unexpectedOperationCanceled();
 
-    if ( !solidFound )
-        return unexpected( std::string( "Failed to find 'solid' prefix in ascii STL" ) );
+    MeshBuilder::VertexIdentifier vi;
+    vi.reserve( tris.size() );
+    vi.addTriangles( tris );
+    if ( !reportProgress( settings.callback, 0.5f ) )
+        return unexpectedOperationCanceled();
 
-    std::vector<MeshBuilder::VertDuplication> dups;
-    std::vector<MeshBuilder::VertDuplication>* dupsPtr = nullptr;
-    if ( settings.duplicatedVertexCount )
-        dupsPtr = &dups;
-    const auto res = Mesh::fromTrianglesDuplicatingNonManifoldVertices( std::move( points ), t, dupsPtr, { .skippedFaceCount = settings.skippedFaceCount } );
-    if ( settings.duplicatedVertexCount )
-        *settings.duplicatedVertexCount = int( dups.size() );
-    return res;
+    return fromIdentifiedTriangles( vi, settings );
 }
 
 Expected<Mesh> fromPly( const std::filesystem::path& file, const MeshLoadSettings& settings /*= {}*/ )
@@ -791,6 +881,58 @@ Expected<Mesh> fromAnySupportedFormat( std::istream& in, const std::string& exte
 MeshLoaderAdder __meshLoaderAdder( NamedMeshLoader{IOFilter( "MrMesh (.mrmesh)", "*.mrmesh" ),MeshLoader{static_cast<Expected<MR::Mesh>(*)(const std::filesystem::path&,VertColors*)>(fromMrmesh)}} );
 */
 
+TEST( MRMesh, LoadMappedFiles )
+{
+    UniqueTemporaryFolder folder( {} );
+    const auto torus = makeTorus( 1.0f, 0.3f, 32, 16 );
+
+    const auto mrmeshPath = folder / "torus.mrmesh";
+    ASSERT_TRUE( MeshSave::toMrmesh( torus, mrmeshPath ).has_value() );
+    auto mrmesh = fromMrmesh( mrmeshPath );
+    ASSERT_TRUE( mrmesh.has_value() );
+    EXPECT_EQ( mrmesh->topology, torus.topology );
+    EXPECT_EQ( mrmesh->points, torus.points );
+
+    const auto stlPath = folder / "torus.stl";
+    ASSERT_TRUE( MeshSave::toBinaryStl( torus, stlPath ).has_value() );
+    auto stl = fromBinaryStl( stlPath );
+    ASSERT_TRUE( stl.has_value() );
+    EXPECT_EQ( stl->topology.numValidFaces(), torus.topology.numValidFaces() );
+    EXPECT_EQ( stl->topology.numValidVerts(), torus.topology.numValidVerts() );
+    auto anyStl = fromAnyStl( stlPath );
+    ASSERT_TRUE( anyStl.has_value() );
+    EXPECT_EQ( anyStl->topology.numValidFaces(), torus.topology.numValidFaces() );
+
+    // truncated files are rejected
+    std::filesystem::resize_file( stlPath, std::filesystem::file_size( stlPath ) - 10 );
+    EXPECT_FALSE( fromBinaryStl( stlPath ).has_value() );
+    std::filesystem::resize_file( mrmeshPath, std::filesystem::file_size( mrmeshPath ) - 10 );
+    EXPECT_FALSE( fromMrmesh( mrmeshPath ).has_value() );
+}
+
+TEST( MRMesh, LoadTextFormatsByChunks )
+{
+    // the torus has more lines than one chunk of parsing
+    const auto torus = makeTorus( 1.0f, 0.3f, 64, 32 );
+
+    std::stringstream stlStream;
+    ASSERT_TRUE( MeshSave::toAsciiStl( torus, stlStream ).has_value() );
+    auto stl = fromASCIIStl( stlStream );
+    ASSERT_TRUE( stl.has_value() );
+    EXPECT_EQ( stl->topology.numValidFaces(), torus.topology.numValidFaces() );
+    EXPECT_EQ( stl->topology.numValidVerts(), torus.topology.numValidVerts() );
+
+    std::stringstream offStream;
+    ASSERT_TRUE( MeshSave::toOff( torus, offStream ).has_value() );
+    auto off = fromOff( offStream );
+    ASSERT_TRUE( off.has_value() );
+    EXPECT_EQ( off->topology.numValidFaces(), torus.topology.numValidFaces() );
+    EXPECT_EQ( off->topology.numValidVerts(), torus.topology.numValidVerts() );
+
+    std::stringstream badStream( "solid bad\n facet normal 0 0 1\n  outer loop\n   vertex 0 0 x\n" );
+    EXPECT_FALSE( fromASCIIStl( badStream ).has_value() );
+}
+
 MR_ADD_MESH_LOADER_WITH_PRIORITY( IOFilter( "MeshInspector (.mrmesh)", "*.mrmesh" ), fromMrmesh, -1 )
 MR_ADD_MESH_LOADER( IOFilter( "Stereolithography (.stl)", "*.stl" ), fromAnyStl )
 MR_ADD_MESH_LOADER( IOFilter( "Object format file (.off)", "*.off" ), fromOff )
@@ -1,5 +1,6 @@
 #include "MRMeshProject.h"
 #include "MRAABBTree.h"
+#include "MRAABBTreeWide.h"
 #include "MRMesh.h"
 #include "MRClosestPointInTriangle.h"
 #include "MRBall.h"
@@ -10,6 +11,147 @@
 namespace MR
 {
 
+namespace
+{
+
+/// computes the closest point to pt on given face of the mesh, optionally transformed by xf
+MeshProjectionResult projectOnFace( const Vector3f & pt, const Mesh & mesh, FaceId face, const AffineXf3f * xf )
+{
+    Vector3f a, b, c;
+    mesh.getTriPoints( face, a, b, c );
+    if ( xf )
+    {
+        a = (*xf)( a );
+        b = (*xf)( b );
+        c = (*xf)( c );
+    }
+
+    // compute the closest point in double-precision, because float might be not enough
+    const auto [projD, baryD] = closestPointInTriangle( Vector3d( pt ), Vector3d( a ), Vector3d( b ), Vector3d( c ) );
+    const Vector3f proj( projD );
+    return
+    {
+        .proj = PointOnFace{ face, proj },
+        .mtp = MeshTriPoint{ mesh.topology.edgeWithLeft( face ), TriPointf( baryD ) },
+        .distSq = ( proj - pt ).lengthSq()
+    };
+}
+
+} //anonymous namespace
+
+MeshProjectionResult findProjectionWide( const Vector3f & pt, const MeshPart & mp, const AABBTreeWide & tree, float upDistLimitSq, float loDistLimitSq,
+    const FacePredicate & validFaces, const std::function<bool(const MeshProjectionResult&)> & validProjections )
+{
+    MeshProjectionResult res;
+    res.distSq = upDistLimitSq;
+    if ( tree.nodes().empty() || !( tree.getBoundingBox().getDistanceSq( pt ) < res.distSq ) )
+        return res;
+
+    struct SubTask
+    {
+        NoInitNodeId n;
+        float distSq;
+    };
+    // each level of the tree adds at most Width-1 tasks
+    InplaceStack<SubTask, 32 * ( AABBTreeWideNode::Width - 1 ) + 1> subtasks;
+    subtasks.push( { tree.rootNodeId(), 0.0f } );
+
+    while ( !subtasks.empty() )
+    {
+        const auto s = subtasks.top();
+        subtasks.pop();
+        if ( s.distSq >= res.distSq )
+            continue;
+
+        const auto & node = tree[s.n];
+        float distSq[AABBTreeWideNode::Width];
+        childBoxesDistanceSq( node, pt, distSq );
+
+        SubTask inner[AABBTreeWideNode::Width];
+        int numInner = 0;
+        for ( int i = 0; i < AABBTreeWideNode::Width; ++i )
+        {
+            if ( !node.hasChild( i ) || !( distSq[i] < res.distSq ) )
+                continue;
+            if ( !node.leafChild( i ) )
+            {
+                inner[numInner++] = { node.childNode( i ), distSq[i] };
+                continue;
+            }
+            const auto face = node.childFace( i );
+            if ( validFaces && !validFaces( face ) )
+                continue;
+            if ( mp.region && !mp.region->test( face ) )
+                continue;
+            const auto candidate = projectOnFace( pt, mp.mesh, face, nullptr );
+            if ( validProjections && !validProjections( candidate ) )
+                continue;
+            if ( candidate.distSq < res.distSq )
+            {
+                res = candidate;
+                if ( res.distSq <= loDistLimitSq )
+                    return res;
+            }
+        }
+
+        // add tasks with smaller distance last to descend there first
+        std::sort( inner, inner + numInner, []( const SubTask & a, const SubTask & b ) { return a.distSq > b.distSq; } );
+        for ( int i = 0; i < numInner; ++i )
+            subtasks.push( inner[i] );
+    }
+
+    return res;
+}
+
+void findBoxedTrisInBallWide( const MeshPart & mp, const AABBTreeWide & tree, Ball3f ball, const FoundBoxedTriCallback& foundCallback )
+{
+    if ( tree.nodes().empty() || !( tree.getBoundingBox().getDistanceSq( ball.center ) < ball.radiusSq ) )
+        return;
+
+    struct SubTask
+    {
+        NoInitNodeId n;
+        float distSq;
+    };
+    InplaceStack<SubTask, 32 * ( AABBTreeWideNode::Width - 1 ) + 1> subtasks;
+    subtasks.push( { tree.rootNodeId(), 0.0f } );
+
+    while ( !subtasks.empty() )
+    {
+        const auto s = subtasks.top();
+        subtasks.pop();
+        if ( !( s.distSq < ball.radiusSq ) )
+            continue;
+
+        const auto & node = tree[s.n];
+        float distSq[AABBTreeWideNode::Width];
+        childBoxesDistanceSq( node, ball.center, distSq );
+
+        SubTask inner[AABBTreeWideNode::Width];
+        int numInner = 0;
+        for ( int i = 0; i < AABBTreeWideNode::Width; ++i )
+        {
+            if ( !node.hasChild( i ) || !( distSq[i] < ball.radiusSq ) )
+                continue;
+            if ( !node.leafChild( i ) )
+            {
+                inner[numInner++] = { node.childNode( i ), distSq[i] };
+                continue;
+            }
+            const auto face = node.childFace( i );
+            if ( mp.region && !mp.region->test( face ) )
+                continue;
+            if ( foundCallback( face, ball ) == Processing::Stop )
+                return;
+        }
+
+        /// first go in the node located closer to ball's center (in case the ball will shrink and the other nodes will be away)
+        std::sort( inner, inner + numInner, []( const SubTask & a, const SubTask & b ) { return a.distSq > b.distSq; } );
+        for ( int i = 0; i < numInner; ++i )
+            subtasks.push( inner[i] );
+    }
+}
+
 MeshProjectionResult findProjectionSubtree( const Vector3f & pt, const MeshPart & mp, const AABBTree & tree, float upDistLimitSq, const AffineXf3f * xf, float loDistLimitSq,
     const FacePredicate & validFaces, const std::function<bool(const MeshProjectionResult&)> & validProjections )
 {
@@ -55,24 +197,7 @@ MeshProjectionResult findProjectionSubtree( const Vector3f & pt, const MeshPart
                 continue;
             if ( mp.region && !mp.region->test( face ) )
                 continue;
-            Vector3f a, b, c;
-            mp.mesh.getTriPoints( face, a, b, c );
-            if ( xf )
-            {
-                a = (*xf)( a );
-                b = (*xf)( b );
-                c = (*xf)( c );
-            }
-            
-            // compute the closest point in double-precision, because float might be not enough
-            const auto [projD, baryD] = closestPointInTriangle( Vector3d( pt ), Vector3d( a ), Vector3d( b ), Vector3d( c ) );
-            const Vector3f proj( projD );
-            const MeshProjectionResult candidate
-            {
-                .proj = PointOnFace{ face, proj },
-                .mtp = MeshTriPoint{ mp.mesh.topology.edgeWithLeft( face ), TriPointf( baryD ) },
-                .distSq = ( proj - pt ).lengthSq()
-            };
+            const auto candidate = projectOnFace( pt, mp.mesh, face, xf );
             if ( validProjections && !validProjections( candidate ) )
                 continue;
             if ( candidate.distSq < res.distSq )
@@ -186,18 +311,20 @@ void findTrisInBall( const MeshPart & mp, const Ball3f& ball, const FoundTriCall
     {
         if ( validFaces && !validFaces( face ) )
             return Processing::Continue;
-        Vector3f a, b, c;
-        mp.mesh.getTriPoints( face, a, b, c );
-            
-        // compute the closest point in double-precision, because float might be not enough
-        const auto [projD, baryD] = closestPointInTriangle( Vector3d( ball.center ), Vector3d( a ), Vector3d( b ), Vector3d( c ) );
-        const Vector3f proj( projD );
-        const MeshProjectionResult candidate
-        {
-            .proj = PointOnFace{ face, proj },
-            .mtp = MeshTriPoint{ mp.mesh.topology.edgeWithLeft( face ), TriPointf( baryD ) },
-            .distSq = ( proj - ball.center ).lengthSq()
-        };
+        const auto candidate = projectOnFace( ball.center, mp.mesh, face, nullptr );
+        if ( candidate.distSq < ball.radiusSq )
+            return foundCallback( candidate, ball );
+        return Processing::Continue;
+    } );
+}
+
+void findTrisInBallWide( const MeshPart & mp, const AABBTreeWide & tree, const Ball3f& ball, const FoundTriCallback& foundCallback, const FacePredicate & validFaces )
+{
+    findBoxedTrisInBallWide( mp, tree, ball, [&]( FaceId face, Ball3f & ball )
+    {
+        if ( validFaces && !validFaces( face ) )
+            return Processing::Continue;
+        const auto candidate = projectOnFace( ball.center, mp.mesh, face, nullptr );
         if ( candidate.distSq < ball.radiusSq )
             return foundCallback( candidate, ball );
         return Processing::Continue;
@@ -77,6 +77,21 @@ MRMESH_API MeshProjectionTransforms createProjectionTransforms( AffineXf3f& stor
     const FacePredicate & validFaces = {},
     const std::function<bool(const MeshProjectionResult&)> & validProjections = {} );
 
+/**
+ * \brief computes the closest point on mesh (or its region) to given point, traversing explicitly given wide tree (e.g. Mesh::getAABBTreeWide()),
+ * which is faster for large meshes; the result is the same as from \ref findProjection without transformation
+ * \param upDistLimitSq upper limit on the distance in question, if the real distance is larger than the function exits returning upDistLimitSq and no valid point
+ * \param loDistLimitSq low limit on the distance in question, if a point is found within this distance then it is immediately returned without searching for a closer one
+ * \param validFaces if provided then only faces from there will be considered as projections
+ * \param validProjections if provided then only projections passed this test can be returned
+ */
+[[nodiscard]] MRMESH_API MeshProjectionResult findProjectionWide( const Vector3f & pt,
+    const MeshPart & mp, const AABBTreeWide & tree,
+    float upDistLimitSq = FLT_MAX,
+    float loDistLimitSq = 0,
+    const FacePredicate & validFaces = {},
+    const std::function<bool(const MeshProjectionResult&)> & validProjections = {} );
+
 /// this callback is invoked on every triangle with bounding box at least partially in the ball (the triangle itself can be fully out of ball),
 /// and allows changing (shrinking only) the ball
 using FoundBoxedTriCallback = std::function<Processing( FaceId found, Ball3f & ball )>;
@@ -86,6 +101,9 @@ using FoundBoxedTriCallback = std::function<Processing( FaceId found, Ball3f & b
 /// the ball during enumeration can shrink (new ball is always within the previous one) but never expand
 MRMESH_API void findBoxedTrisInBall( const MeshPart & mp, Ball3f ball, const FoundBoxedTriCallback& foundCallback );
 
+/// same as \ref findBoxedTrisInBall, but traverses explicitly given wide tree (e.g. Mesh::getAABBTreeWide())
+MRMESH_API void findBoxedTrisInBallWide( const MeshPart & mp, const AABBTreeWide & tree, Ball3f ball, const FoundBoxedTriCallback& foundCallback );
+
 /// this callback is invoked on every triangle at least partially in the ball, and allows changing (shrinking only) the ball
 using FoundTriCallback = std::function<Processing( const MeshProjectionResult & found, Ball3f & ball )>;
 
@@ -93,6 +111,10 @@ using FoundTriCallback = std::function<Processing( const MeshProjectionResult &
 /// the ball during enumeration can shrink (new ball is always within the previous one) but never expand
 MRMESH_API void findTrisInBall( const MeshPart & mp, const Ball3f& ball, const FoundTriCallback& foundCallback, const FacePredicate & validFaces = {} );
 
+/// same as \ref findTrisInBall, but traverses explicitly given wide tree (e.g. Mesh::getAABBTreeWide())
+MRMESH_API void findTrisInBallWide( const MeshPart & mp, const AABBTreeWide & tree, const Ball3f& ball, const FoundTriCallback& foundCallback,
+    const FacePredicate & validFaces = {} );
+
 struct SignedDistanceToMeshResult
 {
     /// the closest point on mesh
@@ -23,8 +23,12 @@ namespace MR
 
 bool relax( Mesh& mesh, const MeshRelaxParams& params, const ProgressCallback& cb )
 {
-    mesh.invalidateCaches();
-    return relaxT( mesh.topology, mesh.points, params, cb );
+    if ( !params.region )
+        mesh.invalidateCaches();
+    const bool res = relaxT( mesh.topology, mesh.points, params, cb );
+    if ( params.region )
+        mesh.updateCaches( *params.region ); // only the vertices from the region could move
+    return res;
 }
 
 bool relax( const MeshTopology& topology, VertCoords& points, const MeshRelaxParams& params, const ProgressCallback& cb )
@@ -192,9 +196,14 @@ bool relaxKeepVolume( const MeshTopology& topology, VertCoords& points, const Me
 
 bool relaxKeepVolume( Mesh& mesh, const MeshRelaxParams& params, const ProgressCallback& cb )
 {
-    if ( params.iterations > 0 )
+    if ( params.iterations <= 0 )
+        return true;
+    if ( !params.region )
         mesh.invalidateCaches();
-    return relaxKeepVolume( mesh.topology, mesh.points, params, cb );
+    const bool res = relaxKeepVolume( mesh.topology, mesh.points, params, cb );
+    if ( params.region )
+        mesh.updateCaches( *params.region ); // only the vertices from the region could move
+    return res;
 }
 
 bool relaxApprox( const MeshTopology& topology, VertCoords& points, const MeshApproxRelaxParams& params, const ProgressCallback& cb )
@@ -278,9 +287,14 @@ bool relaxApprox( const MeshTopology& topology, VertCoords& points, const MeshAp
 
 bool relaxApprox( Mesh& mesh, const MeshApproxRelaxParams& params, const ProgressCallback& cb )
 {
-    if ( params.iterations > 0 )
+    if ( params.iterations <= 0 )
+        return true;
+    if ( !params.region )
         mesh.invalidateCaches();
-    return relaxApprox( mesh.topology, mesh.points, params, cb );
+    const bool res = relaxApprox( mesh.topology, mesh.points, params, cb );
+    if ( params.region )
+        mesh.updateCaches( *params.region ); // only the vertices from the region could move
+    return res;
 }
 
 void removeSpikes( const MeshTopology& topology, VertCoords& points, int maxIterations, float minSumAngle, const VertBitSet * region )
@@ -1,6 +1,7 @@
 #include "MRMeshSave.h"
 #include "MRIOFormatsRegistry.h"
 #include "MRMesh.h"
+#include "MRMeshBinaryFormats.h"
 #include "MRTimer.h"
 #include "MRColor.h"
 #include "MRStringConvert.h"
@@ -10,6 +11,8 @@
 #include "MRMeshTexture.h"
 #include "MRImageSave.h"
 
+#include <iterator>
+
 namespace MR
 {
 
@@ -144,77 +147,77 @@ Expected<void> toObj( const Mesh & mesh, std::ostream & out, const SaveSettings
         out << fmt::format( "mtllib {}.mtl\n", settings.materialName );
 
     const VertRenumber vertRenumber( mesh.topology.getValidVerts(), settings.saveValidOnly );
-    const int numPoints = vertRenumber.sizeVerts();
     const VertId lastVertId = mesh.topology.lastValidVert();
 
-    int numSaved = 0;
-    auto sb = subprogress( settings.progress, 0.0f, settings.uvMap ? 0.35f : 0.5f );
-    for ( VertId i{ 0 }; i <= lastVertId; ++i )
+    // the lines are formatted directly in per-chunk buffers by parallel threads
+    const size_t numVertIds = size_t( lastVertId + 1 );
+    if ( !writeInParallel( out, numVertIds, [&] ( size_t begin, size_t end, std::string& buf )
     {
-        if ( settings.saveValidOnly && !mesh.topology.hasVert( i ) )
-            continue;
-
-        auto saveVertex = [&]( auto && p )
+        auto it = std::back_inserter( buf );
+        for ( VertId i( begin ); i < end; ++i )
         {
-            if ( settings.colors )
+            if ( settings.saveValidOnly && !mesh.topology.hasVert( i ) )
+                continue;
+
+            auto saveVertex = [&]( auto && p )
             {
-                const auto c = (Vector4f)( *settings.colors )[i];
-                out << fmt::format( "v {} {} {} {} {} {}\n", p.x, p.y, p.z, c[0], c[1], c[2] );
-            }
+                if ( settings.colors )
+                {
+                    const auto c = (Vector4f)( *settings.colors )[i];
+                    fmt::format_to( it, "v {} {} {} {} {} {}\n", p.x, p.y, p.z, c[0], c[1], c[2] );
+                }
+                else
+                {
+                    fmt::format_to( it, "v {} {} {}\n", p.x, p.y, p.z );
+                }
+            };
+            if ( settings.xf )
+                saveVertex( applyDouble( settings.xf, mesh.points[i] ) );
             else
-            {
-                out << fmt::format( "v {} {} {}\n", p.x, p.y, p.z );
-            }
-        };
-        if ( settings.xf )
-            saveVertex( applyDouble( settings.xf, mesh.points[i] ) );
-        else
-            saveVertex( mesh.points[i] );
-        ++numSaved;
-        if ( settings.progress && !( numSaved & 0x3FF ) && !sb( float( numSaved ) / numPoints ) )
-            return unexpectedOperationCanceled();
-    }
+                saveVertex( mesh.points[i] );
+        }
+    }, subprogress( settings.progress, 0.0f, settings.uvMap ? 0.35f : 0.5f ) ) )
+        return unexpectedOperationCanceled();
 
     if ( settings.uvMap )
     {
-        numSaved = 0;
-        sb = subprogress( settings.progress, 0.35f, 0.7f );
-        for ( VertId i{ 0 }; i <= lastVertId; ++i )
+        if ( !writeInParallel( out, numVertIds, [&] ( size_t begin, size_t end, std::string& buf )
         {
-            if ( settings.saveValidOnly && !mesh.topology.hasVert( i ) )
-                continue;
-            const auto& uv = ( *settings.uvMap )[i];
-            out << fmt::format( "vt {} {}\n", uv.x, uv.y );
-            ++numSaved;
-            if ( settings.progress && !( numSaved & 0x3FF ) && !sb( float( numSaved ) / numPoints ) )
-                return unexpectedOperationCanceled();
-        }
+            for ( VertId i( begin ); i < end; ++i )
+            {
+                if ( settings.saveValidOnly && !mesh.topology.hasVert( i ) )
+                    continue;
+                const auto& uv = ( *settings.uvMap )[i];
+                fmt::format_to( std::back_inserter( buf ), "vt {} {}\n", uv.x, uv.y );
+            }
+        }, subprogress( settings.progress, 0.35f, 0.7f ) ) )
+            return unexpectedOperationCanceled();
         out << "usemtl Texture\n";
     }
 
-    sb = subprogress( settings.progress, settings.uvMap ? 0.7f : 0.5f, 1.0f );
-    const float facesNum = float( mesh.topology.edgePerFace().size() );
-    size_t faceIndex = 0;
-    for ( const auto& e : mesh.topology.edgePerFace() )
+    if ( !writeInParallel( out, mesh.topology.edgePerFace().size(), [&] ( size_t begin, size_t end, std::string& buf )
     {
-        ++faceIndex;
-        if ( settings.progress && !( faceIndex & 0x3FF ) && !sb( faceIndex / facesNum ) )
-            return unexpectedOperationCanceled();
-        if ( !e.valid() )
-            continue;
+        auto it = std::back_inserter( buf );
+        for ( FaceId f( begin ); f < end; ++f )
+        {
+            const auto e = mesh.topology.edgePerFace()[f];
+            if ( !e.valid() )
+                continue;
 
-        VertId a, b, c;
-        mesh.topology.getLeftTriVerts( e, a, b, c );
-        Vector3i values( vertRenumber( a ) + firstVertId, vertRenumber( b ) + firstVertId, vertRenumber( c ) + firstVertId );
-        if ( settings.uvMap )
-            out << fmt::format( "f {}/{} {}/{} {}/{}\n",
-                values.x, values.x,
-                values.y, values.y,
-                values.z, values.z );
-        else
-            out << fmt::format( "f {} {} {}\n",
-                values.x, values.y, values.z );
-    }
+            VertId a, b, c;
+            mesh.topology.getLeftTriVerts( e, a, b, c );
+            Vector3i values( vertRenumber( a ) + firstVertId, vertRenumber( b ) + firstVertId, vertRenumber( c ) + firstVertId );
+            if ( settings.uvMap )
+                fmt::format_to( it, "f {}/{} {}/{} {}/{}\n",
+                    values.x, values.x,
+                    values.y, values.y,
+                    values.z, values.z );
+            else
+                fmt::format_to( it, "f {} {} {}\n",
+                    values.x, values.y, values.z );
+        }
+    }, subprogress( settings.progress, settings.uvMap ? 0.7f : 0.5f, 1.0f ) ) )
+        return unexpectedOperationCanceled();
 
     if ( !out )
         return unexpected( std::string( "Error saving in OBJ-format" ) );
@@ -272,33 +275,29 @@ Expected<void> toBinaryStl( const Mesh & mesh, std::ostream & out, const SaveSet
     auto numTris = (std::uint32_t)notDegenTris.count();
     out.write( ( const char* )&numTris, 4 );
 
-    const float trisNum = float( notDegenTris.count() );
-    int trisIndex = 0;
-    for ( auto f : notDegenTris )
+    if ( !writeInParallel( out, notDegenTris.size(), [&] ( size_t begin, size_t end, std::string& buf )
     {
-        VertId a, b, c;
-        mesh.topology.getTriVerts( f, a, b, c );
-        assert( a.valid() && b.valid() && c.valid() );
-
-        // perform normal computation in double-precision to get exactly the same single-precision result on all platforms
-        const Vector3d ad = applyDouble( settings.xf, mesh.points[a] );
-        const Vector3d bd = applyDouble( settings.xf, mesh.points[b] );
-        const Vector3d cd = applyDouble( settings.xf, mesh.points[c] );
-        const Vector3f normal( cross( bd - ad, cd - ad ).normalized() );
-        const Vector3f ap( ad );
-        const Vector3f bp( bd );
-        const Vector3f cp( cd );
-
-        out.write( (const char*)&normal, 12 );
-        out.write( (const char*)&ap, 12 );
-        out.write( (const char*)&bp, 12 );
-        out.write( (const char*)&cp, 12 );
-        std::uint16_t attr{ 0 };
-        out.write( ( const char* )&attr, 2 );
-        if ( settings.progress && !( trisIndex & 0x3FF ) && !settings.progress( trisIndex / trisNum ) )
-            return unexpectedOperationCanceled();
-        ++trisIndex;
-    }
+        for ( FaceId f( begin ); f < end; ++f )
+        {
+            if ( !notDegenTris.test( f ) )
+                continue;
+            VertId a, b, c;
+            mesh.topology.getTriVerts( f, a, b, c );
+            assert( a.valid() && b.valid() && c.valid() );
+
+            // perform normal computation in double-precision to get exactly the same single-precision result on all platforms
+            const Vector3d ad = applyDouble( settings.xf, mesh.points[a] );
+            const Vector3d bd = applyDouble( settings.xf, mesh.points[b] );
+            const Vector3d cd = applyDouble( settings.xf, mesh.points[c] );
+            StlTriangle tri;
+            tri.normal = Vector3f( cross( bd - ad, cd - ad ).normalized() );
+            tri.vert[0] = Vector3f( ad );
+            tri.vert[1] = Vector3f( bd );
+            tri.vert[2] = Vector3f( cd );
+            buf.append( (const char*)&tri, sizeof( StlTriangle ) );
+        }
+    }, settings.progress ) )
+        return unexpectedOperationCanceled();
 
     if ( !out )
         return unexpected( std::string( "Error saving in binary STL-format" ) );
@@ -323,33 +322,35 @@ Expected<void> toAsciiStl( const Mesh& mesh, std::ostream& out, const SaveSettin
     static const char* solid_name = "MeshInspector.com";
     out << "solid " << solid_name << "\n";
     auto notDegenTris = getNotDegenTris( mesh );
-    const float trisNum = float( notDegenTris.count() );
-    int trisIndex = 0;
-    for ( auto f : notDegenTris )
+    if ( !writeInParallel( out, notDegenTris.size(), [&] ( size_t begin, size_t end, std::string& buf )
     {
-        VertId a, b, c;
-        mesh.topology.getTriVerts( f, a, b, c );
-        assert( a.valid() && b.valid() && c.valid() );
-        auto saveVertex = [&]( auto && ap, auto && bp, auto && cp )
+        auto it = std::back_inserter( buf );
+        for ( FaceId f( begin ); f < end; ++f )
         {
-            const auto normal = cross( bp - ap, cp - ap ).normalized();
-            out << "" << fmt::format( "facet normal {} {} {}\n", normal.x, normal.y, normal.z );
-            out << "outer loop\n";
-            for ( const auto & p : { ap, bp, cp } )
-                out << fmt::format( "vertex {} {} {}\n", p.x, p.y, p.z );
-        };
-        if ( settings.xf )
-            saveVertex( applyDouble( settings.xf, mesh.points[a] ),
-                        applyDouble( settings.xf, mesh.points[b] ),
-                        applyDouble( settings.xf, mesh.points[c] ) );
-        else
-            saveVertex( mesh.points[a], mesh.points[b], mesh.points[c] );
-        out << "endloop\n";
-        out << "endfacet\n";
-        if ( settings.progress && !( trisIndex & 0x3FF ) && !settings.progress( trisIndex / trisNum ) )
-            return unexpectedOperationCanceled();
-        ++trisIndex;
-    }
+            if ( !notDegenTris.test( f ) )
+                continue;
+            VertId a, b, c;
+            mesh.topology.getTriVerts( f, a, b, c );
+            assert( a.valid() && b.valid() && c.valid() );
+            auto saveVertex = [&]( auto && ap, auto && bp, auto && cp )
+            {
+                const auto normal = cross( bp - ap, cp - ap ).normalized();
+                fmt::format_to( it, "facet normal {} {} {}\n", normal.x, normal.y, normal.z );
+                buf += "outer loop\n";
+                for ( const auto & p : { ap, bp, cp } )
+                    fmt::format_to( it, "vertex {} {} {}\n", p.x, p.y, p.z );
+            };
+            if ( settings.xf )
+                saveVertex( applyDouble( settings.xf, mesh.points[a] ),
+                            applyDouble( settings.xf, mesh.points[b] ),
+                            applyDouble( settings.xf, mesh.points[c] ) );
+            else
+                saveVertex( mesh.points[a], mesh.points[b], mesh.points[c] );
+            buf += "endloop\n";
+            buf += "endfacet\n";
+        }
+    }, settings.progress ) )
+        return unexpectedOperationCanceled();
     out << "endsolid " << solid_name << "\n";
 
     if ( !out )
@@ -396,54 +397,45 @@ Expected<void> toPly( const Mesh & mesh, std::ostream & out, const SaveSettings
     static_assert( sizeof( PlyColor ) == 3, "check your padding" );
 
     // write vertices
-    int numSaved = 0;
-    for ( VertId i{ 0 }; i <= lastVertId; ++i )
+    if ( !writeInParallel( out, size_t( lastVertId + 1 ), [&] ( size_t begin, size_t end, std::string& buf )
     {
-        if ( settings.saveValidOnly && !mesh.topology.hasVert( i ) )
-            continue;
-        const Vector3f p = applyFloat( settings.xf, mesh.points[i] );
-        out.write( ( const char* )&p, 12 );
-        if ( settings.colors )
+        for ( VertId i( begin ); i < end; ++i )
         {
-            const auto c = ( *settings.colors )[i];
-            PlyColor pc{ .r = c.r, .g = c.g, .b = c.b };
-            out.write( ( const char* )&pc, 3 );
+            if ( settings.saveValidOnly && !mesh.topology.hasVert( i ) )
+                continue;
+            const Vector3f p = applyFloat( settings.xf, mesh.points[i] );
+            buf.append( ( const char* )&p, 12 );
+            if ( saveColors )
+            {
+                const auto c = ( *settings.colors )[i];
+                PlyColor pc{ .r = c.r, .g = c.g, .b = c.b };
+                buf.append( ( const char* )&pc, 3 );
+            }
         }
-        ++numSaved;
-        if ( settings.progress && !( numSaved & 0x3FF ) && !settings.progress( float( numSaved ) / numPoints * 0.5f ) )
-            return unexpectedOperationCanceled();
-    }
+    }, subprogress( settings.progress, 0.0f, 0.5f ) ) )
+        return unexpectedOperationCanceled();
 
     // write triangles
-    #pragma pack(push, 1)
-    struct PlyTriangle
+    if ( !writeInParallel( out, size_t( fLast + 1 ), [&] ( size_t begin, size_t end, std::string& buf )
     {
-        char cnt = 3;
-        int v[3];
-    };
-    #pragma pack(pop)
-    static_assert( sizeof( PlyTriangle ) == 13, "check your padding" );
-
-    PlyTriangle tri;
-    int savedFaces = 0;
-    for ( FaceId f{0}; f <= fLast; ++f )
-    {
-        if ( mesh.topology.hasFace( f ) )
+        PlyTriangle tri;
+        for ( FaceId f( begin ); f < end; ++f )
         {
-            VertId vs[3];
-            mesh.topology.getTriVerts( f, vs );
-            for ( int i = 0; i < 3; ++i )
-                tri.v[i] = vertRenumber( vs[i] );
+            if ( mesh.topology.hasFace( f ) )
+            {
+                VertId vs[3];
+                mesh.topology.getTriVerts( f, vs );
+                for ( int i = 0; i < 3; ++i )
+                    tri.v[i] = vertRenumber( vs[i] );
+            }
+            else if ( !settings.rearrangeTriangles )
+                tri.v[0] = tri.v[1] = tri.v[2] = 0;
+            else
+                continue;
+            buf.append( (const char *)&tri, sizeof( PlyTriangle ) );
         }
-        else if ( !settings.rearrangeTriangles )
-            tri.v[0] = tri.v[1] = tri.v[2] = 0;
-        else
-            continue;
-        out.write( (const char *)&tri, sizeof( PlyTriangle ) );
-        ++savedFaces;
-        if ( settings.progress && !( savedFaces & 0x3FF ) && !settings.progress( float( savedFaces ) / numSaveFaces * 0.5f + 0.5f ) )
-            return unexpectedOperationCanceled();
-    }
+    }, subprogress( settings.progress, 0.5f, 1.0f ) ) )
+        return unexpectedOperationCanceled();
 
     if ( !out )
         return unexpected( std::string( "Error saving in PLY-format" ) );
@@ -0,0 +1,182 @@
+#include "MRMeshStreamWriter.h"
+#include "MRProgressReadWrite.h"
+#include "MRMesh.h"
+#include "MRMeshBinaryFormats.h"
+#include "MRMeshLoad.h"
+#include "MRTorus.h"
+#include "MRTimer.h"
+#include "MRGTest.h"
+#include <climits>
+#include <cstdint>
+
+namespace MR
+{
+
+BinaryStlStreamWriter::BinaryStlStreamWriter( std::ostream& out ) : out_( out )
+{
+    headerPos_ = out_.tellp();
+    char header[80] = "MeshInspector.com";
+    out_.write( header, 80 );
+    const std::uint32_t numTris = 0; // will be rewritten in finish()
+    out_.write( ( const char* )&numTris, 4 );
+}
+
+Expected<void> BinaryStlStreamWriter::addPart( const std::vector<Vector3f>& points, const std::vector<ThreeVertIds>& tris )
+{
+    MR_TIMER;
+    points_.insert( points_.end(), points.begin(), points.end() );
+    auto getPoint = [&] ( VertId v ) -> const Vector3f&
+    {
+        assert( v >= firstPoint_ && v < firstPoint_ + points_.size() );
+        return points_[v - firstPoint_];
+    };
+
+    writeInParallel( out_, tris.size(), [&] ( size_t begin, size_t end, std::string& buf )
+    {
+        for ( size_t i = begin; i < end; ++i )
+        {
+            // perform normal computation in double-precision to get exactly the same single-precision result on all platforms
+            const Vector3d ad( getPoint( tris[i][0] ) );
+            const Vector3d bd( getPoint( tris[i][1] ) );
+            const Vector3d cd( getPoint( tris[i][2] ) );
+            StlTriangle tri;
+            tri.normal = Vector3f( cross( bd - ad, cd - ad ).normalized() );
+            for ( int j = 0; j < 3; ++j )
+                tri.vert[j] = getPoint( tris[i][j] );
+            buf.append( ( const char* )&tri, sizeof( StlTriangle ) );
+        }
+    } );
+    numTris_ += tris.size();
+
+    if ( !out_ )
+        return unexpected( std::string( "Error saving in binary STL-format" ) );
+    return {};
+}
+
+void BinaryStlStreamWriter::releasePoints( VertId upTo )
+{
+    if ( upTo <= firstPoint_ )
+        return;
+    const auto num = std::min( size_t( upTo - firstPoint_ ), points_.size() );
+    points_.erase( points_.begin(), points_.begin() + num );
+    firstPoint_ += int( num );
+}
+
+Expected<void> BinaryStlStreamWriter::finish()
+{
+    if ( numTris_ > UINT32_MAX )
+        return unexpected( std::string( "Too many triangles for binary STL-format" ) );
+    if ( headerPos_ == std::streampos( -1 ) )
+        return unexpected( std::string( "The stream does not support seeking to write the number of triangles" ) );
+
+    const auto endPos = out_.tellp();
+    out_.seekp( headerPos_ + std::streamoff( 80 ) );
+    const auto numTris = std::uint32_t( numTris_ );
+    out_.write( ( const char* )&numTris, 4 );
+    out_.seekp( endPos );
+
+    if ( !out_ )
+        return unexpected( std::string( "Error saving in binary STL-format" ) );
+    return {};
+}
+
+PlyStreamWriter::PlyStreamWriter( std::ostream& out ) : out_( out ), tmpFolder_( {} )
+{
+    if ( !tmpFolder_ )
+        return;
+    vertsFile_.open( tmpFolder_ / "verts.bin", std::ofstream::binary );
+    facesFile_.open( tmpFolder_ / "faces.bin", std::ofstream::binary );
+}
+
+Expected<void> PlyStreamWriter::addPart( const std::vector<Vector3f>& points, const std::vector<ThreeVertIds>& tris )
+{
+    MR_TIMER;
+    if ( !vertsFile_ || !facesFile_ )
+        return unexpected( std::string( "Cannot write temporary files" ) );
+
+    static_assert( sizeof( Vector3f ) == 12, "wrong size of Vector3f" );
+    vertsFile_.write( ( const char* )points.data(), points.size() * sizeof( Vector3f ) );
+    numVerts_ += points.size();
+    if ( numVerts_ > INT_MAX )
+        return unexpected( std::string( "Too many vertices for PLY-format" ) );
+
+    writeInParallel( facesFile_, tris.size(), [&] ( size_t begin, size_t end, std::string& buf )
+    {
+        PlyTriangle tri;
+        for ( size_t i = begin; i < end; ++i )
+        {
+            for ( int j = 0; j < 3; ++j )
+                tri.v[j] = tris[i][j];
+            buf.append( ( const char* )&tri, sizeof( PlyTriangle ) );
+        }
+    } );
+    numFaces_ += tris.size();
+
+    if ( !vertsFile_ || !facesFile_ )
+        return unexpected( std::string( "Cannot write temporary files" ) );
+    return {};
+}
+
+Expected<void> PlyStreamWriter::finish()
+{
+    MR_TIMER;
+    vertsFile_.close();
+    facesFile_.close();
+    if ( !vertsFile_ || !facesFile_ )
+        return unexpected( std::string( "Cannot write temporary files" ) );
+
+    out_ << "ply\nformat binary_little_endian 1.0\ncomment MeshInspector.com\n"
+        "element vertex " << numVerts_ << "\nproperty float x\nproperty float y\nproperty float z\n"
+        "element face " << numFaces_ << "\nproperty list uchar int vertex_indices\nend_header\n";
+
+    for ( auto [name, num] : { std::pair{ "verts.bin", numVerts_ }, std::pair{ "faces.bin", numFaces_ } } )
+    {
+        if ( num == 0 )
+            continue; // copying of empty buffer sets failbit in the output stream
+        std::ifstream in( tmpFolder_ / name, std::ifstream::binary );
+        if ( !in )
+            return unexpected( std::string( "Cannot read temporary files" ) );
+        out_ << in.rdbuf();
+    }
+
+    if ( !out_ )
+        return unexpected( std::string( "Error saving in PLY-format" ) );
+    return {};
+}
+
+TEST( MRMesh, MeshStreamWriter )
+{
+    const auto torus = makeTorus( 1.0f, 0.3f, 32, 16 );
+    const auto tris = torus.topology.getTriangulation();
+    const size_t half = tris.size() / 2;
+    const std::vector<ThreeVertIds> tris0( tris.vec_.begin(), tris.vec_.begin() + half ), tris1( tris.vec_.begin() + half, tris.vec_.end() );
+    const auto & points = torus.points.vec_;
+
+    UniqueTemporaryFolder folder( {} );
+    auto check = [&]( IMeshStreamWriter & writer, std::ofstream & out, const std::filesystem::path & path )
+    {
+        // all points are added with the first half of triangles
+        EXPECT_TRUE( writer.addPart( points, tris0 ).has_value() );
+        EXPECT_TRUE( writer.addPart( {}, tris1 ).has_value() );
+        writer.releasePoints( VertId( int( points.size() ) ) );
+        EXPECT_TRUE( writer.finish().has_value() );
+        out.close();
+
+        auto loaded = MeshLoad::fromAnySupportedFormat( path );
+        ASSERT_TRUE( loaded.has_value() );
+        EXPECT_EQ( loaded->topology.numValidFaces(), torus.topology.numValidFaces() );
+        EXPECT_EQ( loaded->topology.numValidVerts(), torus.topology.numValidVerts() );
+    };
+
+    const auto stlPath = folder / "torus.stl";
+    std::ofstream stlOut( stlPath, std::ofstream::binary );
+    BinaryStlStreamWriter stlWriter( stlOut );
+    check( stlWriter, stlOut, stlPath );
+
+    const auto plyPath = folder / "torus.ply";
+    std::ofstream plyOut( plyPath, std::ofstream::binary );
+    PlyStreamWriter plyWriter( plyOut );
+    check( plyWriter, plyOut, plyPath );
+}
+
+} //namespace MR
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "MRMeshFwd.h"
+#include "MRExpected.h"
+#include "MRId.h"
+#include "MRVector3.h"
+#include "MRUniqueTemporaryFolder.h"
+#include <fstream>
+#include <ostream>
+#include <vector>
+
+namespace MR
+{
+
+/// Abstract class for writing a mesh in a file part by part, without keeping whole mesh in memory;
+/// the points get consecutive ids in the order of their addition starting from 0
+class IMeshStreamWriter
+{
+public:
+    virtual ~IMeshStreamWriter() = default;
+
+    /// appends new points and the triangles, which can reference both new points and previously added (not released) points
+    virtual Expected<void> addPart( const std::vector<Vector3f>& points, const std::vector<ThreeVertIds>& tris ) = 0;
+
+    /// notifies that the points with ids less than given one will not be referenced by next triangles,
+    /// so the memory occupied by them can be freed
+    virtual void releasePoints( VertId ) {}
+
+    /// completes writing of the file, no parts can be added after that
+    virtual Expected<void> finish() = 0;
+};
+
+/// writes the mesh in binary STL format;
+/// the stream must support seeking, since the number of triangles is written in the header after all parts
+class MRMESH_CLASS BinaryStlStreamWriter : public IMeshStreamWriter
+{
+public:
+    MRMESH_API explicit BinaryStlStreamWriter( std::ostream& out );
+
+    MRMESH_API Expected<void> addPart( const std::vector<Vector3f>& points, const std::vector<ThreeVertIds>& tris ) override;
+    MRMESH_API void releasePoints( VertId upTo ) override;
+    MRMESH_API Expected<void> finish() override;
+
+private:
+    std::ostream& out_;
+    std::streampos headerPos_;
+    /// not released points, starting from the point with id firstPoint_
+    std::vector<Vector3f> points_;
+    VertId firstPoint_{ 0 };
+    size_t numTris_ = 0;
+};
+
+/// writes the mesh in binary PLY format;
+/// since all vertices must precede all faces in the file, both are written in temporary files first,
+/// and copied in the output stream in finish()
+class MRMESH_CLASS PlyStreamWriter : public IMeshStreamWriter
+{
+public:
+    MRMESH_API explicit PlyStreamWriter( std::ostream& out );
+
+    MRMESH_API Expected<void> addPart( const std::vector<Vector3f>& points, const std::vector<ThreeVertIds>& tris ) override;
+    MRMESH_API Expected<void> finish() override;
+
+private:
+    std::ostream& out_;
+    UniqueTemporaryFolder tmpFolder_;
+    std::ofstream vertsFile_;
+    std::ofstream facesFile_;
+    size_t numVerts_ = 0;
+    size_t numFaces_ = 0;
+};
+
+} //namespace MR
@@ -13,6 +13,7 @@
 #include "MRGridSettings.h"
 #include "MRIOParsing.h"
 #include <atomic>
+#include <cstring>
 #include <initializer_list>
 
 namespace MR
@@ -2400,6 +2401,43 @@ Expected<void> MeshTopology::read( std::istream & s, ProgressCallback callback )
     return {};
 }
 
+Expected<size_t> MeshTopology::read( const char * data, size_t size, ProgressCallback callback )
+{
+    MR_TIMER;
+    updateValids_ = false;
+
+    size_t pos = 0;
+    // reads the number of elements and copies the elements in given vector
+    auto readVector = [&]( auto & vec, float progressFrom ) -> Expected<void>
+    {
+        std::uint32_t num;
+        if ( pos + 4 > size )
+            return unexpected( std::string( "Buffer reading error: buffer is too short" ) );
+        std::memcpy( &num, data + pos, 4 );
+        pos += 4;
+        const size_t numBytes = size_t( num ) * sizeof( *vec.data() );
+        if ( pos + numBytes > size )
+            return unexpected( std::string( "Buffer reading error: buffer is too short" ) );
+        vec.resizeNoInit( num );
+        if ( !copyByBlocks( data + pos, (char*)vec.data(), numBytes, subprogress( callback, progressFrom, progressFrom + 1 / 3.f ) ) )
+            return unexpectedOperationCanceled();
+        pos += numBytes;
+        return {};
+    };
+
+    if ( auto res = readVector( edges_, 0.f ); !res )
+        return unexpected( std::move( res.error() ) );
+    if ( auto res = readVector( edgePerVertex_, 1 / 3.f ); !res )
+        return unexpected( std::move( res.error() ) );
+    if ( auto res = readVector( edgePerFace_, 2 / 3.f ); !res )
+        return unexpected( std::move( res.error() ) );
+
+    computeValidsFromEdges();
+
+    if ( !checkValidity() )
+        return unexpected( std::string( "Data is invalid" ) );
+    return pos;
+}
 
 bool MeshTopology::checkValidity( ProgressCallback cb, bool allVerts ) const
 {
@@ -487,6 +487,10 @@ public:
     /// \return text of error if any
     MRMESH_API Expected<void> read( std::istream& s, ProgressCallback callback = {} );
 
+    /// loads from binary data in memory (e.g. mapped file) having the same layout as written by \ref write
+    /// \return the number of consumed bytes or text of error if any
+    MRMESH_API Expected<size_t> read( const char * data, size_t size, ProgressCallback callback = {} );
+
     /// compare that two topologies are exactly the same
     [[nodiscard]] MRMESH_API bool operator ==( const MeshTopology & b ) const;
 
@@ -3,6 +3,8 @@
 #include "MRSerializer.h"
 #include "MRStringConvert.h"
 #include "MRHeapBytes.h"
+#include "MRDirectory.h"
+#include "MRTimer.h"
 #include "MRPch/MRJson.h"
 #include "MRPch/MRSpdlog.h"
 #include "MRGTest.h"
@@ -403,6 +405,12 @@ void Object::setVisibilityMask( ViewportMask viewportMask )
     if ( visibilityMask_ == viewportMask )
         return;
 
+    if ( deferredModel_ && !viewportMask.empty() )
+    {
+        if ( auto res = loadDeferredModel(); !res )
+            spdlog::error( "Cannot load deferred model of {}: {}", name_, res.error() );
+    }
+
     needRedraw_ = true;
     visibilityMask_ = viewportMask;
 }
@@ -535,12 +543,33 @@ Expected<std::vector<std::future<Expected<void>>>> Object::serializeRecursive( c
     // the key must be unique among all children of same parent
     std::string key = std::to_string( childId ) + "_" + replaceProhibitedChars( name_ );
 
-    auto model = serializeModel_( path / pathFromUtf8( key ) );
-    if ( !model.has_value() )
-        return unexpected( model.error() );
-    if ( model.value().valid() )
-        res.push_back( std::move( model.value() ) );
-    serializeFields_( root );
+    if ( deferredModel_ )
+    {
+        // the model was never loaded, so copy its file and the fields read from the scene,
+        // updating the ones changed since that
+        if ( deferredModel_->modelFiles )
+        {
+            if ( auto fetched = deferredModel_->modelFiles->fetch( deferredModel_->path ); !fetched )
+                return unexpected( std::move( fetched.error() ) );
+        }
+        if ( auto modelFile = findPathWithExtension( deferredModel_->path ); !modelFile.empty() )
+        {
+            std::filesystem::copy_file( modelFile, path / pathFromUtf8( key + utf8string( modelFile.extension() ) ),
+                std::filesystem::copy_options::overwrite_existing, ec );
+            if ( ec )
+                return unexpected( "Cannot copy file " + utf8string( modelFile ) + ": " + systemToUtf8( ec.message() ) );
+        }
+        root = actualDeferredFields_();
+    }
+    else
+    {
+        auto model = serializeModel_( path / pathFromUtf8( key ) );
+        if ( !model.has_value() )
+            return unexpected( model.error() );
+        if ( model.value().valid() )
+            res.push_back( std::move( model.value() ) );
+        serializeFields_( root );
+    }
 
     root["Key"] = key;
 
@@ -567,15 +596,44 @@ Expected<std::vector<std::future<Expected<void>>>> Object::serializeRecursive( c
 }
 
 Expected<void> Object::deserializeRecursive( const std::filesystem::path& path, const Json::Value& root,
-        ProgressCallback progressCb, int* objCounter )
+        ProgressCallback progressCb, int* objCounter, DeferModels deferModels, std::shared_ptr<const SceneModelFiles> modelFiles )
 {
     std::string key = root["Key"].isString() ? root["Key"].asString() : root["Name"].asString();
+    const auto modelPath = path / pathFromUtf8( key );
 
-    auto res = deserializeModel_( path / pathFromUtf8( key ), progressCb );
-    if ( !res.has_value() )
-        return res;
+    const bool defer = deferModels == DeferModels::Always
+        || ( deferModels == DeferModels::Invisible && root["Visibility"].isUInt() && root["Visibility"].asUInt() == 0 );
+    // the objects from old scenes without stored bounding box are not deferred to have valid boxes
+    if ( defer && root.isMember( "BoundingBox" ) && !findPathWithExtension( modelPath ).empty() )
+    {
+        auto fields = std::make_shared<Json::Value>( Json::objectValue );
+        for ( const auto& field : root.getMemberNames() )
+            if ( field != "Children" )
+                ( *fields )[field] = root[field];
+        // set before reading the fields to let derived objects know that the model is absent intentionally
+        deferredModel_ = std::make_shared<DeferredModel>( DeferredModel{ modelPath, std::move( fields ), modelFiles } );
+    }
+    else
+    {
+        if ( modelFiles )
+        {
+            if ( auto fetched = modelFiles->fetch( modelPath ); !fetched )
+                return fetched;
+        }
+        auto res = deserializeModel_( modelPath, progressCb );
+        if ( !res.has_value() )
+            return res;
+    }
 
     deserializeFields_( root );
+    if ( deferredModel_ )
+    {
+        auto initialFields = std::make_shared<Json::Value>();
+        serializeFields_( *initialFields );
+        auto deferred = std::make_shared<DeferredModel>( *deferredModel_ );
+        deferred->initialFields = std::move( initialFields );
+        deferredModel_ = std::move( deferred );
+    }
     if ( objCounter )
         ++( *objCounter );
 
@@ -628,7 +686,7 @@ Expected<void> Object::deserializeRecursive( const std::filesystem::path& path,
             if ( !childObj )
                 continue;
 
-            auto childRes = childObj->deserializeRecursive( path / pathFromUtf8( key ), child, progressCb, objCounter );
+            auto childRes = childObj->deserializeRecursive( modelPath, child, progressCb, objCounter, deferModels, modelFiles );
             if ( !childRes.has_value() )
                 return childRes;
             addChild( childObj );
@@ -637,6 +695,62 @@ Expected<void> Object::deserializeRecursive( const std::filesystem::path& path,
     return {};
 }
 
+Expected<void> Object::loadDeferredModel( ProgressCallback progressCb )
+{
+    if ( !deferredModel_ )
+        return {};
+    MR_TIMER;
+
+    // take the fields before the model is loaded to compare them with the initial ones
+    const auto fields = actualDeferredFields_();
+
+    // reset before loading for deserializeFields_ to process the fields depending on the model
+    const auto deferred = std::move( deferredModel_ );
+    deferredModel_.reset();
+    if ( deferred->modelFiles )
+    {
+        if ( auto fetched = deferred->modelFiles->fetch( deferred->path ); !fetched )
+        {
+            deferredModel_ = deferred;
+            return fetched;
+        }
+    }
+    if ( auto res = deserializeModel_( deferred->path, progressCb ); !res )
+    {
+        deferredModel_ = deferred;
+        return res;
+    }
+
+    deserializeFields_( fields );
+    needRedraw_ = true;
+    return {};
+}
+
+void Object::loadDeferredModelOnAccess_() const
+{
+    // the model is the part of logical state of the object, so it can be loaded from const accessors
+    if ( auto res = const_cast<Object*>( this )->loadDeferredModel(); !res )
+        spdlog::error( "Cannot load deferred model of {}: {}", name_, res.error() );
+}
+
+Json::Value Object::actualDeferredFields_() const
+{
+    assert( deferredModel_ );
+    Json::Value res = *deferredModel_->fields;
+    if ( !deferredModel_->initialFields )
+        return res;
+    const auto& initial = *deferredModel_->initialFields;
+    Json::Value current;
+    serializeFields_( current );
+    for ( const auto& field : current.getMemberNames() )
+        if ( current[field] != initial[field] )
+            res[field] = current[field];
+    for ( const auto& field : initial.getMemberNames() )
+        if ( !current.isMember( field ) )
+            res.removeMember( field );
+    return res;
+}
+
 void Object::swap( Object& other )
 {
     swapBase_( other );
@@ -27,6 +27,41 @@ namespace MR
  * \{
  */
 
+/// which objects get their models (meshes, point clouds, voxels, ...) loaded only on demand during scene deserialization
+enum class DeferModels
+{
+    Never,     ///< all models are loaded immediately
+    Invisible, ///< the models of invisible objects are loaded when the objects become visible or on explicit request
+    Always     ///< all models are loaded on explicit request or when hidden objects become visible
+};
+
+/// the storage of the model files of deserialized scene, kept by the objects with deferred models
+class SceneModelFiles
+{
+public:
+    virtual ~SceneModelFiles() = default;
+
+    /// makes the file of the model with given path (without extension) available on disk before reading it,
+    /// e.g. extracts it from a scene container; does nothing by default, when all files are already in the folder
+    virtual Expected<void> fetch( const std::filesystem::path& ) const { return {}; }
+};
+
+/// the data necessary to load the model of deserialized object later
+struct DeferredModel
+{
+    /// the path to the model file without extension
+    std::filesystem::path path;
+
+    /// the fields of the object (without children) to apply once the model is loaded
+    std::shared_ptr<const Json::Value> fields;
+
+    /// keeps the folder with model files alive (e.g. the temporary folder with decompressed scene) and fetches the files from it
+    std::shared_ptr<const SceneModelFiles> modelFiles;
+
+    /// the fields serialized by the object right after deferring its model, to find the fields changed since that
+    std::shared_ptr<const Json::Value> initialFields;
+};
+
 /// the main purpose of this class is to avoid copy and move constructor and assignment operator
 /// implementation in Object class, which has too many fields for that;
 /// since every object stores a pointer on its parent,
@@ -230,8 +265,19 @@ public:
     /// loads subtree into this Object
     ///   models from the folder by given path and
     ///   fields from given JSON
+    /// \param deferModels selects the objects which only get their fields now, and the models are loaded later by loadDeferredModel
+    /// \param modelFiles if given, it is asked to fetch each model file before reading, and it is stored in deferred objects
+    ///                   to keep the folder with their models alive
     MRMESH_API Expected<void> deserializeRecursive( const std::filesystem::path& path, const Json::Value& root,
-        ProgressCallback progressCb = {}, int* objCounter = nullptr );
+        ProgressCallback progressCb = {}, int* objCounter = nullptr,
+        DeferModels deferModels = DeferModels::Never, std::shared_ptr<const SceneModelFiles> modelFiles = {} );
+
+    /// returns true if the model of this object was not loaded yet during deserialization
+    [[nodiscard]] bool hasDeferredModel() const { return bool( deferredModel_ ); }
+
+    /// loads the model of this object deferred during deserialization (does nothing if there is no deferred model);
+    /// all fields changed since deserialization (name, transformation, colors, ...) are preserved
+    MRMESH_API Expected<void> loadDeferredModel( ProgressCallback progressCb = {} );
 
     /// swaps this object with other
     /// note: do not swap object signals, so listeners will get notifications from swapped object
@@ -294,6 +340,13 @@ protected:
     ViewportMask visibilityMask_ = ViewportMask::all(); // Prefer to not read directly. Use the getter, as it can be overridden.
     bool locked_ = false;
     bool parentLocked_ = false;
+    std::shared_ptr<const DeferredModel> deferredModel_; // not empty if the model is not loaded yet
+    /// returns the fields read from the scene for the object with deferred model, updated with the fields changed since that
+    [[nodiscard]] Json::Value actualDeferredFields_() const;
+    /// loads the deferred model (if any) on access to it via model accessors like ObjectMeshHolder::mesh();
+    /// as other lazily computed data of objects, it shall not be called for the first time from several threads simultaneously
+    void ensureModelLoaded_() const { if ( deferredModel_ ) loadDeferredModelOnAccess_(); }
+    MRMESH_API void loadDeferredModelOnAccess_() const;
     bool selected_{ false };
     bool ancillary_{ false };
     mutable bool needRedraw_{false};
@@ -24,7 +24,7 @@ public:
     /// sets given polyline to this, and returns back previous polyline of this;
     MRMESH_API virtual std::shared_ptr< Polyline3 > updatePolyline( std::shared_ptr< Polyline3 > polyline );
 
-    virtual const std::shared_ptr<Polyline3>& varPolyline() { return polyline_; }
+    virtual const std::shared_ptr<Polyline3>& varPolyline() { ensureModelLoaded_(); return polyline_; }
 
     MRMESH_API virtual void setDirtyFlags( uint32_t mask, bool invalidateCaches = true ) override;
 
@@ -99,7 +99,7 @@ void ObjectLinesHolder::swapBase_( Object& other )
 Box3f ObjectLinesHolder::getWorldBox( ViewportId id ) const
 {
     if ( !polyline_ )
-        return {};
+        return hasDeferredModel() ? VisualObject::getWorldBox( id ) : Box3f{};
     bool isDef = true;
     const auto worldXf = this->worldXf( id, &isDef );
     if ( isDef )
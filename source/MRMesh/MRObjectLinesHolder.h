@@ -35,7 +35,7 @@ public:
     MRMESH_API virtual std::shared_ptr<Object> shallowClone() const override;
 
     const std::shared_ptr<const Polyline3>& polyline() const
-    { return reinterpret_cast< const std::shared_ptr<const Polyline3>& >( polyline_ ); } // reinterpret_cast to avoid making a copy of shared_ptr
+    { ensureModelLoaded_(); return reinterpret_cast< const std::shared_ptr<const Polyline3>& >( polyline_ ); } // reinterpret_cast to avoid making a copy of shared_ptr
 
     MRMESH_API virtual void setDirtyFlags( uint32_t mask, bool invalidateCaches = true ) override;
 
@@ -23,6 +23,9 @@
 #include "MRSceneSettings.h"
 #include "MRMeshLoadSettings.h"
 #include "MRZip.h"
+#include "MRObjectSave.h"
+#include "MRCube.h"
+#include "MRGTest.h"
 #include "MRVoxels/MRDicom.h"
 #include "MRPch/MRTBB.h"
 #include "MRPch/MRFmt.h"
@@ -34,6 +37,13 @@ namespace MR
 namespace
 {
 
+/// the temporary folder with decompressed scene, where all model files are already present
+struct TemporarySceneFolder : SceneModelFiles
+{
+    explicit TemporarySceneFolder( FolderCallback onPreTempFolderDelete ) : folder( std::move( onPreTempFolderDelete ) ) {}
+    UniqueTemporaryFolder folder;
+};
+
 /// finds if given mesh has enough sharp edges (>25 degrees) to recommend flat shading
 bool detectFlatShading( const Mesh& mesh )
 {
@@ -471,21 +481,27 @@ Expected<LoadedObject> loadSceneFromAnySupportedFormat( const std::filesystem::p
 }
 
 Expected<LoadedObject> deserializeObjectTree( const std::filesystem::path& path, const FolderCallback& postDecompress,
-                                              const ProgressCallback& progressCb )
+                                              const ProgressCallback& progressCb, DeferModels deferModels )
 {
     MR_TIMER;
-    UniqueTemporaryFolder scenePath( postDecompress );
+    auto scene = std::make_shared<TemporarySceneFolder>( postDecompress );
+    const auto& scenePath = scene->folder;
     if ( !scenePath )
         return unexpected( "Cannot create temporary folder" );
     auto res = decompressZip( path, scenePath );
     if ( !res.has_value() )
         return unexpected( std::move( res.error() ) );
 
-    return deserializeObjectTreeFromFolder( scenePath, progressCb );
+    // deferred models are read from the temporary folder, so it is removed together with the last of them
+    std::shared_ptr<const SceneModelFiles> modelFiles;
+    if ( deferModels != DeferModels::Never )
+        modelFiles = scene;
+    return deserializeObjectTreeFromFolder( scenePath, progressCb, deferModels, std::move( modelFiles ) );
 }
 
 Expected<LoadedObject> deserializeObjectTreeFromFolder( const std::filesystem::path& folder,
-                                                        const ProgressCallback& progressCb )
+                                                        const ProgressCallback& progressCb,
+                                                        DeferModels deferModels, std::shared_ptr<const SceneModelFiles> modelFiles )
 {
     MR_TIMER;
 
@@ -555,7 +571,7 @@ Expected<LoadedObject> deserializeObjectTreeFromFolder( const std::filesystem::p
         };
     }
 
-    auto resDeser = res.obj->deserializeRecursive( folder, root, cb, &modelCounter );
+    auto resDeser = res.obj->deserializeRecursive( folder, root, cb, &modelCounter, deferModels, std::move( modelFiles ) );
     if ( !resDeser.has_value() )
     {
         std::string errorStr = resDeser.error();
@@ -572,6 +588,84 @@ Expected<LoadedObject> deserializeObjectTree( const std::filesystem::path& path,
     return deserializeObjectTree( path, FolderCallback{}, progressCb );
 }
 
+Expected<void> loadDeferredModels( Object& root, const ProgressCallback& progressCb )
+{
+    MR_TIMER;
+    std::vector<Object*> objs;
+    std::vector<Object*> todo{ &root };
+    while ( !todo.empty() )
+    {
+        auto obj = todo.back();
+        todo.pop_back();
+        if ( obj->hasDeferredModel() )
+            objs.push_back( obj );
+        for ( const auto& child : obj->children() )
+            todo.push_back( child.get() );
+    }
+
+    for ( int i = 0; i < objs.size(); ++i )
+    {
+        auto res = objs[i]->loadDeferredModel( subprogress( progressCb, float( i ) / objs.size(), float( i + 1 ) / objs.size() ) );
+        if ( !res.has_value() )
+            return res;
+    }
+    return {};
+}
+
 MR_ADD_SCENE_LOADER_WITH_PRIORITY( IOFilter( "MeshInspector scene (.mru)", "*.mru" ), deserializeObjectTree, -1 )
 
+TEST( MRMesh, DeserializeDeferredModels )
+{
+    Object root;
+    auto visible = std::make_shared<ObjectMesh>();
+    visible->setName( "Visible" );
+    visible->setMesh( std::make_shared<Mesh>( makeCube() ) );
+    root.addChild( visible );
+    auto hidden = std::make_shared<ObjectMesh>();
+    hidden->setName( "Hidden" );
+    hidden->setMesh( std::make_shared<Mesh>( makeCube( Vector3f::diagonal( 2.f ), Vector3f::diagonal( 1.f ) ) ) );
+    hidden->setVisible( false );
+    root.addChild( hidden );
+
+    UniqueTemporaryFolder folder( {} );
+    ASSERT_TRUE( serializeObjectTreeToFolder( root, folder ).has_value() );
+
+    auto loaded = deserializeObjectTreeFromFolder( folder, {}, DeferModels::Invisible );
+    ASSERT_TRUE( loaded.has_value() );
+    ASSERT_EQ( loaded->obj->children().size(), 2 );
+    auto loadedVisible = std::dynamic_pointer_cast<ObjectMesh>( loaded->obj->children()[0] );
+    auto loadedHidden = std::dynamic_pointer_cast<ObjectMesh>( loaded->obj->children()[1] );
+    ASSERT_TRUE( loadedVisible && loadedHidden );
+    EXPECT_FALSE( loadedVisible->hasDeferredModel() );
+    EXPECT_TRUE( loadedVisible->mesh() );
+
+    // the hidden object has only its fields and the box until it becomes visible or its model is requested
+    EXPECT_TRUE( loadedHidden->hasDeferredModel() );
+    EXPECT_EQ( loadedHidden->name(), "Hidden" );
+    EXPECT_EQ( loadedHidden->getBoundingBox(), hidden->getBoundingBox() );
+
+    // the color changed before loading of the model is preserved
+    loadedHidden->setFrontColor( Color::red(), false );
+    loadedHidden->setVisible( true );
+    EXPECT_FALSE( loadedHidden->hasDeferredModel() );
+    EXPECT_EQ( loadedHidden->getFrontColor( false ), Color::red() );
+    ASSERT_TRUE( loadedHidden->mesh() );
+    EXPECT_EQ( loadedHidden->mesh()->topology.numValidFaces(), 12 );
+    EXPECT_TRUE( loadedHidden->isVisible() );
+    EXPECT_EQ( loadedHidden->getBoundingBox(), hidden->getBoundingBox() );
+
+    // the model is loaded on first access to it, and the object remains hidden
+    auto loadedAgain = deserializeObjectTreeFromFolder( folder, {}, DeferModels::Always );
+    ASSERT_TRUE( loadedAgain.has_value() );
+    ASSERT_EQ( loadedAgain->obj->children().size(), 2 );
+    auto deferredHidden = std::dynamic_pointer_cast<ObjectMesh>( loadedAgain->obj->children()[1] );
+    ASSERT_TRUE( deferredHidden );
+    EXPECT_TRUE( deferredHidden->hasDeferredModel() );
+    ASSERT_TRUE( deferredHidden->mesh() );
+    EXPECT_FALSE( deferredHidden->hasDeferredModel() );
+    EXPECT_EQ( deferredHidden->mesh()->topology.numValidFaces(), 12 );
+    EXPECT_FALSE( deferredHidden->isVisible() );
+    EXPECT_EQ( deferredHidden->getBoundingBox(), hidden->getBoundingBox() );
+}
+
 } //namespace MR
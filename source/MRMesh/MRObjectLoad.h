@@ -7,6 +7,7 @@
 #include "MRMeshLoadSettings.h"
 #include "MRUniqueTemporaryFolder.h"
 #include "MRLoadedObjects.h"
+#include "MRObject.h"
 
 #include <filesystem>
 
@@ -55,10 +56,16 @@ MRMESH_API Expected<LoadedObject> loadSceneFromAnySupportedFormat( const std::fi
  *
  * if postDecompress is set, it is called after decompression
  * loading is controlled with Object::deserializeModel_ and Object::deserializeFields_
+ *
+ * if deferModels is set then selected objects get only their fields and bounding boxes, and their models
+ * are loaded by Object::loadDeferredModel or loadDeferredModels, when the objects become visible,
+ * or on first access to the models (e.g. by ObjectMeshHolder::mesh());
+ * the temporary folder with decompressed scene is kept until all deferred models are loaded or the objects are destroyed
  */
 MRMESH_API Expected<LoadedObject> deserializeObjectTree( const std::filesystem::path& path,
                                                          const FolderCallback& postDecompress = {},
-                                                         const ProgressCallback& progressCb = {} );
+                                                         const ProgressCallback& progressCb = {},
+                                                         DeferModels deferModels = DeferModels::Never );
 
 /**
  * \brief loads objects tree from given scene folder
@@ -67,9 +74,16 @@ MRMESH_API Expected<LoadedObject> deserializeObjectTree( const std::filesystem::
  *  all objects parameters are saved in one JSON file in the root folder
  *
  * loading is controlled with Object::deserializeModel_ and Object::deserializeFields_
+ * \param modelFiles if given, it fetches the model files before reading them, and it is kept by the objects with deferred models
+ *                   (if deferModels is set) to keep the folder alive
  */
 MRMESH_API Expected<LoadedObject> deserializeObjectTreeFromFolder( const std::filesystem::path& folder,
-                                                                   const ProgressCallback& progressCb = {} );
+                                                                   const ProgressCallback& progressCb = {},
+                                                                   DeferModels deferModels = DeferModels::Never,
+                                                                   std::shared_ptr<const SceneModelFiles> modelFiles = {} );
+
+/// loads all models deferred during deserialization in given object and its subtree
+MRMESH_API Expected<void> loadDeferredModels( Object& root, const ProgressCallback& progressCb = {} );
 
 
 /// returns filters for all supported file formats for all types of objects
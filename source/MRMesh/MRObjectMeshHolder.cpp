@@ -581,7 +581,7 @@ bool ObjectMeshHolder::isMeshClosed() const
 Box3f ObjectMeshHolder::getWorldBox( ViewportId id ) const
 {
     if ( !data_.mesh )
-        return {};
+        return hasDeferredModel() ? VisualObject::getWorldBox( id ) : Box3f{};
     bool isDef = true;
     const auto worldXf = this->worldXf( id, &isDef );
     if ( isDef )
@@ -50,13 +50,13 @@ public:
     #pragma GCC diagnostic ignored "-Wstrict-aliasing" // Fingers crossed.
     #endif
     const std::shared_ptr< const Mesh >& mesh() const
-    { return reinterpret_cast< const std::shared_ptr<const Mesh>& >( data_.mesh ); } // reinterpret_cast to avoid making a copy of shared_ptr
+    { ensureModelLoaded_(); return reinterpret_cast< const std::shared_ptr<const Mesh>& >( data_.mesh ); } // reinterpret_cast to avoid making a copy of shared_ptr
     #ifdef __GNUC__
     #pragma GCC diagnostic pop
     #endif
 
     /// \return the pair ( mesh, selected triangles ) if any triangle is selected or whole mesh otherwise
-    MeshPart meshPart() const { return data_.selectedFaces.any() ? MeshPart{ *data_.mesh, &data_.selectedFaces } : *data_.mesh; }
+    MeshPart meshPart() const { ensureModelLoaded_(); return data_.selectedFaces.any() ? MeshPart{ *data_.mesh, &data_.selectedFaces } : *data_.mesh; }
 
     MRMESH_API virtual std::shared_ptr<Object> clone() const override;
     MRMESH_API virtual std::shared_ptr<Object> shallowClone() const override;
@@ -19,7 +19,7 @@ public:
     virtual const char* typeName() const override { return TypeName(); }
 
     /// returns variable point cloud, if const point cloud is needed use `pointCloud()` instead
-    virtual const std::shared_ptr<PointCloud>& varPointCloud() { return points_; }
+    virtual const std::shared_ptr<PointCloud>& varPointCloud() { ensureModelLoaded_(); return points_; }
 
     MRMESH_API virtual std::shared_ptr<Object> clone() const override;
     MRMESH_API virtual std::shared_ptr<Object> shallowClone() const override;
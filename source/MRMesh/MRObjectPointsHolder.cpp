@@ -184,7 +184,7 @@ void ObjectPointsHolder::setPointSize( float size )
 Box3f ObjectPointsHolder::getWorldBox( ViewportId id ) const
 {
     if ( !points_ )
-        return {};
+        return hasDeferredModel() ? VisualObject::getWorldBox( id ) : Box3f{};
     bool isDef = true;
     const auto worldXf = this->worldXf( id, &isDef );
     if ( isDef )
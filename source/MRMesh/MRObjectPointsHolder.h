@@ -32,7 +32,7 @@ public:
     [[nodiscard]] virtual bool hasModel() const override { return bool( points_ ); }
 
     const std::shared_ptr<const PointCloud>& pointCloud() const
-    { return reinterpret_cast< const std::shared_ptr<const PointCloud>& >( points_ ); } // reinterpret_cast to avoid making a copy of shared_ptr
+    { ensureModelLoaded_(); return reinterpret_cast< const std::shared_ptr<const PointCloud>& >( points_ ); } // reinterpret_cast to avoid making a copy of shared_ptr
 
     MRMESH_API virtual std::shared_ptr<Object> clone() const override;
     MRMESH_API virtual std::shared_ptr<Object> shallowClone() const override;
@@ -198,6 +198,24 @@ Expected<void> serializeObjectTree( const Object& object, const std::filesystem:
     if ( !scenePath )
         return unexpected( "Cannot create temporary folder" );
 
+    if ( auto res = serializeObjectTreeToFolder( object, scenePath, subprogress( progressCb, 0.0f, 0.9f ) ); !res )
+        return res;
+
+    if ( preCompress )
+        preCompress( scenePath );
+
+    return compressZip( path, scenePath, {}, nullptr, subprogress( progressCb, 0.9f, 1.0f ) );
+}
+
+Expected<void> serializeObjectTree( const Object& object, const std::filesystem::path& path, ProgressCallback progress )
+{
+    return serializeObjectTree( object, path, std::move( progress ), {} );
+}
+
+Expected<void> serializeObjectTreeToFolder( const Object& object, const std::filesystem::path& scenePath,
+                                          ProgressCallback progressCb )
+{
+    MR_TIMER;
     if ( progressCb && !progressCb( 0.0f ) )
         return unexpected( "Canceled" );
 
@@ -223,7 +241,7 @@ Expected<void> serializeObjectTree( const Object& object, const std::filesystem:
     if ( !reportProgress( progressCb, 0.1f ) )
         return unexpectedOperationCanceled();
 
-    // wait for all models are saved before making compressed folder
+    // wait for all models are saved before returning the folder to the caller
     BitSet inProgress( saveModelFutures.size(), true );
     while ( inProgress.any() )
     {
@@ -232,7 +250,7 @@ Expected<void> serializeObjectTree( const Object& object, const std::filesystem:
             if ( saveModelFutures[i].wait_for( std::chrono::milliseconds( 200 ) ) != std::future_status::timeout )
                 inProgress.reset( i );
         }
-        if ( !reportProgress( subprogress( progressCb, 0.1f, 0.9f ), 1.0f - (float)inProgress.count() / inProgress.size() ) )
+        if ( !reportProgress( subprogress( progressCb, 0.1f, 1.0f ), 1.0f - (float)inProgress.count() / inProgress.size() ) )
             return unexpectedOperationCanceled();
     }
 #endif
@@ -244,15 +262,7 @@ Expected<void> serializeObjectTree( const Object& object, const std::filesystem:
             return v;
     }
 
-    if ( preCompress )
-        preCompress( scenePath );
-
-    return compressZip( path, scenePath, {}, nullptr, subprogress( progressCb, 0.9f, 1.0f ) );
-}
-
-Expected<void> serializeObjectTree( const Object& object, const std::filesystem::path& path, ProgressCallback progress )
-{
-    return serializeObjectTree( object, path, std::move( progress ), {} );
+    return {};
 }
 
 MR_ADD_SCENE_SAVER_WITH_PRIORITY( IOFilter( "MeshInspector scene (.mru)", "*.mru" ), serializeObjectTree, -1 )
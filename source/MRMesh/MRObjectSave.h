@@ -40,4 +40,12 @@ MRMESH_API Expected<void> serializeObjectTree( const Object& object, const std::
 MRMESH_API Expected<void> serializeObjectTree( const Object& object, const std::filesystem::path& path,
                                              ProgressCallback progress = {} );
 
+/**
+ * \brief saves object subtree in given existing folder in the same layout as inside scene file (zip/mru)
+ * \details the function returns only after all models are saved;
+ * it is the first stage of serializeObjectTree, which can be used to pack the folder in other containers
+ */
+MRMESH_API Expected<void> serializeObjectTreeToFolder( const Object& object, const std::filesystem::path& folder,
+                                                     ProgressCallback progress = {} );
+
 } // namespace MR
@@ -5,11 +5,25 @@
 #include "MRBestFit.h"
 #include "MRPointsInBall.h"
 #include "MRPointsComponents.h"
+#include "MRPointNeighborhoodGraph.h"
 
 namespace MR
 {
 
 Expected<void> OutliersDetector::prepare( const PointCloud& pointCloud, float radius, OutlierTypeMask mask, ProgressCallback progress /*= {}*/ )
+{
+    const auto graph = findCachedNeighborhoodGraph( pointCloud, { .radius = radius } );
+    return prepare_( pointCloud, radius, graph.get(), mask, progress );
+}
+
+Expected<void> OutliersDetector::prepare( const PointCloud& pointCloud, const PointNeighborhoodGraph& graph, OutlierTypeMask mask, ProgressCallback progress /*= {}*/ )
+{
+    if ( graph.settings.radius <= 0 )
+        return unexpected( "Neighborhood graph must be built for some radius" );
+    return prepare_( pointCloud, graph.settings.radius, &graph, mask, progress );
+}
+
+Expected<void> OutliersDetector::prepare_( const PointCloud& pointCloud, float radius, const PointNeighborhoodGraph* graph, OutlierTypeMask mask, ProgressCallback progress )
 {
     validPoints_ = pointCloud.validPoints;
 
@@ -45,6 +59,23 @@ Expected<void> OutliersDetector::prepare( const PointCloud& pointCloud, float ra
     ProgressCallback subProgress = subprogress( progress, 0.f, 0.4f );
     const auto& points = pointCloud.points;
     const auto& normals = pointCloud.normals;
+
+    // calls given function for each point within the radius around v0 (including v0 itself)
+    auto forEachPointInBall = [&]( VertId v0, auto && callback )
+    {
+        if ( graph )
+        {
+            callback( v0 );
+            graph->forEachNeighborWithin( points, v0, sqr( radius_ ), callback );
+            return;
+        }
+        findPointsInBall( pointCloud.getAABBTree(), { points[v0], sqr( radius_ ) },
+                          [&] ( const PointsProjectionResult & found, const Vector3f&, Ball3f & )
+        {
+            callback( found.vId );
+            return Processing::Continue;
+        } );
+    };
     if ( numThreads > 1 )
     {
         secondPassVerts.resize( numVerts );
@@ -56,12 +87,10 @@ Expected<void> OutliersDetector::prepare( const PointCloud& pointCloud, float ra
             int count = 0;
             PointAccumulator plane;
             Vector3f normalSum;
-            findPointsInBall( pointCloud.getAABBTree(), { pointCloud.points[v0], sqr( radius_ ) },
-                              [&] ( const PointsProjectionResult & found, const Vector3f&, Ball3f & )
+            forEachPointInBall( v0, [&] ( VertId v1 )
             {
-                const auto v1 = found.vId;
                 if ( !contains( validPoints_, v1 ) )
-                    return Processing::Continue;
+                    return;
                 if ( v1 != v0 )
                 {
                     ++count;
@@ -77,7 +106,6 @@ Expected<void> OutliersDetector::prepare( const PointCloud& pointCloud, float ra
                     else
                         unionFindStructure_.unite( v0, v1 );
                 }
-                return Processing::Continue;
             } );
             if ( calcWeaklyConnectedCached )
                 weaklyConnectedStat_[int( v0 )] = uint8_t( std::min( count, 255 ) );
@@ -108,15 +136,12 @@ Expected<void> OutliersDetector::prepare( const PointCloud& pointCloud, float ra
         const int counterDivider = std::max( lastPassVertsCount / 100, 1 );
         for ( auto v0 : *lastPassVerts )
         {
-            findPointsInBall( pointCloud.getAABBTree(), { pointCloud.points[v0], sqr( radius_ ) },
-                              [&] ( const PointsProjectionResult & found, const Vector3f&, Ball3f & )
+            forEachPointInBall( v0, [&] ( VertId v1 )
             {
-                const auto v1 = found.vId;
                 if ( v0 < v1 && contains( validPoints_, v1 ) )
                 {
                     unionFindStructure_.unite( v0, v1 );
                 }
-                return Processing::Continue;
             } );
             ++counterProcessedVerts;
             if ( !reportProgress( subProgress, counterProcessedVerts / counterMax, counterProcessedVerts, counterDivider ) )
@@ -228,7 +253,9 @@ Expected<VertBitSet> OutliersDetector::findAwayNormal( ProgressCallback progress
 Expected<VertBitSet> findOutliers( const PointCloud& pc, const FindOutliersParams& params )
 {
     OutliersDetector finder;
-    auto res = finder.prepare( pc, params.radius, params.mask, subprogress( params.progress, 0.f, 0.8f ) );
+    auto res = params.neighborhoodGraph ?
+        finder.prepare( pc, *params.neighborhoodGraph, params.mask, subprogress( params.progress, 0.f, 0.8f ) ) :
+        finder.prepare( pc, params.radius, params.mask, subprogress( params.progress, 0.f, 0.8f ) );
     if ( !res.has_value() )
         return unexpected( res.error() );
     finder.setParams( params.finderParams );
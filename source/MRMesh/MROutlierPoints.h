@@ -45,11 +45,21 @@ public:
     /// 
     /// @param pc point cloud
     /// @param radius radius of the search for neighboring points for analysis
+    ///        (the neighbours are taken from the graph cached in the cloud if it covers this radius)
     /// @param mask mask of the types of outliers that are looking for
     /// @param progress progress callback function
     /// @return error text or nothing
     MRMESH_API Expected<void> prepare( const PointCloud& pc, float radius, OutlierTypeMask mask, ProgressCallback progress = {} ); // calculate caches
 
+    /// Make a preliminary stage of outlier search taking the neighbours of points from given graph. Caches the result
+    ///
+    /// @param pc point cloud
+    /// @param graph neighbours of all points within some radius, which is used in the analysis
+    /// @param mask mask of the types of outliers that are looking for
+    /// @param progress progress callback function
+    /// @return error text or nothing
+    MRMESH_API Expected<void> prepare( const PointCloud& pc, const PointNeighborhoodGraph& graph, OutlierTypeMask mask, ProgressCallback progress = {} );
+
     /// Set search parameters
     MRMESH_API void setParams( const OutlierParams& params );
     /// Get search parameters
@@ -63,6 +73,8 @@ public:
     MRMESH_API const std::vector<uint8_t>& getWeaklyConnectedStat() { return weaklyConnectedStat_; }
 
 private:
+    Expected<void> prepare_( const PointCloud& pc, float radius, const PointNeighborhoodGraph* graph, OutlierTypeMask mask, ProgressCallback progress );
+
     Expected<VertBitSet> findSmallComponents( ProgressCallback progress = {} );
     Expected<VertBitSet> findWeaklyConnected( ProgressCallback progress = {} );
     Expected<VertBitSet> findFarSurface( ProgressCallback progress = {} );
@@ -88,6 +100,10 @@ struct FindOutliersParams
     OutlierParams finderParams; ///< Parameters of various criteria for detecting outlier points
     float radius = 1.f; ///< Radius of the search for neighboring points for analysis
 
+    /// optional: the neighbours of all points, if given then its radius is used instead of (radius);
+    /// otherwise the graph cached in the cloud can be used
+    const PointNeighborhoodGraph* neighborhoodGraph = nullptr;
+
     OutlierTypeMask mask = OutlierTypeMask::All; ///< Mask of the types of outliers that are looking for
 
     ProgressCallback progress = {}; ///< Progress callback
@@ -1,5 +1,6 @@
 #include "MRPointCloud.h"
 #include "MRAABBTreePoints.h"
+#include "MRPointNeighborhoodGraph.h"
 #include "MRComputeBoundingBox.h"
 #include "MRPlane3.h"
 #include "MRBitSetParallelFor.h"
@@ -117,12 +118,21 @@ const AABBTreePoints& PointCloud::getAABBTree() const
     return AABBTreeOwner_.getOrCreate( [this]{ return AABBTreePoints( *this ); } );
 }
 
+std::shared_ptr<const PointNeighborhoodGraph> PointCloud::getNeighborhoodGraph( const PointNeighborhoodSettings & settings ) const
+{
+    if ( auto res = neighborhoodGraphOwner_.getPtr(); res && ( res->settings != settings || res->numPoints() != points.size() ) )
+        neighborhoodGraphOwner_.reset(); // the holders of old graph keep it alive
+    neighborhoodGraphOwner_.getOrCreate( [&]{ return *buildPointNeighborhoodGraph( *this, settings ); } );
+    return neighborhoodGraphOwner_.getPtr();
+}
+
 size_t PointCloud::heapBytes() const
 {
     return points.heapBytes()
         + normals.heapBytes()
         + validPoints.heapBytes()
-        + AABBTreeOwner_.heapBytes();
+        + AABBTreeOwner_.heapBytes()
+        + neighborhoodGraphOwner_.heapBytes();
 }
 
 void PointCloud::mirror( const Plane3f& plane )
@@ -259,6 +269,7 @@ VertBMap PointCloud::pack( Reorder reoder )
     {
         getAABBTree(); // ensure that tree is constructed
         AABBTreeOwner_.update( [&map]( AABBTreePoints& t ) { t.getLeafOrderAndReset( map ); } );
+        neighborhoodGraphOwner_.reset();
         if ( !wasPacked )
         {
             ParallelFor( 0_v, map.b.endId(), [&]( VertId v )
@@ -42,6 +42,14 @@ struct PointCloud
     /// returns cached aabb-tree for this point cloud, but does not create it if it did not exist
     [[nodiscard]] const AABBTreePoints * getAABBTreeNotCreate() const { return AABBTreeOwner_.get(); }
 
+    /// returns cached graph of neighbours of all points if it was built with given settings;
+    /// otherwise creates and caches the graph with given settings in a thread-safe manner, replacing the graph with other settings if any
+    /// (the holders of previously returned graph keep it valid, but the calls with different settings must not be done in parallel)
+    MRMESH_API std::shared_ptr<const PointNeighborhoodGraph> getNeighborhoodGraph( const PointNeighborhoodSettings & settings ) const;
+
+    /// returns cached graph of neighbours of all points, but does not create it if it did not exist
+    [[nodiscard]] std::shared_ptr<const PointNeighborhoodGraph> getNeighborhoodGraphNotCreate() const { return neighborhoodGraphOwner_.getPtr(); }
+
     /// returns the minimal bounding box containing all valid vertices (implemented via getAABBTree())
     [[nodiscard]] MRMESH_API Box3f getBoundingBox() const;
 
@@ -85,14 +93,15 @@ struct PointCloud
     /// \return points mapping: old -> new
     MRMESH_API VertBMap pack( Reorder reoder );
 
-    /// Invalidates caches (e.g. aabb-tree) after a change in point cloud
-    void invalidateCaches() { AABBTreeOwner_.reset(); }
+    /// Invalidates caches (e.g. aabb-tree and neighborhood graph) after a change in point cloud
+    void invalidateCaches() { AABBTreeOwner_.reset(); neighborhoodGraphOwner_.reset(); }
 
     /// returns the amount of memory this object occupies on heap
     [[nodiscard]] MRMESH_API size_t heapBytes() const;
 
 private:
     mutable SharedThreadSafeOwner<AABBTreePoints> AABBTreeOwner_;
+    mutable SharedThreadSafeOwner<PointNeighborhoodGraph> neighborhoodGraphOwner_;
 };
 
 } // namespace MR
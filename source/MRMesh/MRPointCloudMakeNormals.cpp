@@ -13,25 +13,24 @@
 #include "MRHeap.h"
 #include "MRBuffer.h"
 #include "MRLocalTriangulations.h"
+#include "MRPointNeighborhoodGraph.h"
 #include <cfloat>
 
 namespace MR
 {
 
-std::optional<VertNormals> makeUnorientedNormals( const PointCloud& pointCloud, float radius, const ProgressCallback & progress, OrientNormals orient )
+template<class T>
+std::optional<VertNormals> makeUnorientedNormalsCore( const PointCloud& pointCloud, const T & enumNeis, const ProgressCallback & progress, OrientNormals orient )
 {
     MR_TIMER;
 
     VertNormals normals;
     normals.resizeNoInit( pointCloud.points.size() );
-    if ( !BitSetParallelFor( pointCloud.validPoints, [&, radiusSq = sqr( radius )]( VertId vid )
+    if ( !BitSetParallelFor( pointCloud.validPoints, [&]( VertId vid )
     {
         PointAccumulator accum;
-        findPointsInBall( pointCloud, { pointCloud.points[vid], radiusSq }, [&]( const PointsProjectionResult &, const Vector3f & foundPos, Ball3f & )
-        {
-            accum.addPoint( Vector3d( foundPos ) );
-            return Processing::Continue;
-        } );
+        accum.addPoint( pointCloud.points[vid] );
+        enumNeis( vid, [&]( VertId v ) { accum.addPoint( pointCloud.points[v] ); } );
         auto n = Vector3f( accum.getBestPlane().n );
         if ( orient != OrientNormals::Smart )
         {
@@ -45,6 +44,30 @@ std::optional<VertNormals> makeUnorientedNormals( const PointCloud& pointCloud,
     return normals;
 }
 
+std::optional<VertNormals> makeUnorientedNormals( const PointCloud& pointCloud, float radius, const ProgressCallback & progress, OrientNormals orient )
+{
+    if ( auto graph = findCachedNeighborhoodGraph( pointCloud, { .radius = radius } ) )
+    {
+        return makeUnorientedNormalsCore( pointCloud,
+            [&, radiusSq = sqr( radius )]( VertId base, auto callback )
+            {
+                graph->forEachNeighborWithin( pointCloud.points, base, radiusSq, callback );
+            }, progress, orient );
+    }
+
+    return makeUnorientedNormalsCore( pointCloud,
+        [&, radiusSq = sqr( radius )]( VertId base, auto callback )
+        {
+            findPointsInBall( pointCloud, { pointCloud.points[base], radiusSq },
+                [&]( const PointsProjectionResult & found, const Vector3f &, Ball3f & )
+                {
+                    if ( found.vId != base )
+                        callback( found.vId );
+                    return Processing::Continue;
+                } );
+        }, progress, orient );
+}
+
 std::optional<VertNormals> makeUnorientedNormals( const PointCloud& pointCloud, const AllLocalTriangulations& triangs, const ProgressCallback & progress, OrientNormals orient )
 {
     MR_TIMER;
@@ -69,29 +92,24 @@ std::optional<VertNormals> makeUnorientedNormals( const PointCloud& pointCloud,
 std::optional<VertNormals> makeUnorientedNormals( const PointCloud& pointCloud,
     const Buffer<VertId> & closeVerts, int numNei, const ProgressCallback & progress, OrientNormals orient )
 {
-    MR_TIMER;
-
-    VertNormals normals;
-    normals.resizeNoInit( pointCloud.points.size() );
-    if ( !BitSetParallelFor( pointCloud.validPoints, [&]( VertId vid )
-    {
-        PointAccumulator accum;
-        accum.addPoint( pointCloud.points[vid] );
-        VertId * p = closeVerts.data() + ( (size_t)vid * numNei );
-        const VertId * pEnd = p + numNei;
-        for ( ; p < pEnd && *p; ++p )
-            accum.addPoint( pointCloud.points[*p] );
-        auto n = Vector3f( accum.getBestPlane().n );
-        if ( orient != OrientNormals::Smart )
+    return makeUnorientedNormalsCore( pointCloud,
+        [&]( VertId base, auto callback )
         {
-            if ( ( dot( n, pointCloud.points[vid] ) > 0 ) == ( orient == OrientNormals::TowardOrigin ) )
-                n = -n;
-        }
-        normals[vid] = n;
-    }, progress ) )
-        return {};
+            VertId * p = closeVerts.data() + ( (size_t)base * numNei );
+            const VertId * pEnd = p + numNei;
+            for ( ; p < pEnd && *p; ++p )
+                callback( *p );
+        }, progress, orient );
+}
 
-    return normals;
+std::optional<VertNormals> makeUnorientedNormals( const PointCloud& pointCloud,
+    const PointNeighborhoodGraph & graph, const ProgressCallback & progress, OrientNormals orient )
+{
+    return makeUnorientedNormalsCore( pointCloud,
+        [&]( VertId base, auto callback )
+        {
+            graph.forEachNeighbor( base, callback );
+        }, progress, orient );
 }
 
 template<class T>
@@ -183,6 +201,15 @@ bool orientNormalsCore( const PointCloud& pointCloud, VertNormals& normals, cons
 
 bool orientNormals( const PointCloud& pointCloud, VertNormals& normals, float radius, const ProgressCallback & progress )
 {
+    if ( auto graph = findCachedNeighborhoodGraph( pointCloud, { .radius = radius } ) )
+    {
+        return orientNormalsCore( pointCloud, normals,
+            [&, radiusSq = sqr( radius )]( VertId base, auto callback )
+            {
+                graph->forEachNeighborWithin( pointCloud.points, base, radiusSq, callback );
+            }, progress );
+    }
+
     return orientNormalsCore( pointCloud, normals,
         [&, radiusSq = sqr( radius )]( VertId base, auto callback )
         {
@@ -209,6 +236,16 @@ bool orientNormals( const PointCloud& pointCloud, VertNormals& normals, const Bu
         }, progress );
 }
 
+bool orientNormals( const PointCloud& pointCloud, VertNormals& normals, const PointNeighborhoodGraph & graph,
+    const ProgressCallback & progress )
+{
+    return orientNormalsCore( pointCloud, normals,
+        [&]( VertId base, auto callback )
+        {
+            graph.forEachNeighbor( base, callback );
+        }, progress );
+}
+
 bool orientNormals( const PointCloud& pointCloud, VertNormals& normals, const AllLocalTriangulations& triangs,
      const ProgressCallback & progress )
 {
@@ -8,7 +8,7 @@ namespace MR
 {
 
 /// \brief Makes normals for valid points of given point cloud by directing them along the normal of best plane through the neighbours
-/// \param radius of neighborhood to consider
+/// \param radius of neighborhood to consider; the neighbours are taken from the graph cached in the cloud if it covers this radius
 /// \param orient OrientNormals::Smart here means orientation from best fit plane
 /// \return nullopt if progress returned false
 /// \ingroup PointCloudGroup
@@ -32,7 +32,7 @@ namespace MR
     const Buffer<VertId> & closeVerts, int numNei, const ProgressCallback & progress = {}, OrientNormals orient = OrientNormals::Smart );
 
 /// \brief Select orientation of given normals to make directions of close points consistent;
-/// \param radius of neighborhood to consider
+/// \param radius of neighborhood to consider; the neighbours are taken from the graph cached in the cloud if it covers this radius
 /// \return false if progress returned false
 /// \ingroup PointCloudGroup
 MRMESH_API bool orientNormals( const PointCloud& pointCloud, VertNormals& normals, float radius,
@@ -48,6 +48,14 @@ MRMESH_API bool orientNormals( const PointCloud& pointCloud, VertNormals& normal
 MRMESH_API bool orientNormals( const PointCloud& pointCloud, VertNormals& normals, const AllLocalTriangulations& triangs,
     const ProgressCallback & progress = {} );
 
+/// \brief Makes normals for valid points of given point cloud by directing them along the normal of best plane through the neighbours
+/// \param graph the neighbours of each point
+/// \param orient OrientNormals::Smart here means orientation from best fit plane
+/// \return nullopt if progress returned false
+/// \ingroup PointCloudGroup
+[[nodiscard]] MRMESH_API std::optional<VertNormals> makeUnorientedNormals( const PointCloud& pointCloud,
+    const PointNeighborhoodGraph & graph, const ProgressCallback & progress = {}, OrientNormals orient = OrientNormals::Smart );
+
 /// \brief Select orientation of given normals to make directions of close points consistent;
 /// \param closeVerts a buffer where for every valid point #i its neighbours are stored at indices [i*numNei; (i+1)*numNei)
 /// \return false if progress returned false
@@ -55,6 +63,13 @@ MRMESH_API bool orientNormals( const PointCloud& pointCloud, VertNormals& normal
 MRMESH_API bool orientNormals( const PointCloud& pointCloud, VertNormals& normals, const Buffer<VertId> & closeVerts, int numNei,
     const ProgressCallback & progress = {} );
 
+/// \brief Select orientation of given normals to make directions of close points consistent;
+/// \param graph the neighbours of each point
+/// \return false if progress returned false
+/// \ingroup PointCloudGroup
+MRMESH_API bool orientNormals( const PointCloud& pointCloud, VertNormals& normals, const PointNeighborhoodGraph & graph,
+    const ProgressCallback & progress = {} );
+
 /// \brief Makes normals for valid points of given point cloud; directions of close points are selected to be consistent;
 /// \param radius of neighborhood to consider
 /// \return nullopt if progress returned false
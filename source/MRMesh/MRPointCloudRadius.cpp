@@ -6,17 +6,19 @@
 #include "MRParallelFor.h"
 #include "MRPointsProject.h"
 #include "MRFewSmallest.h"
+#include "MRPointNeighborhoodGraph.h"
 #include "MRTimer.h"
 #include <numeric>
 
 namespace MR
 {
 
-float findAvgPointsRadius( const PointCloud& pointCloud, int avgPoints, int samples )
+namespace
 {
-    MR_TIMER;
 
-    assert( avgPoints > 0 );
+/// selects given number of valid points uniformly distributed among all of them
+std::vector<VertId> selectSamples( const PointCloud& pointCloud, int samples )
+{
     assert( samples > 0 );
     const auto totalPoints = (int)pointCloud.validPoints.count();
     std::vector<VertId> sampleIds;
@@ -31,6 +33,20 @@ float findAvgPointsRadius( const PointCloud& pointCloud, int avgPoints, int samp
         }
         s += samples;
     }
+    return sampleIds;
+}
+
+} //anonymous namespace
+
+float findAvgPointsRadius( const PointCloud& pointCloud, int avgPoints, int samples )
+{
+    MR_TIMER;
+
+    assert( avgPoints > 0 );
+    if ( auto graph = findCachedNeighborhoodGraph( pointCloud, { .numNei = avgPoints } ) )
+        return findAvgPointsRadius( pointCloud, *graph, samples );
+
+    const auto sampleIds = selectSamples( pointCloud, samples );
     if ( sampleIds.empty() )
         return 0;
 
@@ -54,6 +70,30 @@ float findAvgPointsRadius( const PointCloud& pointCloud, int avgPoints, int samp
     return std::accumulate( radia.begin(), radia.end(), 0.0f ) / radia.size();
 }
 
+float findAvgPointsRadius( const PointCloud& pointCloud, const PointNeighborhoodGraph& graph, int samples )
+{
+    MR_TIMER;
+
+    assert( graph.settings.numNei > 0 );
+    const auto sampleIds = selectSamples( pointCloud, samples );
+    if ( sampleIds.empty() )
+        return 0;
+
+    std::vector<float> radia( sampleIds.size() );
+    ParallelFor( sampleIds, [&]( size_t i )
+    {
+        const VertId v = sampleIds[i];
+        float maxDistSq = 0;
+        graph.forEachNeighbor( v, [&]( VertId u )
+        {
+            maxDistSq = std::max( maxDistSq, ( pointCloud.points[u] - pointCloud.points[v] ).lengthSq() );
+        } );
+        radia[i] = std::sqrt( maxDistSq );
+    } );
+
+    return std::accumulate( radia.begin(), radia.end(), 0.0f ) / radia.size();
+}
+
 bool dilateRegion( const PointCloud& pointCloud, VertBitSet& region, float dilation, ProgressCallback cb, const AffineXf3f* xf )
 {
     auto regionCopy = region;
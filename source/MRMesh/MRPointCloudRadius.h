@@ -7,9 +7,16 @@ struct PointCloud;
 
 /// \brief Finds the radius of ball, so on average that ball contained avgPoints excluding the central point
 /// \param samples the number of test points to find given number of samples in each
+/// \details the neighbours are taken from the graph cached in the cloud if it was built for avgPoints neighbours
 /// \ingroup PointCloudGroup
 MRMESH_API float findAvgPointsRadius( const PointCloud& pointCloud, int avgPoints, int samples = 1024 );
 
+/// \brief Finds the radius of ball, so on average that ball contained the number of neighbours from given graph
+/// \param graph the graph built for some number of closest neighbours of each point
+/// \param samples the number of test points
+/// \ingroup PointCloudGroup
+MRMESH_API float findAvgPointsRadius( const PointCloud& pointCloud, const PointNeighborhoodGraph& graph, int samples = 1024 );
+
 /// expands the region on given euclidian distance. returns false if callback also returns false
 MRMESH_API bool dilateRegion( const PointCloud& pointCloud, VertBitSet& region, float dilation, ProgressCallback cb = {}, const AffineXf3f* xf = nullptr );
 /// shrinks the region on given euclidian distance. returns false if callback also returns false
@@ -19,7 +19,12 @@
 #include "MRLocalTriangulations.h"
 #include "MRMeshFixer.h"
 #include "MREdgePaths.h"
+#include "MRMakeSphereMesh.h"
+#include "MRMeshNormals.h"
+#include "MRGTest.h"
 #include <parallel_hashmap/phmap.h>
+#include <algorithm>
+#include <cstdint>
 
 namespace MR
 {
@@ -32,6 +37,9 @@ public:
     std::optional<Mesh> triangulate( ProgressCallback progressCb );
 
 private:
+    /// triangulates the cloud by independent spatial blocks, each together with the band of points around it
+    std::optional<Mesh> triangulateByBlocks_( ProgressCallback progressCb );
+
     /// constructs mesh from given triangles
     std::optional<Mesh> makeMesh_( Triangulation && t3, Triangulation && t2, ProgressCallback progressCb );
 
@@ -51,6 +59,10 @@ std::optional<Mesh> PointCloudTriangulator::triangulate( ProgressCallback progre
     assert( ( params_.numNeighbours <= 0 && params_.radius > 0 )
          || ( params_.numNeighbours > 0 && params_.radius <= 0 ) );
 
+    // without normals, the orientation of local triangulations requires the whole cloud, so blockSize is ignored (as documented)
+    if ( params_.blockSize > 0 && pointCloud_.hasNormals() )
+        return triangulateByBlocks_( progressCb );
+
     auto optLocalTriangulations = TriangulationHelpers::buildUnitedLocalTriangulations( pointCloud_,
         {
             .radius = params_.radius,
@@ -59,7 +71,8 @@ std::optional<Mesh> PointCloudTriangulator::triangulate( ProgressCallback progre
             .boundaryAngle = params_.boundaryAngle,
             .trustedNormals = pointCloud_.hasNormals() ? &pointCloud_.normals : nullptr,
             .automaticRadiusIncrease = params_.automaticRadiusIncrease,
-            .searchNeighbors = params_.searchNeighbors
+            .searchNeighbors = params_.searchNeighbors,
+            .neighborhoodGraph = params_.neighborhoodGraph
         }, subprogress( progressCb, 0.0f, pointCloud_.hasNormals() ? 0.4f : 0.3f ) );
     if ( !optLocalTriangulations )
         return {};
@@ -74,6 +87,148 @@ std::optional<Mesh> PointCloudTriangulator::triangulate( ProgressCallback progre
     return makeMesh_( std::move( t3 ), std::move( t2 ), subprogress( progressCb, 0.5f, 1.0f ) );
 }
 
+std::optional<Mesh> PointCloudTriangulator::triangulateByBlocks_( ProgressCallback progressCb )
+{
+    MR_TIMER;
+    assert( params_.blockSize > 0 && pointCloud_.hasNormals() );
+
+    const auto box = pointCloud_.computeBoundingBox();
+    if ( !box.valid() )
+        return makeMesh_( {}, {}, progressCb );
+
+    // distribute valid points among the blocks of regular grid
+    const float blockSize = params_.blockSize;
+    Vector3i dims;
+    for ( int i = 0; i < 3; ++i )
+        dims[i] = std::max( 1, (int)std::ceil( box.size()[i] / blockSize ) );
+    auto blockCoord = [&]( const Vector3f & p )
+    {
+        Vector3i res;
+        for ( int i = 0; i < 3; ++i )
+            res[i] = std::clamp( (int)std::floor( ( p[i] - box.min[i] ) / blockSize ), 0, dims[i] - 1 );
+        return res;
+    };
+    auto blockIndex = [&]( const Vector3i & c ) { return ( size_t( c.z ) * dims.y + c.y ) * dims.x + c.x; };
+    const size_t numBlocks = size_t( dims.x ) * dims.y * dims.z;
+
+    Vector<size_t, VertId> blockOfPoint( pointCloud_.points.size(), SIZE_MAX );
+    BitSetParallelFor( pointCloud_.validPoints, [&]( VertId v )
+    {
+        blockOfPoint[v] = blockIndex( blockCoord( pointCloud_.points[v] ) );
+    } );
+    // the points of i-th block are blockPoints[firstBlockPoint[i]], ..., blockPoints[firstBlockPoint[i+1]-1]
+    std::vector<size_t> firstBlockPoint( numBlocks + 1, 0 );
+    for ( auto v : pointCloud_.validPoints )
+        ++firstBlockPoint[blockOfPoint[v] + 1];
+    for ( size_t i = 0; i < numBlocks; ++i )
+        firstBlockPoint[i + 1] += firstBlockPoint[i];
+    std::vector<VertId> blockPoints( firstBlockPoint.back() );
+    {
+        auto pos = firstBlockPoint;
+        for ( auto v : pointCloud_.validPoints )
+            blockPoints[pos[blockOfPoint[v]]++] = v;
+    }
+    if ( !reportProgress( progressCb, 0.05f ) )
+        return {};
+
+    // each triangle is taken from the block containing its vertex with minimal id,
+    // where it is found in the same local triangulations as in the whole cloud if the overlap is enough
+    std::vector<Triangulation> blockT3( numBlocks ), blockT2( numBlocks );
+    if ( !ParallelFor( size_t( 0 ), numBlocks, [&]( size_t b )
+    {
+        const auto firstPoint = firstBlockPoint[b];
+        const auto lastPoint = firstBlockPoint[b + 1];
+        if ( firstPoint == lastPoint )
+            return;
+
+        const Vector3i c( int( b % dims.x ), int( b / dims.x % dims.y ), int( b / ( size_t( dims.x ) * dims.y ) ) );
+        const Box3f blockBox( box.min + Vector3f( c ) * blockSize, box.min + Vector3f( c + Vector3i::diagonal( 1 ) ) * blockSize );
+
+        float overlap = params_.blockOverlap;
+        if ( overlap <= 0 )
+        {
+            float searchRadius = params_.radius;
+            if ( searchRadius <= 0 )
+            {
+                // the distance to neighbours is estimated on the points of this block only with a margin for nonuniform density
+                PointCloud blockCloud;
+                blockCloud.points.reserve( lastPoint - firstPoint );
+                for ( auto i = firstPoint; i < lastPoint; ++i )
+                    blockCloud.points.push_back( pointCloud_.points[blockPoints[i]] );
+                blockCloud.validPoints.resize( blockCloud.points.size(), true );
+                searchRadius = 2 * findAvgPointsRadius( blockCloud, params_.numNeighbours );
+            }
+            overlap = params_.automaticRadiusIncrease ? 2 * searchRadius : searchRadius;
+        }
+
+        // the local triangulations are built for the points within the overlap from the block,
+        // and they need all neighbours within the overlap from those points
+        const auto expandedBox = blockBox.expanded( Vector3f::diagonal( 2 * overlap ) );
+        const auto cMin = blockCoord( expandedBox.min );
+        const auto cMax = blockCoord( expandedBox.max );
+        std::vector<VertId> ids;
+        for ( int z = cMin.z; z <= cMax.z; ++z )
+            for ( int y = cMin.y; y <= cMax.y; ++y )
+                for ( int x = cMin.x; x <= cMax.x; ++x )
+                {
+                    const auto nb = blockIndex( { x, y, z } );
+                    for ( auto i = firstBlockPoint[nb]; i < firstBlockPoint[nb + 1]; ++i )
+                        if ( expandedBox.contains( pointCloud_.points[blockPoints[i]] ) )
+                            ids.push_back( blockPoints[i] );
+                }
+        // keep the order of points as in whole cloud to get the same triangles
+        std::sort( ids.begin(), ids.end() );
+
+        PointCloud subCloud;
+        subCloud.points.resizeNoInit( ids.size() );
+        subCloud.normals.resizeNoInit( ids.size() );
+        for ( VertId i( 0 ); i < ids.size(); ++i )
+        {
+            subCloud.points[i] = pointCloud_.points[ids[i]];
+            subCloud.normals[i] = pointCloud_.normals[ids[i]];
+        }
+        subCloud.validPoints.resize( ids.size(), true );
+
+        const auto optLocalTriangulations = TriangulationHelpers::buildUnitedLocalTriangulations( subCloud,
+            {
+                .radius = params_.radius,
+                .numNeis = params_.numNeighbours,
+                .critAngle = params_.critAngle,
+                .boundaryAngle = params_.boundaryAngle,
+                .trustedNormals = &subCloud.normals,
+                .automaticRadiusIncrease = params_.automaticRadiusIncrease
+            } );
+        if ( !optLocalTriangulations )
+            return;
+
+        Triangulation t3, t2;
+        findRepeatedOrientedTriangles( *optLocalTriangulations, &t3, &t2 );
+        auto takeOwned = [&]( const Triangulation & from, Triangulation & to )
+        {
+            for ( const auto & t : from )
+            {
+                const ThreeVertIds globalTri{ ids[t[0]], ids[t[1]], ids[t[2]] };
+                if ( blockOfPoint[std::min( { globalTri[0], globalTri[1], globalTri[2] } )] == b )
+                    to.push_back( globalTri );
+            }
+        };
+        takeOwned( t3, blockT3[b] );
+        takeOwned( t2, blockT2[b] );
+    }, subprogress( progressCb, 0.05f, 0.5f ), 1 ) )
+        return {};
+
+    Triangulation t3, t2;
+    for ( size_t b = 0; b < numBlocks; ++b )
+    {
+        t3.vec_.insert( t3.vec_.end(), blockT3[b].vec_.begin(), blockT3[b].vec_.end() );
+        blockT3[b] = {};
+        t2.vec_.insert( t2.vec_.end(), blockT2[b].vec_.begin(), blockT2[b].vec_.end() );
+        blockT2[b] = {};
+    }
+
+    return makeMesh_( std::move( t3 ), std::move( t2 ), subprogress( progressCb, 0.5f, 1.0f ) );
+}
+
 std::optional<Mesh> PointCloudTriangulator::makeMesh_( Triangulation && t3, Triangulation && t2, ProgressCallback progressCb )
 {
     MR_TIMER;
@@ -118,7 +273,7 @@ std::optional<Mesh> PointCloudTriangulator::makeMesh_( Triangulation && t3, Tria
     // fill small holes
     const auto maxHolePerimeterToFill = params_.critHoleLength >= 0.0f ?
         params_.critHoleLength :
-        pointCloud_.getBoundingBox().diagonal() * 0.1f;
+        pointCloud_.computeBoundingBox().diagonal() * 0.1f;
     auto boundaries = findRightBoundary( mesh.topology );
     // setup parameters to prevent any appearance of multiple edges during hole filling
     FillHoleParams fillHoleParams;
@@ -147,4 +302,27 @@ std::optional<Mesh> triangulatePointCloud( const PointCloud& pointCloud, const T
     return triangulator.triangulate( progressCb );
 }
 
+TEST( MRMesh, TriangulatePointCloudByBlocks )
+{
+    const auto sphere = makeSphere( { .radius = 1.0f, .numMeshVertices = 3000 } );
+    PointCloud pc;
+    pc.points = sphere.points;
+    pc.normals = computePerVertNormals( sphere );
+    pc.validPoints = sphere.topology.getValidVerts();
+
+    const TriangulationParameters params{ .numNeighbours = 0, .radius = 0.1f };
+    const auto whole = triangulatePointCloud( pc, params );
+    ASSERT_TRUE( whole.has_value() );
+
+    auto blockParams = params;
+    blockParams.blockSize = 0.4f;
+    const auto blocks = triangulatePointCloud( pc, blockParams );
+    ASSERT_TRUE( blocks.has_value() );
+
+    // with sufficient overlap each block finds exactly the same triangles as whole cloud triangulation
+    EXPECT_EQ( blocks->topology.numValidFaces(), whole->topology.numValidFaces() );
+    EXPECT_EQ( blocks->topology.numValidVerts(), whole->topology.numValidVerts() );
+    EXPECT_EQ( blocks->topology.findNumHoles(), whole->topology.findNumHoles() );
+}
+
 } //namespace MR
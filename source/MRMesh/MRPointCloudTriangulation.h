@@ -69,6 +69,28 @@ struct TriangulationParameters
 
     /// optional: if provided this cloud will be used for searching of neighbors (so it must have same validPoints)
     const PointCloud * searchNeighbors = nullptr;
+
+    /// optional: precomputed neighbours of all points (in the cloud used for searching), which replace initial search of neighbours
+    /// if the graph covers the radius or has the same number of neighbours;
+    /// if not provided then the graph cached in the cloud used for searching is taken if it fits
+    const PointNeighborhoodGraph * neighborhoodGraph = nullptr;
+
+    /**
+     * \brief If positive then the cloud is subdivided on cubic blocks of this size, which are triangulated independently and in parallel,
+     * each together with the points in the band around it; this bounds the memory used for local triangulations
+     * \note Block-wise triangulation requires the normals in the cloud, since independent blocks cannot orient local triangulations consistently;
+     * if the cloud has no normals then this parameter is ignored and the whole cloud is triangulated at once as if blockSize = 0,
+     * so compute the normals beforehand (e.g. by makeOrientedNormals) to bound the memory;
+     * block-wise triangulation does not use searchNeighbors and neighborhoodGraph
+     */
+    float blockSize = 0;
+
+    /**
+     * The width of the band around each block with the points, which local triangulations are built for the triangles of the block;
+     * it must exceed the distance to the farthest neighbour of any point (after automatic radius increase);
+     * if not positive then it is selected automatically from radius or from the average distance to numNeighbours points in each block
+     */
+    float blockOverlap = 0;
 };
 
 /**
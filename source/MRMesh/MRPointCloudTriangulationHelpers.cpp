@@ -10,6 +10,7 @@
 #include "MRTimer.h"
 #include "MRBitSetParallelFor.h"
 #include "MRLocalTriangulations.h"
+#include "MRPointNeighborhoodGraph.h"
 #include <algorithm>
 #include <numeric>
 #include <limits>
@@ -494,7 +495,26 @@ void buildLocalTriangulation( const PointCloud& cloud, VertId v, const Settings
 
     const auto & searchCloud = settings.searchNeighbors ? *settings.searchNeighbors : cloud;
 
-    if ( settings.radius > 0 )
+    const auto * graph = settings.neighborhoodGraph;
+    if ( graph && graph->covers( { .radius = settings.radius, .numNei = settings.numNeis } ) )
+    {
+        fanData.neighbors.clear();
+        if ( settings.radius > 0 )
+        {
+            graph->forEachNeighborWithin( searchCloud.points, v, sqr( settings.radius ), [&]( VertId u ) { fanData.neighbors.push_back( u ); } );
+        }
+        else
+        {
+            float maxDistSq = 0;
+            graph->forEachNeighbor( v, [&]( VertId u )
+            {
+                fanData.neighbors.push_back( u );
+                maxDistSq = std::max( maxDistSq, ( searchCloud.points[u] - searchCloud.points[v] ).lengthSq() );
+            } );
+            actualRadius = std::sqrt( maxDistSq );
+        }
+    }
+    else if ( settings.radius > 0 )
         findNeighborsInBall( searchCloud, v, actualRadius, fanData.neighbors );
     else
         actualRadius = std::sqrt( findNumNeighbors( searchCloud, v, settings.numNeis, fanData.neighbors, fanData.nearesetPoints ) );
@@ -542,10 +562,23 @@ std::optional<std::vector<SomeLocalTriangulations>> buildLocalTriangulations(
     MR_TIMER;
 
     // construct tree before parallel region
-    if ( settings.searchNeighbors )
-        settings.searchNeighbors->getAABBTree();
-    else
-        cloud.getAABBTree();
+    const auto & searchCloud = settings.searchNeighbors ? *settings.searchNeighbors : cloud;
+    searchCloud.getAABBTree();
+
+    // take the neighbours of points from the graph cached in the cloud if it was not given
+    std::shared_ptr<const PointNeighborhoodGraph> cachedGraph;
+    Settings graphSettings;
+    const Settings * pSettings = &settings;
+    if ( !settings.neighborhoodGraph )
+    {
+        cachedGraph = findCachedNeighborhoodGraph( searchCloud, { .radius = settings.radius, .numNei = settings.numNeis } );
+        if ( cachedGraph )
+        {
+            graphSettings = settings;
+            graphSettings.neighborhoodGraph = cachedGraph.get();
+            pSettings = &graphSettings;
+        }
+    }
 
     struct PerThreadData : SomeLocalTriangulations
     {
@@ -557,7 +590,7 @@ std::optional<std::vector<SomeLocalTriangulations>> buildLocalTriangulations(
     {
         auto& localData = threadData.local();
         auto& disc = localData.fanData;
-        TriangulationHelpers::buildLocalTriangulation( cloud, v, settings, disc );
+        TriangulationHelpers::buildLocalTriangulation( cloud, v, *pSettings, disc );
 
         localData.fanRecords.push_back( { v, disc.border, (std::uint32_t)localData.neighbors.size() } );
         localData.neighbors.insert( localData.neighbors.end(), disc.neighbors.begin(), disc.neighbors.end() );
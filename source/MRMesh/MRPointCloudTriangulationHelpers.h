@@ -133,6 +133,11 @@ struct Settings
 
     /// optional: if provided this cloud will be used for searching of neighbors (so it must have same validPoints)
     const PointCloud * searchNeighbors = nullptr;
+
+    /// optional: precomputed neighbours of all points (in the cloud used for searching), which replace initial search of neighbours
+    /// if the graph covers the radius or has the same number of neighbours;
+    /// if not provided then the graph cached in the cloud used for searching can be taken by buildLocalTriangulations
+    const PointNeighborhoodGraph * neighborhoodGraph = nullptr;
 };
 
 /// constructs local triangulation around given point
@@ -0,0 +1,195 @@
+#include "MRPointNeighborhoodGraph.h"
+#include "MRPointCloud.h"
+#include "MRPointsInBall.h"
+#include "MRPointsProject.h"
+#include "MRBuffer.h"
+#include "MRBitSet.h"
+#include "MRParallelFor.h"
+#include "MRTimer.h"
+#include "MRGTest.h"
+
+namespace MR
+{
+
+namespace
+{
+
+/// the number of consecutive points, which neighbours are collected together by one task
+constexpr size_t cChunkSize = 1024;
+
+/// converts the numbers of neighbours stored in firstNei[v+1] into the positions of first neighbours;
+/// returns the total number of neighbours
+size_t countsToPositions( Vector<size_t, VertId> & firstNei )
+{
+    assert( !firstNei.empty() );
+    firstNei.front() = 0;
+    for ( VertId v = 0_v; v + 1 < firstNei.size(); ++v )
+        firstNei[v + 1] += firstNei[v];
+    return firstNei.back();
+}
+
+} //anonymous namespace
+
+std::optional<PointNeighborhoodGraph> buildPointNeighborhoodGraph( const PointCloud& pointCloud,
+    const PointNeighborhoodSettings& settings, const ProgressCallback& progress )
+{
+    MR_TIMER;
+    assert( ( settings.radius > 0 && settings.numNei == 0 )
+         || ( settings.radius == 0 && settings.numNei > 0 ) );
+
+    if ( settings.numNei > 0 )
+    {
+        const auto closeVerts = findNClosestPointsPerPoint( pointCloud, settings.numNei, subprogress( progress, 0.0f, 0.9f ) );
+        if ( closeVerts.size() != pointCloud.points.size() * settings.numNei )
+            return {}; // canceled
+        auto res = makePointNeighborhoodGraph( pointCloud, closeVerts, settings.numNei );
+        if ( !reportProgress( progress, 1.0f ) )
+            return {};
+        return res;
+    }
+
+    PointNeighborhoodGraph res;
+    res.settings = settings;
+    const auto numPoints = pointCloud.points.size();
+    res.firstNei.resize( numPoints + 1 );
+
+    pointCloud.getAABBTree(); // construct tree before parallel region
+
+    // the neighbours of each chunk of points are collected separately, and then copied in the common array
+    const size_t numChunks = ( numPoints + cChunkSize - 1 ) / cChunkSize;
+    std::vector<std::vector<VertId>> chunkNeis( numChunks );
+    if ( !ParallelFor( size_t( 0 ), numChunks, [&, radiusSq = sqr( settings.radius )]( size_t c )
+    {
+        auto & neis = chunkNeis[c];
+        const VertId vEnd( std::min( numPoints, ( c + 1 ) * cChunkSize ) );
+        for ( VertId v( c * cChunkSize ); v < vEnd; ++v )
+        {
+            if ( !contains( pointCloud.validPoints, v ) )
+                continue;
+            const auto sz = neis.size();
+            findPointsInBall( pointCloud, { pointCloud.points[v], radiusSq }, [&]( const PointsProjectionResult & found, const Vector3f &, Ball3f & )
+            {
+                if ( found.vId != v )
+                    neis.push_back( found.vId );
+                return Processing::Continue;
+            } );
+            res.firstNei[v + 1] = neis.size() - sz;
+        }
+    }, subprogress( progress, 0.0f, 0.8f ) ) )
+        return {};
+
+    res.neighbors.resize( countsToPositions( res.firstNei ) );
+    if ( !ParallelFor( size_t( 0 ), numChunks, [&]( size_t c )
+    {
+        auto & neis = chunkNeis[c];
+        std::copy( neis.begin(), neis.end(), res.neighbors.begin() + res.firstNei[VertId( c * cChunkSize )] );
+        neis = {};
+    }, subprogress( progress, 0.8f, 1.0f ) ) )
+        return {};
+
+    return res;
+}
+
+PointNeighborhoodGraph makePointNeighborhoodGraph( const PointCloud& pointCloud, const Buffer<VertId>& closeVerts, int numNei )
+{
+    MR_TIMER;
+    assert( numNei > 0 );
+    assert( closeVerts.size() == pointCloud.points.size() * numNei );
+
+    PointNeighborhoodGraph res;
+    res.settings.numNei = numNei;
+    res.firstNei.resize( pointCloud.points.size() + 1 );
+
+    ParallelFor( pointCloud.points, [&]( VertId v )
+    {
+        if ( !contains( pointCloud.validPoints, v ) )
+            return;
+        const VertId * p = closeVerts.data() + ( (size_t)v * numNei );
+        const VertId * pEnd = p + numNei;
+        size_t count = 0;
+        for ( ; p < pEnd && *p; ++p )
+            ++count;
+        res.firstNei[v + 1] = count;
+    } );
+
+    res.neighbors.resize( countsToPositions( res.firstNei ) );
+    ParallelFor( pointCloud.points, [&]( VertId v )
+    {
+        const VertId * p = closeVerts.data() + ( (size_t)v * numNei );
+        std::copy( p, p + res.numNeighbors( v ), res.neighbors.begin() + res.firstNei[v] );
+    } );
+
+    return res;
+}
+
+std::shared_ptr<const PointNeighborhoodGraph> findCachedNeighborhoodGraph( const PointCloud& pointCloud,
+    const PointNeighborhoodSettings& settings )
+{
+    auto res = pointCloud.getNeighborhoodGraphNotCreate();
+    if ( res && res->numPoints() == pointCloud.points.size() && res->covers( settings ) )
+        return res;
+    return {};
+}
+
+TEST( MRMesh, PointNeighborhoodGraph )
+{
+    // points in the nodes of a planar grid with unit step
+    constexpr int cSide = 40;
+    PointCloud pc;
+    for ( int y = 0; y < cSide; ++y )
+        for ( int x = 0; x < cSide; ++x )
+            pc.addPoint( Vector3f( float( x ), float( y ), 0.0f ) );
+    pc.validPoints.reset( 0_v ); // one invalid point in the corner
+
+    auto byRadius = buildPointNeighborhoodGraph( pc, { .radius = 1.01f } );
+    ASSERT_TRUE( byRadius.has_value() );
+    EXPECT_EQ( byRadius->numPoints(), pc.points.size() );
+    EXPECT_EQ( byRadius->numNeighbors( 0_v ), 0 );
+    EXPECT_EQ( byRadius->numNeighbors( 1_v ), 2 ); // on the border near invalid point
+    EXPECT_EQ( byRadius->numNeighbors( VertId( cSide + 1 ) ), 3 );
+    EXPECT_EQ( byRadius->numNeighbors( VertId( 2 * cSide + 2 ) ), 4 );
+    EXPECT_TRUE( byRadius->coversRadius( 1.0f ) );
+    EXPECT_FALSE( byRadius->coversRadius( 2.0f ) );
+    for ( auto v : pc.validPoints )
+    {
+        size_t count = 0;
+        findPointsInBall( pc, { pc.points[v], sqr( 1.01f ) }, [&]( const PointsProjectionResult & found, const Vector3f &, Ball3f & )
+        {
+            if ( found.vId != v )
+                ++count;
+            return Processing::Continue;
+        } );
+        EXPECT_EQ( byRadius->numNeighbors( v ), count );
+        byRadius->forEachNeighbor( v, [&]( VertId u )
+        {
+            EXPECT_TRUE( pc.validPoints.test( u ) );
+            EXPECT_LE( ( pc.points[u] - pc.points[v] ).length(), 1.01f );
+        } );
+    }
+
+    auto byNum = buildPointNeighborhoodGraph( pc, { .numNei = 6 } );
+    ASSERT_TRUE( byNum.has_value() );
+    EXPECT_EQ( byNum->neighbors.size(), 6 * pc.validPoints.count() );
+    EXPECT_GT( byNum->heapBytes(), 0 );
+
+    // the graph is cached in the cloud for the last requested settings
+    auto cached = pc.getNeighborhoodGraph( { .radius = 1.01f } );
+    EXPECT_EQ( cached, pc.getNeighborhoodGraphNotCreate() );
+    EXPECT_EQ( cached, pc.getNeighborhoodGraph( { .radius = 1.01f } ) );
+    EXPECT_EQ( cached->neighbors.size(), byRadius->neighbors.size() );
+    EXPECT_EQ( findCachedNeighborhoodGraph( pc, { .radius = 1.0f } ), cached );
+    EXPECT_FALSE( findCachedNeighborhoodGraph( pc, { .radius = 2.0f } ) );
+    EXPECT_FALSE( findCachedNeighborhoodGraph( pc, { .numNei = 6 } ) );
+    auto another = pc.getNeighborhoodGraph( { .numNei = 6 } );
+    EXPECT_EQ( another, pc.getNeighborhoodGraphNotCreate() );
+    EXPECT_EQ( another, pc.getNeighborhoodGraph( { .numNei = 6 } ) );
+    EXPECT_EQ( another->neighbors.size(), byNum->neighbors.size() );
+    EXPECT_EQ( findCachedNeighborhoodGraph( pc, { .numNei = 6 } ), another );
+    EXPECT_FALSE( findCachedNeighborhoodGraph( pc, { .radius = 1.0f } ) );
+    // previously returned graph remains valid
+    EXPECT_EQ( cached->neighbors.size(), byRadius->neighbors.size() );
+    pc.invalidateCaches();
+    EXPECT_FALSE( pc.getNeighborhoodGraphNotCreate() );
+}
+
+} //namespace MR
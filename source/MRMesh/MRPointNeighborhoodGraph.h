@@ -0,0 +1,104 @@
+#pragma once
+
+#include "MRMeshFwd.h"
+#include "MRId.h"
+#include "MRVector.h"
+#include "MRVector3.h"
+#include "MRHeapBytes.h"
+#include "MRProgressCallback.h"
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace MR
+{
+
+/// \addtogroup PointCloudGroup
+/// \{
+
+/// the rule of neighbours selection for each point of a cloud
+struct PointNeighborhoodSettings
+{
+    /// if positive then all valid points within this distance from a point are its neighbours;
+    /// if radius is positive then numNei must be zero
+    float radius = 0;
+
+    /// if positive then this number of closest valid points are the neighbours of a point;
+    /// if numNei is positive then radius must be zero
+    int numNei = 0;
+
+    bool operator==( const PointNeighborhoodSettings& rhs ) const = default;
+};
+
+/// the neighbours of all points of a cloud stored in compressed sparse row layout:
+/// the neighbours of point v (excluding v itself) are neighbors[firstNei[v]], ..., neighbors[firstNei[v+1]-1]
+struct PointNeighborhoodGraph
+{
+    /// the settings the graph was built with
+    PointNeighborhoodSettings settings;
+
+    /// the position of the first neighbour of each point in (neighbors) with one extra element in the end;
+    /// invalid points have no neighbours
+    Vector<size_t, VertId> firstNei;
+
+    /// the neighbours of all points one after another
+    std::vector<VertId> neighbors;
+
+    /// the number of points in the cloud the graph was built for
+    [[nodiscard]] size_t numPoints() const { return firstNei.empty() ? 0 : firstNei.size() - 1; }
+
+    /// returns the number of neighbours of given point
+    [[nodiscard]] size_t numNeighbors( VertId v ) const { return firstNei[v + 1] - firstNei[v]; }
+
+    /// the pointer to the first neighbour of given point
+    [[nodiscard]] const VertId * neiBegin( VertId v ) const { return neighbors.data() + firstNei[v]; }
+
+    /// the pointer after the last neighbour of given point
+    [[nodiscard]] const VertId * neiEnd( VertId v ) const { return neighbors.data() + firstNei[v + 1]; }
+
+    /// calls given function for each neighbour of given point
+    template<typename F>
+    void forEachNeighbor( VertId v, F && f ) const
+    {
+        for ( auto p = neiBegin( v ), pEnd = neiEnd( v ); p < pEnd; ++p )
+            f( *p );
+    }
+
+    /// calls given function for each neighbour of given point located within given squared distance from it
+    template<typename F>
+    void forEachNeighborWithin( const VertCoords & points, VertId v, float radiusSq, F && f ) const
+    {
+        for ( auto p = neiBegin( v ), pEnd = neiEnd( v ); p < pEnd; ++p )
+            if ( ( points[*p] - points[v] ).lengthSq() <= radiusSq )
+                f( *p );
+    }
+
+    /// returns true if the graph contains all points within given radius around each point
+    [[nodiscard]] bool coversRadius( float radius ) const { return settings.radius > 0 && settings.radius >= radius; }
+
+    /// returns true if the graph can be used instead of the search of neighbours with given settings:
+    /// it was built either for the same number of neighbours or for not smaller radius
+    [[nodiscard]] bool covers( const PointNeighborhoodSettings & s ) const
+        { return s.radius > 0 ? coversRadius( s.radius ) : settings.numNei == s.numNei; }
+
+    /// returns the amount of memory this object occupies on heap
+    [[nodiscard]] size_t heapBytes() const { return MR::heapBytes( firstNei ) + MR::heapBytes( neighbors ); }
+};
+
+/// finds the neighbours of all valid points in the cloud according to given settings in parallel;
+/// returns std::nullopt if the operation was canceled
+[[nodiscard]] MRMESH_API std::optional<PointNeighborhoodGraph> buildPointNeighborhoodGraph( const PointCloud& pointCloud,
+    const PointNeighborhoodSettings& settings, const ProgressCallback& progress = {} );
+
+/// converts the buffer with given number of neighbours per point (found by findNClosestPointsPerPoint)
+/// in the graph, skipping invalid ids in the buffer
+[[nodiscard]] MRMESH_API PointNeighborhoodGraph makePointNeighborhoodGraph( const PointCloud& pointCloud,
+    const Buffer<VertId>& closeVerts, int numNei );
+
+/// returns the graph cached in given point cloud if it covers the search with given settings, otherwise nullptr
+[[nodiscard]] MRMESH_API std::shared_ptr<const PointNeighborhoodGraph> findCachedNeighborhoodGraph( const PointCloud& pointCloud,
+    const PointNeighborhoodSettings& settings );
+
+/// \}
+
+} //namespace MR
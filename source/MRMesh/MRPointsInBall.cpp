@@ -80,13 +80,18 @@ void findPointsInBall( const AABBTreePoints& tree, Ball3f ball,
         if ( node.leaf() )
         {
             auto [first, last] = node.getLeafPointRange();
+            // the distances are computed for all points of the leaf at once, and recomputed only if the callback moves the ball
+            float leafDistSq[AABBTreePoints::MaxNumPointsInLeaf];
+            const auto leafCenter = ball.center;
+            if ( !xf )
+                tree.getDistancesSq( leafCenter, first, last, leafDistSq );
             for ( int i = first; i < last; ++i )
             {
                 auto coord = xf ? ( *xf )( orderedPoints[i].coord ) : orderedPoints[i].coord;
 
                 const PointsProjectionResult candidate
                 {
-                    .distSq = distanceSq( coord, ball.center ),
+                    .distSq = !xf && ball.center == leafCenter ? leafDistSq[i - first] : distanceSq( coord, ball.center ),
                     .vId = orderedPoints[i].id
                 };
                 if ( candidate.distSq <= ball.radiusSq )
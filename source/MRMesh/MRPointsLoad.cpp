@@ -8,11 +8,12 @@
 #include "MRProgressReadWrite.h"
 #include "MRPointCloud.h"
 #include "MRIOParsing.h"
-#include "MRParallelFor.h"
 #include "MRComputeBoundingBox.h"
-#include "MRBitSetParallelFor.h"
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
+#include <sstream>
 
 namespace MR::PointsLoad
 {
@@ -82,37 +83,34 @@ Expected<PointCloud> fromText( std::istream& in, const PointsLoadSettings& setti
         break;
     }
 
-    std::string parseError;
-    tbb::task_group_context ctx;
-    const auto keepGoing = BitSetParallelForAll( cloud.validPoints, [&] ( VertId v )
+    // the chunks of lines are multiples of 64, so the bits of validPoints can be set from parallel threads
+    auto parseRes = parseLinesByChunks( lineCount, [&] ( size_t, size_t firstLine, size_t lastLine ) -> Expected<void>
     {
-        const std::string_view line( buf->data() + newlines[v], newlines[v + 1] - newlines[v + 0] );
-        if ( line.empty() || line.starts_with( '#' ) || line.starts_with( ';' ) )
-            return;
-
-        Vector3d point( noInit );
-        Vector3d normal( noInit );
-        Color color( noInit );
-        auto result = parseTextCoordinate( line, point, hasNormals ? &normal : nullptr, hasColors ? &color : nullptr );
-        if ( !result )
+        for ( auto i = firstLine; i < lastLine; ++i )
         {
-            if ( ctx.cancel_group_execution() )
-                parseError = std::move( result.error() );
-            return;
+            const auto line = getLine( buf->data(), newlines, i );
+            if ( line.empty() || line.starts_with( '#' ) || line.starts_with( ';' ) )
+                continue;
+
+            Vector3d point( noInit );
+            Vector3d normal( noInit );
+            Color color( noInit );
+            auto result = parseTextCoordinate( line, point, hasNormals ? &normal : nullptr, hasColors ? &color : nullptr );
+            if ( !result )
+                return unexpected( std::move( result.error() ) );
+
+            const VertId v( i );
+            cloud.points[v] = Vector3f( settings.outXf ? point - firstPoint : point );
+            cloud.validPoints.set( v, true );
+            if ( hasNormals )
+                cloud.normals[v] = Vector3f( normal );
+            if ( hasColors )
+                ( *settings.colors )[v] = color;
         }
-
-        cloud.points[v] = Vector3f( settings.outXf ? point - firstPoint : point );
-        cloud.validPoints.set( v, true );
-        if ( hasNormals )
-            cloud.normals[v] = Vector3f( normal );
-        if ( hasColors )
-            ( *settings.colors )[v] = color;
+        return {};
     }, subprogress( settings.callback, 0.60f, 1.00f ) );
-
-    if ( !keepGoing )
-        return unexpectedOperationCanceled();
-    if ( !parseError.empty() )
-        return unexpected( std::move( parseError ) );
+    if ( !parseRes )
+        return unexpected( std::move( parseRes.error() ) );
 
     return cloud;
 }
@@ -174,27 +172,25 @@ Expected<MR::PointCloud> fromPts( std::istream& in, const PointsLoadSettings& se
     PointCloud pc;
     pc.points.resize( lineOffsets.size() - firstLine - 1 );
 
-    std::string parseError;
-    tbb::task_group_context ctx;
-    auto keepGoing = ParallelFor( pc.points, [&] ( size_t i )
+    auto parseRes = parseLinesByChunks( pc.points.size(), [&] ( size_t, size_t first, size_t last ) -> Expected<void>
     {
-        std::string_view line( data.data() + lineOffsets[firstLine + i], lineOffsets[firstLine + i + 1] - lineOffsets[firstLine + i] );
-        Vector3d tempDoubleCoord;
-        Color tempColor;
-        auto parseRes = parsePtsCoordinate( line, tempDoubleCoord, tempColor );
-        if ( !parseRes.has_value() && ctx.cancel_group_execution() )
-            parseError = std::move( parseRes.error() );
-
-        pc.points[VertId( i )] = Vector3f( tempDoubleCoord - firstLineCoord );
-        if ( settings.colors )
-            ( *settings.colors )[VertId( i )] = tempColor;
+        for ( auto i = first; i < last; ++i )
+        {
+            const auto line = getLine( data.data(), lineOffsets, firstLine + i );
+            Vector3d tempDoubleCoord;
+            Color tempColor;
+            auto res = parsePtsCoordinate( line, tempDoubleCoord, tempColor );
+            if ( !res )
+                return unexpected( std::move( res.error() ) );
+
+            pc.points[VertId( i )] = Vector3f( tempDoubleCoord - firstLineCoord );
+            if ( settings.colors )
+                ( *settings.colors )[VertId( i )] = tempColor;
+        }
+        return {};
     }, subprogress( settings.callback, 0.25f, 1.0f ) );
-
-    if ( !keepGoing )
-        return unexpectedOperationCanceled();
-
-    if ( !parseError.empty() )
-        return unexpected( parseError );
+    if ( !parseRes )
+        return unexpected( std::move( parseRes.error() ) );
 
     pc.validPoints.resize( pc.points.size(), true );
     return pc;
@@ -275,6 +271,279 @@ Expected<MR::PointCloud> fromPly( std::istream& in, const PointsLoadSettings& se
     return res;
 }
 
+namespace
+{
+
+enum class PlyFormat
+{
+    Ascii,
+    BinaryLittleEndian,
+    BinaryBigEndian
+};
+
+enum class PlyType
+{
+    Int8, UInt8, Int16, UInt16, Int32, UInt32, Float32, Float64
+};
+
+/// the layout of the rows of vertex element
+struct PlyVertexLayout
+{
+    PlyFormat format = PlyFormat::Ascii;
+    size_t numVerts = 0;
+    std::vector<PlyType> types;
+    std::vector<size_t> offsets; ///< the offset of each property in binary row
+    size_t rowSize = 0; ///< the size of binary row
+    int pos[3] = { -1, -1, -1 };
+    int color[3] = { -1, -1, -1 };
+};
+
+std::optional<PlyType> parsePlyType( const std::string& s )
+{
+    if ( s == "char" || s == "int8" )
+        return PlyType::Int8;
+    if ( s == "uchar" || s == "uint8" )
+        return PlyType::UInt8;
+    if ( s == "short" || s == "int16" )
+        return PlyType::Int16;
+    if ( s == "ushort" || s == "uint16" )
+        return PlyType::UInt16;
+    if ( s == "int" || s == "int32" )
+        return PlyType::Int32;
+    if ( s == "uint" || s == "uint32" )
+        return PlyType::UInt32;
+    if ( s == "float" || s == "float32" )
+        return PlyType::Float32;
+    if ( s == "double" || s == "float64" )
+        return PlyType::Float64;
+    return {};
+}
+
+size_t plyTypeSize( PlyType t )
+{
+    switch ( t )
+    {
+    case PlyType::Int8:
+    case PlyType::UInt8:
+        return 1;
+    case PlyType::Int16:
+    case PlyType::UInt16:
+        return 2;
+    case PlyType::Int32:
+    case PlyType::UInt32:
+    case PlyType::Float32:
+        return 4;
+    case PlyType::Float64:
+        return 8;
+    }
+    return 0;
+}
+
+/// reads the header of PLY file leaving the stream at the start of data
+Expected<PlyVertexLayout> readPlyHeader( std::istream& in )
+{
+    PlyVertexLayout res;
+    std::string line;
+    if ( !std::getline( in, line ) || line.rfind( "ply", 0 ) != 0 )
+        return unexpected( std::string( "Not a PLY file" ) );
+
+    bool inVertexElement = false, gotVertexElement = false, gotFormat = false;
+    while ( std::getline( in, line ) )
+    {
+        if ( !line.empty() && line.back() == '\r' )
+            line.pop_back();
+        std::istringstream ls( line );
+        std::string keyword;
+        ls >> keyword;
+        if ( keyword == "end_header" )
+            break;
+        if ( keyword == "format" )
+        {
+            std::string format;
+            ls >> format;
+            if ( format == "ascii" )
+                res.format = PlyFormat::Ascii;
+            else if ( format == "binary_little_endian" )
+                res.format = PlyFormat::BinaryLittleEndian;
+            else if ( format == "binary_big_endian" )
+                res.format = PlyFormat::BinaryBigEndian;
+            else
+                return unexpected( "Unknown PLY format: " + format );
+            gotFormat = true;
+        }
+        else if ( keyword == "element" )
+        {
+            std::string name;
+            ls >> name;
+            if ( gotVertexElement )
+            {
+                inVertexElement = false;
+                continue;
+            }
+            if ( name != "vertex" )
+                return unexpected( std::string( "PLY vertex element must be the first one" ) );
+            ls >> res.numVerts;
+            inVertexElement = gotVertexElement = true;
+        }
+        else if ( keyword == "property" && inVertexElement )
+        {
+            std::string typeName, name;
+            ls >> typeName >> name;
+            if ( typeName == "list" )
+                return unexpected( std::string( "PLY vertex element with list properties is not supported" ) );
+            const auto type = parsePlyType( typeName );
+            if ( !type )
+                return unexpected( "Unknown PLY property type: " + typeName );
+            const int index = int( res.types.size() );
+            res.types.push_back( *type );
+            res.offsets.push_back( res.rowSize );
+            res.rowSize += plyTypeSize( *type );
+            if ( name == "x" )
+                res.pos[0] = index;
+            else if ( name == "y" )
+                res.pos[1] = index;
+            else if ( name == "z" )
+                res.pos[2] = index;
+            else if ( name == "red" || name == "r" )
+                res.color[0] = index;
+            else if ( name == "green" || name == "g" )
+                res.color[1] = index;
+            else if ( name == "blue" || name == "b" )
+                res.color[2] = index;
+        }
+    }
+    if ( !in )
+        return unexpected( std::string( "PLY header read error" ) );
+    if ( !gotFormat || !gotVertexElement )
+        return unexpected( std::string( "PLY file does not contain vertices" ) );
+    if ( res.pos[0] < 0 || res.pos[1] < 0 || res.pos[2] < 0 )
+        return unexpected( std::string( "PLY vertices do not have coordinates" ) );
+    return res;
+}
+
+double readPlyValue( const char* p, PlyType type, bool swapBytes )
+{
+    char bytes[8];
+    const auto size = plyTypeSize( type );
+    if ( swapBytes )
+        std::reverse_copy( p, p + size, bytes );
+    else
+        std::memcpy( bytes, p, size );
+    switch ( type )
+    {
+    case PlyType::Int8:    { std::int8_t v;   std::memcpy( &v, bytes, 1 ); return v; }
+    case PlyType::UInt8:   { std::uint8_t v;  std::memcpy( &v, bytes, 1 ); return v; }
+    case PlyType::Int16:   { std::int16_t v;  std::memcpy( &v, bytes, 2 ); return v; }
+    case PlyType::UInt16:  { std::uint16_t v; std::memcpy( &v, bytes, 2 ); return v; }
+    case PlyType::Int32:   { std::int32_t v;  std::memcpy( &v, bytes, 4 ); return v; }
+    case PlyType::UInt32:  { std::uint32_t v; std::memcpy( &v, bytes, 4 ); return v; }
+    case PlyType::Float32: { float v;         std::memcpy( &v, bytes, 4 ); return v; }
+    case PlyType::Float64: { double v;        std::memcpy( &v, bytes, 8 ); return v; }
+    }
+    return 0;
+}
+
+} // anonymous namespace
+
+Expected<void> fromPlyByParts( const std::filesystem::path& file, const PointsPartCallback& onPart,
+    const PointsLoadSettings& settings, size_t partSize )
+{
+    MR_TIMER;
+    std::ifstream in( file, std::ifstream::binary );
+    if ( !in )
+        return unexpected( std::string( "Cannot open file for reading " ) + utf8string( file ) );
+
+    auto layout = readPlyHeader( in );
+    if ( !layout )
+        return unexpected( std::move( layout.error() ) + ": " + utf8string( file ) );
+
+    const bool needColors = settings.colors && layout->color[0] >= 0 && layout->color[1] >= 0 && layout->color[2] >= 0;
+    const bool swapBytes = layout->format == PlyFormat::BinaryBigEndian;
+    const auto numProps = layout->types.size();
+    partSize = std::max( partSize, size_t( 1 ) );
+
+    PointCloud part;
+    VertColors colors;
+    std::vector<char> buf;
+    std::vector<double> values( numProps );
+    std::string line;
+    for ( size_t first = 0; first < layout->numVerts; first += partSize )
+    {
+        if ( !reportProgress( settings.callback, float( first ) / float( layout->numVerts ) ) )
+            return unexpectedOperationCanceled();
+
+        const auto num = std::min( partSize, layout->numVerts - first );
+        part.points.resize( num );
+        if ( needColors )
+            colors.resize( num );
+        if ( layout->format != PlyFormat::Ascii )
+        {
+            buf.resize( num * layout->rowSize );
+            if ( !in.read( buf.data(), buf.size() ) )
+                return unexpected( "PLY file read error: " + utf8string( file ) );
+        }
+
+        for ( VertId v( 0 ); v < num; ++v )
+        {
+            if ( layout->format == PlyFormat::Ascii )
+            {
+                if ( !std::getline( in, line ) )
+                    return unexpected( "PLY file read error: " + utf8string( file ) );
+                std::istringstream ls( line );
+                for ( auto& value : values )
+                    ls >> value;
+                if ( !ls )
+                    return unexpected( "PLY file parse error: " + utf8string( file ) );
+            }
+            else
+            {
+                const char* row = buf.data() + v * layout->rowSize;
+                for ( size_t i = 0; i < numProps; ++i )
+                    values[i] = readPlyValue( row + layout->offsets[i], layout->types[i], swapBytes );
+            }
+            part.points[v] = Vector3f( float( values[layout->pos[0]] ), float( values[layout->pos[1]] ), float( values[layout->pos[2]] ) );
+            if ( needColors )
+                colors[v] = Color( int( values[layout->color[0]] ), int( values[layout->color[1]] ), int( values[layout->color[2]] ) );
+        }
+
+        part.validPoints.clear();
+        part.validPoints.resize( num, true );
+        if ( auto res = onPart( part, needColors ? &colors : nullptr ); !res )
+            return res;
+    }
+    return {};
+}
+
+Expected<TiledPointCloud> plyToTiledPointCloud( const std::filesystem::path& file, const std::filesystem::path& folder,
+    const TiledPointCloudSettings& tiledSettings, const PointsLoadSettings& settings )
+{
+    MR_TIMER;
+    Box3f box;
+    auto boxSettings = settings;
+    boxSettings.colors = nullptr;
+    boxSettings.callback = subprogress( settings.callback, 0.0f, 0.3f );
+    auto measured = fromPlyByParts( file, [&]( const PointCloud& part, const VertColors* )
+    {
+        box.include( computeBoundingBox( part.points ) );
+        return Expected<void>{};
+    }, boxSettings );
+    if ( !measured )
+        return unexpected( std::move( measured.error() ) );
+
+    TiledPointCloudBuilder builder( folder, box, tiledSettings );
+    VertColors colors;
+    auto partSettings = settings;
+    partSettings.colors = tiledSettings.colors ? &colors : nullptr;
+    partSettings.callback = subprogress( settings.callback, 0.3f, 0.8f );
+    auto added = fromPlyByParts( file, [&]( const PointCloud& part, const VertColors* partColors )
+    {
+        return builder.addPoints( part.points, partColors );
+    }, partSettings );
+    if ( !added )
+        return unexpected( std::move( added.error() ) );
+    return builder.finish( subprogress( settings.callback, 0.8f, 1.0f ) );
+}
+
 Expected<MR::PointCloud> fromObj( const std::filesystem::path& file, const PointsLoadSettings& settings )
 {
     std::ifstream in( file, std::ifstream::binary );
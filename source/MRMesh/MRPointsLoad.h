@@ -4,6 +4,7 @@
 #include "MRExpected.h"
 #include "MRIOFilters.h"
 #include "MRPointsLoadSettings.h"
+#include "MRTiledPointCloud.h"
 
 #include <filesystem>
 
@@ -26,6 +27,21 @@ MRMESH_API Expected<PointCloud> fromPts( std::istream& in, const PointsLoadSetti
 MRMESH_API Expected<PointCloud> fromPly( const std::filesystem::path& file, const PointsLoadSettings& settings = {} );
 MRMESH_API Expected<PointCloud> fromPly( std::istream& in, const PointsLoadSettings& settings = {} );
 
+/// receives next part of points read from a file, and their colors if they were requested and present in the file
+using PointsPartCallback = std::function<Expected<void>( const PointCloud& part, const VertColors* colors )>;
+
+/// reads .ply file part by part without keeping all points in memory, and passes each part in given callback;
+/// the vertex element must be the first in the file and it must have no list properties;
+/// if settings.colors is not null then the colors of each part are passed in the callback (and settings.colors itself is not filled)
+MR_BIND_IGNORE MRMESH_API Expected<void> fromPlyByParts( const std::filesystem::path& file, const PointsPartCallback& onPart,
+    const PointsLoadSettings& settings = {}, size_t partSize = size_t( 1 ) << 20 );
+
+/// builds out-of-core tiled point cloud in given folder from .ply file reading it part by part twice:
+/// first to find the bounding box of the points, and then to distribute them among the tiles;
+/// settings.colors is ignored, the colors are stored if tiledSettings.colors is set
+MR_BIND_IGNORE MRMESH_API Expected<TiledPointCloud> plyToTiledPointCloud( const std::filesystem::path& file, const std::filesystem::path& folder,
+    const TiledPointCloudSettings& tiledSettings = {}, const PointsLoadSettings& settings = {} );
+
 /// loads from .obj file
 MRMESH_API Expected<PointCloud> fromObj( const std::filesystem::path& file, const PointsLoadSettings& settings = {} );
 MRMESH_API Expected<PointCloud> fromObj( std::istream& in, const PointsLoadSettings& settings = {} );
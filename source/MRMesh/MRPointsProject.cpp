@@ -7,6 +7,7 @@
 #include "MRInplaceStack.h"
 #include "MRParallelFor.h"
 #include "MRTimer.h"
+#include "MRGTest.h"
 #include "MRPch/MRTBB.h"
 
 namespace MR
@@ -20,6 +21,46 @@ struct SubTask
     float distSq;
 };
 
+/// the number of spatially close queries processed together by one thread
+constexpr size_t cQueryBlockSize = 64;
+
+/// finds few closest points for each query in a block of spatially close queries:
+/// the ball around previous query containing all its found points, expanded by the distance between the queries,
+/// contains at least the same number of points for next query, so it limits the search
+template<typename GetQuery, typename OnFound>
+void findFewClosestPointsInBlock( const PointCloud& pc, size_t numQueries, FewSmallest<PointsProjectionResult> & neis,
+    GetQuery && getQuery, OnFound && onFound )
+{
+    Vector3f prevPt;
+    float prevDist = -1; // negative if previous query did not find enough points
+    for ( size_t i = 0; i < numQueries; ++i )
+    {
+        const Vector3f pt = getQuery( i );
+        if ( prevDist >= 0 )
+        {
+            // the limit is slightly enlarged to be robust against rounding errors
+            const float upDistLimit = ( prevDist + distance( pt, prevPt ) ) * 1.0001f;
+            findFewClosestPoints( pt, pc, neis, sqr( upDistLimit ) );
+        }
+        if ( prevDist < 0 || !neis.full() )
+            findFewClosestPoints( pt, pc, neis );
+        prevPt = pt;
+        prevDist = neis.full() ? std::sqrt( neis.top().distSq ) : -1.0f;
+        onFound( i, neis );
+    }
+}
+
+/// spreads 10 lower bits of given value to every third bit
+inline std::uint32_t spreadBits( std::uint32_t x )
+{
+    x &= 0x3ff;
+    x = ( x | ( x << 16 ) ) & 0x030000ff;
+    x = ( x | ( x << 8 ) ) & 0x0300f00f;
+    x = ( x | ( x << 4 ) ) & 0x030c30c3;
+    x = ( x | ( x << 2 ) ) & 0x09249249;
+    return x;
+}
+
 } //anonymous namespace
 
 
@@ -74,13 +115,15 @@ PointsProjectionResult findProjectionOnPoints( const Vector3f& pt, const AABBTre
         if ( node.leaf() )
         {
             auto [first, last] = node.getLeafPointRange();
+            float leafDistSq[AABBTreePoints::MaxNumPointsInLeaf];
+            if ( !xf )
+                tree.getDistancesSq( pt, first, last, leafDistSq );
             bool lowBreak = false;
             for ( int i = first; i < last && !lowBreak; ++i )
             {
                 if ( skipCb && skipCb( orderedPoints[i].id ) )
                     continue;
-                auto proj = xf ? ( *xf )( orderedPoints[i].coord ) : orderedPoints[i].coord;
-                float distSq = ( proj - pt ).lengthSq();
+                float distSq = xf ? ( ( *xf )( orderedPoints[i].coord ) - pt ).lengthSq() : leafDistSq[i - first];
                 if ( distSq < res.distSq )
                 {
                     res.distSq = distSq;
@@ -159,11 +202,13 @@ void findFewClosestPoints( const Vector3f& pt, const PointCloud& pc, FewSmallest
         if ( node.leaf() )
         {
             auto [first, last] = node.getLeafPointRange();
+            float leafDistSq[AABBTreePoints::MaxNumPointsInLeaf];
+            if ( !xf )
+                tree.getDistancesSq( pt, first, last, leafDistSq );
             bool lowBreak = false;
             for ( int i = first; i < last && !lowBreak; ++i )
             {
-                auto proj = xf ? ( *xf )( orderedPoints[i].coord ) : orderedPoints[i].coord;
-                float distSq = ( proj - pt ).lengthSq();
+                float distSq = xf ? ( ( *xf )( orderedPoints[i].coord ) - pt ).lengthSq() : leafDistSq[i - first];
                 if ( distSq < topDistSq() )
                 {
                     res.push( { .distSq = distSq, .vId = orderedPoints[i].id } );
@@ -201,22 +246,69 @@ Buffer<VertId> findNClosestPointsPerPoint( const PointCloud& pc, int numNei, con
 
     tbb::enumerable_thread_specific<FewSmallest<PointsProjectionResult>> perThreadNeis( numNei + 1 );
 
-    pc.getAABBTree(); // to avoid multiple calls to tree construction from parallel region,
-                      // which can result that two different vertices will start being processed by one thread
-
-    if ( !BitSetParallelFor( pc.validPoints, [&]( VertId v )
+    // the points are processed in the order of the tree, where consecutive points are close to one another
+    const auto & orderedPoints = pc.getAABBTree().orderedPoints();
+    if ( !ParallelFor( size_t( 0 ), ( orderedPoints.size() + cQueryBlockSize - 1 ) / cQueryBlockSize, [&]( size_t b )
     {
         auto & neis = perThreadNeis.local();
-        neis.clear();
         assert( neis.maxElms() == numNei + 1 );
-        findFewClosestPoints( pc.points[v], pc, neis );
-        VertId * p = res.data() + ( (size_t)v * numNei );
-        const VertId * pEnd = p + numNei;
-        for ( const auto & n : neis.get() )
-            if ( n.vId != v && p < pEnd )
+        const auto begin = b * cQueryBlockSize;
+        findFewClosestPointsInBlock( pc, std::min( cQueryBlockSize, orderedPoints.size() - begin ), neis,
+            [&]( size_t i ) { return orderedPoints[begin + i].coord; },
+            [&]( size_t i, const FewSmallest<PointsProjectionResult> & found )
+        {
+            const VertId v = orderedPoints[begin + i].id;
+            VertId * p = res.data() + ( (size_t)v * numNei );
+            const VertId * pEnd = p + numNei;
+            for ( const auto & n : found.get() )
+                if ( n.vId != v && p < pEnd )
+                    *p++ = n.vId;
+            while ( p < pEnd )
+                *p++ = {};
+        } );
+    }, progress ) )
+        res.clear();
+
+    return res;
+}
+
+Buffer<VertId> findNClosestPoints( const PointCloud& pc, const std::vector<Vector3f>& queries, int numNei, const ProgressCallback & progress )
+{
+    MR_TIMER;
+    assert( numNei >= 1 );
+    Buffer<VertId> res( queries.size() * numNei );
+
+    // sort the queries along Z-order curve in their bounding box
+    Box3f box;
+    for ( const auto & q : queries )
+        box.include( q );
+    const auto scale = box.valid() ? div( Vector3f::diagonal( 1023.0f ), box.size() + Vector3f::diagonal( FLT_MIN ) ) : Vector3f();
+    std::vector<std::pair<std::uint32_t, size_t>> order( queries.size() );
+    ParallelFor( order, [&]( size_t i )
+    {
+        const auto p = mult( queries[i] - box.min, scale );
+        order[i] = { spreadBits( std::uint32_t( p.x ) ) | ( spreadBits( std::uint32_t( p.y ) ) << 1 ) | ( spreadBits( std::uint32_t( p.z ) ) << 2 ), i };
+    } );
+    tbb::parallel_sort( order.begin(), order.end() );
+
+    tbb::enumerable_thread_specific<FewSmallest<PointsProjectionResult>> perThreadNeis( numNei );
+    pc.getAABBTree(); // to avoid tree construction from parallel region
+
+    if ( !ParallelFor( size_t( 0 ), ( order.size() + cQueryBlockSize - 1 ) / cQueryBlockSize, [&]( size_t b )
+    {
+        auto & neis = perThreadNeis.local();
+        const auto begin = b * cQueryBlockSize;
+        findFewClosestPointsInBlock( pc, std::min( cQueryBlockSize, order.size() - begin ), neis,
+            [&]( size_t i ) { return queries[order[begin + i].second]; },
+            [&]( size_t i, const FewSmallest<PointsProjectionResult> & found )
+        {
+            VertId * p = res.data() + order[begin + i].second * numNei;
+            const VertId * pEnd = p + numNei;
+            for ( const auto & n : found.get() )
                 *p++ = n.vId;
-        while ( p < pEnd )
-            *p++ = {};
+            while ( p < pEnd )
+                *p++ = {};
+        } );
     }, progress ) )
         res.clear();
 
@@ -296,4 +388,54 @@ size_t PointsProjector::projectionsHeapBytes( size_t ) const
     return 0;
 }
 
+TEST( MRMesh, FindNClosestPoints )
+{
+    PointCloud pc;
+    for ( int z = 0; z < 10; ++z )
+        for ( int y = 0; y < 10; ++y )
+            for ( int x = 0; x < 10; ++x )
+                pc.points.emplace_back( x + 0.01f * y, y + 0.01f * z, z + 0.01f * x );
+    pc.validPoints.resize( pc.points.size(), true );
+
+    constexpr int numNei = 6;
+    // equally distant points can be found in any order, so only the distances are compared
+    auto sorted = [&]( const VertId * p, const Vector3f & pt )
+    {
+        std::vector<float> res;
+        for ( int j = 0; j < numNei; ++j )
+            res.push_back( distanceSq( pc.points[p[j]], pt ) );
+        std::sort( res.begin(), res.end() );
+        return res;
+    };
+
+    std::vector<Vector3f> queries;
+    for ( int i = 0; i < 200; ++i )
+        queries.emplace_back( 0.05f * i, 0.037f * i, 9.0f - 0.041f * i );
+    const auto found = findNClosestPoints( pc, queries, numNei );
+    ASSERT_EQ( found.size(), queries.size() * numNei );
+    FewSmallest<PointsProjectionResult> neis( numNei );
+    for ( size_t i = 0; i < queries.size(); ++i )
+    {
+        findFewClosestPoints( queries[i], pc, neis );
+        std::vector<VertId> expected;
+        for ( const auto & n : neis.get() )
+            expected.push_back( n.vId );
+        EXPECT_EQ( sorted( found.data() + i * numNei, queries[i] ), sorted( expected.data(), queries[i] ) );
+    }
+
+    const auto perPoint = findNClosestPointsPerPoint( pc, numNei );
+    ASSERT_EQ( perPoint.size(), pc.points.size() * numNei );
+    FewSmallest<PointsProjectionResult> neisWithSelf( numNei + 1 );
+    for ( auto v : pc.validPoints )
+    {
+        findFewClosestPoints( pc.points[v], pc, neisWithSelf );
+        std::vector<VertId> expected;
+        for ( const auto & n : neisWithSelf.get() )
+            if ( n.vId != v )
+                expected.push_back( n.vId );
+        ASSERT_EQ( expected.size(), numNei );
+        EXPECT_EQ( sorted( perPoint.data() + v * numNei, pc.points[v] ), sorted( expected.data(), pc.points[v] ) );
+    }
+}
+
 } //namespace MR
@@ -66,6 +66,17 @@ MRMESH_API void findFewClosestPoints( const Vector3f& pt, const PointCloud& pc,
  */
 [[nodiscard]] MRMESH_API Buffer<VertId> findNClosestPointsPerPoint( const PointCloud& pc, int numNei, const ProgressCallback & progress = {} );
 
+/**
+ * \brief finds given number of closest points in the cloud to each query point;
+ * the queries are sorted along a space-filling curve and processed in blocks of close queries,
+ * where the neighbours found for previous query limit the search radius for the next one
+ * \param numNei the number of closest points to find for each query
+ * \return a buffer where the neighbours of i-th query are stored at indices [i*numNei; (i+1)*numNei) in arbitrary order,
+ *         with invalid ids in the end if the cloud has less points; empty buffer if the operation was canceled
+ */
+[[nodiscard]] MRMESH_API Buffer<VertId> findNClosestPoints( const PointCloud& pc, const std::vector<Vector3f>& queries, int numNei,
+    const ProgressCallback & progress = {} );
+
 /// finds two closest points (first id < second id) in whole point cloud
 [[nodiscard]] MRMESH_API VertPair findTwoClosestPoints( const PointCloud& pc, const ProgressCallback & progress = {} );
 
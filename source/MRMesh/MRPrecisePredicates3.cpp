@@ -289,4 +289,28 @@ TEST( MRMesh, PrecisePredicates3 )
     EXPECT_TRUE( res.dIsLeftFromABC );
 }
 
+TEST( MRMesh, Orient3dFiltered )
+{
+    const Vector3i a( 2, 1, 0 ), b( -2, 1, 0 ), c( 0, -2, 0 );
+    EXPECT_EQ( orient3dFiltered( a, b, c, Vector3i( 0, 0, -1 ) ), 1 );
+    EXPECT_EQ( orient3dFiltered( a, b, c, Vector3i( 0, 0, 1 ) ), -1 );
+    EXPECT_TRUE( orient3d( a, b, c, Vector3i( 0, 0, -1 ) ) );
+
+    // the point exactly on the plane requires exact predicate
+    EXPECT_EQ( orient3dFiltered( a, b, c, Vector3i( 5, 7, 0 ) ), 0 );
+
+    // large coordinates, where products are not exact in double, but the sign must be either certain and correct or unknown
+    constexpr int big = 1 << 30;
+    const Vector3i p( -big, -big + 1, 3 ), q( big - 5, -big, -7 ), r( 11, big - 3, 1 );
+    for ( int z = -4; z <= 4; ++z )
+    {
+        const Vector3i d( 13, -17, z );
+        const int s = orient3dFiltered( p, q, r, d );
+        if ( s != 0 )
+        {
+            EXPECT_EQ( s > 0, orient3d( p, q, r, d ) );
+        }
+    }
+}
+
 } //namespace MR
@@ -4,6 +4,8 @@
 #include "MRId.h"
 
 #include <array>
+#include <cmath>
+#include <limits>
 
 namespace MR
 {
@@ -20,6 +22,29 @@ MRMESH_API bool orient3d( const Vector3i & a, const Vector3i & b, const Vector3i
 inline bool orient3d( const Vector3i & a, const Vector3i & b, const Vector3i & c, const Vector3i & d )
     { return orient3d( a - d, b - d, c - d ); }
 
+/// evaluates the sign of orient3d( a, b, c, d ) in floating-point arithmetic with error bound and without simulation-of-simplicity:
+/// returns 1 if the plane with orientated triangle ABC certainly has D point at the left, -1 if D is certainly at the right,
+/// and 0 if the sign cannot be determined this way (then the exact predicate must be called)
+[[nodiscard]] inline int orient3dFiltered( const Vector3i & a, const Vector3i & b, const Vector3i & c, const Vector3i & d )
+{
+    // the differences of integer coordinates are exact in double
+    const Vector3d ad( a - d ), bd( b - d ), cd( c - d );
+    const double bdxcdy = bd.x * cd.y, cdxbdy = cd.x * bd.y;
+    const double cdxady = cd.x * ad.y, adxcdy = ad.x * cd.y;
+    const double adxbdy = ad.x * bd.y, bdxady = bd.x * ad.y;
+    const double det = ad.z * ( bdxcdy - cdxbdy ) + bd.z * ( cdxady - adxcdy ) + cd.z * ( adxbdy - bdxady );
+
+    // the bound of rounding errors from J.R. Shewchuk "Adaptive Precision Floating-Point Arithmetic and Fast Robust Geometric Predicates"
+    constexpr double eps = std::numeric_limits<double>::epsilon() / 2;
+    constexpr double errBoundFactor = ( 7 + 56 * eps ) * eps;
+    const double permanent =
+          ( std::abs( bdxcdy ) + std::abs( cdxbdy ) ) * std::abs( ad.z )
+        + ( std::abs( cdxady ) + std::abs( adxcdy ) ) * std::abs( bd.z )
+        + ( std::abs( adxbdy ) + std::abs( bdxady ) ) * std::abs( cd.z );
+    const double errBound = errBoundFactor * permanent;
+    return det > errBound ? 1 : ( det < -errBound ? -1 : 0 );
+}
+
 struct PreciseVertCoords
 {
     VertId id;   ///< unique id of the vertex (in both meshes)
@@ -1,4 +1,9 @@
 #include "MRProgressReadWrite.h"
+#include "MRParallelFor.h"
+#include "MRGTest.h"
+#include "MRPch/MRTBB.h"
+#include <sstream>
+#include <cstring>
 
 namespace MR
 {
@@ -51,4 +56,77 @@ bool readByBlocks( std::istream& in, char* data, size_t dataSize, ProgressCallba
     return true;
 }
 
+bool writeInParallel( std::ostream& out, size_t numItems,
+    const std::function<void( size_t begin, size_t end, std::string& buf )>& format, ProgressCallback callback /*= {}*/, size_t chunkSize /*= 16384*/ )
+{
+    assert( chunkSize > 0 );
+    const size_t numChunks = ( numItems + chunkSize - 1 ) / chunkSize;
+    // several chunks per thread in a batch for better load balancing
+    const size_t batchSize = 4 * size_t( tbb::this_task_arena::max_concurrency() );
+
+    // the buffers are reused between batches to avoid reallocations
+    std::vector<std::string> batch, nextBatch;
+    auto formatBatch = [&] ( size_t firstChunk, std::vector<std::string>& buffers )
+    {
+        buffers.resize( std::min( batchSize, numChunks - firstChunk ) );
+        ParallelFor( buffers, [&] ( size_t i )
+        {
+            auto& buf = buffers[i];
+            buf.clear();
+            const size_t begin = ( firstChunk + i ) * chunkSize;
+            format( begin, std::min( begin + chunkSize, numItems ), buf );
+        } );
+    };
+
+    if ( numChunks > 0 )
+        formatBatch( 0, batch );
+    for ( size_t firstChunk = 0; firstChunk < numChunks; firstChunk += batchSize )
+    {
+        const size_t nextFirstChunk = firstChunk + batchSize;
+        tbb::task_group taskGroup;
+        if ( nextFirstChunk < numChunks )
+            taskGroup.run( [&] { formatBatch( nextFirstChunk, nextBatch ); } );
+
+        // write in the current thread to be compatible with PythonOstreamBuf
+        for ( const auto& buf : batch )
+            out.write( buf.data(), buf.size() );
+
+        taskGroup.wait();
+        if ( !reportProgress( callback, float( std::min( nextFirstChunk, numChunks ) ) / numChunks ) )
+            return false;
+        batch.swap( nextBatch );
+    }
+    return true;
+}
+
+bool copyByBlocks( const char* src, char* data, size_t dataSize, ProgressCallback callback /*= {}*/, size_t blockSize /*= ( size_t( 1 ) << 20 )*/ )
+{
+    const size_t numBlocks = ( dataSize + blockSize - 1 ) / blockSize;
+    return ParallelFor( size_t( 0 ), numBlocks, [&] ( size_t blockIndex )
+    {
+        const size_t begin = blockIndex * blockSize;
+        std::memcpy( data + begin, src + begin, std::min( blockSize, dataSize - begin ) );
+    }, callback, 1 );
+}
+
+TEST( MRMesh, WriteInParallel )
+{
+    constexpr size_t numItems = 100000;
+    std::ostringstream expected;
+    for ( size_t i = 0; i < numItems; ++i )
+        expected << i << '\n';
+
+    std::ostringstream out;
+    float lastProgress = 0;
+    EXPECT_TRUE( writeInParallel( out, numItems, [] ( size_t begin, size_t end, std::string& buf )
+    {
+        for ( size_t i = begin; i < end; ++i )
+            buf += std::to_string( i ) + '\n';
+    }, [&] ( float p ) { lastProgress = p; return true; }, 1000 ) );
+    EXPECT_EQ( out.str(), expected.str() );
+    EXPECT_EQ( lastProgress, 1.0f );
+
+    EXPECT_FALSE( writeInParallel( out, numItems, [] ( size_t, size_t, std::string& ) {}, [] ( float ) { return false; }, 1000 ) );
+}
+
 }
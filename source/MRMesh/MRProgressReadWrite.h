@@ -3,6 +3,8 @@
 #include "MRMeshFwd.h"
 #include <ostream>
 #include <istream>
+#include <functional>
+#include <string>
 
 namespace MR
 {
@@ -22,4 +24,20 @@ MRMESH_API bool writeByBlocks( std::ostream& out, const char* data, size_t dataS
  */
 MRMESH_API bool readByBlocks( std::istream& in, char* data, size_t dataSize, ProgressCallback callback = {}, size_t blockSize = ( size_t( 1 ) << 16 ) );
 
+/**
+ * \brief write numItems items to out stream, formatting them in parallel threads by chunks of chunkSize items
+ * \details the chunks are formatted in batches, and each batch is written in order from the calling thread
+ * while the next batch is being formatted in other threads
+ * \param format appends to the buffer the representation of items [begin, end)
+ * \return false if process was canceled (callback is set and return false )
+ */
+MRMESH_API bool writeInParallel( std::ostream& out, size_t numItems,
+    const std::function<void( size_t begin, size_t end, std::string& buf )>& format, ProgressCallback callback = {}, size_t chunkSize = 16384 );
+
+/**
+ * \brief copy dataSize bytes from memory src (e.g. mapped file) to data by blocks blockSize bytes in parallel threads
+ * \return false if process was canceled (callback is set and return false )
+ */
+MRMESH_API bool copyByBlocks( const char* src, char* data, size_t dataSize, ProgressCallback callback = {}, size_t blockSize = ( size_t( 1 ) << 20 ) );
+
 }
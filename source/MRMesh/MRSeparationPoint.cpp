@@ -12,16 +12,23 @@ void SeparationPointStorage::resize( size_t blockCount, size_t blockSize )
 }
 
 int SeparationPointStorage::makeUniqueVids()
+{
+    return int( makeUniqueVids( 0, blocks_.size(), VertId( 0 ) ) );
+}
+
+VertId SeparationPointStorage::makeUniqueVids( size_t beginBlock, size_t endBlock, VertId firstVid )
 {
     MR_TIMER;
-    VertId lastShift{ 0 };
-    for ( auto & b : blocks_ )
+    assert( beginBlock <= endBlock && endBlock <= blocks_.size() );
+    VertId lastShift = firstVid;
+    for ( size_t bi = beginBlock; bi < endBlock; ++bi )
     {
+        auto & b = blocks_[bi];
         b.shift = lastShift;
         lastShift += b.nextVid();
     }
 
-    ParallelFor( size_t( 0 ), blocks_.size(), [&] ( size_t bi )
+    ParallelFor( beginBlock, endBlock, [&] ( size_t bi )
     {
         const auto shift = blocks_[bi].shift;
         for ( auto& [_, set] : blocks_[bi].smap )
@@ -45,6 +45,10 @@ public:
     /// returns the total number of valid points in the storage
     MRMESH_API int makeUniqueVids();
 
+    /// shifts vertex ids in the blocks [beginBlock, endBlock) (after they are filled) to make them unique,
+    /// the first point of beginBlock gets firstVid; returns the id after the last point in endBlock-1
+    MRMESH_API VertId makeUniqueVids( size_t beginBlock, size_t endBlock, VertId firstVid );
+
     /// finds the set (locating the block) by voxel id
     auto findSeparationPointSet( size_t voxelId ) const -> const SeparationPointSet *
     {
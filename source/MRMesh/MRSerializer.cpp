@@ -368,6 +368,14 @@ void deserializeFromJson( const Json::Value& root, Vector4f& vec )
     }
 }
 
+void deserializeFromJson( const Json::Value& root, Box3f& box )
+{
+    if ( !root.isObject() )
+        return;
+    deserializeFromJson( root["min"], box.min );
+    deserializeFromJson( root["max"], box.max );
+}
+
 void deserializeFromJson( const Json::Value& root, Color& col )
 {
     if ( root.isObject() && root["r"].isNumeric() && root["g"].isNumeric() && root["b"].isNumeric() && root["a"].isNumeric() )
@@ -71,6 +71,7 @@ MRMESH_API void deserializeFromJson( const Json::Value& root, Vector2f& vec );
 MRMESH_API void deserializeFromJson( const Json::Value& root, Vector3i& vec );
 MRMESH_API void deserializeFromJson( const Json::Value& root, Vector3f& vec );
 MRMESH_API void deserializeFromJson( const Json::Value& root, Vector4f& vec );
+MRMESH_API void deserializeFromJson( const Json::Value& root, Box3f& box );
 MRMESH_API void deserializeFromJson( const Json::Value& root, Color& col );
 MRMESH_API void deserializeFromJson( const Json::Value& root, Matrix2f& matrix );
 MRMESH_API void deserializeFromJson( const Json::Value& root, Matrix3f& matrix );
@@ -0,0 +1,554 @@
+#include "MRTiledPointCloud.h"
+#include "MRPointCloud.h"
+#include "MRColor.h"
+#include "MRParallelFor.h"
+#include "MRphmap.h"
+#include "MRStringConvert.h"
+#include "MRUniqueTemporaryFolder.h"
+#include "MRPointsLoad.h"
+#include "MRPointsSave.h"
+#include "MRSaveSettings.h"
+#include "MRTimer.h"
+#include "MRGTest.h"
+#include "MRPch/MRFmt.h"
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+namespace MR
+{
+
+namespace
+{
+
+constexpr char cIndexMagic[8] = { 'M', 'R', 'T', 'i', 'l', 'e', 's', '1' };
+constexpr int cMaxDepth = 7;
+
+const char * indexFileName = "tiles.idx";
+
+inline size_t numTilesAtLevel( int level )
+{
+    return size_t( 1 ) << ( 3 * level );
+}
+
+inline size_t tileIndex( int level, const Vector3i & pos )
+{
+    const size_t n = size_t( 1 ) << level;
+    return size_t( pos.x ) + ( size_t( pos.y ) + size_t( pos.z ) * n ) * n;
+}
+
+inline Vector3i tilePos( int level, size_t i )
+{
+    const size_t n = size_t( 1 ) << level;
+    return Vector3i( int( i % n ), int( ( i / n ) % n ), int( i / ( n * n ) ) );
+}
+
+/// finds the position of the tile of given level containing given point, the points outside the box are clamped to it
+inline Vector3i tilePos( const Box3f & box, int level, const Vector3f & p )
+{
+    const int n = 1 << level;
+    Vector3i res;
+    for ( int i = 0; i < 3; ++i )
+    {
+        const auto sz = box.max[i] - box.min[i];
+        const int x = sz > 0 ? int( std::floor( ( p[i] - box.min[i] ) / sz * n ) ) : 0;
+        res[i] = std::clamp( x, 0, n - 1 );
+    }
+    return res;
+}
+
+inline size_t recordSize( bool colors )
+{
+    return sizeof( Vector3f ) + ( colors ? sizeof( Color ) : 0 );
+}
+
+inline Vector3f recordPoint( const char * record )
+{
+    Vector3f p;
+    std::memcpy( &p, record, sizeof( Vector3f ) );
+    return p;
+}
+
+bool readWholeFile( const std::filesystem::path & path, std::vector<char> & data )
+{
+    std::ifstream in( path, std::ifstream::binary );
+    if ( !in )
+        return false;
+    in.seekg( 0, std::ios::end );
+    const auto size = size_t( in.tellg() );
+    in.seekg( 0 );
+    const auto oldSize = data.size();
+    data.resize( oldSize + size );
+    in.read( data.data() + oldSize, size );
+    return bool( in );
+}
+
+/// leaves at most one record per voxel of the grid with given resolution over given box, which point is the closest to voxel center
+std::vector<char> sampleRecords( const std::vector<char> & records, size_t recSize, const Box3f & box, int resolution )
+{
+    const size_t numRecords = records.size() / recSize;
+    const auto voxelSize = box.size() / float( resolution );
+    struct Sample
+    {
+        float centerDistSq = FLT_MAX;
+        size_t record = 0;
+    };
+    HashMap<size_t, Sample> voxels;
+    for ( size_t r = 0; r < numRecords; ++r )
+    {
+        const auto p = recordPoint( records.data() + r * recSize );
+        Vector3i vox;
+        Vector3f center;
+        for ( int i = 0; i < 3; ++i )
+        {
+            const int x = voxelSize[i] > 0 ? int( ( p[i] - box.min[i] ) / voxelSize[i] ) : 0;
+            vox[i] = std::clamp( x, 0, resolution - 1 );
+            center[i] = box.min[i] + ( vox[i] + 0.5f ) * voxelSize[i];
+        }
+        const auto key = size_t( vox.x ) + ( size_t( vox.y ) + size_t( vox.z ) * resolution ) * resolution;
+        auto & s = voxels[key];
+        const auto distSq = ( p - center ).lengthSq();
+        if ( distSq < s.centerDistSq )
+        {
+            s.centerDistSq = distSq;
+            s.record = r;
+        }
+    }
+
+    std::vector<char> res( voxels.size() * recSize );
+    size_t n = 0;
+    for ( const auto & [key, s] : voxels )
+        std::memcpy( res.data() + recSize * n++, records.data() + recSize * s.record, recSize );
+    return res;
+}
+
+} //anonymous namespace
+
+std::filesystem::path TiledPointCloud::tileFile( const std::filesystem::path & folder, int level, const Vector3i & pos )
+{
+    return folder / fmt::format( "{}_{}_{}_{}.pts", level, pos.x, pos.y, pos.z );
+}
+
+Box3f TiledPointCloud::tileBox( const Box3f & rootBox, int level, const Vector3i & pos )
+{
+    const auto tileSize = rootBox.size() / float( 1 << level );
+    const auto min = rootBox.min + mult( Vector3f( pos ), tileSize );
+    return Box3f( min, min + tileSize );
+}
+
+Expected<TiledPointCloud> TiledPointCloud::open( const std::filesystem::path & folder )
+{
+    MR_TIMER;
+    std::ifstream in( folder / indexFileName, std::ifstream::binary );
+    if ( !in )
+        return unexpected( "Cannot open tiled point cloud in " + utf8string( folder ) );
+
+    char magic[sizeof( cIndexMagic )];
+    in.read( magic, sizeof( magic ) );
+    if ( !in || std::memcmp( magic, cIndexMagic, sizeof( magic ) ) != 0 )
+        return unexpected( "Unknown format of tiled point cloud in " + utf8string( folder ) );
+
+    TiledPointCloud res;
+    res.folder_ = folder;
+    std::int32_t params[3];
+    in.read( ( char* )&res.box_, sizeof( Box3f ) );
+    in.read( ( char* )params, sizeof( params ) );
+    if ( !in || params[0] < 0 || params[0] > cMaxDepth )
+        return unexpected( "Corrupted index of tiled point cloud in " + utf8string( folder ) );
+    res.settings_.depth = params[0];
+    res.settings_.lodResolution = params[1];
+    res.settings_.colors = params[2] != 0;
+
+    res.numPoints_.resize( res.settings_.depth + 1 );
+    for ( int level = 0; level <= res.settings_.depth; ++level )
+    {
+        auto & counts = res.numPoints_[level];
+        counts.resize( numTilesAtLevel( level ) );
+        static_assert( sizeof( size_t ) == sizeof( std::uint64_t ) );
+        in.read( ( char* )counts.data(), counts.size() * sizeof( size_t ) );
+    }
+    if ( !in )
+        return unexpected( "Corrupted index of tiled point cloud in " + utf8string( folder ) );
+    return res;
+}
+
+size_t TiledPointCloud::numPoints() const
+{
+    size_t res = 0;
+    for ( auto n : numPoints_[settings_.depth] )
+        res += n;
+    return res;
+}
+
+std::vector<TiledPointCloud::Tile> TiledPointCloud::findTiles( const Box3f & box, int level ) const
+{
+    std::vector<Tile> res;
+    if ( level < 0 || level > settings_.depth || !box.valid() || !box.intersects( box_ ) )
+        return res;
+
+    const auto minPos = tilePos( box_, level, box.min );
+    const auto maxPos = tilePos( box_, level, box.max );
+    Vector3i pos;
+    for ( pos.z = minPos.z; pos.z <= maxPos.z; ++pos.z )
+        for ( pos.y = minPos.y; pos.y <= maxPos.y; ++pos.y )
+            for ( pos.x = minPos.x; pos.x <= maxPos.x; ++pos.x )
+            {
+                const auto n = numPoints_[level][tileIndex( level, pos )];
+                if ( n > 0 )
+                    res.push_back( { level, pos, tileBox( box_, level, pos ), n } );
+            }
+    return res;
+}
+
+Expected<PointCloud> TiledPointCloud::loadTile( const Tile & tile, VertColors * colors ) const
+{
+    std::vector<char> records;
+    const auto path = tileFile( folder_, tile.level, tile.pos );
+    const auto recSize = recordSize( settings_.colors );
+    if ( !readWholeFile( path, records ) || records.size() != tile.numPoints * recSize )
+        return unexpected( "Cannot read tile file " + utf8string( path ) );
+
+    PointCloud res;
+    res.points.resizeNoInit( tile.numPoints );
+    if ( colors && settings_.colors )
+        colors->resizeNoInit( tile.numPoints );
+    ParallelFor( res.points, [&]( VertId v )
+    {
+        const char * rec = records.data() + recSize * v;
+        std::memcpy( &res.points[v], rec, sizeof( Vector3f ) );
+        if ( colors && settings_.colors )
+            std::memcpy( &( *colors )[v], rec + sizeof( Vector3f ), sizeof( Color ) );
+    } );
+    res.validPoints.resize( tile.numPoints, true );
+    return res;
+}
+
+Expected<PointCloud> TiledPointCloud::loadBox( const Box3f & box, int level, VertColors * colors ) const
+{
+    MR_TIMER;
+    PointCloud res;
+    auto added = forEachTile( box, level, [&]( const Tile & tile, const PointCloud & cloud, const VertColors & tileColors )
+    {
+        const bool wholeTile = box.contains( tile.box );
+        for ( auto v : cloud.validPoints )
+        {
+            if ( !wholeTile && !box.contains( cloud.points[v] ) )
+                continue;
+            res.points.push_back( cloud.points[v] );
+            if ( colors && settings_.colors )
+                colors->push_back( tileColors[v] );
+        }
+        return true;
+    } );
+    if ( !added )
+        return unexpected( std::move( added.error() ) );
+    res.validPoints.resize( res.points.size(), true );
+    return res;
+}
+
+Expected<void> TiledPointCloud::forEachTile( const Box3f & box, int level,
+    const std::function<bool( const Tile &, const PointCloud &, const VertColors & )> & func, const ProgressCallback & cb ) const
+{
+    const auto tiles = findTiles( box, level );
+    VertColors colors;
+    for ( size_t i = 0; i < tiles.size(); ++i )
+    {
+        if ( !reportProgress( cb, float( i ) / tiles.size() ) )
+            return unexpectedOperationCanceled();
+        colors.clear();
+        auto cloud = loadTile( tiles[i], &colors );
+        if ( !cloud )
+            return unexpected( std::move( cloud.error() ) );
+        if ( !func( tiles[i], *cloud, colors ) )
+            break;
+    }
+    return {};
+}
+
+Expected<void> TiledPointCloud::findPointsInBall( const Ball3f & ball, int level, const std::function<void( const Vector3f & )> & foundCallback ) const
+{
+    const auto radius = std::sqrt( ball.radiusSq );
+    const Box3f box( ball.center - Vector3f::diagonal( radius ), ball.center + Vector3f::diagonal( radius ) );
+    return forEachTile( box, level, [&]( const Tile & tile, const PointCloud & cloud, const VertColors & )
+    {
+        if ( tile.box.getDistanceSq( ball.center ) > ball.radiusSq )
+            return true;
+        for ( auto v : cloud.validPoints )
+            if ( !ball.outside( cloud.points[v] ) )
+                foundCallback( cloud.points[v] );
+        return true;
+    } );
+}
+
+TiledPointCloudBuilder::TiledPointCloudBuilder( std::filesystem::path folder, const Box3f & box, const TiledPointCloudSettings & settings )
+{
+    res_.folder_ = std::move( folder );
+    res_.box_ = box;
+    res_.settings_ = settings;
+    res_.settings_.depth = std::clamp( settings.depth, 0, cMaxDepth );
+    res_.settings_.lodResolution = std::max( settings.lodResolution, 1 );
+    recordSize_ = recordSize( settings.colors );
+
+    const auto depth = res_.settings_.depth;
+    res_.numPoints_.resize( depth + 1 );
+    res_.numPoints_[depth].resize( numTilesAtLevel( depth ), 0 );
+    buffers_.resize( numTilesAtLevel( depth ) );
+    written_.resize( numTilesAtLevel( depth ), false );
+}
+
+Expected<void> TiledPointCloudBuilder::addPoints( const VertCoords & points, const VertColors * colors )
+{
+    MR_TIMER;
+    assert( !res_.settings_.colors || ( colors && colors->size() >= points.size() ) );
+    if ( res_.settings_.colors && ( !colors || colors->size() < points.size() ) )
+        return unexpected( std::string( "Colors of points are not given" ) );
+
+    const auto depth = res_.settings_.depth;
+    for ( VertId v( 0 ); v < points.size(); ++v )
+    {
+        const auto i = tileIndex( depth, tilePos( res_.box_, depth, points[v] ) );
+        auto & buf = buffers_[i];
+        buf.insert( buf.end(), ( const char* )&points[v], ( const char* )&points[v] + sizeof( Vector3f ) );
+        if ( res_.settings_.colors )
+            buf.insert( buf.end(), ( const char* )&( *colors )[v], ( const char* )&( *colors )[v] + sizeof( Color ) );
+        ++res_.numPoints_[depth][i];
+        if ( ++numBuffered_ >= res_.settings_.maxBufferedPoints )
+        {
+            if ( auto flushed = flush_(); !flushed )
+                return flushed;
+        }
+    }
+    return {};
+}
+
+Expected<void> TiledPointCloudBuilder::flush_()
+{
+    MR_TIMER;
+    const auto depth = res_.settings_.depth;
+    std::atomic<bool> ioError{ false };
+    ParallelFor( buffers_, [&]( size_t i )
+    {
+        auto & buf = buffers_[i];
+        if ( buf.empty() )
+            return;
+        // the first write truncates the file possibly remaining from previous build in the same folder
+        const auto mode = written_[i] ? std::ofstream::binary | std::ofstream::app : std::ofstream::binary | std::ofstream::trunc;
+        written_[i] = true;
+        std::ofstream out( TiledPointCloud::tileFile( res_.folder_, depth, tilePos( depth, i ) ), mode );
+        out.write( buf.data(), buf.size() );
+        if ( !out )
+            ioError = true;
+        buf = {};
+    } );
+    numBuffered_ = 0;
+    if ( ioError )
+        return unexpected( "Cannot write tile files in " + utf8string( res_.folder_ ) );
+    return {};
+}
+
+Expected<TiledPointCloud> TiledPointCloudBuilder::finish( const ProgressCallback & cb )
+{
+    MR_TIMER;
+    if ( auto flushed = flush_(); !flushed )
+        return unexpected( std::move( flushed.error() ) );
+    buffers_ = {};
+
+    // each upper node takes the samples from the points of its children
+    const auto depth = res_.settings_.depth;
+    std::atomic<bool> ioError{ false };
+    for ( int level = depth - 1; level >= 0; --level )
+    {
+        auto & counts = res_.numPoints_[level];
+        const auto & childCounts = res_.numPoints_[level + 1];
+        counts.resize( numTilesAtLevel( level ), 0 );
+        const bool keepGoing = ParallelFor( size_t( 0 ), counts.size(), [&]( size_t i )
+        {
+            const auto pos = tilePos( level, i );
+            std::vector<char> records;
+            for ( int c = 0; c < 8; ++c )
+            {
+                const Vector3i childPos( 2 * pos.x + ( c & 1 ), 2 * pos.y + ( ( c >> 1 ) & 1 ), 2 * pos.z + ( c >> 2 ) );
+                if ( childCounts[tileIndex( level + 1, childPos )] == 0 )
+                    continue;
+                if ( !readWholeFile( TiledPointCloud::tileFile( res_.folder_, level + 1, childPos ), records ) )
+                    ioError = true;
+            }
+            if ( records.empty() )
+                return;
+            const auto samples = sampleRecords( records, recordSize_, TiledPointCloud::tileBox( res_.box_, level, pos ), res_.settings_.lodResolution );
+            std::ofstream out( TiledPointCloud::tileFile( res_.folder_, level, pos ), std::ofstream::binary );
+            out.write( samples.data(), samples.size() );
+            if ( !out )
+                ioError = true;
+            counts[i] = samples.size() / recordSize_;
+        }, subprogress( cb, float( depth - 1 - level ) / depth, float( depth - level ) / depth ) );
+        if ( !keepGoing )
+            return unexpectedOperationCanceled();
+        if ( ioError )
+            return unexpected( "Cannot write tile files in " + utf8string( res_.folder_ ) );
+    }
+
+    std::ofstream out( res_.folder_ / indexFileName, std::ofstream::binary );
+    out.write( cIndexMagic, sizeof( cIndexMagic ) );
+    out.write( ( const char* )&res_.box_, sizeof( Box3f ) );
+    const std::int32_t params[3] = { depth, res_.settings_.lodResolution, res_.settings_.colors ? 1 : 0 };
+    out.write( ( const char* )params, sizeof( params ) );
+    for ( const auto & counts : res_.numPoints_ )
+        out.write( ( const char* )counts.data(), counts.size() * sizeof( size_t ) );
+    if ( !out )
+        return unexpected( "Cannot write index of tiled point cloud in " + utf8string( res_.folder_ ) );
+
+    return std::move( res_ );
+}
+
+Expected<PointCloud> pointGridSampling( const TiledPointCloud & cloud, float voxelSize, const ProgressCallback & cb )
+{
+    MR_TIMER;
+    assert( voxelSize > 0 );
+    const auto & rootBox = cloud.box();
+    const auto depth = cloud.depth();
+    auto voxelPos = [&]( const Vector3f & p )
+    {
+        return Vector3<long long>(
+            (long long)std::floor( ( p.x - rootBox.min.x ) / voxelSize ),
+            (long long)std::floor( ( p.y - rootBox.min.y ) / voxelSize ),
+            (long long)std::floor( ( p.z - rootBox.min.z ) / voxelSize ) );
+    };
+
+    // each voxel is processed together with the leaf tile containing its minimal corner,
+    // and the points of the voxels crossing tile boundaries are loaded from neighbor tiles
+    PointCloud res;
+    const auto leaves = cloud.findTiles( rootBox, depth );
+    for ( size_t i = 0; i < leaves.size(); ++i )
+    {
+        if ( !reportProgress( cb, float( i ) / leaves.size() ) )
+            return unexpectedOperationCanceled();
+        const auto & tile = leaves[i];
+        const auto loadedBox = tile.box.expanded( Vector3f::diagonal( voxelSize ) );
+        auto part = cloud.loadBox( loadedBox, depth );
+        if ( !part )
+            return unexpected( std::move( part.error() ) );
+        const auto minVox = voxelPos( loadedBox.min );
+        const auto dims = voxelPos( loadedBox.max ) - minVox + Vector3<long long>::diagonal( 1 );
+
+        struct Sample
+        {
+            float centerDistSq = FLT_MAX;
+            VertId v;
+        };
+        HashMap<size_t, Sample> voxels;
+        for ( auto v : part->validPoints )
+        {
+            const auto & p = part->points[v];
+            const auto vox = voxelPos( p );
+            const auto voxMin = rootBox.min + Vector3f( vox ) * voxelSize;
+            if ( tilePos( rootBox, depth, voxMin ) != tile.pos )
+                continue;
+            const auto rel = vox - minVox;
+            auto & s = voxels[size_t( rel.x + ( rel.y + rel.z * dims.y ) * dims.x )];
+            const auto distSq = ( p - ( voxMin + Vector3f::diagonal( 0.5f * voxelSize ) ) ).lengthSq();
+            if ( distSq < s.centerDistSq )
+            {
+                s.centerDistSq = distSq;
+                s.v = v;
+            }
+        }
+        for ( const auto & [key, s] : voxels )
+            res.points.push_back( part->points[s.v] );
+    }
+    res.validPoints.resize( res.points.size(), true );
+    return res;
+}
+
+TEST( MRMesh, TiledPointCloud )
+{
+    // points on a regular grid with a step of 0.01 in the box [0,1)^3
+    PointCloud cloud;
+    VertColors colors;
+    for ( int z = 0; z < 100; z += 3 )
+        for ( int y = 0; y < 100; ++y )
+            for ( int x = 0; x < 100; ++x )
+            {
+                cloud.points.emplace_back( x * 0.01f, y * 0.01f, z * 0.01f );
+                colors.emplace_back( x, y, z );
+            }
+    cloud.validPoints.resize( cloud.points.size(), true );
+    const Box3f box( Vector3f(), Vector3f::diagonal( 1.0f ) );
+
+    UniqueTemporaryFolder folder( {} );
+    TiledPointCloudBuilder builder( folder, box, { .depth = 2, .lodResolution = 8, .colors = true, .maxBufferedPoints = 10000 } );
+    EXPECT_TRUE( builder.addPoints( cloud.points, &colors ).has_value() );
+    EXPECT_TRUE( builder.finish().has_value() );
+
+    auto tiled = TiledPointCloud::open( folder );
+    ASSERT_TRUE( tiled.has_value() );
+    EXPECT_EQ( tiled->depth(), 2 );
+    EXPECT_TRUE( tiled->hasColors() );
+    EXPECT_EQ( tiled->numPoints(), cloud.points.size() );
+
+    VertColors loadedColors;
+    auto all = tiled->loadBox( box, 2, &loadedColors );
+    ASSERT_TRUE( all.has_value() );
+    EXPECT_EQ( all->points.size(), cloud.points.size() );
+    ASSERT_EQ( loadedColors.size(), cloud.points.size() );
+    for ( VertId v( 0 ); v < all->points.size(); ++v )
+    {
+        const auto & p = all->points[v];
+        EXPECT_EQ( loadedColors[v], Color( int( std::lround( p.x * 100 ) ), int( std::lround( p.y * 100 ) ), int( std::lround( p.z * 100 ) ) ) );
+    }
+
+    // the root contains at most one point per voxel of 8x8x8 grid
+    auto root = tiled->loadBox( box, 0 );
+    ASSERT_TRUE( root.has_value() );
+    EXPECT_GT( root->points.size(), 0 );
+    EXPECT_LE( root->points.size(), 8 * 8 * 8 );
+
+    const Ball3f ball{ Vector3f::diagonal( 0.5f ), 0.04f };
+    size_t numInBall = 0;
+    EXPECT_TRUE( tiled->findPointsInBall( ball, 2, [&]( const Vector3f & ) { ++numInBall; } ).has_value() );
+    size_t expectedInBall = 0;
+    for ( const auto & p : cloud.points )
+        if ( !ball.outside( p ) )
+            ++expectedInBall;
+    EXPECT_EQ( numInBall, expectedInBall );
+
+    // voxels of size 0.1 contain 10x10x(3 or 4) points
+    auto samples = pointGridSampling( *tiled, 0.1f );
+    ASSERT_TRUE( samples.has_value() );
+    EXPECT_EQ( samples->points.size(), 1000 );
+
+    // building again in the same folder replaces previous tiles
+    PointCloud half;
+    half.points.vec_.assign( cloud.points.vec_.begin(), cloud.points.vec_.begin() + cloud.points.size() / 2 );
+    half.validPoints.resize( half.points.size(), true );
+    TiledPointCloudBuilder builder2( folder, box, { .depth = 2, .lodResolution = 8 } );
+    EXPECT_TRUE( builder2.addPoints( half.points ).has_value() );
+    EXPECT_TRUE( builder2.finish().has_value() );
+    auto tiled2 = TiledPointCloud::open( folder );
+    ASSERT_TRUE( tiled2.has_value() );
+    EXPECT_EQ( tiled2->numPoints(), half.points.size() );
+    auto all2 = tiled2->loadBox( box, 2 );
+    ASSERT_TRUE( all2.has_value() );
+    EXPECT_EQ( all2->points.size(), half.points.size() );
+
+    // building from PLY file
+    UniqueTemporaryFolder plyFolder( {} );
+    const auto plyFile = plyFolder / "cloud.ply";
+    EXPECT_TRUE( PointsSave::toPly( cloud, plyFile, { .colors = &colors } ).has_value() );
+    auto fromPly = PointsLoad::plyToTiledPointCloud( plyFile, plyFolder, { .depth = 2, .lodResolution = 8, .colors = true } );
+    ASSERT_TRUE( fromPly.has_value() );
+    EXPECT_EQ( fromPly->numPoints(), cloud.points.size() );
+    VertColors plyColors;
+    auto allPly = fromPly->loadBox( fromPly->box(), 2, &plyColors );
+    ASSERT_TRUE( allPly.has_value() );
+    EXPECT_EQ( allPly->points.size(), cloud.points.size() );
+    ASSERT_EQ( plyColors.size(), cloud.points.size() );
+    for ( VertId v( 0 ); v < allPly->points.size(); ++v )
+    {
+        const auto & p = allPly->points[v];
+        EXPECT_EQ( plyColors[v], Color( int( std::lround( p.x * 100 ) ), int( std::lround( p.y * 100 ) ), int( std::lround( p.z * 100 ) ) ) );
+    }
+}
+
+} //namespace MR
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "MRMeshFwd.h"
+#include "MRBox.h"
+#include "MRBall.h"
+#include "MRExpected.h"
+#include "MRProgressCallback.h"
+#include "MRPch/MRBindingMacros.h"
+#include <filesystem>
+#include <functional>
+#include <vector>
+
+namespace MR
+{
+
+/// \addtogroup PointCloudGroup
+/// \{
+
+/// parameters of out-of-core tiled point cloud
+struct TiledPointCloudSettings
+{
+    /// the number of octree levels below the root (at most 7);
+    /// the leaves of the octree form the grid of 2^depth tiles along each axis and contain all points
+    int depth = 4;
+
+    /// each not-leaf node of the octree (level of details) contains at most one point per voxel,
+    /// where the node is subdivided on this number of voxels along each axis
+    int lodResolution = 128;
+
+    /// if true then a color is stored together with each point
+    bool colors = false;
+
+    /// the maximal number of points kept in memory by the builder before writing them in tile files
+    size_t maxBufferedPoints = size_t( 1 ) << 24;
+};
+
+/// point cloud stored on disk in the files of octree nodes, where the leaves contain all points in their boxes,
+/// and upper nodes contain decimated points (levels of details); only requested tiles are loaded in memory
+class MR_BIND_IGNORE TiledPointCloud
+{
+public:
+    /// one node of the octree
+    struct Tile
+    {
+        /// 0 for the root, depth() for the leaves
+        int level = 0;
+        /// the position of the tile in the grid of 2^level tiles along each axis
+        Vector3i pos;
+        Box3f box;
+        size_t numPoints = 0;
+    };
+
+    /// opens the tiled point cloud previously built by TiledPointCloudBuilder in given folder
+    [[nodiscard]] MRMESH_API static Expected<TiledPointCloud> open( const std::filesystem::path & folder );
+
+    /// the box of the root tile
+    [[nodiscard]] const Box3f & box() const { return box_; }
+
+    /// the level of the leaves
+    [[nodiscard]] int depth() const { return settings_.depth; }
+
+    /// returns true if the colors of points are stored
+    [[nodiscard]] bool hasColors() const { return settings_.colors; }
+
+    /// the total number of points in the leaves
+    [[nodiscard]] MRMESH_API size_t numPoints() const;
+
+    /// returns all not-empty tiles of given level with the boxes intersecting given box
+    [[nodiscard]] MRMESH_API std::vector<Tile> findTiles( const Box3f & box, int level ) const;
+
+    /// loads all points of given tile;
+    /// \param colors if not null and the colors are stored, then receives the colors of loaded points
+    [[nodiscard]] MRMESH_API Expected<PointCloud> loadTile( const Tile & tile, VertColors * colors = nullptr ) const;
+
+    /// loads the points of given level located within given box from all tiles intersecting it;
+    /// \param colors if not null and the colors are stored, then receives the colors of loaded points
+    [[nodiscard]] MRMESH_API Expected<PointCloud> loadBox( const Box3f & box, int level, VertColors * colors = nullptr ) const;
+
+    /// calls given function for each not-empty tile of given level intersecting given box,
+    /// only one tile is kept in memory at a time; the iteration stops if the function returns false
+    MRMESH_API Expected<void> forEachTile( const Box3f & box, int level,
+        const std::function<bool( const Tile &, const PointCloud &, const VertColors & )> & func, const ProgressCallback & cb = {} ) const;
+
+    /// finds all points of given level inside or on the surface of given ball
+    MRMESH_API Expected<void> findPointsInBall( const Ball3f & ball, int level, const std::function<void( const Vector3f & )> & foundCallback ) const;
+
+    /// returns the path to the file with the points of given tile
+    [[nodiscard]] MRMESH_API static std::filesystem::path tileFile( const std::filesystem::path & folder, int level, const Vector3i & pos );
+
+    /// returns the box of the tile at given level and position for the cloud with given root box
+    [[nodiscard]] MRMESH_API static Box3f tileBox( const Box3f & rootBox, int level, const Vector3i & pos );
+
+private:
+    friend class TiledPointCloudBuilder;
+    std::filesystem::path folder_;
+    Box3f box_;
+    TiledPointCloudSettings settings_;
+    /// numPoints_[level][i] is the number of points in the tile with linear index i at given level
+    std::vector<std::vector<size_t>> numPoints_;
+};
+
+/// builds tiled point cloud in given folder from the points added part by part,
+/// only limited number of points is kept in memory at any moment
+class MR_BIND_IGNORE TiledPointCloudBuilder
+{
+public:
+    /// \param folder where the files of the tiles will be created (it must exist)
+    /// \param box all added points must be within this box, other points are put in the closest tiles
+    MRMESH_API TiledPointCloudBuilder( std::filesystem::path folder, const Box3f & box, const TiledPointCloudSettings & settings = {} );
+
+    /// distributes given points among the leaves of the octree;
+    /// \param colors must be given if settings.colors is true
+    MRMESH_API Expected<void> addPoints( const VertCoords & points, const VertColors * colors = nullptr );
+
+    /// writes all remaining points, builds the levels of details and the index of the tiles;
+    /// no points can be added after that
+    MRMESH_API Expected<TiledPointCloud> finish( const ProgressCallback & cb = {} );
+
+private:
+    Expected<void> flush_();
+
+    TiledPointCloud res_;
+    size_t recordSize_ = 0;
+    /// not written points of each leaf
+    std::vector<std::vector<char>> buffers_;
+    /// whether the file of each leaf was already written by this builder (as vector of chars to be modified from parallel threads)
+    std::vector<char> written_;
+    size_t numBuffered_ = 0;
+};
+
+/// performs sampling of the points from the leaves of tiled cloud, loading one tile at a time;
+/// subdivides the root box on voxels of given size and returns at most one point (closest to voxel center) per voxel
+[[nodiscard]] MRMESH_API Expected<PointCloud> pointGridSampling( const TiledPointCloud & cloud, float voxelSize, const ProgressCallback & cb = {} );
+
+/// \}
+
+} //namespace MR
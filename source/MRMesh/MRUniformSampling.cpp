@@ -5,6 +5,7 @@
 #include "MRTimer.h"
 #include "MRPointsInBall.h"
 #include "MRBox.h"
+#include "MRPointNeighborhoodGraph.h"
 #include <cfloat>
 
 namespace MR
@@ -30,6 +31,15 @@ std::optional<VertBitSet> pointUniformSampling( const PointCloud& pointCloud, co
     };
     std::vector<NearVert> nearVerts;
 
+    std::shared_ptr<const PointNeighborhoodGraph> cachedGraph;
+    const PointNeighborhoodGraph * graph = settings.neighborhoodGraph;
+    assert( !graph || graph->coversRadius( settings.distance ) );
+    if ( !graph || !graph->coversRadius( settings.distance ) )
+    {
+        cachedGraph = findCachedNeighborhoodGraph( pointCloud, { .radius = settings.distance } );
+        graph = cachedGraph.get();
+    }
+
     auto processOne = [&]( VertId v )
     {
         if ( visited.test( v ) )
@@ -37,15 +47,30 @@ std::optional<VertBitSet> pointUniformSampling( const PointCloud& pointCloud, co
         sampled.set( v );
         const auto c = pointCloud.points[v];
         float localMaxDistSq = sqr( settings.distance );
-        findPointsInBall( pointCloud, { c, localMaxDistSq }, [&] ( const PointsProjectionResult & found, const Vector3f&, Ball3f & )
+        auto addNear = [&]( VertId u, float distSq )
         {
-            const auto u = found.vId;
             if ( pNormals && std::abs( dot( (*pNormals)[v], (*pNormals)[u] ) ) < settings.minNormalDot )
-                localMaxDistSq = std::min( localMaxDistSq, found.distSq );
+                localMaxDistSq = std::min( localMaxDistSq, distSq );
             else
-                nearVerts.push_back( { u, found.distSq } );
-            return Processing::Continue;
-        } );
+                nearVerts.push_back( { u, distSq } );
+        };
+        if ( graph )
+        {
+            graph->forEachNeighbor( v, [&]( VertId u )
+            {
+                const auto distSq = ( pointCloud.points[u] - c ).lengthSq();
+                if ( distSq <= sqr( settings.distance ) )
+                    addNear( u, distSq );
+            } );
+        }
+        else
+        {
+            findPointsInBall( pointCloud, { c, localMaxDistSq }, [&] ( const PointsProjectionResult & found, const Vector3f&, Ball3f & )
+            {
+                addNear( found.vId, found.distSq );
+                return Processing::Continue;
+            } );
+        }
         for ( const auto & [ u, distSq ] : nearVerts )
         {
             if ( distSq >= localMaxDistSq )
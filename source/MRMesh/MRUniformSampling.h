@@ -22,6 +22,10 @@ struct UniformSamplingSettings
     bool lexicographicalOrder = true;
     /// if not nullptr then these normals will be used during sampling instead of normals in the cloud itself
     const VertNormals * pNormals = nullptr;
+    /// if not nullptr then the neighbours of points are taken from this graph, which must be built with the radius not less than (distance)
+    /// (a graph with fixed number of neighbours cannot be used here, since it can miss some points within the distance);
+    /// if nullptr then the graph cached in the cloud is used if it covers (distance)
+    const PointNeighborhoodGraph * neighborhoodGraph = nullptr;
     /// to report progress and cancel processing
     ProgressCallback progress;
 };
@@ -8,6 +8,11 @@
 #include "MRMeshDecimate.h"
 #include "MRMeshCollidePrecise.h"
 #include "MRBox.h"
+#include "MRParallelFor.h"
+#include "MRMakeSphereMesh.h"
+#include "MRMeshComponents.h"
+#include "MRGTest.h"
+#include <numeric>
 #include <random>
 
 namespace MR
@@ -171,6 +176,60 @@ private:
     std::vector<Mesh>& mergedMeshes_;
 };
 
+namespace
+{
+
+// reorders the meshes so that spatially close meshes get close indices:
+// the meshes are recursively split in halves by the median of box centers along the largest dimension
+// in the same way as the range is split by the balanced reduction, so each its subtree unites the meshes from compact region
+void orderMeshesSpatially( std::vector<Mesh>& meshes )
+{
+    MR_TIMER;
+    if ( meshes.size() <= 2 )
+        return;
+
+    std::vector<Vector3f> centers( meshes.size() );
+    ParallelFor( centers, [&] ( size_t i )
+    {
+        // the tree is reused by the boolean afterwards
+        centers[i] = meshes[i].getBoundingBox().center();
+    } );
+
+    std::vector<int> order( meshes.size() );
+    std::iota( order.begin(), order.end(), 0 );
+    std::vector<std::pair<int, int>> ranges{ { 0, int( order.size() ) } };
+    while ( !ranges.empty() )
+    {
+        const auto [first, last] = ranges.back();
+        ranges.pop_back();
+        if ( last - first <= 2 )
+            continue;
+
+        Box3f box;
+        for ( int i = first; i < last; ++i )
+            box.include( centers[order[i]] );
+        auto boxDiag = box.max - box.min;
+        const int splitDim = int( std::max_element( begin( boxDiag ), end( boxDiag ) ) - begin( boxDiag ) );
+
+        // same as tbb::blocked_range splits
+        const int mid = first + ( last - first ) / 2;
+        std::nth_element( order.begin() + first, order.begin() + mid, order.begin() + last, [&] ( int a, int b )
+        {
+            return centers[a][splitDim] < centers[b][splitDim];
+        } );
+        ranges.emplace_back( first, mid );
+        ranges.emplace_back( mid, last );
+    }
+
+    std::vector<Mesh> ordered;
+    ordered.reserve( meshes.size() );
+    for ( int i : order )
+        ordered.push_back( std::move( meshes[i] ) );
+    meshes = std::move( ordered );
+}
+
+} // anonymous namespace
+
 Expected<Mesh> uniteManyMeshes(
     const std::vector<const Mesh*>& meshes, const UniteManyMeshesParams& params /*= {} */ )
 {
@@ -310,6 +369,9 @@ Expected<Mesh> uniteManyMeshes(
         } );
     }
 
+    // let the balanced reduction unite spatially close meshes first
+    orderMeshesSpatially( mergedMeshes );
+
     float currentProgress = separateComponentsProcess ? 0.7f : 0.3f;
     if ( !reportProgress( params.progressCb, currentProgress ) )
         return unexpectedOperationCanceled();
@@ -325,7 +387,8 @@ Expected<Mesh> uniteManyMeshes(
                 shift[i] = dist( mt );
     }
 
-    // parallel reduce unite merged meshes
+    // parallel reduce unite merged meshes: the range is split in halves down to single meshes,
+    // so the independent pairs and then the subtrees are united concurrently with logarithmic depth
     UniteReducerParams urParams;
     urParams.commonParams.fixDegeneracies = params.fixDegenerations;
     urParams.commonParams.forceCut = params.forceCut;
@@ -347,4 +410,28 @@ Expected<Mesh> uniteManyMeshes(
     return reducer.resultMesh;
 }
 
+TEST( MRMesh, UniteManyMeshes )
+{
+    // a chain of overlapping spheres given not in spatial order
+    const Mesh sphere = makeUVSphere( 1.0f, 16, 16 );
+    const double sphereVolume = sphere.volume();
+    std::vector<Mesh> spheres;
+    for ( int i : { 5, 2, 7, 0, 3, 6, 1, 4 } )
+    {
+        spheres.push_back( sphere );
+        spheres.back().transform( AffineXf3f::translation( Vector3f( 1.5f * i, 0.f, 0.f ) ) );
+    }
+    std::vector<const Mesh*> meshes;
+    for ( const auto& m : spheres )
+        meshes.push_back( &m );
+
+    auto res = uniteManyMeshes( meshes );
+    ASSERT_TRUE( res.has_value() );
+    EXPECT_EQ( MeshComponents::getNumComponents( *res ), 1 );
+    EXPECT_TRUE( res->topology.isClosed() );
+    const double volume = res->volume();
+    EXPECT_GT( volume, 4 * sphereVolume );
+    EXPECT_LT( volume, 8 * sphereVolume );
+}
+
 }
@@ -52,7 +52,7 @@ struct UniteManyMeshesParams
 
 // Computes the surface of objects' union each of which is defined by its own surface mesh
 // - merge non intersecting meshes first
-// - unite merged groups
+// - unite merged groups by balanced parallel reduction, where spatially close groups are united first
 MRMESH_API Expected<Mesh> uniteManyMeshes( const std::vector<const Mesh*>& meshes, 
     const UniteManyMeshesParams& params = {} );
 
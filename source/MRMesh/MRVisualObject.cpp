@@ -200,7 +200,8 @@ void VisualObject::resetDirtyExceptMask( uint32_t mask ) const
 
 Box3f VisualObject::getBoundingBox() const
 {
-    if ( dirty_ & DIRTY_BOUNDING_BOX )
+    // the box of deferred model is read from the scene and kept until the model is loaded
+    if ( ( dirty_ & DIRTY_BOUNDING_BOX ) && !hasDeferredModel() )
     {
         boundingBoxCache_ = computeBoundingBox_();
         dirty_ &= ~DIRTY_BOUNDING_BOX;
@@ -350,6 +351,9 @@ MR_SUPPRESS_WARNING_POP
     root["Type"].append( VisualObject::TypeName() );
 
     root["UseDefaultSceneProperties"] = useDefaultScenePropertiesOnDeserialization_;
+
+    // to know the box of the object before its model is loaded
+    serializeToJson( getBoundingBox(), root["BoundingBox"] );
 }
 
 void VisualObject::deserializeFields_( const Json::Value& root )
@@ -390,6 +394,12 @@ MR_SUPPRESS_WARNING_POP
         setDefaultSceneProperties_();
 
     dirty_ = DIRTY_ALL;
+    if ( hasDeferredModel() )
+    {
+        boundingBoxCache_ = Box3f();
+        deserializeFromJson( root["BoundingBox"], boundingBoxCache_ );
+        dirty_ &= ~DIRTY_BOUNDING_BOX;
+    }
 }
 
 Box3f VisualObject::getWorldBox( ViewportId id ) const
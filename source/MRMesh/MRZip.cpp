@@ -1,8 +1,12 @@
 #include "MRZip.h"
 #include "MRDirectory.h"
 #include "MRIOParsing.h"
+#include "MRParallelFor.h"
 #include "MRStringConvert.h"
 #include "MRTimer.h"
+#include "MRUniqueTemporaryFolder.h"
+#include "MRGTest.h"
+#include "MRPch/MRTBB.h"
 
 #if (defined(__APPLE__) && defined(__clang__)) || defined(__EMSCRIPTEN__)
 #pragma clang diagnostic push
@@ -18,6 +22,9 @@
 
 #include <cassert>
 #include <fstream>
+#include <memory>
+#include <numeric>
+#include <optional>
 
 namespace MR
 {
@@ -162,7 +169,35 @@ zip_int64_t istreamZipSourceCallback( void *istream, void *data, zip_uint64_t le
     return -1;
 }
 
-Expected<void> decompressZip_( zip_t * zip, const std::filesystem::path& targetFolder, const char * password )
+/// extracts one file from the archive in given path, which parent folder must exist
+Expected<void> extractFile( zip_t * zip, zip_uint64_t index, const zip_stat_t & stats, const std::filesystem::path& newItemPath,
+    std::vector<char> & fileBufer )
+{
+    zip_file_t* zfile = zip_fopen_index( zip, index, 0 );
+    if ( !zfile )
+        return unexpected( std::string( "Cannot open zip file " ) + stats.name );
+
+    std::ofstream ofs( newItemPath, std::ios::binary );
+    if ( !ofs || ofs.bad() )
+    {
+        zip_fclose( zfile );
+        return unexpected( "Cannot create file " + utf8string( newItemPath ) );
+    }
+
+    fileBufer.resize( stats.size );
+    auto bitesRead = zip_fread( zfile, (void*)fileBufer.data(), fileBufer.size() );
+    zip_fclose( zfile );
+    if ( bitesRead != (zip_int64_t)stats.size )
+        return unexpected( std::string( "Cannot read file from zip " ) + stats.name );
+
+    if ( !ofs.write( fileBufer.data(), fileBufer.size() ) )
+        return unexpected( "Cannot write file from zip " + utf8string( newItemPath ) );
+    return {};
+}
+
+/// if zipFile is given then the files are extracted in parallel threads, each opening the archive again
+Expected<void> decompressZip_( zip_t * zip, const std::filesystem::path& targetFolder, const char * password,
+    const std::filesystem::path* zipFile = nullptr )
 {
     assert( zip );
 
@@ -173,8 +208,15 @@ Expected<void> decompressZip_( zip_t * zip, const std::filesystem::path& targetF
     if ( password )
         zip_set_default_password( zip, password );
 
+    struct FileToExtract
+    {
+        zip_uint64_t index = 0;
+        zip_stat_t stats;
+        std::filesystem::path path;
+    };
+    std::vector<FileToExtract> deferredFiles;
+
     zip_stat_t stats;
-    zip_file_t* zfile;
     std::vector<char> fileBufer;
     for ( int i = 0; i < zip_get_num_entries( zip, 0 ); ++i )
     {
@@ -186,46 +228,178 @@ Expected<void> decompressZip_( zip_t * zip, const std::filesystem::path& targetF
         std::filesystem::path relativeName = pathFromUtf8( nameFixed );
         relativeName.make_preferred();
         std::filesystem::path newItemPath = targetFolder / relativeName;
+        // in some manually created zip-files there is no folder entries for files in sub-folders;
+        // so let us create directory each time before saving a file in it
+        if ( !std::filesystem::exists( newItemPath.parent_path(), ec ) )
+            if ( !std::filesystem::create_directories( newItemPath.parent_path(), ec ) )
+                return unexpected( "Cannot create folder " + utf8string( newItemPath.parent_path() ) );
         if ( !nameFixed.empty() && nameFixed.back() == '/' )
+            continue;
+
+        if ( zipFile )
         {
-            if ( !std::filesystem::exists( newItemPath.parent_path(), ec ) )
-                if ( !std::filesystem::create_directories( newItemPath.parent_path(), ec ) )
-                    return unexpected( "Cannot create folder " + utf8string( newItemPath.parent_path() ) );
+            deferredFiles.push_back( { .index = zip_uint64_t( i ), .stats = stats, .path = std::move( newItemPath ) } );
+            continue;
         }
-        else
+        if ( auto res = extractFile( zip, i, stats, newItemPath, fileBufer ); !res )
+            return res;
+    }
+    if ( deferredFiles.empty() )
+        return {};
+
+    // each thread opens its own handle of the archive, since a handle cannot be used concurrently
+    struct ThreadData
+    {
+        std::unique_ptr<AutoCloseZip> zip;
+        std::vector<char> fileBufer;
+    };
+    tbb::enumerable_thread_specific<ThreadData> threadData;
+    std::vector<std::string> errors( deferredFiles.size() );
+    std::atomic<bool> failed{ false };
+    ParallelFor( size_t( 0 ), deferredFiles.size(), threadData, [&] ( size_t i, ThreadData & td )
+    {
+        if ( failed.load( std::memory_order_relaxed ) )
+            return;
+        const auto & file = deferredFiles[i];
+        if ( !td.zip )
+        {
+            int err;
+            td.zip = std::make_unique<AutoCloseZip>( utf8string( *zipFile ).c_str(), ZIP_RDONLY, &err );
+            if ( !*td.zip )
+            {
+                td.zip.reset();
+                errors[i] = "Cannot open zip, error code: " + std::to_string( err );
+                failed = true;
+                return;
+            }
+            if ( password )
+                zip_set_default_password( *td.zip, password );
+        }
+        if ( auto res = extractFile( *td.zip, file.index, file.stats, file.path, td.fileBufer ); !res )
         {
-            zfile = zip_fopen_index(zip,i,0);
-            if ( !zfile )
-                return unexpected( "Cannot open zip file " + nameFixed );
-
-            // in some manually created zip-files there is no folder entries for files in sub-folders;
-            // so let us create directory each time before saving a file in it
-            if ( !std::filesystem::exists( newItemPath.parent_path(), ec ) )
-                if ( !std::filesystem::create_directories( newItemPath.parent_path(), ec ) )
-                    return unexpected( "Cannot create folder " + utf8string( newItemPath.parent_path() ) );
-
-            std::ofstream ofs( newItemPath, std::ios::binary );
-            if ( !ofs || ofs.bad() )
-                return unexpected( "Cannot create file " + utf8string( newItemPath ) );
-
-            fileBufer.resize(stats.size);
-            auto bitesRead = zip_fread(zfile,(void*)fileBufer.data(),fileBufer.size());
-            if ( bitesRead != (zip_int64_t)stats.size )
-                return unexpected( "Cannot read file from zip " + nameFixed );
-
-            zip_fclose(zfile);
-            if ( !ofs.write( fileBufer.data(), fileBufer.size() ) )
-                return unexpected( "Cannot write file from zip " + utf8string( newItemPath ) );
-            ofs.close();
+            errors[i] = std::move( res.error() );
+            failed = true;
         }
+    } );
+
+    for ( auto & error : errors )
+        if ( !error.empty() )
+            return unexpected( std::move( error ) );
+    return {};
+}
+
+/// a file to be added in zip-archive
+struct FileToZip
+{
+    std::filesystem::path path;
+    std::string archivePath;
+    std::uintmax_t size = 0;
+    size_t part = 0; ///< the index of temporary archive, where the file is compressed in parallel mode
+    zip_int64_t indexInPart = -1; ///< the index of the file in that archive
+};
+
+/// sets the compression of given file in the archive according to zlib convention for the level: -1 - default, 0 - no compression, 1..9 - deflate;
+/// returns zero on success
+int setFileCompression( zip_t * zip, zip_int64_t index, int compressionLevel )
+{
+    if ( compressionLevel < 0 )
+        return 0; // keep libzip's default
+    if ( compressionLevel == 0 )
+        return zip_set_file_compression( zip, index, ZIP_CM_STORE, 0 );
+    return zip_set_file_compression( zip, index, ZIP_CM_DEFLATE, zip_uint32_t( compressionLevel ) );
+}
+
+std::string partPath( const std::filesystem::path& folder, size_t part )
+{
+    return utf8string( folder / ( std::to_string( part ) + ".zip" ) );
+}
+
+/// distributes the files among given number of temporary archives with approximately equal total sizes of files,
+/// and compresses each archive in a separate thread
+Expected<void> compressInParts( std::vector<FileToZip>& files, size_t numParts, const std::filesystem::path& folder,
+    int compressionLevel, ProgressCallback cb )
+{
+    MR_TIMER;
+    // the largest files are distributed first, each in the part with the smallest total size so far
+    std::vector<size_t> order( files.size() );
+    std::iota( order.begin(), order.end(), size_t( 0 ) );
+    std::sort( order.begin(), order.end(), [&] ( size_t a, size_t b ) { return files[a].size > files[b].size; } );
+    std::vector<std::uintmax_t> partSize( numParts, 0 );
+    std::vector<std::vector<size_t>> partFiles( numParts );
+    for ( auto i : order )
+    {
+        const auto p = size_t( std::min_element( partSize.begin(), partSize.end() ) - partSize.begin() );
+        files[i].part = p;
+        partSize[p] += files[i].size;
+        partFiles[p].push_back( i );
     }
+
+    std::vector<std::string> errors( numParts );
+    const auto keepGoing = ParallelFor( size_t( 0 ), numParts, [&] ( size_t p )
+    {
+        int err;
+        AutoCloseZip part( partPath( folder, p ).c_str(), ZIP_CREATE | ZIP_TRUNCATE, &err );
+        if ( !part )
+        {
+            errors[p] = "Cannot create temporary zip, error code: " + std::to_string( err );
+            return;
+        }
+        for ( auto i : partFiles[p] )
+        {
+            auto & file = files[i];
+            auto fileSource = zip_source_file( part, utf8string( file.path ).c_str(), 0, 0 );
+            if ( !fileSource )
+            {
+                errors[p] = "Cannot open file " + utf8string( file.path ) + " for reading";
+                return;
+            }
+            file.indexInPart = zip_file_add( part, std::to_string( i ).c_str(), fileSource, ZIP_FL_OVERWRITE );
+            if ( file.indexInPart < 0 )
+            {
+                zip_source_free( fileSource );
+                errors[p] = "Cannot add file " + file.archivePath + " to temporary archive";
+                return;
+            }
+            if ( setFileCompression( part, file.indexInPart, compressionLevel ) )
+            {
+                errors[p] = "Cannot set compression of file " + file.archivePath + " in archive";
+                return;
+            }
+        }
+        // the files are actually compressed here
+        if ( part.close() == -1 )
+            errors[p] = "Cannot close temporary zip";
+    }, cb, 1 );
+
+    for ( auto & error : errors )
+        if ( !error.empty() )
+            return unexpected( std::move( error ) );
+    if ( !keepGoing )
+        return unexpectedOperationCanceled();
     return {};
 }
 
+/// makes the source with compressed data of given file in another archive, which will be copied in (zip) without recompression
+zip_source_t * compressedSourceFromZip( zip_t * zip, zip_t * srcZip, zip_int64_t index )
+{
+#if (defined(LIBZIP_VERSION_MINOR) && LIBZIP_VERSION_MINOR >= 10 )
+    return zip_source_zip_file( zip, srcZip, zip_uint64_t( index ), ZIP_FL_COMPRESSED, 0, -1, nullptr );
+#else
+    // whole file (start = 0, len = 0) is taken in compressed form
+    return zip_source_zip( zip, srcZip, zip_uint64_t( index ), 0, 0, 0 );
+#endif
+}
+
 } // anonymous namespace
 
 Expected<void> compressZip( const std::filesystem::path& zipFile, const std::filesystem::path& sourceFolder,
     const std::vector<std::filesystem::path>& excludeFiles, const char * password, ProgressCallback cb )
+{
+    return compressZip( zipFile, sourceFolder, { .excludeFiles = excludeFiles, .password = password }, std::move( cb ) );
+}
+
+Expected<void> compressZip( const std::filesystem::path& zipFile, const std::filesystem::path& sourceFolder,
+    const CompressZipSettings& settings, ProgressCallback cb )
 {
     MR_TIMER;
 
@@ -236,72 +410,101 @@ Expected<void> compressZip( const std::filesystem::path& zipFile, const std::fil
     if ( !std::filesystem::is_directory( sourceFolder, ec ) )
         return unexpected( "Directory '" + utf8string( sourceFolder ) + "' does not exist" );
 
-    int err;
-    AutoCloseZip zip( utf8string( zipFile ).c_str(), ZIP_CREATE | ZIP_TRUNCATE, &err, subprogress( cb, 0.5f, 1.0f ) );
-    if ( !zip )
-        return unexpected( "Cannot create zip, error code: " + std::to_string( err ) );
-
     auto goodFile = [&]( const std::filesystem::path & path )
     {
         if ( !is_regular_file( path, ec ) )
             return false;
-        auto excluded = std::find_if( excludeFiles.begin(), excludeFiles.end(), [&] ( const auto& a )
+        auto excluded = std::find_if( settings.excludeFiles.begin(), settings.excludeFiles.end(), [&] ( const auto& a )
         {
             return std::filesystem::equivalent( a, path, ec );
         } );
-        return excluded == excludeFiles.end();
+        return excluded == settings.excludeFiles.end();
+    };
+
+    auto archivePath = [&]( const std::filesystem::path & path )
+    {
+        auto res = utf8string( std::filesystem::relative( path, sourceFolder, ec ) );
+        // convert folder separators in Linux style for the latest 7-zip to open archive correctly
+        std::replace( res.begin(), res.end(), '\\', '/' );
+        return res;
     };
 
-    // pass #1: add directories in the archive and count the files
-    int totalFiles = 0;
+    // pass #1: find directories and files for the archive
+    std::vector<std::string> archiveDirs;
+    std::vector<FileToZip> files;
     for ( auto entry : DirectoryRecursive{ sourceFolder, ec } )
     {
         const auto path = entry.path();
         if ( entry.is_directory( ec ) && path != sourceFolder )
+            archiveDirs.push_back( archivePath( path ) );
+        else if ( goodFile( path ) )
+            files.push_back( { .path = path, .archivePath = archivePath( path ), .size = entry.file_size( ec ) } );
+    }
+
+    // pass #2 (optional): compress the files in temporary archives in parallel threads;
+    // these archives must be open until the result archive is closed, since their data are copied from there
+    std::optional<UniqueTemporaryFolder> partsFolder;
+    std::vector<std::unique_ptr<AutoCloseZip>> parts;
+    const auto numParts = settings.parallel ?
+        std::min( files.size(), size_t( std::max( 1, tbb::this_task_arena::max_concurrency() ) ) ) : 0;
+    if ( numParts > 1 )
+    {
+        partsFolder.emplace( FolderCallback{} );
+        if ( !*partsFolder )
+            return unexpected( "Cannot create temporary folder" );
+        if ( auto res = compressInParts( files, numParts, *partsFolder, settings.compressionLevel, subprogress( cb, 0.0f, 0.8f ) ); !res )
+            return unexpected( std::move( res.error() ) );
+
+        for ( size_t p = 0; p < numParts; ++p )
         {
-            auto archiveDirPath = utf8string( std::filesystem::relative( path, sourceFolder, ec ) );
-            // convert folder separators in Linux style for the latest 7-zip to open archive correctly
-            std::replace( archiveDirPath.begin(), archiveDirPath.end(), '\\', '/' );
-            if ( zip_dir_add( zip, archiveDirPath.c_str(), ZIP_FL_ENC_UTF_8 ) == -1 )
-                return unexpected( "Cannot add directory " + archiveDirPath + " to archive" );
-            continue;
+            int err;
+            parts.push_back( std::make_unique<AutoCloseZip>( partPath( *partsFolder, p ).c_str(), ZIP_RDONLY, &err ) );
+            if ( !*parts.back() )
+                return unexpected( "Cannot open temporary zip, error code: " + std::to_string( err ) );
         }
+    }
+
+    int err;
+    AutoCloseZip zip( utf8string( zipFile ).c_str(), ZIP_CREATE | ZIP_TRUNCATE, &err, subprogress( cb, parts.empty() ? 0.5f : 0.8f, 1.0f ) );
+    if ( !zip )
+        return unexpected( "Cannot create zip, error code: " + std::to_string( err ) );
 
-        if ( goodFile( path ) )
-            ++totalFiles;
+    for ( const auto & archiveDirPath : archiveDirs )
+    {
+        if ( zip_dir_add( zip, archiveDirPath.c_str(), ZIP_FL_ENC_UTF_8 ) == -1 )
+            return unexpected( "Cannot add directory " + archiveDirPath + " to archive" );
     }
 
-    // pass #2: add files in the archive
-    int compressedFiles = 0;
+    // pass #3: add files in the archive
     auto scb = subprogress( cb, 0.0f, 0.5f );
-    for ( auto entry : DirectoryRecursive{ sourceFolder, ec } )
+    for ( size_t i = 0; i < files.size(); ++i )
     {
-        const auto path = entry.path();
-        if ( !goodFile( path ) )
-            continue;
-
-        auto fileSource = zip_source_file( zip, utf8string( path ).c_str(), 0, 0 );
+        const auto & file = files[i];
+        zip_source_t * fileSource = nullptr;
+        if ( !parts.empty() )
+            fileSource = compressedSourceFromZip( zip, *parts[file.part], file.indexInPart );
+        else
+            fileSource = zip_source_file( zip, utf8string( file.path ).c_str(), 0, 0 );
         if ( !fileSource )
-            return unexpected( "Cannot open file " + utf8string( path ) + " for reading" );
+            return unexpected( "Cannot open file " + utf8string( file.path ) + " for reading" );
 
-        auto archiveFilePath = utf8string( std::filesystem::relative( path, sourceFolder, ec ) );
-        // convert folder separators in Linux style for the latest 7-zip to open archive correctly
-        std::replace( archiveFilePath.begin(), archiveFilePath.end(), '\\', '/' );
-        const auto index = zip_file_add( zip, archiveFilePath.c_str(), fileSource, ZIP_FL_OVERWRITE | ZIP_FL_ENC_UTF_8 );
+        const auto index = zip_file_add( zip, file.archivePath.c_str(), fileSource, ZIP_FL_OVERWRITE | ZIP_FL_ENC_UTF_8 );
         if ( index < 0 )
         {
             zip_source_free( fileSource );
-            return unexpected( "Cannot add file " + archiveFilePath + " to archive" );
+            return unexpected( "Cannot add file " + file.archivePath + " to archive" );
         }
 
-        if ( password )
+        if ( parts.empty() && setFileCompression( zip, index, settings.compressionLevel ) )
+            return unexpected( "Cannot set compression of file " + file.archivePath + " in archive" );
+
+        if ( settings.password )
         {
-            if ( zip_file_set_encryption( zip, index, ZIP_EM_AES_256, password ) )
-                return unexpected( "Cannot encrypt file " + archiveFilePath + " in archive" );
+            if ( zip_file_set_encryption( zip, index, ZIP_EM_AES_256, settings.password ) )
+                return unexpected( "Cannot encrypt file " + file.archivePath + " in archive" );
         }
 
-        ++compressedFiles;
-        if ( !reportProgress( scb, std::min( float( compressedFiles ) / totalFiles, 1.0f ) ) )
+        if ( parts.empty() && !reportProgress( scb, float( i + 1 ) / files.size() ) )
             return unexpectedOperationCanceled();
     }
 
@@ -324,7 +527,7 @@ Expected<void> decompressZip( const std::filesystem::path& zipFile, const std::f
     if ( !zip )
         return unexpected( "Cannot open zip, error code: " + std::to_string( err ) );
 
-    return decompressZip_( zip, targetFolder, password );
+    return decompressZip_( zip, targetFolder, password, &zipFile );
 }
 
 Expected<void> decompressZip( std::istream& zipStream, const std::filesystem::path& targetFolder, const char * password )
@@ -342,4 +545,31 @@ Expected<void> decompressZip( std::istream& zipStream, const std::filesystem::pa
     return decompressZip_( zip, targetFolder, password );
 }
 
+TEST( MRMesh, CompressZipInParallel )
+{
+    UniqueTemporaryFolder source( {} ), target( {} ), archive( {} );
+    ASSERT_TRUE( source && target && archive );
+
+    std::filesystem::create_directories( source / "sub" );
+    std::vector<std::pair<std::filesystem::path, std::string>> files;
+    for ( int i = 0; i < 10; ++i )
+        files.emplace_back( std::filesystem::path( i % 2 ? "sub" : "" ) / ( std::to_string( i ) + ".txt" ),
+            std::string( 1000 * i, char( 'a' + i ) ) );
+    for ( const auto & [name, content] : files )
+        std::ofstream( source / name, std::ofstream::binary ) << content;
+
+    const auto zipFile = archive / "test.zip";
+    for ( int level : { -1, 0, 9 } )
+    {
+        ASSERT_TRUE( compressZip( zipFile, source, { .compressionLevel = level, .parallel = true } ).has_value() );
+        ASSERT_TRUE( decompressZip( zipFile, target ).has_value() );
+        for ( const auto & [name, content] : files )
+        {
+            std::ifstream in( target / name, std::ifstream::binary );
+            std::string read( std::istreambuf_iterator<char>( in ), {} );
+            EXPECT_EQ( read, content );
+        }
+    }
+}
+
 } // namespace MR
@@ -14,7 +14,8 @@ namespace MR
 /// \{
 
 /**
- * \brief decompresses given zip-file into given folder
+ * \brief decompresses given zip-file into given folder;
+ * the files are extracted in parallel threads, each having its own handle of the archive
  * \param password if password is given then it will be used to decipher encrypted archive
  */
 MRMESH_API Expected<void> decompressZip( const std::filesystem::path& zipFile, const std::filesystem::path& targetFolder,
@@ -35,6 +36,30 @@ MRMESH_API Expected<void> decompressZip( std::istream& zipStream, const std::fil
 MRMESH_API Expected<void> compressZip( const std::filesystem::path& zipFile, const std::filesystem::path& sourceFolder, 
     const std::vector<std::filesystem::path>& excludeFiles = {}, const char * password = nullptr, ProgressCallback cb = {} );
 
+/// parameters of folder compression in zip-file
+struct CompressZipSettings
+{
+    /// files that should not be included to result zip
+    std::vector<std::filesystem::path> excludeFiles;
+
+    /// if password is given then the archive will be encrypted
+    const char * password = nullptr;
+
+    /// the compression level of zlib: 0 - no compression, 1 - the fastest, 9 - the strongest, -1 - default level
+    int compressionLevel = -1;
+
+    /// if true then the files are distributed among parallel threads, each compressing its files in a temporary archive,
+    /// and then already compressed data are copied in the result archive
+    bool parallel = true;
+};
+
+/**
+ * \brief compresses given folder in given zip-file
+ * \param cb an option to get progress notifications and cancel the operation
+ */
+MRMESH_API Expected<void> compressZip( const std::filesystem::path& zipFile, const std::filesystem::path& sourceFolder,
+    const CompressZipSettings& settings, ProgressCallback cb = {} );
+
 /// \}
 
 } // namespace MR
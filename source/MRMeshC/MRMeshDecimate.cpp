@@ -51,6 +51,7 @@ MRDecimateSettings mrDecimateSettingsNew()
         COPY_FROM( def, decimateBetweenParts )
         // TODO: partFaces
         COPY_FROM( def, minFacesInPart )
+        COPY_FROM( def, subdivideSpatially )
     };
 #undef COPY
 }
@@ -94,6 +95,7 @@ MRDecimateResult mrDecimateMesh( MRMesh* mesh_, const MRDecimateSettings* settin
             COPY_FROM( src, decimateBetweenParts )
             // TODO: partFaces
             COPY_FROM( src, minFacesInPart )
+            COPY_FROM( src, subdivideSpatially )
         };
     }
 
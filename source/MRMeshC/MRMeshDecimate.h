@@ -79,6 +79,9 @@ typedef struct MRDecimateSettings
     // TODO: partFaces
     /// minimum number of faces in one subdivision part for ( subdivideParts > 1 ) mode
     int minFacesInPart;
+    /// If true and subdivideParts > 1, then the mesh is subdivided on compact in space parts (subtrees of AABB tree),
+    /// so there is no need to call mrMeshPackOptimally before the decimation
+    bool subdivideSpatially;
 } MRDecimateSettings;
 
 /// initializes a default instance
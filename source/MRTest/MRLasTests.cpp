@@ -0,0 +1,158 @@
+#include <MRIOExtras/config.h>
+#ifndef MRIOEXTRAS_NO_LAS
+#include <MRMesh/MRGTest.h>
+#include <MRMesh/MRPointCloud.h>
+#include <MRMesh/MRUniqueTemporaryFolder.h>
+#include <MRIOExtras/MRLas.h>
+
+#include <lazperf/lazperf.hpp>
+#include <lazperf/writers.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+namespace
+{
+
+using namespace MR;
+
+/// the record of point data format 0
+#pragma pack(push, 1)
+struct LasPoint0
+{
+    std::int32_t x = 0;
+    std::int32_t y = 0;
+    std::int32_t z = 0;
+    std::uint16_t intensity = 0;
+    std::uint8_t returnFlags = 0;
+    std::uint8_t classification = 0;
+    std::int8_t scanAngle = 0;
+    std::uint8_t userData = 0;
+    std::uint16_t pointSourceId = 0;
+};
+#pragma pack(pop)
+static_assert( sizeof( LasPoint0 ) == 20, "check your padding" );
+
+LasPoint0 makePoint( int i )
+{
+    return { .x = i % 1000, .y = ( i / 1000 ) % 1000, .z = ( i * 7919 ) % 1013 };
+}
+
+/// writes uncompressed LAS 1.2 file with point data format 0
+void writeLas( const std::filesystem::path& file, int numPoints )
+{
+    std::string header( 227, '\0' );
+    auto put = [&] ( size_t pos, const auto& value ) { std::memcpy( header.data() + pos, &value, sizeof( value ) ); };
+    std::memcpy( header.data(), "LASF", 4 );
+    put( 24, std::uint8_t( 1 ) ); // version 1.2
+    put( 25, std::uint8_t( 2 ) );
+    put( 94, std::uint16_t( 227 ) ); // header size
+    put( 96, std::uint32_t( 227 ) ); // offset to point data
+    put( 104, std::uint8_t( 0 ) ); // point data format
+    put( 105, std::uint16_t( sizeof( LasPoint0 ) ) );
+    put( 107, std::uint32_t( numPoints ) );
+    put( 111, std::uint32_t( numPoints ) ); // all points are first returns
+    for ( int i = 0; i < 3; ++i )
+        put( 131 + 8 * i, 0.001 ); // scale
+    const double box[6] = { 0.999, 0, 0.999, 0, 1.012, 0 }; // max x, min x, max y, min y, max z, min z
+    for ( int i = 0; i < 6; ++i )
+        put( 179 + 8 * i, box[i] );
+
+    std::ofstream out( file, std::ofstream::binary );
+    out.write( header.data(), header.size() );
+    for ( int i = 0; i < numPoints; ++i )
+    {
+        const auto p = makePoint( i );
+        out.write( (const char*)&p, sizeof( p ) );
+    }
+}
+
+/// writes LAZ file with point data format 0;
+/// if chunkSize is lazperf::VariableChunkSize, then new chunks are started after the points with ids in (chunkStarts)
+void writeLaz( const std::filesystem::path& file, int numPoints, unsigned chunkSize, const std::vector<int>& chunkStarts = {} )
+{
+    lazperf::writer::named_file::config config( lazperf::vector3( 0.001, 0.001, 0.001 ), lazperf::vector3( 0, 0, 0 ), chunkSize );
+    lazperf::writer::named_file writer( file.string(), config );
+    auto nextStart = chunkStarts.begin();
+    for ( int i = 0; i < numPoints; ++i )
+    {
+        if ( nextStart != chunkStarts.end() && *nextStart == i )
+        {
+            writer.newChunk();
+            ++nextStart;
+        }
+        const auto p = makePoint( i );
+        writer.writePoint( (const char*)&p );
+    }
+    writer.close();
+}
+
+/// moves the offset of the chunk table from the beginning of the points in the end of the file,
+/// as the writers to not-seekable streams do
+void moveChunkTableOffsetToEnd( const std::filesystem::path& file )
+{
+    std::string data;
+    {
+        std::ifstream in( file, std::ifstream::binary );
+        data.assign( std::istreambuf_iterator<char>( in ), {} );
+    }
+    std::uint32_t pointOffset = 0;
+    std::memcpy( &pointOffset, data.data() + 96, sizeof( pointOffset ) );
+    std::int64_t tableOffset = 0;
+    std::memcpy( &tableOffset, data.data() + pointOffset, sizeof( tableOffset ) );
+    const std::int64_t unknown = -1;
+    std::memcpy( data.data() + pointOffset, &unknown, sizeof( unknown ) );
+    data.append( (const char*)&tableOffset, sizeof( tableOffset ) );
+    std::ofstream( file, std::ofstream::binary ).write( data.data(), data.size() );
+}
+
+/// checks that parallel decoding of the file mapped in memory gives the same points as sequential decoding of the stream
+void checkSameAsSequential( const std::filesystem::path& file, int numPoints )
+{
+    const auto parallel = PointsLoad::fromLas( file );
+    ASSERT_TRUE( parallel.has_value() ) << parallel.error();
+    std::ifstream in( file, std::ifstream::binary );
+    const auto sequential = PointsLoad::fromLas( in );
+    ASSERT_TRUE( sequential.has_value() ) << sequential.error();
+
+    ASSERT_EQ( parallel->points.size(), size_t( numPoints ) );
+    EXPECT_EQ( parallel->points.vec_, sequential->points.vec_ );
+    EXPECT_EQ( parallel->validPoints, sequential->validPoints );
+}
+
+} // anonymous namespace
+
+namespace MR
+{
+
+TEST( MRIOExtras, LasParallelDecoding )
+{
+    UniqueTemporaryFolder folder( {} );
+    ASSERT_TRUE( folder );
+
+    // uncompressed file of several chunks
+    constexpr int cNumLasPoints = 150000;
+    writeLas( folder / "points.las", cNumLasPoints );
+    checkSameAsSequential( folder / "points.las", cNumLasPoints );
+
+    // compressed file with chunks of fixed size, the last chunk is incomplete
+    constexpr int cNumLazPoints = 10000;
+    writeLaz( folder / "fixed.laz", cNumLazPoints, 1500 );
+    checkSameAsSequential( folder / "fixed.laz", cNumLazPoints );
+
+    // compressed file with chunks of variable size
+    writeLaz( folder / "variable.laz", cNumLazPoints, lazperf::VariableChunkSize, { 100, 101, 2000, 2500, 7777 } );
+    checkSameAsSequential( folder / "variable.laz", cNumLazPoints );
+
+    // the offset of chunk table is stored in the end of file
+    moveChunkTableOffsetToEnd( folder / "fixed.laz" );
+    checkSameAsSequential( folder / "fixed.laz", cNumLazPoints );
+    moveChunkTableOffsetToEnd( folder / "variable.laz" );
+    checkSameAsSequential( folder / "variable.laz", cNumLazPoints );
+}
+
+} // namespace MR
+#endif
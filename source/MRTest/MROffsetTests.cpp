@@ -0,0 +1,35 @@
+#include <MRMesh/MRMesh.h>
+#include <MRMesh/MRTorus.h>
+#include <MRMesh/MRGTest.h>
+#include <MRVoxels/MROffset.h>
+
+namespace MR
+{
+
+TEST( MRMesh, OffsetMeshMemoryEfficient )
+{
+    auto torus = makeTorus( 1.0f, 0.3f, 32, 16 );
+    // make a hole in the mesh to require winding numbers for sign detection
+    torus.topology.deleteFace( 0_f );
+
+    OffsetParameters params;
+    params.voxelSize = 0.05f;
+    params.signDetectionMode = SignDetectionMode::HoleWindingRule;
+
+    // the grid of winding numbers is computed by z-slabs
+    params.memoryEfficient = true;
+    const auto slabs = mcOffsetMesh( torus, 0.1f, params );
+    ASSERT_TRUE( slabs.has_value() ) << slabs.error();
+
+    // the grid of winding numbers is computed at once
+    params.memoryEfficient = false;
+    const auto whole = mcOffsetMesh( torus, 0.1f, params );
+    ASSERT_TRUE( whole.has_value() ) << whole.error();
+
+    // the voxel centers can differ in last bits because of different grid origins of the slabs
+    EXPECT_NEAR( slabs->topology.numValidFaces(), whole->topology.numValidFaces(), 0.001 * whole->topology.numValidFaces() );
+    EXPECT_NEAR( slabs->volume(), whole->volume(), 1e-3f * whole->volume() );
+    EXPECT_EQ( slabs->topology.findHoleRepresentiveEdges().size(), 0 );
+}
+
+} //namespace MR
@@ -0,0 +1,94 @@
+#include <MRIOExtras/config.h>
+#ifndef MRIOEXTRAS_NO_ZLIB
+#include <MRMesh/MRCube.h>
+#include <MRMesh/MRGTest.h>
+#include <MRMesh/MRMesh.h>
+#include <MRMesh/MRObjectMesh.h>
+#include <MRMesh/MRUniqueTemporaryFolder.h>
+#include <MRIOExtras/MRSceneContainer.h>
+
+#include <fstream>
+
+namespace MR
+{
+
+TEST( MRIOExtras, SceneContainer )
+{
+    UniqueTemporaryFolder source( {} ), target( {} ), container( {} );
+    ASSERT_TRUE( source && target && container );
+
+    // a file of several blocks with both compressible and incompressible parts
+    std::string big( 10000, 'a' );
+    for ( size_t i = big.size() / 2; i < big.size(); ++i )
+        big[i] = char( ( i * 7919 ) >> 3 );
+    std::filesystem::create_directories( source / "sub" );
+    std::ofstream( source / "big.bin", std::ofstream::binary ) << big;
+    std::ofstream( source / "sub" / "small.txt", std::ofstream::binary ) << "small";
+    std::ofstream( source / "empty", std::ofstream::binary );
+
+    const auto file = container / "scene.mrscene";
+    ASSERT_TRUE( packFolderInSceneContainer( source, file, { .blockSize = 1024 } ).has_value() );
+
+    SceneContainerReader reader;
+    ASSERT_TRUE( reader.open( file ).has_value() );
+    EXPECT_EQ( reader.entries().size(), 3 );
+    const auto bigIndex = reader.findEntry( "big.bin" );
+    ASSERT_GE( bigIndex, 0 );
+    EXPECT_EQ( reader.entries()[bigIndex].blocks.size(), 10 );
+    EXPECT_EQ( reader.findEntry( "missing" ), -1 );
+    auto bigRead = reader.readEntry( bigIndex );
+    ASSERT_TRUE( bigRead.has_value() );
+    EXPECT_EQ( *bigRead, big );
+
+    // only the requested files are extracted
+    ASSERT_TRUE( reader.extract( target, [] ( const SceneContainerEntry& e ) { return e.name != "big.bin"; } ).has_value() );
+    EXPECT_FALSE( std::filesystem::exists( target / "big.bin" ) );
+    EXPECT_TRUE( std::filesystem::exists( target / "empty" ) );
+    std::ifstream small( target / "sub" / "small.txt", std::ifstream::binary );
+    std::string smallRead;
+    small >> smallRead;
+    EXPECT_EQ( smallRead, "small" );
+
+    // truncated container is rejected
+    std::filesystem::resize_file( file, std::filesystem::file_size( file ) - 1 );
+    EXPECT_FALSE( reader.open( file ).has_value() );
+}
+
+TEST( MRIOExtras, SceneContainerDeferredModels )
+{
+    UniqueTemporaryFolder container( {} );
+    ASSERT_TRUE( container );
+
+    Object root;
+    auto visible = std::make_shared<ObjectMesh>();
+    visible->setName( "Visible" );
+    visible->setMesh( std::make_shared<Mesh>( makeCube() ) );
+    root.addChild( visible );
+    auto hidden = std::make_shared<ObjectMesh>();
+    hidden->setName( "Hidden" );
+    hidden->setMesh( std::make_shared<Mesh>( makeCube() ) );
+    hidden->setVisible( false );
+    root.addChild( hidden );
+
+    const auto file = container / "scene.mrscene";
+    ASSERT_TRUE( serializeObjectTreeToSceneContainer( root, file ).has_value() );
+
+    auto loaded = deserializeObjectTreeFromSceneContainer( file, DeferModels::Invisible );
+    ASSERT_TRUE( loaded.has_value() );
+    ASSERT_EQ( loaded->obj->children().size(), 2 );
+    auto loadedVisible = std::dynamic_pointer_cast<ObjectMesh>( loaded->obj->children()[0] );
+    auto loadedHidden = std::dynamic_pointer_cast<ObjectMesh>( loaded->obj->children()[1] );
+    ASSERT_TRUE( loadedVisible && loadedHidden );
+    ASSERT_TRUE( loadedVisible->mesh() );
+    EXPECT_EQ( loadedVisible->mesh()->topology.numValidFaces(), 12 );
+
+    // the model of hidden object is extracted from the container only when it becomes visible
+    EXPECT_TRUE( loadedHidden->hasDeferredModel() );
+    loadedHidden->setVisible( true );
+    EXPECT_FALSE( loadedHidden->hasDeferredModel() );
+    ASSERT_TRUE( loadedHidden->mesh() );
+    EXPECT_EQ( loadedHidden->mesh()->topology.numValidFaces(), 12 );
+}
+
+} // namespace MR
+#endif
@@ -9,6 +9,9 @@
 #include "MRMesh/MRVolumeIndexer.h"
 #include "MRMesh/MRParallelFor.h"
 #include "MRMesh/MRTriMesh.h"
+#include "MRMesh/MRMeshStreamWriter.h"
+#include "MRMesh/MRMeshLoad.h"
+#include "MRMesh/MRUniqueTemporaryFolder.h"
 
 namespace MR
 {
@@ -161,6 +164,61 @@ TEST( MRMesh, volumeToMeshByParts )
     EXPECT_NEAR( expectedVolume, mesh.volume(), 0.001f );
 }
 
+TEST( MRMesh, MarchingCubesByPartsToStream )
+{
+    const Vector3i dimensions { 41, 41, 41 };
+    constexpr float radius = 15.f;
+    constexpr Vector3f center { 20.f, 20.f, 20.f };
+    constexpr int zLayersInPart = 7;
+    constexpr int layersPerBlock = 4; // some blocks are split between parts
+
+    // passes the volume in parts to given mesher
+    auto addParts = [&] ( MarchingCubesByParts & mc )
+    {
+        while ( mc.nextZ() + 1 < dimensions.z )
+        {
+            const int firstZ = mc.nextZ();
+            const int numZ = std::min( zLayersInPart, dimensions.z - firstZ );
+            SimpleVolume part
+            {
+                .dims = { dimensions.x, dimensions.y, numZ },
+                .voxelSize = Vector3f::diagonal( 1.f )
+            };
+            part.data.resize( size_t( numZ ) * dimensions.x * dimensions.y );
+            VoxelId i( size_t( 0 ) );
+            for ( auto z = 0; z < numZ; ++z )
+                for ( auto y = 0; y < dimensions.y; ++y )
+                    for ( auto x = 0; x < dimensions.x; ++x, ++i )
+                        part.data[i] = ( center - Vector3f( (float)x, (float)y, (float)( firstZ + z ) ) ).length() - radius;
+            EXPECT_TRUE( mc.addPart( part ).has_value() );
+        }
+    };
+
+    MarchingCubesByParts mcInMemory( dimensions, { .iso = 0.f, .lessInside = true }, layersPerBlock );
+    addParts( mcInMemory );
+    const auto expected = Mesh::fromTriMesh( *mcInMemory.finalize() );
+
+    UniqueTemporaryFolder folder( {} );
+    const auto path = folder / "sphere.ply";
+    {
+        std::ofstream out( path, std::ofstream::binary );
+        PlyStreamWriter writer( out );
+        MarchingCubesByParts mc( dimensions, { .iso = 0.f, .lessInside = true }, writer, layersPerBlock );
+        addParts( mc );
+        auto res = mc.finalize();
+        ASSERT_TRUE( res.has_value() );
+        EXPECT_TRUE( res->tris.empty() );
+    }
+
+    auto streamed = MeshLoad::fromPly( path );
+    ASSERT_TRUE( streamed.has_value() );
+    EXPECT_EQ( streamed->topology.numValidVerts(), expected.topology.numValidVerts() );
+    EXPECT_EQ( streamed->topology.numValidFaces(), expected.topology.numValidFaces() );
+    // the vertices on the boundaries of blocks are not duplicated
+    EXPECT_EQ( streamed->topology.findNumHoles(), 0 );
+    EXPECT_NEAR( streamed->volume(), expected.volume(), 1e-3f * expected.volume() );
+}
+
 } //namespace MR
 
 #endif //!MESHLIB_NO_VOXELS
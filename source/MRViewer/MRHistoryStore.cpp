@@ -33,6 +33,10 @@ void HistoryStore::appendAction( std::shared_ptr<HistoryAction> action )
     spdlog::info( "History action append: \"{}\"", action->name() );
     assert( !action->name().empty() );
 
+    // the changes of previous action are over, so it can be made more compact before memory limit check;
+    // the actions of scoped block are notified together, when the whole combined action is finished
+    if ( firstRedoIndex_ > 0 && stack_[firstRedoIndex_ - 1] )
+        stack_[firstRedoIndex_ - 1]->changesFinished();
     stack_.resize( firstRedoIndex_ + 1 );
     stack_[firstRedoIndex_] = std::move( action );
     ++firstRedoIndex_;
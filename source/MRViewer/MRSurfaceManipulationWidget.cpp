@@ -36,6 +36,9 @@
 namespace MR
 {
 
+/// the subtrees of mesh's AABB tree are rebuilt after brush strokes if their boxes became larger than this factor times initial area
+constexpr float cTreeRebuildAreaRatio = 2.0f;
+
 void findSpaceDistancesAndVerts( const Mesh& mesh, const VertBitSet& start, float range, VertScalars& distances, VertBitSet& verts, bool codirected, const VertBitSet* untouchable )
 {
     // note! better update bitset for interesting verts than check for all verts from distances
@@ -474,9 +477,9 @@ bool SurfaceManipulationWidget::onMouseUp_( Viewer::MouseButton button, int /*mo
         params.region = &generalEditingRegion_;
         params.force = settings_.relaxForceAfterEdit;
         params.iterations = 5;
-        relax( *obj_->varMesh(), params );
+        relax( *obj_->varMesh(), params ); // updates mesh caches in the region
         updateValueChanges_( generalEditingRegion_ );
-        obj_->setDirtyFlags( DIRTY_POSITION );
+        obj_->setDirtyFlags( DIRTY_POSITION, false );
     }
 
     generalEditingRegion_.clear();
@@ -609,8 +612,8 @@ void SurfaceManipulationWidget::changeSurface_()
         MeshRelaxParams params;
         params.region = &singleEditingRegion_;
         params.force = settings_.relaxForce;
-        relax( *obj_->varMesh(), params );
-        obj_->setDirtyFlags( DIRTY_POSITION );
+        relax( *obj_->varMesh(), params ); // updates mesh caches in the region
+        obj_->setDirtyFlags( DIRTY_POSITION, false );
         updateValueChanges_( singleEditingRegion_ );
         return;
     }
@@ -646,7 +649,9 @@ void SurfaceManipulationWidget::changeSurface_()
     generalEditingRegion_ |= singleEditingRegion_;
     changedRegion_ |= singleEditingRegion_;
     updateValueChanges_( singleEditingRegion_ );
-    obj_->setDirtyFlags( DIRTY_POSITION );
+    // refit the trees instead of their rebuilding on each brush stroke
+    obj_->varMesh()->updateCaches( singleEditingRegion_, cTreeRebuildAreaRatio );
+    obj_->setDirtyFlags( DIRTY_POSITION, false );
 }
 
 void SurfaceManipulationWidget::updateUVmap_( bool set, bool wholeMesh )
@@ -802,7 +807,8 @@ void SurfaceManipulationWidget::laplacianMoveVert_( const Vector2f& mousePos )
     const Vector3f move = obj_->worldXf().A.inverse()* ( pos1 - pos0 );
     laplacian_->fixVertex( touchVertId_, touchVertIniPos_ + move );
     laplacian_->apply();
-    obj_->setDirtyFlags( DIRTY_POSITION );
+    obj_->varMesh()->updateCaches( singleEditingRegion_, cTreeRebuildAreaRatio );
+    obj_->setDirtyFlags( DIRTY_POSITION, false );
     updateValueChanges_( singleEditingRegion_ );
 }
 
@@ -10,6 +10,7 @@
 #include "MRMesh/MRTimer.h"
 #include "MRMesh/MRParallelFor.h"
 #include "MRMesh/MRTriMesh.h"
+#include "MRMesh/MRMeshStreamWriter.h"
 
 #include <thread>
 
@@ -336,7 +337,8 @@ public:
 public: // custom interface
     /// prepares convention for given volume dimensions and given parameters
     /// \param layersPerBlock all z-slices of the volume will be partitioned on blocks of given size to process in parallel (0 means auto-select layersPerBlock)
-    explicit VolumeMesher( const Vector3i & dims, const MarchingCubesParams& params, int layersPerBlock );
+    /// \param writer if given, receives the triangles of each block as soon as possible, instead of accumulating them till finalize()
+    explicit VolumeMesher( const Vector3i & dims, const MarchingCubesParams& params, int layersPerBlock, IMeshStreamWriter* writer = nullptr );
 
     /// adds one more part of volume into consideration,
     template<typename V>
@@ -365,6 +367,14 @@ private:
     void addPartBlock_( const V& volume, const BlockInfo& blockInfo );
     void addBinaryPartBlock_( const SimpleBinaryVolume& volume, const BlockInfo& blockInfo );
 
+    /// creates the triangles of given block from its separation points and the points in the first layer of next block;
+    /// \param onLayerDone is called after each layer, and the triangulation stops if it returns false
+    void triangulateBlock_( int blockIndex, const std::atomic<bool>& keepGoing, const std::function<bool()>& onLayerDone );
+
+    /// in streaming mode: gives unique ids to the points of completely filled blocks,
+    /// and passes to the writer the triangles of the blocks followed by filled blocks, then frees the memory of passed blocks
+    Expected<void> flushBlocks_();
+
 private:
     VolumeIndexer indexer_;
     const MarchingCubesParams params_;
@@ -376,6 +386,11 @@ private:
     std::vector<BitSet> lowerIso_; ///< voxels with the values lower then params.iso
 
     SeparationPointStorage sepStorage_;
+
+    IMeshStreamWriter* writer_ = nullptr;
+    int numShiftedBlocks_ = 0; ///< the number of first blocks with unique ids of points
+    int numFlushedBlocks_ = 0; ///< the number of first blocks with triangles passed to the writer
+    VertId nextVid_{ 0 }; ///< the unique id of the first point in block #numShiftedBlocks_
 };
 
 template<typename V>
@@ -396,7 +411,8 @@ Expected<TriMesh> VolumeMesher::run( const V& volume, const MarchingCubesParams&
     } );
 }
 
-VolumeMesher::VolumeMesher( const Vector3i & dims, const MarchingCubesParams& params, int layersPerBlock ) : indexer_( dims ), params_( params )
+VolumeMesher::VolumeMesher( const Vector3i & dims, const MarchingCubesParams& params, int layersPerBlock, IMeshStreamWriter* writer )
+    : indexer_( dims ), params_( params ), writer_( writer )
 {
     int threadCount = (int)tbb::global_control::active_value( tbb::global_control::max_allowed_parallelism );
     if ( threadCount == 0 )
@@ -414,6 +430,10 @@ VolumeMesher::VolumeMesher( const Vector3i & dims, const MarchingCubesParams& pa
     {
         const auto approxBlockCount = std::min( layerCount, threadCount > 1 ? 4 * threadCount : 1 );
         layersPerBlock = (int)std::ceil( (float)layerCount / (float)approxBlockCount );
+        // in streaming mode, the memory is occupied by the blocks of current part and by one block before it
+        constexpr int cMaxStreamingLayersPerBlock = 16;
+        if ( writer_ )
+            layersPerBlock = std::min( layersPerBlock, cMaxStreamingLayersPerBlock );
     }
     layersPerBlock_ = layersPerBlock;
     blockCount_ = ( layerCount + layersPerBlock_ - 1 ) / layersPerBlock_;
@@ -526,6 +546,8 @@ Expected<void> VolumeMesher::addPart( const V& part )
     if ( currentSubprogress && !keepGoing )
         return unexpectedOperationCanceled();
 
+    if ( writer_ )
+        return flushBlocks_();
     return {};
 }
 
@@ -711,19 +733,8 @@ void VolumeMesher::addBinaryPartBlock_( const SimpleBinaryVolume& part, const Bl
     }
 }
 
-Expected<TriMesh> VolumeMesher::finalize()
+void VolumeMesher::triangulateBlock_( int blockIndex, const std::atomic<bool>& keepGoing, const std::function<bool()>& onLayerDone )
 {
-    MR_TIMER;
-    if ( nextZ_ + 1 != indexer_.dims().z )
-        return unexpected( "Provided parts do not cover whole volume" );
-
-    const auto totalVertices = sepStorage_.makeUniqueVids();
-    if ( totalVertices > params_.maxVertices )
-        return unexpected( "Vertices number limit exceeded." );
-
-    if ( params_.cb && !params_.cb( 0.5f ) )
-        return unexpectedOperationCanceled();
-
     const size_t dimsX = indexer_.dims().x;
     const size_t cVoxelNeighborsIndexAdd[8] =
     {
@@ -738,229 +749,330 @@ Expected<TriMesh> VolumeMesher::finalize()
     };
     const size_t cDimStep[3] = { 1, dimsX, indexer_.sizeXY() };
 
-    const bool hasInvalidVoxels =
-        std::any_of( invalids_.begin(), invalids_.end(), []( const BitSet & bs ) { return !bs.empty(); } ); // bit set is not empty only if at least one bit is set
-
-    const auto callingThreadId = std::this_thread::get_id();
-    std::atomic<bool> keepGoing{ true };
-
-    // avoid false sharing with other local variables
-    // by putting processedBits in its own cache line
-    constexpr int hardware_destructive_interference_size = 64;
-    struct alignas(hardware_destructive_interference_size) S
-    {
-        std::atomic<int> numProcessedLayers{ 0 };
-    } cacheLineStorage;
-    static_assert( alignof(S) == hardware_destructive_interference_size );
-    static_assert( sizeof(S) == hardware_destructive_interference_size );
+    auto & block = sepStorage_.getBlock( blockIndex );
 
     const int layerCount = indexer_.dims().z;
-    auto currentSubprogress = subprogress( params_.cb, 0.5f, 0.85f );
-    ParallelFor( 0, blockCount_, [&] ( int blockIndex )
+    const int layerBegin = blockIndex * layersPerBlock_;
+    const auto layerEnd = std::min( ( blockIndex + 1 ) * layersPerBlock_, layerCount - 1 ); // skip last layer since no data from next layer
+    if ( layerBegin >= layerEnd )
+        return;
+
+    const bool hasInvalidVoxels = std::any_of( invalids_.begin() + layerBegin, invalids_.begin() + layerEnd + 1,
+        []( const BitSet & bs ) { return !bs.empty(); } ); // bit set is not empty only if at least one bit is set
+
+    // cell data
+    std::array<const SeparationPointSet*, 7> neis;
+    unsigned char voxelConfiguration;
+    VoxelLocation loc = indexer_.toLoc( Vector3i( 0, 0, layerBegin ) );
+    for ( ; loc.pos.z < layerEnd; ++loc.pos.z )
     {
-        auto & block = sepStorage_.getBlock( blockIndex );
-        const bool report = currentSubprogress && std::this_thread::get_id() == callingThreadId;
-
-        const int layerBegin = blockIndex * layersPerBlock_;
-        if ( layerBegin >= layerCount )
-            return;
-        const auto layerEnd = std::min( ( blockIndex + 1 ) * layersPerBlock_, layerCount - 1 ); // skip last layer since no data from next layer
-
-        // cell data
-        std::array<const SeparationPointSet*, 7> neis;
-        unsigned char voxelConfiguration;
-        VoxelLocation loc = indexer_.toLoc( Vector3i( 0, 0, layerBegin ) );
-        for ( ; loc.pos.z < layerEnd; ++loc.pos.z )
+        const BitSet* layerInvalids[2] = { &invalids_[loc.pos.z], &invalids_[loc.pos.z+1] };
+        const BitSet* layerLowerIso[2] = { &lowerIso_[loc.pos.z], &lowerIso_[loc.pos.z+1] };
+        const VoxelId layerFirstVoxelId[2] = { indexer_.toVoxelId( { 0, 0, loc.pos.z } ), indexer_.toVoxelId( { 0, 0, loc.pos.z + 1 } ) };
+        // returns a bit from from one-of-two bit sets (bs) corresponding to given location (vl)
+        auto getBit = [&]( const BitSet *bs[2], const VoxelLocation & vl )
         {
-            const BitSet* layerInvalids[2] = { &invalids_[loc.pos.z], &invalids_[loc.pos.z+1] };
-            const BitSet* layerLowerIso[2] = { &lowerIso_[loc.pos.z], &lowerIso_[loc.pos.z+1] };
-            const VoxelId layerFirstVoxelId[2] = { indexer_.toVoxelId( { 0, 0, loc.pos.z } ), indexer_.toVoxelId( { 0, 0, loc.pos.z + 1 } ) };
-            // returns a bit from from one-of-two bit sets (bs) corresponding to given location (vl)
-            auto getBit = [&]( const BitSet *bs[2], const VoxelLocation & vl )
-            {
-                const auto dl = vl.pos.z - loc.pos.z;
-                assert( dl >= 0 && dl <= 1 );
-                // (*bs)[dl] is one of two bit sets, and layerFirstVoxelId[dl] is VoxelId corresponding to zeroth bit in it
-                return (*bs)[dl].test( vl.id - layerFirstVoxelId[dl] );
-            };
-            for ( loc.pos.y = 0; loc.pos.y + 1 < indexer_.dims().y; ++loc.pos.y )
+            const auto dl = vl.pos.z - loc.pos.z;
+            assert( dl >= 0 && dl <= 1 );
+            // (*bs)[dl] is one of two bit sets, and layerFirstVoxelId[dl] is VoxelId corresponding to zeroth bit in it
+            return (*bs)[dl].test( vl.id - layerFirstVoxelId[dl] );
+        };
+        for ( loc.pos.y = 0; loc.pos.y + 1 < indexer_.dims().y; ++loc.pos.y )
+        {
+            loc.pos.x = 0;
+            loc.id = indexer_.toVoxelId( loc.pos );
+            auto posXY = dimsX * loc.pos.y;
+            for ( ; loc.pos.x + 1 < dimsX; ++loc.pos.x, ++loc.id, ++posXY )
             {
-                loc.pos.x = 0;
-                loc.id = indexer_.toVoxelId( loc.pos );
-                auto posXY = dimsX * loc.pos.y;
-                for ( ; loc.pos.x + 1 < dimsX; ++loc.pos.x, ++loc.id, ++posXY )
-                {
-                    assert( indexer_.toVoxelId( loc.pos ) == loc.id );
-                    if ( params_.cb && !keepGoing.load( std::memory_order_relaxed ) )
-                        return;
+                assert( indexer_.toVoxelId( loc.pos ) == loc.id );
+                if ( !keepGoing.load( std::memory_order_relaxed ) )
+                    return;
 
-                    bool voxelValid = true;
-                    voxelConfiguration = 0;
-                    bool vx[8] =
-                    {
-                        layerLowerIso[0]->test( posXY ),
-                        layerLowerIso[0]->test( posXY + 1 ),
-                        layerLowerIso[0]->test( posXY + dimsX ),
-                        layerLowerIso[0]->test( posXY + dimsX + 1 ),
-                        layerLowerIso[1]->test( posXY ),
-                        layerLowerIso[1]->test( posXY + 1 ),
-                        layerLowerIso[1]->test( posXY + dimsX ),
-                        layerLowerIso[1]->test( posXY + dimsX + 1 )
-                    };
-                    [[maybe_unused]] bool atLeastOneNan = false;
-                    for ( int i = 0; i < cVoxelNeighbors.size(); ++i )
+                bool voxelValid = true;
+                voxelConfiguration = 0;
+                bool vx[8] =
+                {
+                    layerLowerIso[0]->test( posXY ),
+                    layerLowerIso[0]->test( posXY + 1 ),
+                    layerLowerIso[0]->test( posXY + dimsX ),
+                    layerLowerIso[0]->test( posXY + dimsX + 1 ),
+                    layerLowerIso[1]->test( posXY ),
+                    layerLowerIso[1]->test( posXY + 1 ),
+                    layerLowerIso[1]->test( posXY + dimsX ),
+                    layerLowerIso[1]->test( posXY + dimsX + 1 )
+                };
+                [[maybe_unused]] bool atLeastOneNan = false;
+                for ( int i = 0; i < cVoxelNeighbors.size(); ++i )
+                {
+                    bool voxelValueLowerIso = vx[i]; //faster alternative of getBit( layerLowerIso, nloc );
+                    if ( hasInvalidVoxels )
                     {
-                        bool voxelValueLowerIso = vx[i]; //faster alternative of getBit( layerLowerIso, nloc );
-                        if ( hasInvalidVoxels )
+                        VoxelLocation nloc{ loc.id + cVoxelNeighborsIndexAdd[i], loc.pos + cVoxelNeighbors[i] };
+                        bool invalidVoxelValue = getBit( layerInvalids, nloc );
+                        // find non nan neighbor
+                        constexpr std::array<uint8_t, 7> cNeighborsOrder{
+                            0b001,
+                            0b010,
+                            0b100,
+                            0b011,
+                            0b101,
+                            0b110,
+                            0b111
+                        };
+                        int neighIndex = 0;
+                        // iterates over nan neighbors to find consistent value
+                        while ( invalidVoxelValue && neighIndex < 7 )
                         {
-                            VoxelLocation nloc{ loc.id + cVoxelNeighborsIndexAdd[i], loc.pos + cVoxelNeighbors[i] };
-                            bool invalidVoxelValue = getBit( layerInvalids, nloc );
-                            // find non nan neighbor
-                            constexpr std::array<uint8_t, 7> cNeighborsOrder{
-                                0b001,
-                                0b010,
-                                0b100,
-                                0b011,
-                                0b101,
-                                0b110,
-                                0b111
-                            };
-                            int neighIndex = 0;
-                            // iterates over nan neighbors to find consistent value
-                            while ( invalidVoxelValue && neighIndex < 7 )
+                            auto neighLoc = nloc;
+                            for ( int posCoord = 0; posCoord < 3; ++posCoord )
                             {
-                                auto neighLoc = nloc;
-                                for ( int posCoord = 0; posCoord < 3; ++posCoord )
+                                if ( !( ( cNeighborsOrder[neighIndex] & ( 1 << posCoord ) ) >> posCoord ) )
+                                    continue;
+                                if ( cVoxelNeighbors[i][posCoord] == 1 )
                                 {
-                                    if ( !( ( cNeighborsOrder[neighIndex] & ( 1 << posCoord ) ) >> posCoord ) )
-                                        continue;
-                                    if ( cVoxelNeighbors[i][posCoord] == 1 )
-                                    {
-                                        --neighLoc.pos[posCoord];
-                                        neighLoc.id -= cDimStep[posCoord];
-                                    }
-                                    else
-                                    {
-                                        ++neighLoc.pos[posCoord];
-                                        neighLoc.id += cDimStep[posCoord];
-                                    }
+                                    --neighLoc.pos[posCoord];
+                                    neighLoc.id -= cDimStep[posCoord];
+                                }
+                                else
+                                {
+                                    ++neighLoc.pos[posCoord];
+                                    neighLoc.id += cDimStep[posCoord];
                                 }
-                                invalidVoxelValue = getBit( layerInvalids, neighLoc );
-                                voxelValueLowerIso = getBit( layerLowerIso, neighLoc );
-                                ++neighIndex;
-                            }
-                            if ( invalidVoxelValue )
-                            {
-                                voxelValid = false;
-                                break;
                             }
-                            if ( !atLeastOneNan && neighIndex > 0 )
-                                atLeastOneNan = true;
-                            vx[i] = voxelValueLowerIso;
+                            invalidVoxelValue = getBit( layerInvalids, neighLoc );
+                            voxelValueLowerIso = getBit( layerLowerIso, neighLoc );
+                            ++neighIndex;
                         }
-                        if ( voxelValueLowerIso )
-                            voxelConfiguration |= cMapNeighbors[i];
-                    }
-                    if ( !voxelValid || voxelConfiguration == 0x00 || voxelConfiguration == 0xff )
-                        continue;
-
-                    // find only necessary neighbor separation points by comparing
-                    // voxel values in both ends of each edge relative params_.iso (stored in vx array);
-                    // separation points will not be used (and can be not searched for better performance)
-                    // if both ends of the edge are higher or both are lower than params_.iso
-                    voxelValid = false;
-                    auto findNei = [&]( int i, auto check )
-                    {
-                        const auto index = loc.id + cVoxelNeighborsIndexAdd[i];
-                        auto * pSet = sepStorage_.findSeparationPointSet( index );
-                        if ( pSet && check( *pSet ) )
+                        if ( invalidVoxelValue )
                         {
-                            neis[i] = pSet;
-                            voxelValid = true;
+                            voxelValid = false;
+                            break;
                         }
-                    };
-
-                    neis = {};
-                    if ( vx[0] != vx[1] || vx[0] != vx[2] || vx[0] != vx[4] )
-                        findNei( 0, []( auto && ) { return true; } );
-                    if ( vx[1] != vx[3] || vx[1] != vx[5] )
-                        findNei( 1, []( auto && s ) { return s[(int)NeighborDir::Y] || s[(int)NeighborDir::Z]; } );
-                    if ( vx[2] != vx[3] || vx[2] != vx[6] )
-                        findNei( 2, []( auto && s ) { return s[(int)NeighborDir::X] || s[(int)NeighborDir::Z]; } );
-                    if ( vx[3] != vx[7] )
-                        findNei( 3, []( auto && s ) { return (bool)s[(int)NeighborDir::Z]; } );
-                    if ( vx[4] != vx[5] || vx[4] != vx[6] )
-                        findNei( 4, []( auto && s ) { return s[(int)NeighborDir::X] || s[(int)NeighborDir::Y]; } );
-                    if ( vx[5] != vx[7] )
-                        findNei( 5, []( auto && s ) { return (bool)s[(int)NeighborDir::Y]; } );
-                    if ( vx[6] != vx[7] )
-                        findNei( 6, []( auto && s ) { return (bool)s[(int)NeighborDir::X]; } );
-
-                    // ensure consistent nan voxel
-                    if ( atLeastOneNan && voxelValid )
+                        if ( !atLeastOneNan && neighIndex > 0 )
+                            atLeastOneNan = true;
+                        vx[i] = voxelValueLowerIso;
+                    }
+                    if ( voxelValueLowerIso )
+                        voxelConfiguration |= cMapNeighbors[i];
+                }
+                if ( !voxelValid || voxelConfiguration == 0x00 || voxelConfiguration == 0xff )
+                    continue;
+
+                // find only necessary neighbor separation points by comparing
+                // voxel values in both ends of each edge relative params_.iso (stored in vx array);
+                // separation points will not be used (and can be not searched for better performance)
+                // if both ends of the edge are higher or both are lower than params_.iso
+                voxelValid = false;
+                auto findNei = [&]( int i, auto check )
+                {
+                    const auto index = loc.id + cVoxelNeighborsIndexAdd[i];
+                    auto * pSet = sepStorage_.findSeparationPointSet( index );
+                    if ( pSet && check( *pSet ) )
                     {
-                        const auto& plan = cTriangleTable[voxelConfiguration];
-                        for ( int i = 0; i < plan.size() && voxelValid; i += 3 )
-                        {
-                            const auto& [interIndex0, dir0] = cEdgeIndicesMap[plan[i]];
-                            const auto& [interIndex1, dir1] = cEdgeIndicesMap[plan[i + 1]];
-                            const auto& [interIndex2, dir2] = cEdgeIndicesMap[plan[i + 2]];
-                            // `neis` indicates that current voxel has valid point for desired triangulation
-                            // as far as nei has 3 directions we use `dir` to validate (make sure that there is point in needed edge) desired direction
-                            voxelValid = voxelValid && neis[interIndex0] && (*neis[interIndex0])[int( dir0 )];
-                            voxelValid = voxelValid && neis[interIndex1] && (*neis[interIndex1])[int( dir1 )];
-                            voxelValid = voxelValid && neis[interIndex2] && (*neis[interIndex2])[int( dir2 )];
-                        }
+                        neis[i] = pSet;
+                        voxelValid = true;
                     }
-                    if ( !voxelValid )
-                        continue;
+                };
 
+                neis = {};
+                if ( vx[0] != vx[1] || vx[0] != vx[2] || vx[0] != vx[4] )
+                    findNei( 0, []( auto && ) { return true; } );
+                if ( vx[1] != vx[3] || vx[1] != vx[5] )
+                    findNei( 1, []( auto && s ) { return s[(int)NeighborDir::Y] || s[(int)NeighborDir::Z]; } );
+                if ( vx[2] != vx[3] || vx[2] != vx[6] )
+                    findNei( 2, []( auto && s ) { return s[(int)NeighborDir::X] || s[(int)NeighborDir::Z]; } );
+                if ( vx[3] != vx[7] )
+                    findNei( 3, []( auto && s ) { return (bool)s[(int)NeighborDir::Z]; } );
+                if ( vx[4] != vx[5] || vx[4] != vx[6] )
+                    findNei( 4, []( auto && s ) { return s[(int)NeighborDir::X] || s[(int)NeighborDir::Y]; } );
+                if ( vx[5] != vx[7] )
+                    findNei( 5, []( auto && s ) { return (bool)s[(int)NeighborDir::Y]; } );
+                if ( vx[6] != vx[7] )
+                    findNei( 6, []( auto && s ) { return (bool)s[(int)NeighborDir::X]; } );
+
+                // ensure consistent nan voxel
+                if ( atLeastOneNan && voxelValid )
+                {
                     const auto& plan = cTriangleTable[voxelConfiguration];
-                    for ( int i = 0; i < plan.size(); i += 3 )
+                    for ( int i = 0; i < plan.size() && voxelValid; i += 3 )
                     {
                         const auto& [interIndex0, dir0] = cEdgeIndicesMap[plan[i]];
                         const auto& [interIndex1, dir1] = cEdgeIndicesMap[plan[i + 1]];
                         const auto& [interIndex2, dir2] = cEdgeIndicesMap[plan[i + 2]];
-                        assert( neis[interIndex0] && (*neis[interIndex0])[int( dir0 )] );
-                        assert( neis[interIndex1] && (*neis[interIndex1])[int( dir1 )] );
-                        assert( neis[interIndex2] && (*neis[interIndex2])[int( dir2 )] );
-
-                        if ( params_.lessInside )
-                            block.tris.emplace_back( ThreeVertIds{
-                                (*neis[interIndex0])[int( dir0 )],
-                                (*neis[interIndex2])[int( dir2 )],
-                                (*neis[interIndex1])[int( dir1 )]
-                            } );
-                        else
-                            block.tris.emplace_back( ThreeVertIds{
-                                (*neis[interIndex0])[int( dir0 )],
-                                (*neis[interIndex1])[int( dir1 )],
-                                (*neis[interIndex2])[int( dir2 )]
-                            } );
-                        if ( params_.outVoxelPerFaceMap )
-                            block.faceMap.emplace_back( loc.id );
+                        // `neis` indicates that current voxel has valid point for desired triangulation
+                        // as far as nei has 3 directions we use `dir` to validate (make sure that there is point in needed edge) desired direction
+                        voxelValid = voxelValid && neis[interIndex0] && (*neis[interIndex0])[int( dir0 )];
+                        voxelValid = voxelValid && neis[interIndex1] && (*neis[interIndex1])[int( dir1 )];
+                        voxelValid = voxelValid && neis[interIndex2] && (*neis[interIndex2])[int( dir2 )];
                     }
                 }
+                if ( !voxelValid )
+                    continue;
+
+                const auto& plan = cTriangleTable[voxelConfiguration];
+                for ( int i = 0; i < plan.size(); i += 3 )
+                {
+                    const auto& [interIndex0, dir0] = cEdgeIndicesMap[plan[i]];
+                    const auto& [interIndex1, dir1] = cEdgeIndicesMap[plan[i + 1]];
+                    const auto& [interIndex2, dir2] = cEdgeIndicesMap[plan[i + 2]];
+                    assert( neis[interIndex0] && (*neis[interIndex0])[int( dir0 )] );
+                    assert( neis[interIndex1] && (*neis[interIndex1])[int( dir1 )] );
+                    assert( neis[interIndex2] && (*neis[interIndex2])[int( dir2 )] );
+
+                    if ( params_.lessInside )
+                        block.tris.emplace_back( ThreeVertIds{
+                            (*neis[interIndex0])[int( dir0 )],
+                            (*neis[interIndex2])[int( dir2 )],
+                            (*neis[interIndex1])[int( dir1 )]
+                        } );
+                    else
+                        block.tris.emplace_back( ThreeVertIds{
+                            (*neis[interIndex0])[int( dir0 )],
+                            (*neis[interIndex1])[int( dir1 )],
+                            (*neis[interIndex2])[int( dir2 )]
+                        } );
+                    if ( params_.outVoxelPerFaceMap && !writer_ )
+                        block.faceMap.emplace_back( loc.id );
+                }
             }
-            // free memory containing unused data
-            if ( loc.pos.z > layerBegin || loc.pos.z == 0 ) // processed layer, not the first in the block (or the first in the first block)
-            {
-                invalids_[loc.pos.z] = {};
-                lowerIso_[loc.pos.z] = {};
-            }
-            if ( loc.pos.z + 2 == layerCount ) // the very last layer after this one
+        }
+        // free memory containing unused data
+        if ( loc.pos.z > layerBegin || loc.pos.z == 0 ) // processed layer, not the first in the block (or the first in the first block)
+        {
+            invalids_[loc.pos.z] = {};
+            lowerIso_[loc.pos.z] = {};
+        }
+        if ( loc.pos.z + 2 == layerCount ) // the very last layer after this one
+        {
+            invalids_[loc.pos.z + 1] = {};
+            lowerIso_[loc.pos.z + 1] = {};
+        }
+
+        if ( onLayerDone && !onLayerDone() )
+            return;
+    }
+}
+
+Expected<void> VolumeMesher::flushBlocks_()
+{
+    MR_TIMER;
+    assert( writer_ );
+    const int layerCount = indexer_.dims().z;
+    const bool lastPart = nextZ_ + 1 == layerCount;
+    // all layers before nextZ_ are filled, and nextZ_ itself only after the last part
+    const int numFilledBlocks = lastPart ? blockCount_ : nextZ_ / layersPerBlock_;
+
+    nextVid_ = sepStorage_.makeUniqueVids( numShiftedBlocks_, numFilledBlocks, nextVid_ );
+    numShiftedBlocks_ = numFilledBlocks;
+    if ( nextVid_ > params_.maxVertices )
+        return unexpected( "Vertices number limit exceeded." );
+
+    // the triangles of a block reference the points in the first layer of next block, so next block must have unique ids as well
+    const int numReadyBlocks = lastPart ? blockCount_ : std::max( numFlushedBlocks_, numShiftedBlocks_ - 1 );
+    const auto callingThreadId = std::this_thread::get_id();
+    std::atomic<bool> keepGoing{ true };
+    // the triangulation of ready blocks is a part of the last addPart call, so the progress reported by it is repeated here,
+    // mostly to let the user cancel the operation
+    const auto cb = subprogress( params_.cb, 0.0f, 0.3f );
+    const float partProgress = float( lastPart ? nextZ_ : nextZ_ - 1 ) / layerCount;
+    ParallelFor( numFlushedBlocks_, numReadyBlocks, [&] ( int blockIndex )
+    {
+        const bool report = cb && std::this_thread::get_id() == callingThreadId;
+        triangulateBlock_( blockIndex, keepGoing, [&]
+        {
+            if ( report && !reportProgress( cb, partProgress ) )
             {
-                invalids_[loc.pos.z + 1] = {};
-                lowerIso_[loc.pos.z + 1] = {};
+                keepGoing.store( false, std::memory_order_relaxed );
+                return false;
             }
+            return keepGoing.load( std::memory_order_relaxed );
+        } );
+    } );
+
+    if ( params_.cb && !keepGoing )
+        return unexpectedOperationCanceled();
+
+    for ( ; numFlushedBlocks_ < numReadyBlocks; ++numFlushedBlocks_ )
+    {
+        auto & block = sepStorage_.getBlock( numFlushedBlocks_ );
+        if ( numFlushedBlocks_ == 0 )
+        {
+            if ( auto res = writer_->addPart( block.coords, {} ); !res )
+                return res;
+        }
+
+        // the points of each next block are passed together with the first triangles referencing them
+        auto * nextBlock = numFlushedBlocks_ + 1 < blockCount_ ? &sepStorage_.getBlock( numFlushedBlocks_ + 1 ) : nullptr;
+        if ( auto res = writer_->addPart( nextBlock ? nextBlock->coords : std::vector<Vector3f>{}, block.tris.vec_ ); !res )
+            return res;
+        if ( nextBlock )
+        {
+            writer_->releasePoints( nextBlock->shift );
+            nextBlock->coords = {};
+        }
+        block = {};
+
+        const int layerBegin = numFlushedBlocks_ * layersPerBlock_;
+        const int layerEnd = std::min( layerBegin + layersPerBlock_, layerCount );
+        for ( int z = layerBegin; z < layerEnd; ++z )
+        {
+            invalids_[z] = {};
+            lowerIso_[z] = {};
+        }
+    }
+    return {};
+}
+
+Expected<TriMesh> VolumeMesher::finalize()
+{
+    MR_TIMER;
+    if ( nextZ_ + 1 != indexer_.dims().z )
+        return unexpected( "Provided parts do not cover whole volume" );
 
+    if ( writer_ )
+    {
+        // all triangles were already passed to the writer after the last part
+        assert( numFlushedBlocks_ == blockCount_ );
+        if ( auto res = writer_->finish(); !res )
+            return unexpected( std::move( res.error() ) );
+        return TriMesh{};
+    }
+
+    const auto totalVertices = sepStorage_.makeUniqueVids();
+    if ( totalVertices > params_.maxVertices )
+        return unexpected( "Vertices number limit exceeded." );
+
+    if ( params_.cb && !params_.cb( 0.5f ) )
+        return unexpectedOperationCanceled();
+
+    const auto callingThreadId = std::this_thread::get_id();
+    std::atomic<bool> keepGoing{ true };
+
+    // avoid false sharing with other local variables
+    // by putting processedBits in its own cache line
+    constexpr int hardware_destructive_interference_size = 64;
+    struct alignas(hardware_destructive_interference_size) S
+    {
+        std::atomic<int> numProcessedLayers{ 0 };
+    } cacheLineStorage;
+    static_assert( alignof(S) == hardware_destructive_interference_size );
+    static_assert( sizeof(S) == hardware_destructive_interference_size );
+
+    const int layerCount = indexer_.dims().z;
+    auto currentSubprogress = subprogress( params_.cb, 0.5f, 0.85f );
+    ParallelFor( 0, blockCount_, [&] ( int blockIndex )
+    {
+        const bool report = currentSubprogress && std::this_thread::get_id() == callingThreadId;
+        triangulateBlock_( blockIndex, keepGoing, [&]
+        {
             const auto numProcessedLayers = 1 + cacheLineStorage.numProcessedLayers.fetch_add( 1, std::memory_order_relaxed );
             if ( report && !reportProgress( currentSubprogress, float( numProcessedLayers ) / layerCount ) )
             {
                 keepGoing.store( false, std::memory_order_relaxed );
-                return;
+                return false;
             }
-        }
+            return true;
+        } );
     } );
 
     if ( params_.cb && !keepGoing )
@@ -1089,6 +1201,11 @@ MarchingCubesByParts::MarchingCubesByParts( const Vector3i & dims, const Marchin
 {
 }
 
+MarchingCubesByParts::MarchingCubesByParts( const Vector3i & dims, const MarchingCubesParams& params, IMeshStreamWriter& writer, int layersPerBlock )
+    : impl_( new Impl{ VolumeMesher( dims, params, layersPerBlock, &writer ) } )
+{
+}
+
 MarchingCubesByParts::~MarchingCubesByParts() = default;
 MarchingCubesByParts::MarchingCubesByParts( MarchingCubesByParts && s ) noexcept = default;
 MarchingCubesByParts & MarchingCubesByParts::operator=( MarchingCubesByParts && s ) noexcept = default;
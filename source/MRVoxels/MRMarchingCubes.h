@@ -92,6 +92,13 @@ public:
     /// \param layersPerBlock all z-slices of the volume will be partitioned on blocks of given size to process blocks in parallel (0 means auto-select layersPerBlock)
     MRVOXELS_API explicit MarchingCubesByParts( const Vector3i & dims, const MarchingCubesParams& params, int layersPerBlock = 0 );
 
+    /// prepares convention for given volume dimensions and given parameters with streaming output:
+    /// the triangles are passed to the writer (e.g. PlyStreamWriter or BinaryStlStreamWriter) block by block during addPart,
+    /// so only the separation points of current part are kept in memory; finalize() completes the writer and returns empty trimesh;
+    /// params.outVoxelPerFaceMap is not supported in this mode
+    /// \param layersPerBlock all z-slices of the volume will be partitioned on blocks of given size (0 means auto-select layersPerBlock)
+    MRVOXELS_API MarchingCubesByParts( const Vector3i & dims, const MarchingCubesParams& params, IMeshStreamWriter& writer, int layersPerBlock = 0 );
+
     MRVOXELS_API ~MarchingCubesByParts();
     MRVOXELS_API MarchingCubesByParts( MarchingCubesByParts && s ) noexcept;
     MRVOXELS_API MarchingCubesByParts & operator=( MarchingCubesByParts && s ) noexcept;
@@ -27,20 +27,20 @@ public:
     MRVOXELS_API virtual void applyScale( float scaleFactor ) override;
 
     /// Returns iso surface, empty if iso value is not set
-    const std::shared_ptr<Mesh>& surface() const { return data_.mesh; }
+    const std::shared_ptr<Mesh>& surface() const { ensureModelLoaded_(); return data_.mesh; }
 
     /// Return VdbVolume
-    const VdbVolume& vdbVolume() const { return vdbVolume_; };
-    VdbVolume& varVdbVolume() { return vdbVolume_; }
+    const VdbVolume& vdbVolume() const { ensureModelLoaded_(); return vdbVolume_; };
+    VdbVolume& varVdbVolume() { ensureModelLoaded_(); return vdbVolume_; }
 
     /// Returns Float grid which contains voxels data, see more on openvdb::FloatGrid
-    const FloatGrid& grid() const { return vdbVolume_.data; }
+    const FloatGrid& grid() const { ensureModelLoaded_(); return vdbVolume_.data; }
 
     [[nodiscard]] virtual bool hasModel() const override { return bool( vdbVolume_.data ); }
 
     /// Returns dimensions of voxel objects
     const Vector3i& dimensions() const
-    { return vdbVolume_.dims; }
+    { ensureModelLoaded_(); return vdbVolume_.dims; }
     /// Returns current iso value
     float getIsoValue() const
     { return isoValue_; }
@@ -49,7 +49,7 @@ public:
     { return histogram_; }
 
     const Vector3f& voxelSize() const
-    { return vdbVolume_.voxelSize; }
+    { ensureModelLoaded_(); return vdbVolume_.voxelSize; }
 
     MRVOXELS_API virtual std::vector<std::string> getInfoLines() const override;
 
@@ -18,6 +18,7 @@
 #include "MRMesh/MRBitSetParallelFor.h"
 #include "MRMesh/MRRingIterator.h"
 #include "MRMesh/MRTriMesh.h"
+#include "MRPch/MRTBB.h"
 
 namespace MR
 {
@@ -218,6 +219,43 @@ Expected<Mesh> mcOffsetMesh( const MeshPart& mp, float offset,
             } );
     }
 
+    if ( isFuncVolume && isHoleWindingRule && !mp.region )
+    {
+        // the winding numbers are computed by bricks of voxels (much faster than independently for each voxel of function volume)
+        // in z-slabs of the grid, and each slab is passed to marching cubes and freed right after that
+        vol.cb = {};
+        vmParams.cb = params.callBack;
+
+        // the slabs are (2 * thread_count) times thinner than the grid as the blocks of function volume,
+        // and each slab is processed by marching cubes in all threads
+        const int threadCount = std::max( 1, tbb::this_task_arena::max_concurrency() );
+        const int slabLayers = std::max( 1, vol.dimensions.z / ( 2 * threadCount ) );
+        FastWindingNumber fwn( mp.mesh );
+        MarchingCubesByParts mesher( vol.dimensions, vmParams, std::max( 1, slabLayers / threadCount ) );
+        for ( int zOffset = 0; ; zOffset = mesher.nextZ() )
+        {
+            // neighbor slabs share one z-layer
+            const Vector3i dims( vol.dimensions.x, vol.dimensions.y, std::min( slabLayers + 1, vol.dimensions.z - zOffset ) );
+            const AffineXf3f basis { Matrix3f::scale( vol.voxelSize ), origin + mult( Vector3f( 0.5f, 0.5f, zOffset + 0.5f ), vol.voxelSize ) };
+            std::vector<float> data;
+            if ( auto res = fwn.calcFromGridWithDistances( data, dims, basis, dist, {} ); !res )
+                return unexpected( std::move( res.error() ) );
+            const SimpleVolume part {
+                .data = std::move( data ),
+                .dims = dims,
+                .voxelSize = vol.voxelSize,
+            };
+            if ( auto res = mesher.addPart( part ); !res )
+                return unexpected( std::move( res.error() ) );
+            if ( mesher.nextZ() + 1 >= vol.dimensions.z )
+                break;
+        }
+        return mesher.finalize().transform( [] ( TriMesh&& mesh )
+        {
+            return Mesh::fromTriMesh( std::move( mesh ) );
+        } );
+    }
+
     MeshToDistanceVolumeParams msParams { vol, { dist, params.signDetectionMode }, params.fwn };
 
     if ( isFuncVolume )